@@ -0,0 +1,214 @@
+/* emu_links.c - STREAM transfer time and goodput over emulated satellite and radio links */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/danp.h"
+#include "danp/drivers/danp_emu.h"
+#include "danp/drivers/danp_lo.h"
+#include "osal/osal.h"
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#define BENCH_NODE_ID       (1U)
+#define BENCH_SERVER_PORT   (11U)
+#define BENCH_CLIENT_PORT   (12U)
+#define BENCH_CHUNK_BYTES   (1024U)
+#define BENCH_IDLE_MS       (30000U)
+#define BENCH_STALL_MS      (5000U)
+
+/* Types */
+
+typedef struct bench_profile_s
+{
+    const char *label;
+    danp_emu_params_t params;
+    uint32_t bytes; /**< Transfer size, scaled so slow links finish in seconds. */
+} bench_profile_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static danp_lo_interface_t lo_iface;
+static danp_emu_interface_t emu_iface;
+static uint8_t chunk[BENCH_CHUNK_BYTES];
+static volatile uint32_t sink_bytes = 0;
+
+// Data and acknowledgements share the one emulated link, so both directions see the impairments.
+static const bench_profile_t profiles[] = {
+    {.label = "ideal", .params = {.seed = 1}, .bytes = 256U * 1024U},
+    {.label = "leo 1M", .params = {.delay_ms = 20, .jitter_ms = 5, .loss_ppm = 1000, .rate_bps = 1000000, .seed = 1}, .bytes = 64U * 1024U},
+    {.label = "geo 256k", .params = {.delay_ms = 270, .loss_ppm = 100, .rate_bps = 256000, .seed = 1}, .bytes = 8U * 1024U},
+    {.label = "uhf 9k6", .params = {.delay_ms = 5, .jitter_ms = 2, .loss_ppm = 20000, .rate_bps = 9600, .seed = 1}, .bytes = 2U * 1024U},
+    {.label = "reorder", .params = {.delay_ms = 20, .reorder_ppm = 50000, .duplicate_ppm = 10000, .seed = 1}, .bytes = 32U * 1024U},
+};
+
+/* Functions */
+
+static void bench_log(danp_log_level_t level, const char *func_name, const char *message, va_list args)
+{
+    // Retransmissions are the point of the exercise; only report real failures.
+    if (level < DANP_LOG_ERROR)
+    {
+        return;
+    }
+    printf("[%s] ", func_name);
+    vprintf(message, args);
+    printf("\n");
+}
+
+static void stream_sink_task(void *arg)
+{
+    danp_socket_t *server = (danp_socket_t *)arg;
+    uint8_t buffer[512];
+
+    for (;;)
+    {
+        danp_socket_t *conn = danp_accept(server, DANP_WAIT_FOREVER);
+        if (conn == NULL)
+        {
+            continue;
+        }
+
+        for (;;)
+        {
+            int32_t len = danp_recv(conn, buffer, sizeof(buffer), BENCH_IDLE_MS);
+            if (len <= 0)
+            {
+                break;
+            }
+            sink_bytes += (uint32_t)len;
+        }
+        danp_close(conn);
+    }
+}
+
+static void run_profile(const bench_profile_t *profile, uint16_t client_port)
+{
+    danp_socket_t *client = danp_socket(DANP_TYPE_STREAM);
+    uint32_t sent = 0;
+    uint32_t progress_bytes = 0;
+    uint32_t progress_ms = 0;
+    bool stalled = false;
+
+    danp_emu_set_params(&emu_iface, &profile->params);
+    memset(&emu_iface.stats, 0, sizeof(emu_iface.stats));
+    sink_bytes = 0;
+
+    uint32_t start_ms = osalGetTickMs();
+    danp_bind(client, client_port);
+    if (danp_connect(client, BENCH_NODE_ID, BENCH_SERVER_PORT) != 0)
+    {
+        printf("%-9s connect failed\n", profile->label);
+        danp_close(client);
+        return;
+    }
+    uint32_t connect_ms = osalGetTickMs() - start_ms;
+
+    while (sent < profile->bytes)
+    {
+        uint32_t length = profile->bytes - sent;
+        int32_t ret = danp_send(client, chunk, (uint16_t)((length < BENCH_CHUNK_BYTES) ? length : BENCH_CHUNK_BYTES));
+        if (ret <= 0)
+        {
+            printf("%-9s send failed after %u bytes\n", profile->label, sent);
+            break;
+        }
+        sent += (uint32_t)ret;
+    }
+    danp_flush(client);
+    // A link the transport cannot cope with shows up as a stall rather than a long wait.
+    progress_ms = osalGetTickMs();
+    while (sink_bytes < sent)
+    {
+        if (sink_bytes != progress_bytes)
+        {
+            progress_bytes = sink_bytes;
+            progress_ms = osalGetTickMs();
+        }
+        else if ((osalGetTickMs() - progress_ms) >= BENCH_STALL_MS)
+        {
+            stalled = true;
+            break;
+        }
+        osalDelayMs(1);
+    }
+    uint32_t elapsed_ms = osalGetTickMs() - start_ms;
+
+    printf(
+        "%-9s %7u bytes in %6u ms (connect %4u ms): %8.1f KiB/s, %u packets, %u lost, %u dup, %u reordered, %u queue drops%s\n",
+        profile->label,
+        sink_bytes,
+        elapsed_ms,
+        connect_ms,
+        (elapsed_ms > 0) ? ((double)sink_bytes / 1024.0) * 1000.0 / (double)elapsed_ms : 0.0,
+        emu_iface.stats.tx_packets,
+        emu_iface.stats.tx_lost,
+        emu_iface.stats.tx_duplicated,
+        emu_iface.stats.tx_reordered,
+        emu_iface.stats.tx_queue_drops,
+        stalled ? ", stalled" : "");
+
+    // A graceful close, so the sink sees the end even if a reset would have been lost.
+    danp_close(client);
+}
+
+int main(void)
+{
+    danp_config_t config = {
+        .local_node = BENCH_NODE_ID,
+        .log_function = bench_log,
+    };
+    danp_emu_config_t emu_config = {
+        .name = "emu",
+        .lower = &lo_iface.common,
+    };
+    osalThreadAttr_t thread_attr = {
+        .name = "benchEmu",
+        .stackSize = 1024 * 16,
+        .stackMem = NULL,
+        .priority = OSAL_THREAD_PRIORITY_NORMAL,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+
+    danp_init(&config);
+
+    if (danp_lo_init(&lo_iface, BENCH_NODE_ID) != 0 || danp_emu_init(&emu_iface, &emu_config) != 0)
+    {
+        printf("link emulator init failed\n");
+        return 1;
+    }
+    danp_register_interface(&emu_iface);
+    danp_route_table_load("1:emu");
+
+    for (uint32_t i = 0; i < sizeof(chunk); i++)
+    {
+        chunk[i] = (uint8_t)i;
+    }
+
+    danp_socket_t *server = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server, BENCH_SERVER_PORT);
+    danp_listen(server, 1);
+    osalThreadCreate(stream_sink_task, server, &thread_attr);
+
+    printf("emulated link queue depth %u, same seed every run\n", (uint32_t)DANP_EMU_QUEUE_DEPTH);
+    for (uint32_t i = 0; i < sizeof(profiles) / sizeof(profiles[0]); i++)
+    {
+        // A fresh port per run keeps the previous connection's TIME_WAIT out of the way.
+        run_profile(&profiles[i], (uint16_t)(BENCH_CLIENT_PORT + i));
+    }
+
+    return 0;
+}
@@ -0,0 +1,174 @@
+/* rx_scaling.c - datagram receive rate with several driver threads feeding the stack */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/danp.h"
+#include "osal/osal.h"
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#define BENCH_NODE_ID       (1U)
+#define BENCH_PEER_ID       (2U)
+#define BENCH_BASE_PORT     (20U)
+#define BENCH_MAX_THREADS   (4U)
+#define BENCH_RUN_MS        (1000U)
+#define BENCH_PAYLOAD_BYTES (32U)
+
+/* Types */
+
+/** @brief One driver thread and the socket it feeds. */
+typedef struct bench_lane_s
+{
+    danp_socket_t *sock;
+    uint16_t port;
+    volatile uint32_t delivered;
+    volatile bool driver_done;
+    volatile bool consumer_done;
+} bench_lane_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static danp_interface_t bench_iface;
+static bench_lane_t lanes[BENCH_MAX_THREADS];
+static volatile bool running = false;
+
+/* Functions */
+
+static void bench_log(danp_log_level_t level, const char *func_name, const char *message, va_list args)
+{
+    // Pool and queue overruns are expected at full rate, and logging them would be the bottleneck.
+    (void)level;
+    (void)func_name;
+    (void)message;
+    (void)args;
+}
+
+static int32_t bench_tx(void *iface_common, danp_packet_t *packet)
+{
+    (void)iface_common;
+    (void)packet;
+    return 0;
+}
+
+/**
+ * @brief Play the role of an interface driver: hand raw datagrams to danp_input().
+ * @param arg Lane to feed.
+ */
+static void driver_task(void *arg)
+{
+    bench_lane_t *lane = (bench_lane_t *)arg;
+    uint8_t frame[DANP_HEADER_SIZE + BENCH_PAYLOAD_BYTES];
+    uint32_t header = danp_pack_header(0, BENCH_NODE_ID, BENCH_PEER_ID, lane->port, lane->port, DANP_FLAG_NONE);
+
+    memcpy(frame, &header, DANP_HEADER_SIZE);
+    memset(frame + DANP_HEADER_SIZE, 0xA5, BENCH_PAYLOAD_BYTES);
+
+    while (running)
+    {
+        danp_input(&bench_iface, frame, sizeof(frame));
+    }
+    lane->driver_done = true;
+}
+
+/**
+ * @brief Drain the socket of a lane, counting what arrives.
+ * @param arg Lane to drain.
+ */
+static void consumer_task(void *arg)
+{
+    bench_lane_t *lane = (bench_lane_t *)arg;
+    uint8_t buffer[BENCH_PAYLOAD_BYTES];
+
+    while (running)
+    {
+        if (danp_recv(lane->sock, buffer, sizeof(buffer), 10) > 0)
+        {
+            lane->delivered++;
+        }
+    }
+    lane->consumer_done = true;
+}
+
+static void run(uint32_t threads)
+{
+    osalThreadAttr_t thread_attr = {
+        .name = "benchLane",
+        .stackSize = 1024 * 16,
+        .stackMem = NULL,
+        .priority = OSAL_THREAD_PRIORITY_NORMAL,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+    uint32_t total = 0;
+
+    running = true;
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        lanes[i].delivered = 0;
+        lanes[i].driver_done = false;
+        lanes[i].consumer_done = false;
+        osalThreadCreate(consumer_task, &lanes[i], &thread_attr);
+        osalThreadCreate(driver_task, &lanes[i], &thread_attr);
+    }
+
+    osalDelayMs(BENCH_RUN_MS);
+    running = false;
+
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        while (!lanes[i].driver_done || !lanes[i].consumer_done)
+        {
+            osalDelayMs(1);
+        }
+        total += lanes[i].delivered;
+    }
+
+    printf(
+        "%u driver thread(s): %9.0f datagrams/s delivered (%8.0f per thread)\n",
+        threads,
+        (double)total * 1000.0 / BENCH_RUN_MS,
+        (double)total * 1000.0 / BENCH_RUN_MS / threads);
+}
+
+int main(void)
+{
+    danp_config_t config = {
+        .local_node = BENCH_NODE_ID,
+        .log_function = bench_log,
+    };
+
+    danp_init(&config);
+
+    bench_iface.name = "BENCH_RX";
+    bench_iface.address = BENCH_NODE_ID;
+    bench_iface.mtu = DANP_MAX_PACKET_SIZE;
+    bench_iface.tx_func = bench_tx;
+    danp_register_interface(&bench_iface);
+
+    for (uint32_t i = 0; i < BENCH_MAX_THREADS; i++)
+    {
+        lanes[i].port = (uint16_t)(BENCH_BASE_PORT + i);
+        lanes[i].sock = danp_socket(DANP_TYPE_DGRAM);
+        danp_bind(lanes[i].sock, lanes[i].port);
+    }
+
+    for (uint32_t threads = 1; threads <= BENCH_MAX_THREADS; threads *= 2U)
+    {
+        run(threads);
+    }
+
+    return 0;
+}
@@ -0,0 +1,252 @@
+/* serial_throughput.c - COBS and KISS frame rates over pseudo-terminals and the goodput they leave at common baud rates */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* posix_openpt, ptsname */
+#endif
+
+#include "danp/danp.h"
+#include "danp/drivers/danp_serial.h"
+#include "osal/osal.h"
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#define BENCH_NODE_ID        (1U)
+#define BENCH_PEER_ID        (2U)
+#define BENCH_PORT           (10U)
+#define BENCH_RUN_MS         (1000U)
+#define BENCH_PAYLOAD_BYTES  (DANP_MAX_PACKET_SIZE - DANP_HEADER_SIZE)
+#define BENCH_PAYLOAD_COUNT  (64U)
+#define BENCH_WINDOW         (8U)
+#define BENCH_BITS_PER_BYTE  (10U)
+
+/* Types */
+
+typedef struct bench_link_s
+{
+    const char *label;
+    danp_serial_framing_t framing;
+    const char *route;
+    uint8_t worst_byte; /**< Byte the framing expands the most. */
+    danp_serial_interface_t rx;
+    danp_serial_interface_t tx;
+} bench_link_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static bench_link_t links[] = {
+    {.label = "cobs", .framing = DANP_SERIAL_FRAMING_COBS, .route = "1:serCobsTx", .worst_byte = 0xFF},
+    {.label = "kiss", .framing = DANP_SERIAL_FRAMING_KISS, .route = "1:serKissTx", .worst_byte = 0xC0},
+};
+static const uint32_t baud_rates[] = {9600, 57600, 115200, 460800, 921600, 3000000};
+static uint8_t payloads[BENCH_PAYLOAD_COUNT][BENCH_PAYLOAD_BYTES];
+static volatile uint32_t delivered = 0;
+static volatile bool running = false;
+static volatile bool consumer_done = false;
+
+/* Functions */
+
+static void bench_log(danp_log_level_t level, const char *func_name, const char *message, va_list args)
+{
+    if (level < DANP_LOG_ERROR)
+    {
+        return;
+    }
+    printf("[%s] ", func_name);
+    vprintf(message, args);
+    printf("\n");
+}
+
+static uint64_t cpu_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int32_t open_link(bench_link_t *link, const char *rx_name, const char *tx_name)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+    {
+        return -1;
+    }
+    int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (slave < 0)
+    {
+        return -1;
+    }
+
+    // The receiving side carries the node's own address, so frames written by
+    // the sending side are delivered locally. No baud rate is set: a pty has no
+    // line rate and the receive thread must not pace itself to one.
+    danp_serial_config_t rx_config = {
+        .name = rx_name,
+        .address = BENCH_NODE_ID,
+        .fd = master,
+        .framing = link->framing,
+    };
+    danp_serial_config_t tx_config = {
+        .name = tx_name,
+        .address = BENCH_PEER_ID,
+        .fd = slave,
+        .framing = link->framing,
+    };
+    if (danp_serial_init(&link->rx, &rx_config) != 0 || danp_serial_init(&link->tx, &tx_config) != 0)
+    {
+        return -1;
+    }
+    danp_register_interface(&link->rx);
+    danp_register_interface(&link->tx);
+    return 0;
+}
+
+static void consumer_task(void *arg)
+{
+    danp_socket_t *sock = (danp_socket_t *)arg;
+    uint8_t buffer[BENCH_PAYLOAD_BYTES];
+
+    while (running)
+    {
+        if (danp_recv(sock, buffer, sizeof(buffer), 10) > 0)
+        {
+            delivered++;
+        }
+    }
+    consumer_done = true;
+}
+
+static void run_link(bench_link_t *link, bool worst, osalThreadAttr_t *thread_attr)
+{
+    danp_socket_t *sock = danp_socket(DANP_TYPE_DGRAM);
+    uint32_t sent = 0;
+    uint32_t tx_frames = link->tx.stats.tx_frames;
+    uint32_t tx_bytes = link->tx.stats.tx_bytes;
+    uint8_t worst_payload[BENCH_PAYLOAD_BYTES];
+
+    memset(worst_payload, link->worst_byte, sizeof(worst_payload));
+    danp_route_table_load(link->route);
+    danp_bind(sock, BENCH_PORT);
+    delivered = 0;
+    consumer_done = false;
+    running = true;
+    osalThreadCreate(consumer_task, sock, thread_attr);
+
+    uint64_t cpu_start = cpu_ns();
+    uint32_t start_ms = osalGetTickMs();
+    while ((osalGetTickMs() - start_ms) < BENCH_RUN_MS)
+    {
+        // Keep a few frames in flight so the figure is decode rate, not socket queue overflow.
+        if ((sent - delivered) >= BENCH_WINDOW)
+        {
+            osalDelayMs(0);
+            continue;
+        }
+        uint8_t *payload = worst ? worst_payload : payloads[sent % BENCH_PAYLOAD_COUNT];
+        if (danp_send_to(sock, payload, BENCH_PAYLOAD_BYTES, BENCH_NODE_ID, BENCH_PORT) >= 0)
+        {
+            sent++;
+        }
+    }
+    running = false;
+    while (!consumer_done)
+    {
+        osalDelayMs(1);
+    }
+    uint64_t cpu_used = cpu_ns() - cpu_start;
+    danp_close(sock);
+
+    uint32_t frames = link->tx.stats.tx_frames - tx_frames;
+    double encoded = (frames > 0) ? (double)(link->tx.stats.tx_bytes - tx_bytes) / (double)frames : 0.0;
+    double measured = (double)delivered * 1000.0 / BENCH_RUN_MS;
+    double cpu_per_frame = (delivered > 0) ? (double)cpu_used / (double)delivered : 0.0;
+
+    printf(
+        "%s %-6s %9.0f frames/s %10.0f B/s payload, %5.1f B on the line per %u B payload, %6.2f us CPU/frame\n",
+        link->label,
+        worst ? "worst" : "random",
+        measured,
+        measured * BENCH_PAYLOAD_BYTES,
+        encoded,
+        (uint32_t)BENCH_PAYLOAD_BYTES,
+        cpu_per_frame / 1000.0);
+
+    if (encoded == 0.0)
+    {
+        return;
+    }
+    for (uint32_t i = 0; i < sizeof(baud_rates) / sizeof(baud_rates[0]); i++)
+    {
+        double line_frames = ((double)baud_rates[i] / BENCH_BITS_PER_BYTE) / encoded;
+        double frames_out = (measured < line_frames) ? measured : line_frames;
+
+        // CPU share is what decoding and encoding cost when the line runs full.
+        printf(
+            "    %7u baud: %9.0f B/s goodput (%s-bound), %6.1fx CPU headroom, %5.1f%% CPU at line rate\n",
+            baud_rates[i],
+            frames_out * BENCH_PAYLOAD_BYTES,
+            (measured < line_frames) ? "cpu" : "line",
+            measured / line_frames,
+            line_frames * cpu_per_frame / 1e7);
+    }
+}
+
+int main(void)
+{
+    danp_config_t config = {
+        .local_node = BENCH_NODE_ID,
+        .log_function = bench_log,
+    };
+    osalThreadAttr_t thread_attr = {
+        .name = "benchSerial",
+        .stackSize = 1024 * 16,
+        .stackMem = NULL,
+        .priority = OSAL_THREAD_PRIORITY_NORMAL,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+
+    danp_init(&config);
+
+    if (open_link(&links[0], "serCobsRx", "serCobsTx") != 0 || open_link(&links[1], "serKissRx", "serKissTx") != 0)
+    {
+        printf("serial init failed\n");
+        return 1;
+    }
+
+    srand(1);
+    for (uint32_t i = 0; i < BENCH_PAYLOAD_COUNT; i++)
+    {
+        for (uint32_t j = 0; j < BENCH_PAYLOAD_BYTES; j++)
+        {
+            payloads[i][j] = (uint8_t)rand();
+        }
+    }
+
+    printf("serial frames of %u B payload over pseudo-terminals, 8N1 line assumed\n", (uint32_t)BENCH_PAYLOAD_BYTES);
+    for (uint32_t i = 0; i < sizeof(links) / sizeof(links[0]); i++)
+    {
+        run_link(&links[i], false, &thread_attr);
+        run_link(&links[i], true, &thread_attr);
+    }
+
+    return 0;
+}
@@ -0,0 +1,197 @@
+/* shm_latency.c - DGRAM round-trip time between two processes over shared memory */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/danp.h"
+#include "danp/drivers/danp_shm.h"
+#include "osal/osal.h"
+#include <signal.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#define BENCH_NODE_ID       (1U)
+#define BENCH_PEER_ID       (2U)
+#define BENCH_LOCAL_PORT    (10U)
+#define BENCH_ECHO_PORT     (11U)
+#define BENCH_ROUND_TRIPS   (20000U)
+#define BENCH_PAYLOAD_BYTES (32U)
+#define BENCH_PEER_ARG      "--echo"
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static danp_shm_interface_t shm_iface;
+static uint32_t samples_us[BENCH_ROUND_TRIPS];
+
+/* Functions */
+
+static void bench_log(danp_log_level_t level, const char *func_name, const char *message, va_list args)
+{
+    if (level < DANP_LOG_ERROR)
+    {
+        return;
+    }
+    printf("[%s] ", func_name);
+    vprintf(message, args);
+    printf("\n");
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int run_echo(const char *segment)
+{
+    danp_config_t config = {
+        .local_node = BENCH_PEER_ID,
+        .log_function = bench_log,
+    };
+    danp_shm_config_t shm_config = {
+        .address = BENCH_PEER_ID,
+        .peer = BENCH_NODE_ID,
+        .segment = segment,
+    };
+    uint8_t buffer[DANP_MAX_PACKET_SIZE];
+    uint16_t src_node = 0;
+    uint16_t src_port = 0;
+
+    danp_init(&config);
+    if (danp_shm_init(&shm_iface, &shm_config) != 0)
+    {
+        return 1;
+    }
+    danp_register_interface(&shm_iface);
+    danp_route_table_load("1:SHM");
+
+    danp_socket_t *sock = danp_socket(DANP_TYPE_DGRAM);
+    danp_bind(sock, BENCH_ECHO_PORT);
+    for (;;)
+    {
+        int32_t len = danp_recv_from(sock, buffer, sizeof(buffer), &src_node, &src_port, DANP_WAIT_FOREVER);
+        if (len > 0)
+        {
+            danp_send_to(sock, buffer, (uint16_t)len, src_node, src_port);
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    danp_config_t config = {
+        .local_node = BENCH_NODE_ID,
+        .log_function = bench_log,
+    };
+    danp_shm_config_t shm_config = {
+        .address = BENCH_NODE_ID,
+        .peer = BENCH_PEER_ID,
+        .segment = NULL,
+    };
+    char segment[DANP_SHM_NAME_MAX];
+    uint8_t payload[BENCH_PAYLOAD_BYTES];
+    uint8_t reply[DANP_MAX_PACKET_SIZE];
+    uint64_t total_ns = 0;
+    uint32_t done = 0;
+
+    if (argc > 2 && strcmp(argv[1], BENCH_PEER_ARG) == 0)
+    {
+        return run_echo(argv[2]);
+    }
+
+    snprintf(segment, sizeof(segment), "/danp-bench-%d", (int)getpid());
+    danp_shm_unlink(segment);
+    pid_t peer = fork();
+    if (peer == 0)
+    {
+        execl("/proc/self/exe", argv[0], BENCH_PEER_ARG, segment, (char *)NULL);
+        _exit(127);
+    }
+
+    danp_init(&config);
+    shm_config.segment = segment;
+    if (peer < 0 || danp_shm_init(&shm_iface, &shm_config) != 0)
+    {
+        printf("shm init failed\n");
+        return 1;
+    }
+    danp_register_interface(&shm_iface);
+    danp_route_table_load("2:SHM");
+
+    memset(payload, 0x5A, sizeof(payload));
+    danp_socket_t *sock = danp_socket(DANP_TYPE_DGRAM);
+    danp_bind(sock, BENCH_LOCAL_PORT);
+
+    // Wait for the echo process to bind its socket.
+    do
+    {
+        danp_send_to(sock, payload, sizeof(payload), BENCH_PEER_ID, BENCH_ECHO_PORT);
+    } while (danp_recv(sock, reply, sizeof(reply), 100) <= 0);
+
+    while (done < BENCH_ROUND_TRIPS)
+    {
+        uint64_t start_ns = now_ns();
+        danp_send_to(sock, payload, sizeof(payload), BENCH_PEER_ID, BENCH_ECHO_PORT);
+        if (danp_recv(sock, reply, sizeof(reply), 1000) <= 0)
+        {
+            printf("echo lost after %u round trips\n", done);
+            break;
+        }
+        uint64_t rtt_ns = now_ns() - start_ns;
+        samples_us[done++] = (uint32_t)(rtt_ns / 1000U);
+        total_ns += rtt_ns;
+    }
+
+    if (done > 0)
+    {
+        qsort(samples_us, done, sizeof(samples_us[0]), compare_u32);
+        printf(
+            "shm dgram %u B: %u round trips, mean %.1f us, min %u us, median %u us, p99 %u us\n",
+            (uint32_t)BENCH_PAYLOAD_BYTES,
+            done,
+            (double)total_ns / done / 1000.0,
+            samples_us[0],
+            samples_us[done / 2],
+            samples_us[(done * 99U) / 100U]);
+        printf(
+            "shm %u frames sent, %u needed a futex wake, %u receive sleeps\n",
+            shm_iface.stats.tx_packets,
+            shm_iface.stats.tx_wakeups,
+            shm_iface.stats.rx_wakeups);
+    }
+
+    kill(peer, SIGKILL);
+    waitpid(peer, NULL, 0);
+    danp_shm_unlink(segment);
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+/* socket_footprint.c - static RAM and OS objects used by a typical socket mix */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/danp.h"
+#include "osal/osal.h"
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#define BENCH_NODE_ID       (1U)
+#define BENCH_DGRAM_COUNT   (6U)
+#define BENCH_STREAM_COUNT  (3U)
+#define BENCH_DGRAM_PORT    (20U)
+#define BENCH_SERVER_PORT   (10U)
+#define BENCH_CLIENT_PORT   (11U)
+
+// Every socket of the original eager scheme had these, whatever its type.
+#define BASELINE_RX_QUEUE_SIZE     (10U)
+#define BASELINE_ACCEPT_QUEUE_SIZE (5U)
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static danp_interface_t loopback_iface;
+
+/* Functions */
+
+static void bench_log(danp_log_level_t level, const char *func_name, const char *message, va_list args)
+{
+    if (level < DANP_LOG_WARN)
+    {
+        return;
+    }
+    printf("[%s] ", func_name);
+    vprintf(message, args);
+    printf("\n");
+}
+
+static int32_t loopback_tx(void *iface_common, danp_packet_t *packet)
+{
+    uint8_t buffer[DANP_HEADER_SIZE + DANP_MAX_PACKET_SIZE];
+
+    memcpy(buffer, &packet->header_raw, DANP_HEADER_SIZE);
+    memcpy(buffer + DANP_HEADER_SIZE, packet->payload, packet->length);
+    danp_input((danp_interface_t *)iface_common, buffer, DANP_HEADER_SIZE + packet->length);
+
+    return 0;
+}
+
+static void print_row(const char *label, uint32_t queues, uint32_t queue_bytes, uint32_t semaphores, uint32_t mutexes)
+{
+    printf(
+        "%-12s %6u queues %8u bytes of queue storage %6u semaphores %6u mutexes\n",
+        label,
+        queues,
+        queue_bytes,
+        semaphores,
+        mutexes);
+}
+
+int main(void)
+{
+    danp_config_t config = {
+        .local_node = BENCH_NODE_ID,
+        .log_function = bench_log,
+    };
+    danp_socket_footprint_t footprint;
+    danp_socket_t *server;
+    uint32_t in_use = 0;
+
+    danp_init(&config);
+
+    loopback_iface.name = "BENCH_LOOPBACK";
+    loopback_iface.address = BENCH_NODE_ID;
+    loopback_iface.mtu = DANP_MAX_PACKET_SIZE;
+    loopback_iface.tx_func = loopback_tx;
+    danp_register_interface(&loopback_iface);
+    danp_route_table_load("1:BENCH_LOOPBACK");
+
+    for (uint32_t i = 0; i < BENCH_DGRAM_COUNT; i++)
+    {
+        danp_socket_t *dgram = danp_socket(DANP_TYPE_DGRAM);
+        danp_bind(dgram, (uint16_t)(BENCH_DGRAM_PORT + i));
+        in_use++;
+    }
+
+    server = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server, BENCH_SERVER_PORT);
+    danp_listen(server, BENCH_STREAM_COUNT);
+    in_use++;
+
+    for (uint32_t i = 0; i < BENCH_STREAM_COUNT; i++)
+    {
+        danp_socket_t *client = danp_socket(DANP_TYPE_STREAM);
+        danp_bind(client, (uint16_t)(BENCH_CLIENT_PORT + i));
+        if (danp_connect(client, BENCH_NODE_ID, BENCH_SERVER_PORT) != 0 || danp_accept(server, 0) == NULL)
+        {
+            printf("connect failed\n");
+            return 1;
+        }
+        in_use += 2U;
+    }
+
+    danp_socket_get_footprint(&footprint);
+
+    printf(
+        "%u sockets: %u DGRAM, 1 listener, %u STREAM connections accepted over loopback\n",
+        in_use,
+        BENCH_DGRAM_COUNT,
+        BENCH_STREAM_COUNT);
+    printf(
+        "Static RAM: %u bytes (socket pool %u, receive rings %u, transmit backlog %u)\n",
+        (unsigned int)footprint.static_bytes,
+        (unsigned int)footprint.pool_bytes,
+        (unsigned int)footprint.rx_ring_bytes,
+        (unsigned int)footprint.tx_backlog_bytes);
+    print_row("on demand", footprint.queues, footprint.queue_storage_bytes, footprint.semaphores, footprint.mutexes);
+    // The eager scheme gave each socket a receive queue, an accept queue and a semaphore; it had no socket locks.
+    print_row(
+        "eager",
+        in_use * 2U,
+        in_use * (BASELINE_RX_QUEUE_SIZE * (uint32_t)sizeof(danp_packet_t *) +
+                  BASELINE_ACCEPT_QUEUE_SIZE * (uint32_t)sizeof(danp_socket_t *)),
+        in_use,
+        0);
+
+    return 0;
+}
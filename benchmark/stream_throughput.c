@@ -0,0 +1,177 @@
+/* stream_throughput.c - STREAM throughput and small-write benchmark over loopback */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/danp.h"
+#include "osal/osal.h"
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#define BENCH_NODE_ID       (1U)
+#define BENCH_SERVER_PORT   (10U)
+#define BENCH_CLIENT_PORT   (11U)
+#define BENCH_TOTAL_BYTES   (1024U * 1024U)
+#define BENCH_CHUNK_BYTES   (16U * 1024U)
+#define BENCH_RECORD_BYTES  (16U)
+#define BENCH_RECORD_TOTAL  (64U * 1024U)
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static danp_interface_t loopback_iface;
+static uint8_t chunk[BENCH_CHUNK_BYTES];
+static volatile uint32_t sink_bytes = 0;
+static volatile uint32_t wire_bytes = 0;
+
+/* Functions */
+
+static void bench_log(danp_log_level_t level, const char *func_name, const char *message, va_list args)
+{
+    if (level < DANP_LOG_WARN)
+    {
+        return;
+    }
+    printf("[%s] ", func_name);
+    vprintf(message, args);
+    printf("\n");
+}
+
+static int32_t loopback_tx(void *iface_common, danp_packet_t *packet)
+{
+    uint8_t buffer[DANP_HEADER_SIZE + DANP_MAX_PACKET_SIZE];
+
+    wire_bytes += DANP_HEADER_SIZE + packet->length;
+    memcpy(buffer, &packet->header_raw, DANP_HEADER_SIZE);
+    memcpy(buffer + DANP_HEADER_SIZE, packet->payload, packet->length);
+    danp_input((danp_interface_t *)iface_common, buffer, DANP_HEADER_SIZE + packet->length);
+
+    return 0;
+}
+
+static void sink_task(void *arg)
+{
+    danp_socket_t *server = (danp_socket_t *)arg;
+    uint8_t buffer[512];
+
+    for (;;)
+    {
+        danp_socket_t *conn = danp_accept(server, DANP_WAIT_FOREVER);
+        if (conn == NULL)
+        {
+            continue;
+        }
+
+        for (;;)
+        {
+            int32_t len = danp_recv(conn, buffer, sizeof(buffer), 1000);
+            if (len <= 0)
+            {
+                break;
+            }
+            sink_bytes += (uint32_t)len;
+        }
+        danp_close(conn);
+    }
+}
+
+static void run(const char *label, uint32_t total, uint32_t write_len, bool wait_ack, bool nodelay, uint16_t local_port)
+{
+    danp_socket_t *client = danp_socket(DANP_TYPE_STREAM);
+    uint32_t sent = 0;
+
+    danp_bind(client, local_port);
+    danp_setsockopt(client, DANP_SO_SEND_WAIT_ACK, wait_ack ? 1U : 0U);
+    danp_setsockopt(client, DANP_SO_NODELAY, nodelay ? 1U : 0U);
+    if (danp_connect(client, BENCH_NODE_ID, BENCH_SERVER_PORT) != 0)
+    {
+        printf("connect failed\n");
+        return;
+    }
+
+    sink_bytes = 0;
+    wire_bytes = 0;
+    uint32_t start_ms = osalGetTickMs();
+    while (sent < total)
+    {
+        int32_t ret = danp_send(client, chunk, write_len);
+        if (ret <= 0)
+        {
+            printf("send failed after %u bytes\n", sent);
+            break;
+        }
+        sent += (uint32_t)ret;
+    }
+    danp_flush(client);
+    while (sink_bytes < sent)
+    {
+        osalDelayMs(1);
+    }
+    uint32_t elapsed_ms = osalGetTickMs() - start_ms;
+
+    printf(
+        "%-16s %8u bytes in %6u ms: %9.1f KiB/s, goodput %5.1f%% of wire bytes\n",
+        label,
+        sent,
+        elapsed_ms,
+        (elapsed_ms > 0) ? ((double)sent / 1024.0) * 1000.0 / (double)elapsed_ms : 0.0,
+        (wire_bytes > 0) ? 100.0 * (double)sent / (double)wire_bytes : 0.0);
+
+    danp_close(client);
+}
+
+int main(void)
+{
+    danp_config_t config = {
+        .local_node = BENCH_NODE_ID,
+        .log_function = bench_log,
+    };
+    osalThreadAttr_t thread_attr = {
+        .name = "benchSink",
+        .stackSize = 1024 * 16,
+        .stackMem = NULL,
+        .priority = OSAL_THREAD_PRIORITY_NORMAL,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+
+    danp_init(&config);
+
+    loopback_iface.name = "BENCH_LOOPBACK";
+    loopback_iface.address = BENCH_NODE_ID;
+    loopback_iface.mtu = DANP_MAX_PACKET_SIZE;
+    loopback_iface.tx_func = loopback_tx;
+    danp_register_interface(&loopback_iface);
+    danp_route_table_load("1:BENCH_LOOPBACK");
+
+    for (uint32_t i = 0; i < sizeof(chunk); i++)
+    {
+        chunk[i] = (uint8_t)i;
+    }
+
+    danp_socket_t *server = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server, BENCH_SERVER_PORT);
+    danp_listen(server, 1);
+    osalThreadCreate(sink_task, server, &thread_attr);
+
+    run("bulk queued", BENCH_TOTAL_BYTES, BENCH_CHUNK_BYTES, false, true, BENCH_CLIENT_PORT);
+    run("bulk wait-ack", BENCH_TOTAL_BYTES, BENCH_CHUNK_BYTES, true, true, BENCH_CLIENT_PORT + 1U);
+    run("records nodelay", BENCH_RECORD_TOTAL, BENCH_RECORD_BYTES, false, true, BENCH_CLIENT_PORT + 2U);
+    run("records coalesce", BENCH_RECORD_TOTAL, BENCH_RECORD_BYTES, false, false, BENCH_CLIENT_PORT + 3U);
+
+    return 0;
+}
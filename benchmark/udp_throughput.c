@@ -0,0 +1,319 @@
+/* udp_throughput.c - DGRAM and STREAM rates over the UDP driver, threaded and on io_uring, compared with ZeroMQ */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/danp.h"
+#include "danp/drivers/danp_udp.h"
+#ifdef DANP_URING_SUPPORT
+#include "danp/drivers/danp_uring.h"
+#endif
+#ifdef DANP_ZMQ_SUPPORT
+#include "danp/drivers/danp_zmq.h"
+#endif
+#include "osal/osal.h"
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#define BENCH_NODE_ID       (1U)
+#define BENCH_RUN_MS        (1000U)
+#define BENCH_DGRAM_BYTES   (DANP_MAX_PACKET_SIZE - DANP_HEADER_SIZE)
+#define BENCH_DGRAM_WINDOW  (DANP_RX_QUEUE_SIZE / 2U)
+#define BENCH_TOTAL_BYTES   (256U * 1024U)
+#define BENCH_CHUNK_BYTES   (16U * 1024U)
+#define BENCH_ZMQ_ENDPOINT  "tcp://127.0.0.1:5611"
+
+/* Types */
+
+/** @brief Ports one driver run uses, so STREAM ports in TIME_WAIT are not reused. */
+typedef struct bench_ports_s
+{
+    uint16_t dgram_tx;
+    uint16_t dgram_rx;
+    uint16_t server;
+    uint16_t client;
+} bench_ports_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static danp_udp_interface_t udp_iface;
+#ifdef DANP_URING_SUPPORT
+static danp_uring_t uring_loop;
+static danp_udp_interface_t uring_iface;
+#endif
+#ifdef DANP_ZMQ_SUPPORT
+static danp_zmq_interface_t zmq_iface;
+#endif
+static uint8_t chunk[BENCH_CHUNK_BYTES];
+static volatile uint32_t delivered = 0;
+static volatile uint32_t sink_bytes = 0;
+static volatile bool running = false;
+static volatile bool consumer_done = false;
+static osalThreadAttr_t thread_attr = {
+    .name = "benchUdp",
+    .stackSize = 1024 * 16,
+    .stackMem = NULL,
+    .priority = OSAL_THREAD_PRIORITY_NORMAL,
+    .cbMem = NULL,
+    .cbSize = 0,
+};
+
+/* Functions */
+
+static void bench_log(danp_log_level_t level, const char *func_name, const char *message, va_list args)
+{
+    if (level < DANP_LOG_ERROR)
+    {
+        return;
+    }
+    printf("[%s] ", func_name);
+    vprintf(message, args);
+    printf("\n");
+}
+
+static void dgram_consumer_task(void *arg)
+{
+    danp_socket_t *sock = (danp_socket_t *)arg;
+    uint8_t buffer[BENCH_DGRAM_BYTES];
+
+    while (running)
+    {
+        if (danp_recv(sock, buffer, sizeof(buffer), 10) > 0)
+        {
+            delivered++;
+        }
+    }
+    consumer_done = true;
+}
+
+static void stream_sink_task(void *arg)
+{
+    danp_socket_t *server = (danp_socket_t *)arg;
+    uint8_t buffer[512];
+    danp_socket_t *conn = danp_accept(server, DANP_WAIT_FOREVER);
+
+    if (conn == NULL)
+    {
+        return;
+    }
+    for (;;)
+    {
+        int32_t len = danp_recv(conn, buffer, sizeof(buffer), 1000);
+        if (len <= 0)
+        {
+            break;
+        }
+        sink_bytes += (uint32_t)len;
+    }
+    danp_close(conn);
+}
+
+static void run_dgram(const char *label, const bench_ports_t *ports)
+{
+    danp_socket_t *tx = danp_socket(DANP_TYPE_DGRAM);
+    danp_socket_t *rx = danp_socket(DANP_TYPE_DGRAM);
+    uint32_t sent = 0;
+
+    danp_bind(tx, ports->dgram_tx);
+    danp_bind(rx, ports->dgram_rx);
+    delivered = 0;
+    consumer_done = false;
+    running = true;
+    osalThreadCreate(dgram_consumer_task, rx, &thread_attr);
+
+    uint32_t start_ms = osalGetTickMs();
+    uint32_t progress_ms = start_ms;
+    while ((osalGetTickMs() - start_ms) < BENCH_RUN_MS)
+    {
+        // Keep a window in flight; if it stops draining, count the rest as lost and go on.
+        if ((sent - delivered) >= BENCH_DGRAM_WINDOW)
+        {
+            if ((osalGetTickMs() - progress_ms) < 50U)
+            {
+                osalDelayMs(0);
+                continue;
+            }
+            sent = delivered;
+        }
+        progress_ms = osalGetTickMs();
+        danp_send_to(tx, chunk, BENCH_DGRAM_BYTES, BENCH_NODE_ID, ports->dgram_rx);
+        sent++;
+    }
+    running = false;
+    while (!consumer_done)
+    {
+        osalDelayMs(1);
+    }
+
+    printf("%-5s dgram %3u B   %9.0f datagrams/s delivered\n",
+        label,
+        (uint32_t)BENCH_DGRAM_BYTES,
+        (double)delivered * 1000.0 / BENCH_RUN_MS);
+
+    danp_close(tx);
+    danp_close(rx);
+}
+
+static void run_stream(const char *label, const bench_ports_t *ports)
+{
+    danp_socket_t *server = danp_socket(DANP_TYPE_STREAM);
+    danp_socket_t *client = danp_socket(DANP_TYPE_STREAM);
+    uint32_t sent = 0;
+
+    danp_bind(server, ports->server);
+    danp_listen(server, 1);
+    osalThreadCreate(stream_sink_task, server, &thread_attr);
+
+    danp_bind(client, ports->client);
+    if (danp_connect(client, BENCH_NODE_ID, ports->server) != 0)
+    {
+        printf("%-5s connect failed\n", label);
+        return;
+    }
+
+    sink_bytes = 0;
+    uint32_t start_ms = osalGetTickMs();
+    while (sent < BENCH_TOTAL_BYTES)
+    {
+        int32_t ret = danp_send(client, chunk, BENCH_CHUNK_BYTES);
+        if (ret <= 0)
+        {
+            printf("%-5s send failed after %u bytes\n", label, sent);
+            break;
+        }
+        sent += (uint32_t)ret;
+    }
+    danp_flush(client);
+    while (sink_bytes < sent)
+    {
+        osalDelayMs(1);
+    }
+    uint32_t elapsed_ms = osalGetTickMs() - start_ms;
+
+    printf("%-5s stream bulk   %8u bytes in %6u ms: %9.1f KiB/s\n",
+        label,
+        sent,
+        elapsed_ms,
+        (elapsed_ms > 0) ? ((double)sent / 1024.0) * 1000.0 / (double)elapsed_ms : 0.0);
+
+    danp_close(client);
+}
+
+int main(void)
+{
+    danp_config_t config = {
+        .local_node = BENCH_NODE_ID,
+        .log_function = bench_log,
+    };
+    danp_udp_config_t udp_config = {
+        .name = "udp",
+        .address = BENCH_NODE_ID,
+        .bind_host = "127.0.0.1",
+        .bind_port = 0,
+        .rx_threads = 1,
+    };
+    const bench_ports_t udp_ports = {10, 11, 12, 13};
+
+    danp_init(&config);
+
+    for (uint32_t i = 0; i < sizeof(chunk); i++)
+    {
+        chunk[i] = (uint8_t)i;
+    }
+
+    // Each driver sends node 1's traffic back to itself through the kernel.
+    if (danp_udp_init(&udp_iface, &udp_config) != 0)
+    {
+        printf("udp init failed\n");
+        return 1;
+    }
+    danp_udp_add_peer(&udp_iface, BENCH_NODE_ID, "127.0.0.1", udp_iface.bound_port);
+    danp_register_interface(&udp_iface);
+    danp_route_table_load("1:udp");
+
+    run_dgram("udp", &udp_ports);
+    run_stream("udp", &udp_ports);
+    printf("udp   %u datagrams in %u sendmmsg calls, %u in %u recvmmsg calls, %u dropped\n",
+        udp_iface.stats.tx_packets,
+        udp_iface.stats.tx_batches,
+        udp_iface.stats.rx_packets,
+        udp_iface.stats.rx_batches,
+        udp_iface.stats.tx_drops);
+
+#ifdef DANP_URING_SUPPORT
+    // The same socket work, done by one io_uring loop instead of dedicated threads.
+    danp_udp_config_t uring_config = udp_config;
+    const bench_ports_t uring_ports = {30, 31, 32, 33};
+
+    uring_config.name = "uring";
+    uring_config.uring = &uring_loop;
+    if (danp_uring_init(&uring_loop) != 0 || danp_udp_init(&uring_iface, &uring_config) != 0)
+    {
+        printf("uring skipped: io_uring unavailable\n");
+    }
+    else
+    {
+        danp_udp_add_peer(&uring_iface, BENCH_NODE_ID, "127.0.0.1", uring_iface.bound_port);
+        danp_register_interface(&uring_iface);
+        danp_route_table_load("1:uring");
+
+        run_dgram("uring", &uring_ports);
+        run_stream("uring", &uring_ports);
+        printf("uring %u frames sent, %u received, %u io_uring_enter calls, %u receive re-arms\n",
+            uring_loop.stats.tx_packets,
+            uring_loop.stats.rx_packets,
+            uring_loop.stats.enters,
+            uring_loop.stats.rx_rearms);
+    }
+#else
+    printf("uring skipped: built without DANP_URING_SUPPORT\n");
+#endif
+
+#ifdef DANP_ZMQ_SUPPORT
+    const char *zmq_peers[] = {BENCH_ZMQ_ENDPOINT};
+    const bench_ports_t zmq_ports = {20, 21, 22, 23};
+
+    danp_zmq_init(&zmq_iface, BENCH_ZMQ_ENDPOINT, zmq_peers, 1, BENCH_NODE_ID);
+    zmq_iface.common.name = "zmq";
+    danp_register_interface(&zmq_iface);
+    danp_route_table_load("1:zmq");
+    // Let the subscription reach the publisher before measuring.
+    osalDelayMs(200);
+
+    run_dgram("zmq", &zmq_ports);
+    run_stream("zmq", &zmq_ports);
+    printf("zmq   %u frames sent from spare pool packets, %u copied by ZMQ, %u dropped; %u received, %u dropped\n",
+        zmq_iface.stats.tx_pool_frames,
+        zmq_iface.stats.tx_copied,
+        zmq_iface.stats.tx_drops,
+        zmq_iface.stats.rx_packets,
+        zmq_iface.stats.rx_drops);
+
+    // Same link with frames to one node coalesced into bundles.
+    const bench_ports_t zmq_agg_ports = {24, 25, 26, 27};
+    danp_zmq_set_aggregation(&zmq_iface, DANP_ZMQ_AGG_MAX_BYTES, 200);
+    run_dgram("zmq+a", &zmq_agg_ports);
+    run_stream("zmq+a", &zmq_agg_ports);
+    printf("zmq+a %u frames in %u bundles; %u bundles received\n",
+        zmq_iface.stats.tx_bundled,
+        zmq_iface.stats.tx_bundles,
+        zmq_iface.stats.rx_bundles);
+    danp_zmq_shutdown();
+#else
+    printf("zmq   skipped: built without DANP_ZMQ_SUPPORT\n");
+#endif
+
+    return 0;
+}
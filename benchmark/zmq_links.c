@@ -0,0 +1,169 @@
+/* zmq_links.c - threads and one-way latency of the ZMQ driver as links are added */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/danp.h"
+#include "danp/drivers/danp_zmq.h"
+#include "osal/osal.h"
+#include <dirent.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#define BENCH_NODE_ID       (1U)
+#define BENCH_TX_PORT       (10U)
+#define BENCH_RX_PORT       (11U)
+#define BENCH_SAMPLES       (2000U)
+#define BENCH_PAYLOAD_BYTES (32U)
+#define BENCH_BASE_TCP_PORT (5620U)
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static danp_zmq_interface_t links[DANP_ZMQ_MAX_INTERFACES];
+static char link_names[DANP_ZMQ_MAX_INTERFACES][8];
+static char link_endpoints[DANP_ZMQ_MAX_INTERFACES][32];
+static uint32_t samples_us[BENCH_SAMPLES];
+
+/* Functions */
+
+static void bench_log(danp_log_level_t level, const char *func_name, const char *message, va_list args)
+{
+    if (level < DANP_LOG_ERROR)
+    {
+        return;
+    }
+    printf("[%s] ", func_name);
+    vprintf(message, args);
+    printf("\n");
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t count_threads(void)
+{
+    uint32_t count = 0;
+    DIR *dir = opendir("/proc/self/task");
+    struct dirent *entry = NULL;
+
+    if (dir == NULL)
+    {
+        return 0;
+    }
+    while ((entry = readdir(dir)) != NULL)
+    {
+        count += (entry->d_name[0] != '.') ? 1U : 0U;
+    }
+    closedir(dir);
+
+    return count;
+}
+
+/**
+ * @brief Time datagrams from one socket to another over the newest link while the others idle.
+ */
+static void measure(uint32_t link_count, uint32_t base_threads, danp_socket_t *tx, danp_socket_t *rx)
+{
+    uint8_t payload[BENCH_PAYLOAD_BYTES];
+    uint8_t received[DANP_MAX_PACKET_SIZE];
+    char route[16];
+    uint32_t done = 0;
+
+    snprintf(route, sizeof(route), "%u:%s", BENCH_NODE_ID, link_names[link_count - 1]);
+    danp_route_table_load(route);
+    memset(payload, 0x5A, sizeof(payload));
+
+    // Let the subscription reach the publisher before measuring.
+    do
+    {
+        danp_send_to(tx, payload, sizeof(payload), BENCH_NODE_ID, BENCH_RX_PORT);
+    } while (danp_recv(rx, received, sizeof(received), 100) <= 0);
+
+    while (done < BENCH_SAMPLES)
+    {
+        uint64_t start_ns = now_ns();
+        danp_send_to(tx, payload, sizeof(payload), BENCH_NODE_ID, BENCH_RX_PORT);
+        if (danp_recv(rx, received, sizeof(received), 1000) <= 0)
+        {
+            printf("%u links: datagram lost after %u samples\n", link_count, done);
+            break;
+        }
+        samples_us[done++] = (uint32_t)((now_ns() - start_ns) / 1000U);
+    }
+    if (done == 0)
+    {
+        return;
+    }
+
+    qsort(samples_us, done, sizeof(samples_us[0]), compare_u32);
+    printf(
+        "%u links: %u driver threads, one-way %u B median %u us, p99 %u us\n",
+        link_count,
+        count_threads() - base_threads,
+        (uint32_t)BENCH_PAYLOAD_BYTES,
+        samples_us[done / 2],
+        samples_us[(done * 99U) / 100U]);
+}
+
+int main(void)
+{
+    danp_config_t config = {
+        .local_node = BENCH_NODE_ID,
+        .log_function = bench_log,
+    };
+
+    danp_init(&config);
+    danp_socket_t *tx = danp_socket(DANP_TYPE_DGRAM);
+    danp_socket_t *rx = danp_socket(DANP_TYPE_DGRAM);
+    danp_bind(tx, BENCH_TX_PORT);
+    danp_bind(rx, BENCH_RX_PORT);
+
+    // ZMQ's own I/O thread is counted with the driver's.
+    uint32_t base_threads = count_threads();
+    for (uint32_t i = 0; i < DANP_ZMQ_MAX_INTERFACES; i++)
+    {
+        const char *peers[1];
+
+        snprintf(link_names[i], sizeof(link_names[i]), "zmq%u", i);
+        snprintf(link_endpoints[i], sizeof(link_endpoints[i]), "tcp://127.0.0.1:%u", BENCH_BASE_TCP_PORT + i);
+        peers[0] = link_endpoints[i];
+
+        // Every link loops back to itself, so each one carries node 1's traffic when routed.
+        danp_zmq_init(&links[i], link_endpoints[i], peers, 1, BENCH_NODE_ID);
+        links[i].common.name = link_names[i];
+        danp_register_interface(&links[i]);
+        measure(i + 1U, base_threads, tx, rx);
+    }
+
+    danp_zmq_shutdown();
+    printf("after shutdown: %u driver threads\n", count_threads() - base_threads);
+
+    return 0;
+}
@@ -28,6 +28,11 @@ extern "C"
 
 /* Configurations */
 
+/** @brief Threads that can block in danp_poll() at the same time. */
+#ifndef DANP_POLL_MAX_WAITERS
+#define DANP_POLL_MAX_WAITERS 4
+#endif
+
 /* Definitions */
 
 /** @brief Maximum size of a DANP packet payload in bytes. */
@@ -45,15 +50,96 @@ extern "C"
 /** @brief Acknowledgment timeout in milliseconds. */
 #define DANP_ACK_TIMEOUT_MS 500
 
+/** @brief Maximum time a STREAM receiver holds back a standalone ACK, in milliseconds. */
+#define DANP_ACK_DELAY_MS 20
+
+/** @brief Number of in-order segments after which a delayed ACK is sent without waiting. */
+#define DANP_ACK_COALESCE_COUNT 2
+
+/** @brief Maximum number of STREAM segments queued or in flight per socket (a power of two). */
+#define DANP_STREAM_TX_WINDOW 4
+
+/** @brief Size of the versioned (v2) STREAM transport header at the start of the payload. */
+#define DANP_STREAM_HEADER_SIZE 7
+
+/** @brief Packets the socket layer can hold for transmission until it has released its locks. */
+#define DANP_TX_BACKLOG_SIZE 16
+
+/** @brief Lower bound of the STREAM retransmission timeout in milliseconds. */
+#define DANP_RTO_MIN_MS 100
+
+/** @brief Upper bound of the STREAM retransmission timeout in milliseconds. */
+#define DANP_RTO_MAX_MS 8000
+
+/** @brief Congestion window of a new STREAM connection, in segments. */
+#define DANP_CWND_INITIAL 2
+
+/** @brief Number of duplicate ACKs that trigger a fast retransmission. */
+#define DANP_DUPACK_THRESHOLD 3
+
+/** @brief Idle time after which a STREAM connection with keepalive enabled sends its first probe, in milliseconds. */
+#define DANP_KEEPALIVE_IDLE_MS 30000
+
+/** @brief Time between unanswered keepalive probes in milliseconds. */
+#define DANP_KEEPALIVE_INTERVAL_MS 5000
+
+/** @brief Unanswered keepalive probes after which the connection is reset. */
+#define DANP_KEEPALIVE_COUNT 3
+
+/** @brief Time a closed STREAM connection may take to finish its shutdown before it is reset, in milliseconds. */
+#define DANP_CLOSE_TIMEOUT_MS 10000
+
+/** @brief Time a connection that closed first keeps its port and peer reserved (TIME_WAIT), in milliseconds. */
+#define DANP_TIME_WAIT_MS 2000
+
+/** @brief Closed connections the socket layer remembers in TIME_WAIT; the oldest is forgotten first. */
+#define DANP_TIME_WAIT_SLOTS 8
+
+/** @brief DANP_SO_LINGER value for a danp_close() that returns at once and finishes the shutdown in the background. */
+#define DANP_LINGER_OFF 0xFFFFFFFFU
+
+/** @brief Depth of the per-socket receive queue (datagrams on DGRAM sockets, wake-ups on STREAM sockets). */
+#define DANP_RX_QUEUE_SIZE 10
+
+/** @brief Size of the STREAM receive byte ring of a connection. */
+#define DANP_STREAM_RX_BUFFER_SIZE 1024
+
+/** @brief STREAM receive rings shared by all connections; a connection holds one from connect or SYN until it is closed. */
+#define DANP_STREAM_RX_RING_COUNT 8
+
+/** @brief Pending connections a listener holds when danp_listen() is given no backlog. */
+#define DANP_LISTEN_BACKLOG_DEFAULT 5
+
 /** @brief Maximum number of supported ports. */
 #define DANP_MAX_PORTS 64
 
 /** @brief Maximum number of supported nodes. */
 #define DANP_MAX_NODES 256
 
+/** @brief Node address that reaches every node of a link; carries DGRAM traffic only. */
+#define DANP_BROADCAST_NODE 0xFF
+
+/** @brief First multicast group address; no node may use a group address as its own. */
+#define DANP_MULTICAST_FIRST 0xF0
+
+/** @brief Last multicast group address. */
+#define DANP_MULTICAST_LAST 0xFE
+
+/** @brief Number of multicast groups. */
+#define DANP_MULTICAST_COUNT (DANP_MULTICAST_LAST - DANP_MULTICAST_FIRST + 1)
+
+/** @brief True for the broadcast address and the multicast groups. */
+#define DANP_NODE_IS_GROUP(node) ((node) >= DANP_MULTICAST_FIRST && (node) <= DANP_BROADCAST_NODE)
+
 /** @brief Constant for infinite wait. */
 #define DANP_WAIT_FOREVER 0xFFFFFFFFU
 
+/** @brief Error returned by a call on a non-blocking socket that would have to wait. */
+#define DANP_ERR_WOULD_BLOCK (-2)
+
+/** @brief Error returned by a non-blocking danp_connect() once the handshake is under way. */
+#define DANP_ERR_IN_PROGRESS (-3)
+
 /** @brief High priority for packets. */
 #define DANP_PRIORITY_HIGH 1
 
@@ -96,6 +182,60 @@ typedef enum danp_socket_type_e
     DANP_TYPE_STREAM = 1 /**< Reliable (RDP/TCP-like). */
 } danp_socket_type_t;
 
+/**
+ * @brief STREAM transport header versions, negotiated per connection at SYN time.
+ *
+ * A v2 header is [version|options][seq:16][ack:16][window:16], big endian.
+ * Legacy peers send an empty SYN and get the v1 format: a single sequence
+ * byte, no window and one segment in flight.
+ */
+typedef enum danp_stream_version_e
+{
+    DANP_STREAM_V1 = 1, /**< Legacy 8-bit sequence number in payload[0]. */
+    DANP_STREAM_V2 = 2  /**< 16-bit sequence and ACK numbers, window and option bits. */
+} danp_stream_version_t;
+
+/**
+ * @brief Socket options, see danp_setsockopt().
+ */
+typedef enum danp_socket_option_e
+{
+    DANP_SO_SEND_WAIT_ACK = 0, /**< STREAM: danp_send() returns once its data is acknowledged (default 0: once queued). */
+    DANP_SO_NODELAY = 1,       /**< STREAM: send small writes at once (default 1); 0 coalesces them while data is unacknowledged. */
+    DANP_SO_NONBLOCK = 2,      /**< Calls return DANP_ERR_WOULD_BLOCK instead of waiting (default 0). */
+    DANP_SO_KEEPALIVE = 3,     /**< STREAM: probe idle connections and reset them when the peer is gone (default 0). */
+    DANP_SO_KEEPIDLE = 4,      /**< STREAM: idle time before the first probe, in ms (default DANP_KEEPALIVE_IDLE_MS). */
+    DANP_SO_KEEPINTVL = 5,     /**< STREAM: time between unanswered probes, in ms (default DANP_KEEPALIVE_INTERVAL_MS). */
+    DANP_SO_KEEPCNT = 6,       /**< STREAM: unanswered probes before the reset (default DANP_KEEPALIVE_COUNT). */
+    DANP_SO_LINGER = 7,        /**< STREAM: how long danp_close() waits for queued data to be acknowledged, in ms;
+                                    0 resets the connection (default DANP_LINGER_OFF: do not wait). */
+    DANP_SO_JOIN_GROUP = 8,    /**< DGRAM: also receive datagrams sent to multicast group value (set only). */
+    DANP_SO_LEAVE_GROUP = 9    /**< DGRAM: stop receiving datagrams sent to multicast group value (set only). */
+} danp_socket_option_t;
+
+/**
+ * @brief Socket events reported to the callback set with danp_socket_set_callback().
+ */
+typedef enum danp_socket_event_e
+{
+    DANP_EVENT_DATA_READY = 0, /**< Data arrived and can be read, or the peer finished sending. */
+    DANP_EVENT_ACCEPT = 1,     /**< A listening socket has a connection to accept. */
+    DANP_EVENT_CONNECTED = 2,  /**< The STREAM handshake completed. */
+    DANP_EVENT_WRITABLE = 3,   /**< ACKs made room in a send window that was full. */
+    DANP_EVENT_RESET = 4       /**< The connection was reset, timed out or could not be set up. */
+} danp_socket_event_t;
+
+/**
+ * @brief Readiness events reported by danp_poll().
+ */
+typedef enum danp_poll_event_e
+{
+    DANP_POLLIN = 0x01,     /**< Data can be read (or a STREAM connection has ended). */
+    DANP_POLLOUT = 0x02,    /**< danp_send() can queue data without blocking. */
+    DANP_POLLACCEPT = 0x04, /**< A listening socket has a connection to accept. */
+    DANP_POLLERR = 0x08     /**< The STREAM connection was reset; always reported. */
+} danp_poll_event_t;
+
 /**
  * @brief Socket states.
  */
@@ -106,15 +246,42 @@ typedef enum danp_socket_state_e
     DANP_SOCK_LISTENING, /**< Socket is waiting for incoming connections (STREAM). */
     DANP_SOCK_SYN_SENT,  /**< Connection initiated, waiting for SYN-ACK (STREAM). */
     DANP_SOCK_SYN_RECEIVED, /**< SYN received, waiting for final ACK (STREAM). */
-    DANP_SOCK_ESTABLISHED   /**< Connection established (STREAM) or Default Peer Set (DGRAM). */
+    DANP_SOCK_ESTABLISHED,  /**< Connection established (STREAM) or Default Peer Set (DGRAM). */
+    DANP_SOCK_FIN_WAIT,     /**< We finished sending; the peer may still send (STREAM). */
+    DANP_SOCK_CLOSE_WAIT,   /**< The peer finished sending; we may still send (STREAM). */
+    DANP_SOCK_LAST_ACK      /**< Both sides finished sending; waiting for our FIN to be acknowledged (STREAM). */
 } danp_socket_state_t;
 
+/**
+ * @brief Congestion signals reported by the transport to the congestion controller.
+ */
+typedef enum danp_congestion_event_e
+{
+    DANP_CONGESTION_DUPACK = 0, /**< Loss inferred from duplicate ACKs (fast retransmit). */
+    DANP_CONGESTION_TIMEOUT     /**< Retransmission timeout expired. */
+} danp_congestion_event_t;
+
+/**
+ * @brief Protocol timers of a socket, serviced by the timer thread or danp_timer_tick().
+ */
+typedef enum danp_timer_id_e
+{
+    DANP_TIMER_RTO = 0, /**< Retransmission, zero-window persist and SYN retry. */
+    DANP_TIMER_ACK,     /**< Delayed ACK. */
+    DANP_TIMER_KEEPALIVE, /**< Idle connection probing. */
+    DANP_TIMER_CLOSE,   /**< Bound on the shutdown of a closed connection. */
+    DANP_TIMER_COUNT    /**< Number of timers per socket. */
+} danp_timer_id_t;
+
 /** @brief Handle for an OS queue. */
 typedef osalMessageQueueHandle_t danp_os_queue_handle_t;
 
 /** @brief Handle for an OS semaphore. */
 typedef osalSemaphoreHandle_t danp_os_semaphore_handle_t;
 
+/** @brief Handle for an OS mutex. */
+typedef osalMutexHandle_t danp_os_mutex_handle_t;
+
 /* Header Packing Details (omitted for brevity) */
 
 /**
@@ -129,6 +296,65 @@ typedef struct danp_packet_s
     struct danp_interface_s *rx_interface;   /**< Interface where the packet was received. */
 } danp_packet_t;
 
+/**
+ * @brief A STREAM segment held by the sender until it is acknowledged.
+ */
+typedef struct danp_stream_segment_s
+{
+    danp_packet_t *pkt;   /**< Queued packet, NULL if the slot is free. */
+    uint32_t sent_ms;     /**< Tick of the last (re)transmission. */
+    bool retransmitted;   /**< Segment was sent more than once (no RTT sample, Karn). */
+    bool push;            /**< Segment is closed to coalescing and sent as soon as the window allows. */
+    bool fin;             /**< Segment carries no data but the end of the stream. */
+} danp_stream_segment_t;
+
+struct danp_socket_s;
+
+/**
+ * @brief Socket event callback.
+ *
+ * Invoked from the input path or the socket timer with the socket locked. It
+ * may call socket functions on non-blocking sockets but must not block, and
+ * must not create or close sockets.
+ *
+ * @param sock Socket the event occurred on.
+ * @param event Event that occurred.
+ * @param user_data Pointer given to danp_socket_set_callback().
+ */
+typedef void (*danp_socket_callback_t)(struct danp_socket_s *sock, danp_socket_event_t event, void *user_data);
+
+/**
+ * @brief Congestion controller operations.
+ *
+ * A controller owns the cwnd and ssthresh fields of a STREAM socket. All
+ * callbacks are invoked with the socket layer lock held and must not block.
+ */
+typedef struct danp_congestion_ops_s
+{
+    const char *name; /**< Name of the controller, for diagnostics. */
+
+    /**
+     * @brief Initialise congestion state of a new connection.
+     * @param sock Pointer to the socket.
+     */
+    void (*init)(struct danp_socket_s *sock);
+
+    /**
+     * @brief New data was acknowledged.
+     * @param sock Pointer to the socket.
+     * @param acked Number of segments newly acknowledged.
+     * @param rtt_ms Round trip time sample, or negative if none was taken.
+     */
+    void (*on_ack)(struct danp_socket_s *sock, uint16_t acked, int32_t rtt_ms);
+
+    /**
+     * @brief A loss was detected.
+     * @param sock Pointer to the socket.
+     * @param event How the loss was detected.
+     */
+    void (*on_loss)(struct danp_socket_s *sock, danp_congestion_event_t event);
+} danp_congestion_ops_t;
+
 /**
  * @brief Structure representing a DANP socket.
  */
@@ -143,18 +369,116 @@ typedef struct danp_socket_s
     uint16_t remote_node; /**< Remote node address. */
     uint16_t remote_port; /**< Remote port number. */
 
-    // Reliability State (Stop-and-Wait)
-    uint8_t tx_seq;         /**< Transmit sequence number. */
-    uint8_t rx_expected_seq; /**< Expected receive sequence number. */
-
-    // RTOS Handles
-    danp_os_queue_handle_t rx_queue;     /**< Queue for received packets. */
-    danp_os_queue_handle_t accept_queue; /**< Queue for accepted connections. */
-    danp_os_semaphore_handle_t signal;  /**< Semaphore for signaling. */
+    // Reliability State (Sliding Window)
+    danp_stream_version_t version; /**< Transport header version negotiated with the peer. */
+    uint16_t tx_seq;         /**< Sequence number of the next new segment. */
+    uint16_t rx_expected_seq; /**< Expected receive sequence number. */
+    uint16_t snd_una;        /**< Oldest unacknowledged sequence number. */
+    uint16_t snd_nxt;        /**< Next sequence number to (re)transmit. */
+    uint16_t snd_max;        /**< Highest sequence number transmitted so far, plus one. */
+    uint8_t dupack_count;   /**< Consecutive duplicate ACKs received. */
+    uint8_t retries;        /**< Consecutive retransmission timeouts. */
+    uint32_t rto_ms;        /**< Current retransmission timeout. */
+    uint32_t srtt_ms;       /**< Smoothed round trip time, 0 until the first sample. */
+    uint32_t rttvar_ms;     /**< Round trip time variation. */
+    danp_stream_segment_t tx_queue[DANP_STREAM_TX_WINDOW]; /**< Unacknowledged segments, by sequence. */
+    uint16_t tx_mss;        /**< Payload of a full-sized segment on the current route. */
+
+    // Congestion Control
+    const danp_congestion_ops_t *cc_ops; /**< Congestion controller of the connection. */
+    uint16_t cwnd;          /**< Congestion window in segments. */
+    uint16_t ssthresh;      /**< Slow start threshold in segments. */
+    uint16_t cwnd_count;    /**< Acknowledged segments counted towards the next cwnd increase. */
+
+    // Flow Control
+    uint16_t peer_wnd;          /**< Receive window last advertised by the peer, in segments. */
+    uint16_t rx_wnd_advertised; /**< Receive window carried by the last ACK sent. */
+
+    // Receive Buffer
+    uint8_t *rx_buf;            /**< Ring of in-order STREAM bytes not yet read, NULL unless the socket is a connection. */
+    uint16_t rx_head;           /**< Index of the next byte to read from rx_buf. */
+    uint16_t rx_count;          /**< Number of bytes held in rx_buf. */
+
+    // Delayed ACK State
+    bool ack_pending;          /**< An ACK is owed to the peer but has not been sent yet. */
+    uint16_t ack_seq;          /**< Sequence number carried by the pending ACK. */
+    uint8_t ack_unsent_count;  /**< In-order segments received since the last ACK was sent. */
+
+    // Protocol Timers
+    uint8_t timers_armed;                         /**< One bit per running danp_timer_id_t. */
+    uint32_t timer_deadline_ms[DANP_TIMER_COUNT]; /**< Tick at which each running timer expires. */
+
+    // Options
+    bool send_wait_ack;         /**< danp_send() waits until its data is acknowledged. */
+    bool coalesce;              /**< Small writes are merged while data is unacknowledged (DANP_SO_NODELAY off). */
+    bool nonblock;              /**< Calls return DANP_ERR_WOULD_BLOCK instead of waiting. */
+
+    // Keepalive
+    bool keepalive;                 /**< Idle connections are probed (DANP_SO_KEEPALIVE). */
+    uint8_t keepalive_count;        /**< Unanswered probes before the connection is reset. */
+    uint8_t keepalive_probes;       /**< Probes sent since the peer was last heard from. */
+    uint32_t keepalive_idle_ms;     /**< Idle time before the first probe. */
+    uint32_t keepalive_interval_ms; /**< Time between unanswered probes. */
+    uint32_t last_rx_ms;            /**< Tick at which the peer was last heard from. */
+
+    // Shutdown
+    uint32_t linger_ms; /**< How danp_close() ends the connection (DANP_SO_LINGER). */
+    bool fin_pending;   /**< Sending was shut down, but the FIN waits for room in the send window. */
+    bool peer_fin;      /**< The peer finished sending; reads return 0 once rx_buf is empty. */
+    bool orphan;        /**< Closed by the application; the slot is freed once the shutdown completes. */
+    bool time_wait;     /**< Closed first, so freeing the slot leaves a TIME_WAIT entry. */
+
+    // Event Callback
+    danp_socket_callback_t event_cb; /**< Called on socket events, NULL if unset. */
+    void *event_cb_data;             /**< User pointer passed to event_cb. */
+
+    // Readiness
+    uint8_t rx_pending;         /**< Datagrams waiting in rx_queue. */
+
+    // Multicast
+    uint16_t groups;            /**< Groups joined, bit n for DANP_MULTICAST_FIRST + n (DGRAM). */
+
+    // Listen Backlog
+    struct danp_socket_s *accept_head; /**< Oldest connection waiting to be accepted (listeners). */
+    struct danp_socket_s *accept_next; /**< Next connection in the same listener's backlog. */
+    struct danp_socket_s *listener;    /**< Listener whose backlog holds this connection until it is accepted. */
+    uint16_t backlog;                  /**< Maximum number of connections waiting to be accepted (listeners). */
+    uint16_t accept_pending;           /**< Connections waiting to be accepted (listeners). */
+    uint32_t syn_overflows;            /**< SYNs refused because the backlog, the socket pool or the receive rings were full (listeners). */
+
+    // RTOS Handles (created when the slot first needs them, then kept for reuse)
+    danp_os_queue_handle_t rx_queue;     /**< Queue for received packets (DGRAM) or receive wake-ups (STREAM connections). */
+    danp_os_semaphore_handle_t signal;  /**< Semaphore for signaling (send window, handshake, accept). */
+    danp_os_mutex_handle_t lock;        /**< Guards the connection state of this socket. */
 
     struct danp_socket_s *next; /**< Pointer to the next socket in the list. */
 } danp_socket_t;
 
+/**
+ * @brief A socket and the events danp_poll() should wait for on it.
+ */
+typedef struct danp_pollfd_s
+{
+    danp_socket_t *sock; /**< Socket to watch. */
+    uint8_t events;      /**< Requested danp_poll_event_t flags. */
+    uint8_t revents;     /**< Events that are ready, set by danp_poll(). */
+} danp_pollfd_t;
+
+/**
+ * @brief RAM and OS objects used by the socket layer, see danp_socket_get_footprint().
+ */
+typedef struct danp_socket_footprint_s
+{
+    uint32_t pool_bytes;          /**< Static size of the socket pool. */
+    uint32_t rx_ring_bytes;       /**< Static size of the STREAM receive rings. */
+    uint32_t tx_backlog_bytes;    /**< Static size of the transmit backlog. */
+    uint32_t static_bytes;        /**< All static RAM of the socket layer, the figures above included. */
+    uint16_t queues;              /**< OS message queues created so far. */
+    uint16_t semaphores;          /**< OS semaphores created so far. */
+    uint16_t mutexes;             /**< OS mutexes created so far for socket locks. */
+    uint32_t queue_storage_bytes; /**< Item storage held by the created queues. */
+} danp_socket_footprint_t;
+
 /**
  * @brief Structure representing a network interface.
  */
@@ -172,6 +496,20 @@ typedef struct danp_interface_s
      */
     int32_t (*tx_func)(void *iface_common, danp_packet_t *packet);
 
+    /**
+     * @brief Function pointer to start or stop receiving a multicast group; NULL if the link delivers all.
+     *
+     * Called when the first socket of the node joins a group and when the last one
+     * leaves it, and on registration for the groups joined so far. Broadcasts are
+     * always received.
+     *
+     * @param iface Pointer to the interface.
+     * @param group Group address, DANP_MULTICAST_FIRST to DANP_MULTICAST_LAST.
+     * @param join true to start receiving the group, false to stop.
+     * @return 0 on success, negative on error.
+     */
+    int32_t (*group_func)(void *iface_common, uint16_t group, bool join);
+
     struct danp_interface_s *next; /**< Pointer to the next interface in the list. */
 } danp_interface_t;
 
@@ -195,6 +533,7 @@ typedef struct danp_config_s
 {
     uint16_t local_node;                  /**< Local node address. */
     danp_log_function_callback log_function; /**< Logging callback function. */
+    bool external_timer_tick;             /**< The application calls danp_timer_tick(); no timer thread is started. */
 } danp_config_t;
 
 /* External Declarations */
@@ -253,11 +592,34 @@ void danp_log_message_handler(danp_log_level_t level, const char *func_name, con
 
 /**
  * @brief Route a packet for transmission.
+ *
+ * A packet for the broadcast address or a multicast group without a route of
+ * its own leaves once on every registered interface, whose link fans it out.
+ *
  * @param packet Pointer to the packet to route.
  * @return 0 on success, negative on error.
  */
 int32_t danp_route_tx(danp_packet_t *packet);
 
+/**
+ * @brief Count a socket of this node joining or leaving a multicast group.
+ *
+ * Registered interfaces are told through their group_func when the group gains
+ * its first member or loses its last one.
+ *
+ * @param group Group address, DANP_MULTICAST_FIRST to DANP_MULTICAST_LAST.
+ * @param join true when a socket joins, false when it leaves.
+ * @return 0 on success, negative if the group is invalid or has no member to remove.
+ */
+int32_t danp_route_group_update(uint16_t group, bool join);
+
+/**
+ * @brief Get the largest payload that can be routed to a node.
+ * @param dst_node Destination node address.
+ * @return Payload size in bytes, or 0 if there is no route to the node.
+ */
+uint16_t danp_route_get_max_payload(uint16_t dst_node);
+
 /**
  * @brief Load a static routing table from a string.
  *
@@ -277,6 +639,32 @@ int32_t danp_route_table_load(const char *table);
  */
 void danp_input(danp_interface_t *iface, uint8_t *data, uint16_t length);
 
+/**
+ * @brief Process a packet an interface has already placed in a pool buffer.
+ *
+ * Zero-copy counterpart of danp_input() for drivers that receive straight into
+ * packets from danp_buffer_allocate(). The stack takes ownership of the packet
+ * and frees it once consumed or dropped, so the driver must not touch it after
+ * the call.
+ *
+ * @param iface Pointer to the interface receiving the packet.
+ * @param pkt Packet with header_raw, length and payload filled in.
+ */
+void danp_input_packet(danp_interface_t *iface, danp_packet_t *pkt);
+
+/**
+ * @brief Process several pool packets an interface received together.
+ *
+ * Entry point for drivers that unpack many frames from one read, such as
+ * aggregated messages. Packets are delivered in array order and the stack takes
+ * ownership of all of them, exactly as with danp_input_packet().
+ *
+ * @param iface Pointer to the interface receiving the packets.
+ * @param pkts Packets with header_raw, length and payload filled in.
+ * @param count Number of packets in pkts.
+ */
+void danp_input_burst(danp_interface_t *iface, danp_packet_t **pkts, uint32_t count);
+
 /**
  * @brief Allocate a packet from the pool.
  * @return Pointer to the allocated packet, or NULL if pool is empty.
@@ -320,23 +708,59 @@ int32_t danp_bind(danp_socket_t *sock, uint16_t port);
 
 /**
  * @brief Listen for incoming connections on a socket.
+ *
+ * Up to backlog connections are held until danp_accept() takes them. A SYN
+ * arriving while the backlog is full, or while no socket slot or STREAM
+ * receive ring is free, is dropped without a reply and counted in
+ * syn_overflows, so the peer can try again later.
+ *
  * @param sock Pointer to the socket.
- * @param backlog Maximum number of pending connections (currently unused).
+ * @param backlog Maximum number of pending connections (0 or less for DANP_LISTEN_BACKLOG_DEFAULT).
  * @return 0 on success, negative on error.
  */
 int32_t danp_listen(danp_socket_t *sock, int backlog);
 
 /**
  * @brief Close a socket and release resources.
+ *
+ * A v2 STREAM connection is shut down in order: data still queued is
+ * delivered, followed by a FIN, and the library releases the socket once the
+ * peer has acknowledged it and closed its side too, or resets the connection
+ * after DANP_CLOSE_TIMEOUT_MS. The handle must not be used once this returns.
+ * DANP_SO_LINGER decides whether the call waits for the data to be
+ * acknowledged first; with a linger time of 0, and on connections to legacy
+ * peers, the connection is reset at once and unsent data is discarded.
+ *
+ * The side that closes first keeps the port and peer in a small TIME_WAIT
+ * table for DANP_TIME_WAIT_MS, so stray segments of the old connection are
+ * not delivered to a new one and the ephemeral port is not reused meanwhile.
+ *
  * @param sock Pointer to the socket to close.
- * @return 0 on success, negative on error.
+ * @return 0 on success, negative on error or if the linger time passed
+ *         before the peer acknowledged all data (the connection is then reset).
  */
 int32_t danp_close(danp_socket_t *sock); // Added close function
 
+/**
+ * @brief Finish sending on a STREAM connection, but keep receiving.
+ *
+ * Queued data is delivered first, then a FIN tells the peer that no more
+ * follows; its danp_recv() returns 0 once it has read everything. Further
+ * danp_send() calls fail. Requires a peer that speaks the v2 STREAM header.
+ *
+ * @param sock Pointer to the socket.
+ * @return 0 on success, negative if the socket is not connected or the peer is legacy.
+ */
+int32_t danp_shutdown(danp_socket_t *sock);
+
 // Functions updated with timeout_ms
 
 /**
  * @brief Accept a new connection on a listening socket.
+ *
+ * On a non-blocking socket the timeout is ignored and NULL is returned at
+ * once if no connection is pending.
+ *
  * @param server_sock Pointer to the listening socket.
  * @param timeout_ms Timeout in milliseconds.
  * @return Pointer to the new connected socket, or NULL on timeout/error.
@@ -345,29 +769,76 @@ danp_socket_t *danp_accept(danp_socket_t *server_sock, uint32_t timeout_ms);
 
 /**
  * @brief Connect a socket to a remote node and port.
+ *
+ * The SYN is retried until DANP_RETRY_LIMIT attempts have gone unanswered,
+ * waiting DANP_ACK_TIMEOUT_MS after the first and twice as long after each
+ * retry (at most DANP_RTO_MAX_MS). A blocking connect returns once the
+ * handshake completes or the last attempt times out. On a non-blocking STREAM
+ * socket only the first SYN is sent; completion is reported by DANP_POLLOUT
+ * and DANP_EVENT_CONNECTED, failure by DANP_POLLERR and DANP_EVENT_RESET.
+ * A STREAM socket takes one of the DANP_STREAM_RX_RING_COUNT receive rings
+ * and keeps it until it is closed; connecting fails when none is free.
+ *
  * @param sock Pointer to the socket.
  * @param node Remote node address.
  * @param port Remote port number.
- * @return 0 on success, negative on error.
+ * @return 0 on success, DANP_ERR_IN_PROGRESS if a non-blocking handshake was
+ *         started, or negative on error.
  */
 int32_t danp_connect(danp_socket_t *sock, uint16_t node, uint16_t port);
 
 /**
  * @brief Send data over a connected socket.
+ *
+ * For STREAM sockets the buffer may be of any length. It is split into
+ * segments and queued in the send window, blocking only while the window is
+ * full. The call returns once the last segment is queued, or once the peer
+ * has acknowledged all of it when DANP_SO_SEND_WAIT_ACK is set. Queued
+ * segments are transmitted as the congestion window allows and retransmitted
+ * until they are acknowledged or the connection is reset.
+ *
+ * On a non-blocking socket the call queues what fits in the send window and
+ * returns; DANP_SO_SEND_WAIT_ACK is ignored.
+ *
  * @param sock Pointer to the socket.
  * @param data Pointer to the data to send.
  * @param len Length of the data.
- * @return Number of bytes sent, or negative on error.
+ * @return Number of bytes sent, DANP_ERR_WOULD_BLOCK if a non-blocking socket
+ *         could not queue any, or negative on error. A STREAM connection that
+ *         fails or fills up part way through returns the number of bytes
+ *         queued until then.
+ */
+int32_t danp_send(danp_socket_t *sock, void *data, uint32_t len);
+
+/**
+ * @brief Send any data held back by small-write coalescing.
+ *
+ * With DANP_SO_NODELAY cleared, a STREAM socket keeps a trailing segment
+ * smaller than the MSS open while earlier data is unacknowledged, so further
+ * small writes are merged into it. This closes that segment and transmits it
+ * as soon as the send window allows. It does not wait for acknowledgement.
+ *
+ * @param sock Pointer to the socket.
+ * @return 0 on success, negative on error.
  */
-int32_t danp_send(danp_socket_t *sock, void *data, uint16_t len);
+int32_t danp_flush(danp_socket_t *sock);
 
 /**
  * @brief Receive data from a connected socket.
+ *
+ * For STREAM sockets the data is a byte stream: a call returns whatever is
+ * buffered, up to max_len bytes and across segment boundaries, and leaves
+ * the rest for the next call. It blocks only while nothing is buffered,
+ * and returns 0 at once on a STREAM socket that is not connected, or whose
+ * peer has shut down and everything it sent has been read.
+ * On a non-blocking socket the timeout is ignored.
+ *
  * @param sock Pointer to the socket.
  * @param buffer Pointer to the buffer to store received data.
  * @param max_len Maximum length of the buffer.
  * @param timeout_ms Timeout in milliseconds.
- * @return Number of bytes received, or negative on error/timeout.
+ * @return Number of bytes received, DANP_ERR_WOULD_BLOCK if a non-blocking
+ *         socket has nothing buffered, or negative on error/timeout.
  */
 int32_t danp_recv(danp_socket_t *sock, void *buffer, uint16_t max_len, uint32_t timeout_ms);
 
@@ -384,6 +855,10 @@ int32_t danp_send_to(danp_socket_t *sock, void *data, uint16_t len, uint16_t dst
 
 /**
  * @brief Receive data from any source (for DGRAM sockets).
+ *
+ * On a non-blocking socket the timeout is ignored and DANP_ERR_WOULD_BLOCK is
+ * returned if no datagram is queued.
+ *
  * @param sock Pointer to the socket.
  * @param buffer Pointer to the buffer to store received data.
  * @param max_len Maximum length of the buffer.
@@ -400,6 +875,109 @@ int32_t danp_recv_from(
     uint16_t *src_port,
     uint32_t timeout_ms);
 
+// Congestion Control API
+
+/** @brief NewReno-style AIMD congestion controller (the default). */
+extern const danp_congestion_ops_t danp_congestion_newreno;
+
+/**
+ * @brief Select the congestion controller used by new STREAM connections.
+ * @param ops Controller operations, or NULL to restore the NewReno default.
+ */
+void danp_congestion_set_default(const danp_congestion_ops_t *ops);
+
+/**
+ * @brief Get the congestion controller used by new STREAM connections.
+ * @return Pointer to the controller operations.
+ */
+const danp_congestion_ops_t *danp_congestion_get_default(void);
+
+/**
+ * @brief Wait for readiness events on a set of sockets.
+ *
+ * Blocks until at least one socket has a requested event ready, or until the
+ * timeout expires. Readiness is re-evaluated whenever the socket layer
+ * processes input, so one thread can serve many sockets instead of blocking
+ * in danp_recv() or danp_accept() on each of them. DANP_POLLERR is reported
+ * even if it was not requested.
+ *
+ * A call that has to wait takes one of DANP_POLL_MAX_WAITERS waiter slots for
+ * as long as it blocks. If all are taken, it fails with -1 instead of waiting.
+ *
+ * @param fds Array of sockets and requested events; revents is filled in.
+ * @param count Number of entries in fds.
+ * @param timeout_ms Timeout in milliseconds (0 to only check, DANP_WAIT_FOREVER to block).
+ * @return Number of entries with events ready, 0 on timeout, or -1 on error or when
+ *         DANP_POLL_MAX_WAITERS threads are already waiting.
+ */
+int32_t danp_poll(danp_pollfd_t *fds, uint32_t count, uint32_t timeout_ms);
+
+/**
+ * @brief Set a socket option.
+ * @param sock Pointer to the socket.
+ * @param option Option to set.
+ * @param value New value of the option (0/1 for boolean options).
+ * @return 0 on success, negative on error.
+ */
+int32_t danp_setsockopt(danp_socket_t *sock, danp_socket_option_t option, uint32_t value);
+
+/**
+ * @brief Get a socket option.
+ * @param sock Pointer to the socket.
+ * @param option Option to read.
+ * @param value Pointer to store the value of the option.
+ * @return 0 on success, negative on error.
+ */
+int32_t danp_getsockopt(danp_socket_t *sock, danp_socket_option_t option, uint32_t *value);
+
+/**
+ * @brief Register a callback for the events of a socket.
+ *
+ * Connections accepted on a listening socket inherit its callback, user data
+ * and DANP_SO_NONBLOCK setting, so one handler can serve a whole server.
+ *
+ * @param sock Pointer to the socket.
+ * @param callback Function to call, or NULL to remove the callback.
+ * @param user_data Pointer passed to every invocation.
+ * @return 0 on success, negative on error.
+ */
+int32_t danp_socket_set_callback(danp_socket_t *sock, danp_socket_callback_t callback, void *user_data);
+
+/**
+ * @brief Select the congestion controller of a single STREAM socket.
+ *
+ * The controller state of the socket is re-initialised.
+ *
+ * @param sock Pointer to the socket.
+ * @param ops Controller operations, or NULL for the current default.
+ * @return 0 on success, negative on error.
+ */
+int32_t danp_socket_set_congestion(danp_socket_t *sock, const danp_congestion_ops_t *ops);
+
+/**
+ * @brief Report the RAM and OS objects used by the socket layer.
+ *
+ * OS objects are created per socket slot when first needed: a lock for every
+ * socket, a receive queue for DGRAM sockets, a semaphore for listeners, and
+ * a queue and a semaphore for STREAM connections. Objects are never deleted;
+ * a reused slot keeps what it already has.
+ *
+ * @param footprint Filled with the current figures.
+ */
+void danp_socket_get_footprint(danp_socket_footprint_t *footprint);
+
+/**
+ * @brief Service the protocol timers of every socket once.
+ *
+ * Sends delayed ACKs, retransmits unacknowledged segments, probes zero
+ * windows, retries or gives up on handshakes and resets stalled shutdowns. A library thread calls this
+ * whenever the earliest timer is due, unless danp_config_t::external_timer_tick
+ * is set; the application then calls it from its own loop or periodic task,
+ * at least as often as the returned delay asks for.
+ *
+ * @return Milliseconds until the next timer expires, or DANP_WAIT_FOREVER if none is running.
+ */
+uint32_t danp_timer_tick(void);
 
 void danp_print_stats(void (*print_func)(const char *fmt, ...));
 
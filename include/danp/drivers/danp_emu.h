@@ -0,0 +1,127 @@
+/* danp_emu.h - link emulator delaying, dropping, duplicating, reordering and rate-limiting another interface */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_EMU_H
+#define INC_DANP_EMU_H
+
+/* Includes */
+
+#include <stdint.h>
+#include "danp/danp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Configurations */
+
+/** @brief Emulated links that can be initialised in one process. */
+#ifndef DANP_EMU_MAX_INTERFACES
+#define DANP_EMU_MAX_INTERFACES 4
+#endif
+
+/**
+ * @brief Packets one emulated link holds in flight.
+ *
+ * Queued packets are copied into the emulator's own slots, not pool buffers, so a
+ * long delay does not starve the sockets. A full queue drops like a router buffer.
+ */
+#ifndef DANP_EMU_QUEUE_DEPTH
+#define DANP_EMU_QUEUE_DEPTH 64
+#endif
+
+/* Definitions */
+
+/** @brief Probability 1 in the parts-per-million fields of danp_emu_params_t. */
+#define DANP_EMU_PPM 1000000U
+
+/* Types */
+
+/** @brief Impairments applied to every packet sent through an emulated link. */
+typedef struct danp_emu_params_s
+{
+    uint32_t delay_ms;      /**< One-way delay added to every packet. */
+    uint32_t jitter_ms;     /**< Delay varies uniformly by up to this much either way; order is kept. */
+    uint32_t loss_ppm;      /**< Packets lost, in parts per million. */
+    uint32_t duplicate_ppm; /**< Packets sent twice, in parts per million. */
+    uint32_t reorder_ppm;   /**< Packets sent without the delay, overtaking those queued, in parts per million. */
+    uint32_t rate_bps;      /**< Line rate in bit/s for header and payload; 0 for unlimited. */
+    uint32_t seed;          /**< Seed of the random decisions; the same seed repeats the same run. */
+} danp_emu_params_t;
+
+/** @brief Settings for danp_emu_init(). */
+typedef struct danp_emu_config_s
+{
+    const char *name;         /**< Interface name used by the routing table; "EMU" if NULL. */
+    danp_interface_t *lower;  /**< Interface that carries the packets; not registered itself. */
+    danp_emu_params_t params; /**< Initial impairments. */
+} danp_emu_config_t;
+
+/** @brief Traffic counters of an emulated link. */
+typedef struct danp_emu_stats_s
+{
+    uint32_t tx_packets;     /**< Packets offered by the stack. */
+    uint32_t tx_lost;        /**< Packets dropped by loss_ppm. */
+    uint32_t tx_duplicated;  /**< Extra copies queued by duplicate_ppm. */
+    uint32_t tx_reordered;   /**< Packets sent ahead by reorder_ppm. */
+    uint32_t tx_queue_drops; /**< Packets dropped because the queue was full. */
+    uint32_t tx_delivered;   /**< Packets handed to the lower interface. */
+    uint32_t tx_errors;      /**< Packets the lower interface refused. */
+} danp_emu_stats_t;
+
+typedef struct danp_emu_interface_s
+{
+    danp_interface_t common;
+    danp_interface_t *lower; /**< Interface the packets leave on. */
+    danp_emu_stats_t stats;  /**< Traffic counters. */
+    void *context;
+} danp_emu_interface_t;
+
+/* External Declarations */
+
+/**
+ * @brief Put an emulated link in front of an initialised interface.
+ *
+ * Register the emulator instead of the lower interface and route through its name;
+ * the lower driver keeps receiving as before. Each packet is copied into a queue
+ * ordered by release time, and a timer thread hands it to the lower interface when
+ * due, so the impairments apply to the sending direction. Put an emulator in front
+ * of both ends to impair both directions.
+ *
+ * Release times are counted in microseconds on the OSAL millisecond tick: the line
+ * rate holds on average, while single packets leave up to a tick late. Decisions
+ * come from a generator seeded by params.seed, so a run with the same traffic
+ * repeats exactly.
+ *
+ * @param iface Interface to initialise; register it with danp_register_interface() afterwards.
+ * @param config Emulator settings.
+ * @return 0 on success, -1 on invalid settings or when no context is left.
+ */
+extern int32_t danp_emu_init(danp_emu_interface_t *iface, const danp_emu_config_t *config);
+
+/**
+ * @brief Change the impairments of an emulated link.
+ *
+ * Applies to packets sent afterwards; queued ones keep their release time. The
+ * random generator restarts from params->seed.
+ *
+ * @param iface Initialised emulator.
+ * @param params New impairments.
+ * @return 0 on success, -1 on invalid arguments.
+ */
+extern int32_t danp_emu_set_params(danp_emu_interface_t *iface, const danp_emu_params_t *params);
+
+/**
+ * @brief Number of packets waiting in an emulated link.
+ * @param iface Initialised emulator.
+ * @return Queued packets, duplicates included.
+ */
+extern uint32_t danp_emu_pending(danp_emu_interface_t *iface);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_EMU_H */
@@ -16,6 +16,15 @@ extern "C" {
 
 /* Configurations */
 
+/**
+ * @brief Packets the loopback ring can hold in flight; must be a power of two.
+ *
+ * Every queued packet is a pool buffer, so keep this below DANP_POOL_SIZE or the
+ * ring can starve the sockets of buffers.
+ */
+#ifndef DANP_LO_RING_DEPTH
+#define DANP_LO_RING_DEPTH 16
+#endif
 
 /* Definitions */
 
@@ -26,6 +35,7 @@ typedef struct danp_lo_interface_s
 {
     danp_interface_t common;
     void *context;
+    uint32_t tx_drops; /**< Packets dropped because the ring was full or the pool empty. */
 } danp_lo_interface_t;
 
 /* External Declarations */
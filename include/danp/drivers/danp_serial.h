@@ -0,0 +1,119 @@
+/* danp_serial.h - DANP over serial lines (UART, pseudo-terminals) with COBS or KISS framing */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_SERIAL_H
+#define INC_DANP_SERIAL_H
+
+/* Includes */
+
+#include <stdint.h>
+#include "danp/danp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Configurations */
+
+/** @brief Serial interfaces that can be initialised in one process. */
+#ifndef DANP_SERIAL_MAX_INTERFACES
+#define DANP_SERIAL_MAX_INTERFACES 4
+#endif
+
+/** @brief Bytes one read() of the receive thread takes at most. */
+#ifndef DANP_SERIAL_READ_SIZE
+#define DANP_SERIAL_READ_SIZE 256
+#endif
+
+/** @brief Bytes the receive thread lets arrive before it reads the rest of a frame. */
+#ifndef DANP_SERIAL_RX_CHUNK
+#define DANP_SERIAL_RX_CHUNK 32
+#endif
+
+/** @brief Decoded frames handed to the stack together with danp_input_burst(). */
+#ifndef DANP_SERIAL_RX_BURST
+#define DANP_SERIAL_RX_BURST 8
+#endif
+
+/* Definitions */
+
+/** @brief Bytes of the CRC-16/CCITT-FALSE that follows every frame, high byte first. */
+#define DANP_SERIAL_CRC_SIZE 2
+
+/** @brief Longest encoded frame: KISS escapes every byte in the worst case. */
+#define DANP_SERIAL_FRAME_MAX (2 * (DANP_HEADER_SIZE + DANP_MAX_PACKET_SIZE + DANP_SERIAL_CRC_SIZE) + 3)
+
+/* Types */
+
+/** @brief How frames are delimited on the line. */
+typedef enum danp_serial_framing_e
+{
+    DANP_SERIAL_FRAMING_COBS = 0, /**< Consistent Overhead Byte Stuffing, each frame ends with 0x00. */
+    DANP_SERIAL_FRAMING_KISS = 1  /**< KISS data frames on port 0: FEND, command 0x00, escaped bytes, FEND. */
+} danp_serial_framing_t;
+
+/** @brief Settings for danp_serial_init(). */
+typedef struct danp_serial_config_s
+{
+    const char *name;              /**< Interface name used by the routing table; "SERIAL" if NULL. */
+    uint16_t address;              /**< DANP address of the interface. */
+    const char *device;            /**< Device to open, e.g. "/dev/ttyUSB0"; NULL to use fd. */
+    int32_t fd;                    /**< Open terminal (e.g. a pty) used when device is NULL; not closed by the driver. */
+    uint32_t baud;                 /**< Line rate in bit/s, e.g. 115200; 0 keeps the current one. */
+    danp_serial_framing_t framing; /**< Frame delimiting. */
+    struct danp_uring_s *uring;    /**< io_uring loop to run on instead of own threads; NULL for threads. */
+} danp_serial_config_t;
+
+/** @brief Traffic counters of a serial interface. */
+typedef struct danp_serial_stats_s
+{
+    uint32_t tx_frames;     /**< Frames written, or queued to the loop. */
+    uint32_t tx_bytes;      /**< Encoded bytes of those frames. */
+    uint32_t tx_drops;      /**< Frames that could not be written. */
+    uint32_t rx_frames;     /**< Frames handed to the stack. */
+    uint32_t rx_bytes;      /**< Bytes read from the line. */
+    uint32_t rx_reads;      /**< read() calls, or loop reads, that returned data. */
+    uint32_t rx_crc_errors; /**< Frames whose CRC did not match. */
+    uint32_t rx_drops;      /**< Frames dropped: too short or long, bad escape or no pool buffer. */
+} danp_serial_stats_t;
+
+typedef struct danp_serial_interface_s
+{
+    danp_interface_t common;
+    int32_t fd;                       /**< Terminal the interface reads and writes. */
+    danp_serial_framing_t framing;    /**< Frame delimiting in use. */
+    danp_serial_stats_t stats;        /**< Traffic counters. */
+    struct danp_uring_s *uring;       /**< Loop servicing the terminal, or NULL. */
+    int32_t uring_source;             /**< Source handle on that loop. */
+    void *context;
+} danp_serial_interface_t;
+
+/* External Declarations */
+
+/**
+ * @brief Open and configure a serial line and start receiving on it.
+ *
+ * The terminal is switched to raw 8N1 without flow control. Each packet leaves
+ * as one frame: header, payload and CRC, encoded with the configured framing.
+ * The receive thread reads whatever the terminal has buffered and decodes it
+ * byte by byte straight into pool packets, so no frame is copied or held in a
+ * separate buffer. When a read ends inside a frame, the thread waits for
+ * DANP_SERIAL_RX_CHUNK more bytes at the line rate before reading again,
+ * instead of waking for every byte of a slow line.
+ *
+ * With config->uring set the interface starts no thread: the loop reads the
+ * terminal as a stream source and writes the encoded frames.
+ *
+ * @param iface Interface to initialise; register it with danp_register_interface() afterwards.
+ * @param config Interface settings.
+ * @return 0 on success, -1 on invalid settings, an unsupported baud rate, or device errors.
+ */
+extern int32_t danp_serial_init(danp_serial_interface_t *iface, const danp_serial_config_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_SERIAL_H */
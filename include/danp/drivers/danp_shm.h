@@ -0,0 +1,99 @@
+/* danp_shm.h - DANP between processes on one host over shared-memory rings */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_SHM_H
+#define INC_DANP_SHM_H
+
+/* Includes */
+
+#include <stdint.h>
+#include "danp/danp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Configurations */
+
+/** @brief Frames each direction of a segment can hold; must be a power of two. */
+#ifndef DANP_SHM_RING_DEPTH
+#define DANP_SHM_RING_DEPTH 64
+#endif
+
+/** @brief Shared-memory interfaces that can be initialised in one process. */
+#ifndef DANP_SHM_MAX_INTERFACES
+#define DANP_SHM_MAX_INTERFACES 4
+#endif
+
+/* Definitions */
+
+/** @brief Longest segment name, including the leading '/' and the terminator. */
+#define DANP_SHM_NAME_MAX 32
+
+/* Types */
+
+/** @brief Settings for danp_shm_init(). */
+typedef struct danp_shm_config_s
+{
+    const char *name;    /**< Interface name used by the routing table; "SHM" if NULL. */
+    uint16_t address;    /**< DANP address of this end. */
+    uint16_t peer;       /**< DANP address of the process at the other end. */
+    const char *segment; /**< Shared-memory object name; "/danp-<low>-<high>" if NULL. */
+} danp_shm_config_t;
+
+/** @brief Traffic counters of a shared-memory interface. */
+typedef struct danp_shm_stats_s
+{
+    uint32_t tx_packets; /**< Frames written to the peer's ring. */
+    uint32_t tx_wakeups; /**< Frames after which the sleeping peer had to be woken. */
+    uint32_t tx_drops;   /**< Frames dropped because the peer's ring was full. */
+    uint32_t rx_packets; /**< Frames taken from our ring. */
+    uint32_t rx_wakeups; /**< Times the receive thread had to sleep for more. */
+    uint32_t rx_drops;   /**< Frames dropped: malformed or no pool buffer. */
+} danp_shm_stats_t;
+
+typedef struct danp_shm_interface_s
+{
+    danp_interface_t common;
+    uint16_t peer;                       /**< DANP address of the other end. */
+    char segment[DANP_SHM_NAME_MAX];     /**< Shared-memory object in use. */
+    danp_shm_stats_t stats;              /**< Traffic counters. */
+    void *context;
+} danp_shm_interface_t;
+
+/* External Declarations */
+
+/**
+ * @brief Attach to the segment shared with one peer process and start receiving.
+ *
+ * Both processes call this with mirrored address/peer and the same segment; the
+ * first one creates and formats it. The segment holds one ring per direction, each
+ * written by exactly one process, so frames cross without system calls. The receive
+ * thread sleeps on a futex only when its ring is empty, and a sender pays for the
+ * wake-up only in that case, so bursts move without any. Broadcast and group
+ * packets go to the peer like any other; its stack drops groups it did not join.
+ *
+ * @param iface Interface to initialise; register it with danp_register_interface() afterwards.
+ * @param config Interface settings.
+ * @return 0 on success, -1 on invalid settings, a segment of another geometry or OS errors.
+ */
+extern int32_t danp_shm_init(danp_shm_interface_t *iface, const danp_shm_config_t *config);
+
+/**
+ * @brief Remove a segment name so the next danp_shm_init() formats a fresh one.
+ *
+ * Processes still attached keep their mapping. Call it before starting a new pair
+ * of processes if a previous run may have left frames behind.
+ *
+ * @param segment Shared-memory object name.
+ * @return 0 on success, -1 if the name does not exist.
+ */
+extern int32_t danp_shm_unlink(const char *segment);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_SHM_H */
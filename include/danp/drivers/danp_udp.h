@@ -0,0 +1,148 @@
+/* danp_udp.h - DANP over UDP/IPv4 with batched send and receive */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_UDP_H
+#define INC_DANP_UDP_H
+
+/* Includes */
+
+#include <stdint.h>
+#include "danp/danp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Configurations */
+
+/** @brief Node-to-endpoint entries one UDP interface can hold. */
+#ifndef DANP_UDP_MAX_PEERS
+#define DANP_UDP_MAX_PEERS 16
+#endif
+
+/** @brief Datagrams moved per sendmmsg()/recvmmsg() call. */
+#ifndef DANP_UDP_BATCH
+#define DANP_UDP_BATCH 16
+#endif
+
+/** @brief Receive threads, each with its own SO_REUSEPORT socket, one interface may run. */
+#ifndef DANP_UDP_MAX_RX_THREADS
+#define DANP_UDP_MAX_RX_THREADS 4
+#endif
+
+/** @brief Frames waiting for the transmit thread; must be a power of two. */
+#ifndef DANP_UDP_TX_RING_DEPTH
+#define DANP_UDP_TX_RING_DEPTH 32
+#endif
+
+/** @brief UDP interfaces that can be initialised in one process. */
+#ifndef DANP_UDP_MAX_INTERFACES
+#define DANP_UDP_MAX_INTERFACES 4
+#endif
+
+/* Definitions */
+
+
+/* Types */
+
+/** @brief UDP endpoint that packets for a DANP node are sent to. */
+typedef struct danp_udp_peer_s
+{
+    uint16_t node;     /**< DANP node ID. */
+    uint16_t udp_port; /**< UDP port, host byte order. */
+    uint32_t ipv4;     /**< IPv4 address, host byte order. */
+} danp_udp_peer_t;
+
+/** @brief Settings for danp_udp_init(). */
+typedef struct danp_udp_config_s
+{
+    const char *name;      /**< Interface name used by the routing table; "UDP" if NULL. */
+    uint16_t address;      /**< DANP address of the interface. */
+    const char *bind_host; /**< Local IPv4 address to bind; any address if NULL. */
+    uint16_t bind_port;    /**< Local UDP port; 0 lets the kernel pick one. */
+    uint32_t rx_threads;   /**< Receive threads, 1 to DANP_UDP_MAX_RX_THREADS; 0 means 1. */
+    struct danp_uring_s *uring; /**< io_uring loop to run on instead of own threads; NULL for threads. */
+    const char *multicast_net; /**< IPv4 multicast block for group packets, e.g. "239.255.68.0"; NULL for none. */
+    uint16_t multicast_port;   /**< UDP port every member of multicast_net uses. */
+} danp_udp_config_t;
+
+/**
+ * @brief Traffic counters of a UDP interface.
+ *
+ * On an io_uring loop tx_packets counts frames queued to the loop, and the
+ * batch and receive counters stay at zero; the loop keeps its own statistics.
+ */
+typedef struct danp_udp_stats_s
+{
+    uint32_t tx_packets; /**< Datagrams handed to the kernel. */
+    uint32_t tx_batches; /**< sendmmsg() calls that sent them. */
+    uint32_t tx_drops;   /**< Packets dropped: unknown peer, full ring or send error. */
+    uint32_t rx_packets; /**< Datagrams received. */
+    uint32_t rx_batches; /**< recvmmsg() calls that returned them. */
+} danp_udp_stats_t;
+
+typedef struct danp_udp_interface_s
+{
+    danp_interface_t common;
+    int32_t fds[DANP_UDP_MAX_RX_THREADS];     /**< One socket per receive thread; fds[0] also sends. */
+    uint32_t rx_threads;                      /**< Sockets and receive threads in use. */
+    uint16_t bound_port;                      /**< Local UDP port after binding. */
+    danp_udp_peer_t peers[DANP_UDP_MAX_PEERS]; /**< Where packets for each node go. */
+    uint32_t peer_count;                      /**< Entries used in peers. */
+    danp_udp_stats_t stats;                   /**< Traffic counters. */
+    int32_t mcast_fd;                         /**< Socket receiving group packets, or -1. */
+    uint32_t mcast_net;                       /**< Multicast block, host byte order; the low byte is the group. */
+    uint32_t mcast_if;                        /**< Local address groups are joined on, host byte order. */
+    uint16_t mcast_port;                      /**< UDP port of the multicast block. */
+    struct danp_uring_s *uring;               /**< Loop servicing the socket, or NULL. */
+    int32_t uring_source;                     /**< Source handle on that loop. */
+    void *context;
+} danp_udp_interface_t;
+
+/* External Declarations */
+
+/**
+ * @brief Open the sockets of a UDP interface and start its threads.
+ *
+ * Binds config->rx_threads sockets to the same address with SO_REUSEPORT so the
+ * kernel spreads incoming flows across the receive threads. Each thread drains
+ * its socket with recvmmsg(); a transmit thread sends queued packets with
+ * sendmmsg(), so bursts from the stack leave in batches of up to DANP_UDP_BATCH.
+ *
+ * With config->uring set the interface starts no threads and opens one socket,
+ * which the io_uring loop receives on and sends through.
+ *
+ * With config->multicast_net set, broadcasts and multicast groups without a peer
+ * entry map to IPv4 multicast: DANP group G is the address multicast_net with its
+ * low byte set to G, on multicast_port. A further socket and receive thread take
+ * the broadcast group and the groups local sockets join, and drop the interface's
+ * own packets that the host loops back. Multicast needs the thread model.
+ *
+ * @param iface Interface to initialise; register it with danp_register_interface() afterwards.
+ * @param config Interface settings.
+ * @return 0 on success, -1 on invalid settings, socket errors, or a loop in a build without DANP_URING_SUPPORT.
+ */
+extern int32_t danp_udp_init(danp_udp_interface_t *iface, const danp_udp_config_t *config);
+
+/**
+ * @brief Map a DANP node to the UDP endpoint its packets are sent to.
+ *
+ * Add peers before traffic starts; the table is read without locking on transmit.
+ * Adding a node that is already present updates its endpoint. An entry for a
+ * group address sends that group to a unicast endpoint instead of multicast.
+ *
+ * @param iface Initialised UDP interface.
+ * @param node DANP node ID.
+ * @param host IPv4 address in dotted notation.
+ * @param udp_port UDP port of the peer.
+ * @return 0 on success, -1 if the address is invalid or the table is full.
+ */
+extern int32_t danp_udp_add_peer(danp_udp_interface_t *iface, uint16_t node, const char *host, uint16_t udp_port);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_UDP_H */
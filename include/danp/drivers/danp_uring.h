@@ -0,0 +1,165 @@
+/* danp_uring.h - io_uring event loop that services the file descriptors of many DANP drivers */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_URING_H
+#define INC_DANP_URING_H
+
+/* Includes */
+
+#include <stdint.h>
+#include "danp/danp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Configurations */
+
+/** @brief Submission queue entries of the ring. */
+#ifndef DANP_URING_QUEUE_DEPTH
+#define DANP_URING_QUEUE_DEPTH 64
+#endif
+
+/** @brief Pool packets lent to the kernel for multishot receives; must be a power of two. */
+#ifndef DANP_URING_RX_BUFFERS
+#define DANP_URING_RX_BUFFERS 8
+#endif
+
+/** @brief Free pool packets the loop always leaves to the stack. */
+#ifndef DANP_URING_POOL_RESERVE
+#define DANP_URING_POOL_RESERVE 4
+#endif
+
+/** @brief Frames waiting to be sent; must be a power of two. */
+#ifndef DANP_URING_TX_RING_DEPTH
+#define DANP_URING_TX_RING_DEPTH 32
+#endif
+
+/** @brief Largest frame danp_uring_send() accepts, large enough for encoded serial frames. */
+#ifndef DANP_URING_FRAME_SIZE
+#define DANP_URING_FRAME_SIZE (2 * (DANP_HEADER_SIZE + DANP_MAX_PACKET_SIZE) + 8)
+#endif
+
+/** @brief Bytes one read of a stream source returns at most. */
+#ifndef DANP_URING_READ_SIZE
+#define DANP_URING_READ_SIZE 256
+#endif
+
+/** @brief File descriptors one loop can service. */
+#ifndef DANP_URING_MAX_SOURCES
+#define DANP_URING_MAX_SOURCES 8
+#endif
+
+/** @brief Loops that can be initialised in one process. */
+#ifndef DANP_URING_MAX_LOOPS
+#define DANP_URING_MAX_LOOPS 2
+#endif
+
+/* Definitions */
+
+
+/* Types */
+
+/**
+ * @brief Called on the loop thread with the bytes a stream source delivered.
+ * @param arg Argument given to danp_uring_add_stream().
+ * @param data Bytes read; valid only during the call.
+ * @param length Number of bytes.
+ */
+typedef void (*danp_uring_read_cb_t)(void *arg, const uint8_t *data, uint32_t length);
+
+/** @brief Counters of an io_uring loop. */
+typedef struct danp_uring_stats_s
+{
+    uint32_t enters;     /**< io_uring_enter() calls, i.e. system calls the loop made. */
+    uint32_t tx_packets; /**< Frames the kernel accepted. */
+    uint32_t tx_drops;   /**< Frames dropped: full ring or send error. */
+    uint32_t rx_packets; /**< Datagrams handed to the stack. */
+    uint32_t rx_reads;   /**< Reads completed on stream sources. */
+    uint32_t rx_drops;   /**< Datagrams dropped as malformed or oversized. */
+    uint32_t rx_rearms;  /**< Multishot receives started again after the kernel ended them. */
+} danp_uring_stats_t;
+
+typedef struct danp_uring_s
+{
+    danp_uring_stats_t stats; /**< Counters. */
+    void *context;
+} danp_uring_t;
+
+/* External Declarations */
+
+/**
+ * @brief Create a ring and start the thread that services it.
+ *
+ * The thread sets up the ring, lends up to DANP_URING_RX_BUFFERS pool packets to
+ * the kernel as provided buffers, and then sleeps in io_uring_enter() until any
+ * source or transmit request needs it. Datagrams are received straight into the
+ * lent packets, so they reach the stack without a copy, and every pass of the loop
+ * submits all queued sends with one system call.
+ *
+ * Call it after danp_init(); initialising the stack again returns the lent packets
+ * to the pool behind the kernel's back.
+ *
+ * @param loop Loop to initialise.
+ * @return 0 on success, -1 if io_uring or one of the features used is unavailable.
+ */
+extern int32_t danp_uring_init(danp_uring_t *loop);
+
+/**
+ * @brief Receive DANP frames from a datagram socket (UDP, UNIX) on the loop.
+ *
+ * Each datagram must hold one frame. A multishot receive keeps running as long as
+ * lent buffers are available, so the socket costs no system call per frame.
+ *
+ * @param loop Initialised loop.
+ * @param iface Interface the frames are delivered on.
+ * @param fd Datagram socket; it is not closed by the loop.
+ * @return Source handle for danp_uring_send(), or -1 if the table is full.
+ */
+extern int32_t danp_uring_add_datagram(danp_uring_t *loop, danp_interface_t *iface, int32_t fd);
+
+/**
+ * @brief Read a byte stream (serial device, pipe, STREAM socket) on the loop.
+ *
+ * The loop keeps one read outstanding and passes what it returns to on_read, which
+ * runs on the loop thread and must not block. The source stops on end of file or
+ * a read error.
+ *
+ * @param loop Initialised loop.
+ * @param fd Readable file descriptor; it is not closed by the loop.
+ * @param on_read Receives the bytes read.
+ * @param arg Passed to on_read.
+ * @return Source handle for danp_uring_send(), or -1 if the table is full.
+ */
+extern int32_t danp_uring_add_stream(danp_uring_t *loop, int32_t fd, danp_uring_read_cb_t on_read, void *arg);
+
+/**
+ * @brief Queue a frame for a source; the loop sends it on its next pass.
+ *
+ * The frame is copied, so the caller keeps its buffer. Safe from any thread,
+ * including stack code running on the loop thread. Writes to a stream source go
+ * out one at a time and in order; datagrams may be in flight together.
+ *
+ * @param loop Initialised loop.
+ * @param source Handle returned when the source was added.
+ * @param data Frame bytes.
+ * @param length Frame length, at most DANP_URING_FRAME_SIZE.
+ * @param addr Destination address for unconnected datagram sockets, else NULL.
+ * @param addr_len Length of addr.
+ * @return 0 if queued, -1 if the arguments are invalid or the ring is full.
+ */
+extern int32_t danp_uring_send(
+    danp_uring_t *loop,
+    int32_t source,
+    const void *data,
+    uint32_t length,
+    const void *addr,
+    uint32_t addr_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_URING_H */
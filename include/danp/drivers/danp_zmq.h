@@ -17,22 +17,105 @@ extern "C" {
 
 /* Configurations */
 
+/**
+ * @brief Pool packets ZMQ may hold at once, across all interfaces.
+ *
+ * A frame sent from a pool packet keeps it until ZMQ has written the message out,
+ * which takes as long as the slowest subscriber. Beyond this many, frames are sent
+ * with zmq_send(), which copies them, so a slow subscriber cannot drain the pool.
+ */
+#ifndef DANP_ZMQ_POOL_FRAMES
+#define DANP_ZMQ_POOL_FRAMES 8
+#endif
+
+/** @brief Free pool packets below which transmit leaves the pool alone and lets ZMQ copy the frame. */
+#ifndef DANP_ZMQ_POOL_RESERVE
+#define DANP_ZMQ_POOL_RESERVE 4
+#endif
+
+/** @brief ZMQ interfaces that can be initialised in one process. */
+#ifndef DANP_ZMQ_MAX_INTERFACES
+#define DANP_ZMQ_MAX_INTERFACES 4
+#endif
+
+/** @brief Messages the receive loop takes from one SUB socket before serving the others. */
+#ifndef DANP_ZMQ_RX_BATCH
+#define DANP_ZMQ_RX_BATCH 16
+#endif
+
+/** @brief Milliseconds danp_zmq_shutdown() gives queued messages to leave. */
+#ifndef DANP_ZMQ_LINGER_MS
+#define DANP_ZMQ_LINGER_MS 100
+#endif
+
+/** @brief Largest aggregated message, topic included. */
+#ifndef DANP_ZMQ_AGG_MAX_BYTES
+#define DANP_ZMQ_AGG_MAX_BYTES 1024
+#endif
+
+/** @brief Destination nodes one interface aggregates for at the same time. */
+#ifndef DANP_ZMQ_AGG_BUNDLES
+#define DANP_ZMQ_AGG_BUNDLES 4
+#endif
 
 /* Definitions */
 
+/** @brief Bytes of the topic that prefix every message: destination node, then message kind. */
+#define DANP_ZMQ_TOPIC_SIZE 2
+
+/** @brief Message kind: one packet, header then payload. */
+#define DANP_ZMQ_KIND_SINGLE 0
+
+/** @brief Message kind: packets for one node, each as a 2-byte big-endian length and the frame. */
+#define DANP_ZMQ_KIND_BUNDLE 1
 
 /* Types */
 
+/** @brief Traffic counters of a ZMQ interface. */
+typedef struct danp_zmq_stats_s
+{
+    uint32_t tx_pool_frames; /**< Frames copied into a spare pool packet that ZMQ sends in place. */
+    uint32_t tx_copied;      /**< Frames built on the stack and copied again by ZMQ: pool low or DANP_ZMQ_POOL_FRAMES held. */
+    uint32_t tx_bundled;     /**< Frames sent inside aggregated messages. */
+    uint32_t tx_bundles;     /**< Aggregated messages sent. */
+    uint32_t tx_drops;       /**< Frames ZMQ refused. */
+    uint32_t rx_packets;     /**< Frames handed to the stack. */
+    uint32_t rx_bundles;     /**< Aggregated messages received. */
+    uint32_t rx_drops;       /**< Frames dropped: malformed or no pool buffer. */
+} danp_zmq_stats_t;
+
+/**
+ * @brief ZMQ interface.
+ *
+ * Every message starts with DANP_ZMQ_TOPIC_SIZE bytes of topic; SUB sockets filter
+ * on its first byte, the destination node. A single message carries the 4-byte
+ * header and the payload of one packet, a bundle several length-prefixed frames.
+ */
 typedef struct danp_zmq_interface_s
 {
     danp_interface_t common;
     void *pub_sock;
     void *sub_sock;
-    uint32_t rx_thread_id;
+    danp_zmq_stats_t stats; /**< Traffic counters. */
+    void *context;
 } danp_zmq_interface_t;
 
 /* External Declarations */
 
+/**
+ * @brief Open the PUB and SUB sockets of an interface.
+ *
+ * One thread receives for every ZMQ interface of the process: the first call
+ * starts it, later calls add their SUB socket to the sockets it polls. Up to
+ * DANP_ZMQ_MAX_INTERFACES interfaces can be open at once.
+ *
+ * @param iface Interface to initialise.
+ * @param pub_bind_endpoint Endpoint the PUB socket binds to.
+ * @param sub_connect_endpoints Endpoints the SUB socket connects to.
+ * @param sub_count Number of entries in sub_connect_endpoints.
+ * @param node_id Node address; the SUB socket only receives messages for it, broadcasts
+ *        and the multicast groups local sockets join.
+ */
 extern void danp_zmq_init(
     danp_zmq_interface_t *iface,
     const char *pub_bind_endpoint,
@@ -40,6 +123,34 @@ extern void danp_zmq_init(
     int32_t sub_count,
     uint16_t node_id);
 
+/**
+ * @brief Pack packets for the same node into shared messages.
+ *
+ * A packet waits at most delay_us for others to the same node; the message leaves
+ * earlier once the next packet would not fit into max_bytes. Receivers unpack
+ * bundles whether or not they aggregate themselves. Turning aggregation off sends
+ * what is pending. The receive thread sends bundles that time out; it waits in
+ * whole milliseconds, so one may leave up to 1 ms after delay_us.
+ *
+ * @param iface Initialised ZMQ interface.
+ * @param max_bytes Largest message, up to DANP_ZMQ_AGG_MAX_BYTES; 0 turns aggregation off.
+ * @param delay_us Longest time the first packet of a message waits.
+ * @return 0 on success, -1 if max_bytes cannot hold a full packet or is too large.
+ */
+extern int32_t danp_zmq_set_aggregation(danp_zmq_interface_t *iface, uint32_t max_bytes, uint32_t delay_us);
+
+/**
+ * @brief Stop the receive thread and close every ZMQ interface.
+ *
+ * Pending bundles are sent, and queued messages get DANP_ZMQ_LINGER_MS to leave
+ * before the ZMQ context is terminated. Transmits on the closed interfaces fail
+ * afterwards; they stay registered with the stack, so remove their routes.
+ * danp_zmq_init() may be called again once this returns.
+ *
+ * @return 0 on success, -1 if no interface was open.
+ */
+extern int32_t danp_zmq_shutdown(void);
+
 #ifdef __cplusplus
 }
 #endif
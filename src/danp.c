@@ -137,6 +137,17 @@ void danp_input(danp_interface_t *iface, uint8_t *raw_data, uint16_t len)
     {
         memcpy(pkt->payload, raw_data + 4, pkt->length);
     }
+
+    danp_input_packet(iface, pkt);
+}
+
+/**
+ * @brief Hand a pool packet received on an interface to the stack.
+ * @param iface Pointer to the interface receiving the packet.
+ * @param pkt Packet from danp_buffer_allocate(); ownership passes to the stack.
+ */
+void danp_input_packet(danp_interface_t *iface, danp_packet_t *pkt)
+{
     pkt->rx_interface = iface;
 
     uint16_t dst, src;
@@ -160,6 +171,12 @@ void danp_input(danp_interface_t *iface, uint8_t *raw_data, uint16_t len)
         danp_log_message(DANP_LOG_VERBOSE, "Packet received for local node");
         danp_socket_input_handler(pkt);
     }
+    else if (DANP_NODE_IS_GROUP(dst))
+    {
+        // The socket layer keeps what a socket bound to the port has joined.
+        danp_log_message(DANP_LOG_VERBOSE, "Packet received for group %u", dst);
+        danp_socket_input_handler(pkt);
+    }
     else
     {
         danp_log_message(DANP_LOG_INFO, "Packet not for local node, dropping");
@@ -167,6 +184,22 @@ void danp_input(danp_interface_t *iface, uint8_t *raw_data, uint16_t len)
     }
 }
 
+/**
+ * @brief Hand a burst of pool packets received on an interface to the stack, in order.
+ * @param iface Pointer to the interface receiving the packets.
+ * @param pkts Packets from danp_buffer_allocate(); ownership passes to the stack.
+ * @param count Number of packets.
+ */
+void danp_input_burst(danp_interface_t *iface, danp_packet_t **pkts, uint32_t count)
+{
+    danp_log_message(DANP_LOG_VERBOSE, "RX burst of %u packets on %s", count, iface->name);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        danp_input_packet(iface, pkts[i]);
+    }
+}
+
 /**
  * @brief Log a message using the registered callback.
  * @param level Log level.
@@ -0,0 +1,123 @@
+/* danp_congestion.c - STREAM congestion control */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/danp.h"
+#include "danp_debug.h"
+
+/* Imports */
+
+
+/* Definitions */
+
+/** @brief Smallest slow start threshold the NewReno controller falls back to. */
+#define DANP_NEWRENO_SSTHRESH_MIN          (2U)
+
+/* Types */
+
+
+/* Forward Declarations */
+
+static void danp_newreno_init(danp_socket_t *sock);
+static void danp_newreno_on_ack(danp_socket_t *sock, uint16_t acked, int32_t rtt_ms);
+static void danp_newreno_on_loss(danp_socket_t *sock, danp_congestion_event_t event);
+
+/* Variables */
+
+const danp_congestion_ops_t danp_congestion_newreno = {
+    .name = "newreno",
+    .init = danp_newreno_init,
+    .on_ack = danp_newreno_on_ack,
+    .on_loss = danp_newreno_on_loss,
+};
+
+/** @brief Controller assigned to new STREAM connections. */
+static const danp_congestion_ops_t *default_ops = &danp_congestion_newreno;
+
+/* Functions */
+
+/**
+ * @brief Initialise NewReno state: small initial window, unbounded slow start.
+ * @param sock Pointer to the socket.
+ */
+static void danp_newreno_init(danp_socket_t *sock)
+{
+    sock->cwnd = DANP_CWND_INITIAL;
+    sock->ssthresh = UINT16_MAX;
+    sock->cwnd_count = 0;
+}
+
+/**
+ * @brief Grow cwnd by one segment per ACKed segment in slow start and by one
+ *        segment per window in congestion avoidance.
+ * @param sock Pointer to the socket.
+ * @param acked Number of segments newly acknowledged.
+ * @param rtt_ms Round trip time sample (unused by NewReno).
+ */
+static void danp_newreno_on_ack(danp_socket_t *sock, uint16_t acked, int32_t rtt_ms)
+{
+    UNUSED(rtt_ms);
+
+    while (acked-- > 0U)
+    {
+        // Growing past the send window only lets cwnd drift away from the real load.
+        if (sock->cwnd >= DANP_STREAM_TX_WINDOW)
+        {
+            sock->cwnd_count = 0;
+            break;
+        }
+
+        if (sock->cwnd < sock->ssthresh)
+        {
+            sock->cwnd++;
+        }
+        else if (++sock->cwnd_count >= sock->cwnd)
+        {
+            sock->cwnd++;
+            sock->cwnd_count = 0;
+        }
+    }
+}
+
+/**
+ * @brief Halve the window on loss; restart from one segment on timeout.
+ * @param sock Pointer to the socket.
+ * @param event How the loss was detected.
+ */
+static void danp_newreno_on_loss(danp_socket_t *sock, danp_congestion_event_t event)
+{
+    uint16_t flight = (uint16_t)(sock->snd_max - sock->snd_una);
+    uint16_t half = flight / 2U;
+
+    sock->ssthresh = (half > DANP_NEWRENO_SSTHRESH_MIN) ? half : DANP_NEWRENO_SSTHRESH_MIN;
+    sock->cwnd = (event == DANP_CONGESTION_TIMEOUT) ? 1U : sock->ssthresh;
+    sock->cwnd_count = 0;
+
+    danp_log_message(
+        DANP_LOG_DEBUG,
+        "Congestion %s on Port %u: cwnd=%u ssthresh=%u",
+        (event == DANP_CONGESTION_TIMEOUT) ? "timeout" : "dupack",
+        sock->local_port,
+        sock->cwnd,
+        sock->ssthresh);
+}
+
+/**
+ * @brief Select the congestion controller used by new STREAM connections.
+ * @param ops Controller operations, or NULL to restore the NewReno default.
+ */
+void danp_congestion_set_default(const danp_congestion_ops_t *ops)
+{
+    default_ops = ops ? ops : &danp_congestion_newreno;
+}
+
+/**
+ * @brief Get the congestion controller used by new STREAM connections.
+ * @return Pointer to the controller operations.
+ */
+const danp_congestion_ops_t *danp_congestion_get_default(void)
+{
+    return default_ops;
+}
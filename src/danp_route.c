@@ -32,6 +32,9 @@ static danp_route_entry_t route_table[DANP_MAX_NODES];
 /** @brief Number of active entries in the routing table. */
 static size_t route_count = 0U;
 
+/** @brief Sockets of this node in each multicast group, indexed from DANP_MULTICAST_FIRST. */
+static uint16_t group_members[DANP_MULTICAST_COUNT];
+
 /** @brief Mutex protecting routing state and interface list. */
 static osalMutexHandle_t route_mutex;
 
@@ -211,6 +214,15 @@ void danp_register_interface(void *iface)
     iface_list = iface;
     danp_log_message(DANP_LOG_VERBOSE, "Registered network interface");
 
+    // A link added later still has to deliver the groups joined so far.
+    for (uint16_t i = 0; i < DANP_MULTICAST_COUNT && iface_common->group_func; i++)
+    {
+        if (group_members[i] > 0U)
+        {
+            iface_common->group_func(iface_common, (uint16_t)(DANP_MULTICAST_FIRST + i), true);
+        }
+    }
+
     danp_route_unlock(locked);
 }
 
@@ -353,6 +365,137 @@ int32_t danp_route_table_load(const char *table)
     return 0;
 }
 
+/**
+ * @brief Count a socket of this node joining or leaving a multicast group.
+ * @param group Group address.
+ * @param join true when a socket joins, false when it leaves.
+ * @return 0 on success, negative on error.
+ */
+int32_t danp_route_group_update(uint16_t group, bool join)
+{
+    uint16_t index = (uint16_t)(group - DANP_MULTICAST_FIRST);
+    bool notify = false;
+    bool locked = false;
+
+    if (group < DANP_MULTICAST_FIRST || group > DANP_MULTICAST_LAST)
+    {
+        danp_log_message(DANP_LOG_ERROR, "Invalid multicast group %u", group);
+        return -1;
+    }
+
+    locked = danp_route_lock();
+    if (!locked)
+    {
+        /* LCOV_EXCL_START */
+        return -1;
+        /* LCOV_EXCL_STOP */
+    }
+
+    if (join)
+    {
+        notify = (group_members[index]++ == 0U);
+    }
+    else if (group_members[index] > 0U)
+    {
+        notify = (--group_members[index] == 0U);
+    }
+    else
+    {
+        danp_route_unlock(locked);
+        return -1;
+    }
+
+    for (danp_interface_t *cur = iface_list; cur && notify; cur = cur->next)
+    {
+        if (cur->group_func && cur->group_func(cur, group, join) != 0)
+        {
+            danp_log_message(DANP_LOG_WARN, "Interface %s failed to %s group %u", cur->name, join ? "join" : "leave", group);
+        }
+    }
+
+    danp_route_unlock(locked);
+    return 0;
+}
+
+/**
+ * @brief Get the first registered interface; the list only ever grows at its head.
+ * @return Pointer to the newest interface, or NULL if none is registered.
+ */
+static danp_interface_t *danp_route_first_interface(void)
+{
+    danp_interface_t *first = NULL;
+    bool locked = danp_route_lock();
+
+    if (locked)
+    {
+        first = iface_list;
+    }
+    danp_route_unlock(locked);
+
+    return first;
+}
+
+/**
+ * @brief Send a group packet once on every registered interface.
+ * @param pkt Pointer to the packet to send.
+ * @return 0 if at least one interface took the packet, negative otherwise.
+ */
+static int32_t danp_route_tx_all(danp_packet_t *pkt)
+{
+    int32_t ret = -1;
+    size_t guard = 0U;
+
+    for (danp_interface_t *cur = danp_route_first_interface(); cur && guard++ <= DANP_MAX_NODES; cur = cur->next)
+    {
+        if ((uint32_t)pkt->length + DANP_HEADER_SIZE > cur->mtu)
+        {
+            danp_log_message(DANP_LOG_WARN, "Packet length %u exceeds MTU %u for interface %s", pkt->length + DANP_HEADER_SIZE, cur->mtu, cur->name);
+            continue;
+        }
+        if (cur->tx_func(cur, pkt) == 0)
+        {
+            ret = 0;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Get the largest payload that can be routed to a node.
+ * @param dst_node Destination node address.
+ * @return Payload size in bytes, or 0 if there is no route to the node.
+ */
+uint16_t danp_route_get_max_payload(uint16_t dst_node)
+{
+    danp_interface_t *out = danp_route_lookup(dst_node);
+    uint16_t max_payload = DANP_MAX_PACKET_SIZE;
+
+    // Without a route of its own a group packet goes out everywhere, so the smallest MTU counts.
+    if (!out && DANP_NODE_IS_GROUP(dst_node))
+    {
+        for (danp_interface_t *cur = danp_route_first_interface(); cur; cur = cur->next)
+        {
+            if (!out || cur->mtu < out->mtu)
+            {
+                out = cur;
+            }
+        }
+    }
+
+    if (!out || out->mtu <= DANP_HEADER_SIZE)
+    {
+        return 0;
+    }
+
+    if (out->mtu - DANP_HEADER_SIZE < max_payload)
+    {
+        max_payload = out->mtu - DANP_HEADER_SIZE;
+    }
+
+    return max_payload;
+}
+
 /**
  * @brief Route a packet for transmission.
  * @param pkt Pointer to the packet to route.
@@ -371,6 +514,11 @@ int32_t danp_route_tx(danp_packet_t *pkt)
     danp_unpack_header(pkt->header_raw, &dst, &src, &dst_port, &src_port, &flags);
 
     danp_interface_t *out = danp_route_lookup(dst);
+    if (!out && DANP_NODE_IS_GROUP(dst))
+    {
+        danp_log_message(DANP_LOG_DEBUG, "TX [dst]=%u, [src]=%u, [dPort]=%u, [len]=%u on every interface", dst, src, dst_port, pkt->length);
+        return danp_route_tx_all(pkt);
+    }
     if (!out)
     {
         danp_log_message(DANP_LOG_ERROR, "No route to destination %u", dst);
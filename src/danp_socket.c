@@ -16,9 +16,40 @@ extern danp_config_t danp_config;
 /* Definitions */
 
 #define DANP_MAX_SOCKET_COUNT              (20)
+#define DANP_SOCKET_TIMER_STACK_SIZE       (1024 * 4)
+
+// v2 STREAM header layout: [version|options][seq hi][seq lo][ack hi][ack lo][wnd hi][wnd lo]
+#define DANP_STREAM_HDR_VER_OPT            (0)
+#define DANP_STREAM_HDR_SEQ                (1)
+#define DANP_STREAM_HDR_ACK                (3)
+#define DANP_STREAM_HDR_WND                (5)
+#define DANP_STREAM_VERSION_SHIFT          (4)
+#define DANP_STREAM_OPTIONS_MASK           (0x0F)
+
+// The link header has no flag bits left, so the end of the stream is an option of the v2 header.
+#define DANP_STREAM_OPT_FIN                (0x01)
+
+// Legacy (v1) STREAM payloads start with a single sequence byte.
+#define DANP_STREAM_V1_HEADER_SIZE         (1)
 
 /* Types */
 
+/** @brief A thread blocked in danp_poll(), woken whenever socket readiness may have changed. */
+typedef struct danp_poll_waiter_s
+{
+    bool in_use;
+    osalSemaphoreHandle_t signal;
+} danp_poll_waiter_t;
+
+/** @brief A connection that closed first, remembered until its stray segments have died out. */
+typedef struct danp_time_wait_s
+{
+    uint16_t local_port;
+    uint16_t remote_node;
+    uint16_t remote_port;
+    uint16_t snd_nxt;     /**< Sequence number to acknowledge a retransmitted FIN with. */
+    uint32_t expires_ms;
+} danp_time_wait_t;
 
 /* Forward Declarations */
 
@@ -31,11 +62,77 @@ static danp_socket_t *socket_list;
 /** @brief Next available ephemeral port. */
 static uint16_t next_ephemeral_port = 1;
 
-/** @brief Mutex for socket operations. */
+/** @brief Mutex for the socket index: the socket list, slot allocation, ports and listen backlogs. */
 static osalMutexHandle_t mutex_socket;
 
+/** @brief Mutex for the transmit backlog. */
+static osalMutexHandle_t mutex_tx;
+
+/** @brief Held while the transmit backlog is drained, so other threads wait until their packets are out. */
+static osalMutexHandle_t mutex_tx_drain;
+
+/** @brief Mutex for the danp_poll() waiter list. */
+static osalMutexHandle_t mutex_poll;
+
+/** @brief Packets produced under a socket lock, waiting to be transmitted. */
+static danp_packet_t tx_backlog[DANP_TX_BACKLOG_SIZE];
+
+/** @brief Index of the oldest packet in tx_backlog. */
+static uint16_t tx_backlog_head;
+
+/** @brief Number of packets in tx_backlog. */
+static uint16_t tx_backlog_count;
+
+/** @brief A thread is transmitting the backlog; others leave their packets to it. */
+static bool tx_backlog_draining;
+
+/** @brief Packets dropped because tx_backlog was full. */
+static uint32_t tx_backlog_drops;
+
 static danp_socket_t socket_pool[DANP_MAX_SOCKET_COUNT];
 
+/** @brief STREAM receive rings, lent to connections only, so DGRAM sockets and listeners carry none. */
+static uint8_t rx_ring_pool[DANP_STREAM_RX_RING_COUNT][DANP_STREAM_RX_BUFFER_SIZE];
+
+/** @brief Rings of rx_ring_pool lent out, guarded by mutex_socket. */
+static bool rx_ring_used[DANP_STREAM_RX_RING_COUNT];
+
+/** @brief Handle of the thread servicing socket timers. */
+static osalThreadHandle_t socket_timer_thread;
+
+/** @brief Mutex for the timer thread wake-up state below. */
+static osalMutexHandle_t mutex_timer;
+
+/** @brief Wakes the timer thread when a timer is due before it would wake up on its own. */
+static osalSemaphoreHandle_t timer_signal;
+
+/** @brief Tick at which the timer thread wakes up on its own. */
+static uint32_t timer_wake_ms;
+
+/** @brief The timer thread sleeps until signalled because no timer was running. */
+static bool timer_idle = true;
+
+/** @brief A sweep is in progress, so every timer armed meanwhile needs another one. */
+static bool timer_sweeping;
+
+/** @brief Threads waiting in danp_poll(); semaphores are created on first use and kept. */
+static danp_poll_waiter_t poll_waiters[DANP_POLL_MAX_WAITERS];
+
+/** @brief Socket receive queues created so far; slots keep theirs for reuse. */
+static uint16_t created_queues;
+
+/** @brief Socket semaphores created so far; slots keep theirs for reuse. */
+static uint16_t created_semaphores;
+
+/** @brief Socket locks created so far; slots keep theirs for reuse. */
+static uint16_t created_mutexes;
+
+/** @brief Connections reset because their peer stopped answering keepalive probes. */
+static uint32_t keepalive_resets;
+
+/** @brief Connections in TIME_WAIT, guarded by mutex_socket; entries with local_port 0 are free. */
+static danp_time_wait_t time_wait[DANP_TIME_WAIT_SLOTS];
+
 static bool danp_port_in_use(uint16_t port)
 {
     danp_socket_t *cur = socket_list;
@@ -83,10 +180,11 @@ static danp_socket_t *danp_find_socket(uint16_t local_port, uint16_t remote_node
         }
         if (cur->local_port == local_port)
         {
-            // Priority 1: Exact Match (Established/Connecting streams or Connected DGRAM)
+            // Priority 1: Exact Match (Established/Connecting/Closing streams or Connected DGRAM)
             if (cur->remote_node == remote_node && cur->remote_port == remote_port &&
                 (cur->state == DANP_SOCK_ESTABLISHED || cur->state == DANP_SOCK_SYN_SENT ||
-                 cur->state == DANP_SOCK_SYN_RECEIVED))
+                 cur->state == DANP_SOCK_SYN_RECEIVED || cur->state == DANP_SOCK_FIN_WAIT ||
+                 cur->state == DANP_SOCK_CLOSE_WAIT || cur->state == DANP_SOCK_LAST_ACK))
             {
                 ret = cur;
                 break;
@@ -107,230 +205,1952 @@ static danp_socket_t *danp_find_socket(uint16_t local_port, uint16_t remote_node
 }
 
 /**
- * @brief Send a control packet.
- * @param sock Pointer to the socket.
- * @param flags Control flags to send.
- * @param seq_num Sequence number (for ACK packets).
+ * @brief Find the TIME_WAIT entry of a connection (mutex_socket held).
+ * @param local_port Local port number.
+ * @param remote_node Remote node address.
+ * @param remote_port Remote port number, or 0 to match any entry on the local port.
+ * @return Pointer to the live entry, or NULL if there is none.
  */
-static void danp_send_control(danp_socket_t *sock, uint8_t flags, uint8_t seq_num)
+static danp_time_wait_t *danp_time_wait_find(uint16_t local_port, uint16_t remote_node, uint16_t remote_port)
 {
-    danp_packet_t *pkt = danp_buffer_allocate();
+    uint32_t now = osalGetTickMs();
 
-    for (;;)
+    for (int i = 0; i < DANP_TIME_WAIT_SLOTS; i++)
     {
-        if (!pkt)
+        danp_time_wait_t *entry = &time_wait[i];
+
+        if (entry->local_port == 0U)
         {
-            danp_log_message(DANP_LOG_ERROR, "Failed to allocate control packet");
-            break;
+            continue;
         }
 
-        pkt->header_raw = danp_pack_header(
-            0,
-            sock->remote_node,
-            sock->local_node,
-            sock->remote_port,
-            sock->local_port,
-            flags);
-
-        if ((flags & DANP_FLAG_ACK) && sock->type == DANP_TYPE_STREAM)
+        if ((int32_t)(entry->expires_ms - now) <= 0)
         {
-            pkt->payload[0] = seq_num;
-            pkt->length = 1;
+            // Entries expire lazily, whenever the table is looked at.
+            entry->local_port = 0;
+            continue;
         }
-        else
+
+        if (entry->local_port == local_port &&
+            (remote_port == 0U || (entry->remote_node == remote_node && entry->remote_port == remote_port)))
         {
-            pkt->length = 0;
+            return entry;
         }
-
-        danp_route_tx(pkt);
-        danp_buffer_free(pkt);
-
-        break;
     }
+
+    return NULL;
 }
 
 /**
- * @brief Initialize the socket subsystem.
- * @return int32_t
+ * @brief Remember a connection that closed first (mutex_socket held).
+ *
+ * When the table is full the entry closest to expiry makes room.
+ *
+ * @param sock Pointer to the socket.
  */
-int32_t danp_socket_init(void)
+static void danp_time_wait_add(const danp_socket_t *sock)
 {
-    osalMutexAttr_t attr = {
-        .name = "danpSocketMutex",
-        .attrBits = OSAL_MUTEX_RECURSIVE,
-        .cbMem = NULL,
-        .cbSize = 0,
-    };
-    mutex_socket = osalMutexCreate(&attr);
-    if (!mutex_socket)
+    danp_time_wait_t *entry = danp_time_wait_find(sock->local_port, sock->remote_node, sock->remote_port);
+    uint32_t now = osalGetTickMs();
+
+    for (int i = 0; entry == NULL && i < DANP_TIME_WAIT_SLOTS; i++)
     {
-        danp_log_message(DANP_LOG_ERROR, "Failed to create socket mutex");
-        return -1;
+        if (time_wait[i].local_port == 0U)
+        {
+            entry = &time_wait[i];
+        }
     }
 
-    // Initialize socket pool
-    for (int i = 0; i < DANP_MAX_SOCKET_COUNT; i++)
+    if (entry == NULL)
     {
-        socket_pool[i].state = DANP_SOCK_CLOSED;
-        socket_pool[i].next = NULL;
+        entry = &time_wait[0];
+        for (int i = 1; i < DANP_TIME_WAIT_SLOTS; i++)
+        {
+            if ((int32_t)(time_wait[i].expires_ms - entry->expires_ms) < 0)
+            {
+                entry = &time_wait[i];
+            }
+        }
     }
 
-    socket_list = NULL;
+    entry->local_port = sock->local_port;
+    entry->remote_node = sock->remote_node;
+    entry->remote_port = sock->remote_port;
+    entry->snd_nxt = sock->tx_seq;
+    entry->expires_ms = now + DANP_TIME_WAIT_MS;
+}
 
-    return 0;
+/**
+ * @brief Check whether a STREAM connection is synchronised with its peer, including while it shuts down.
+ * @param sock Pointer to the socket.
+ * @return true if segments are exchanged with the peer.
+ */
+static bool danp_stream_synchronized(const danp_socket_t *sock)
+{
+    return sock->state == DANP_SOCK_ESTABLISHED || sock->state == DANP_SOCK_FIN_WAIT ||
+           sock->state == DANP_SOCK_CLOSE_WAIT || sock->state == DANP_SOCK_LAST_ACK;
 }
 
 /**
- * @brief Create a new DANP socket.
- * @param type Type of the socket (DGRAM or STREAM).
- * @return Pointer to the created socket, or NULL on failure.
+ * @brief Check whether the application may still queue data on a STREAM connection.
+ * @param sock Pointer to the socket.
+ * @return true if sending has not been shut down.
  */
-danp_socket_t *danp_socket(danp_socket_type_t type)
+static bool danp_stream_can_send(const danp_socket_t *sock)
 {
-    osalStatus_t osal_status;
-    bool is_mutex_taken = false;
-    danp_socket_t *created_socket = NULL;
-    danp_socket_t *slot = NULL;
-    osalMessageQueueHandle_t rx_q = NULL;
-    osalMessageQueueHandle_t acc_q = NULL;
-    osalSemaphoreHandle_t sig = NULL;
-    osalMessageQueueAttr_t mq_attr = { .name = "danpSockRx", .mqSize = 0 /*...*/ };
-    osalSemaphoreAttr_t sem_attr   = { .name = "danpSockSig", .maxCount = 1 /*...*/ };
+    return sock->state == DANP_SOCK_ESTABLISHED || sock->state == DANP_SOCK_SYN_RECEIVED ||
+           sock->state == DANP_SOCK_CLOSE_WAIT;
+}
 
-    for (;;)
+/**
+ * @brief Get the size of the transport header a STREAM connection puts in front of its data.
+ * @param sock Pointer to the socket.
+ * @return Header size in bytes.
+ */
+static uint16_t danp_stream_header_size(const danp_socket_t *sock)
+{
+    return (sock->version == DANP_STREAM_V1) ? DANP_STREAM_V1_HEADER_SIZE : DANP_STREAM_HEADER_SIZE;
+}
+
+/**
+ * @brief Get the number of further full-sized segments a STREAM socket can buffer.
+ * @param sock Pointer to the socket.
+ * @return Free receive window in segments.
+ */
+static uint16_t danp_stream_rx_window(const danp_socket_t *sock)
+{
+    uint16_t mss = DANP_MAX_PACKET_SIZE - danp_stream_header_size(sock);
+
+    return (uint16_t)((DANP_STREAM_RX_BUFFER_SIZE - sock->rx_count) / mss);
+}
+
+/**
+ * @brief Check whether reading has opened the receive window enough to tell the peer.
+ *
+ * Reopening a closed window is always announced; otherwise the window must have
+ * grown by half the receive buffer, so small reads do not each cost an ACK.
+ *
+ * @param sock Pointer to the socket.
+ * @return true if a window update should be sent.
+ */
+static bool danp_stream_window_update_due(const danp_socket_t *sock)
+{
+    uint16_t window = danp_stream_rx_window(sock);
+    uint16_t full_window = (uint16_t)(DANP_STREAM_RX_BUFFER_SIZE / (DANP_MAX_PACKET_SIZE - DANP_STREAM_HEADER_SIZE));
+
+    if (sock->version != DANP_STREAM_V2 || window <= sock->rx_wnd_advertised)
     {
-        osal_status = osalMutexLock(mutex_socket, OSAL_WAIT_FOREVER);
-        if (osal_status != OSAL_SUCCESS)
-        {
-            danp_log_message(DANP_LOG_ERROR, "Socket allocation failed: Mutex Lock Error");
-            break; // Jump to cleanup
-        }
-        is_mutex_taken = true;
+        return false;
+    }
 
-        for (int i = 0; i < DANP_MAX_SOCKET_COUNT; i++)
-        {
-            if (socket_pool[i].state == DANP_SOCK_CLOSED && socket_pool[i].local_port == 0)
-            {
-                slot = &socket_pool[i];
-                break;
-            }
-        }
+    return (sock->rx_wnd_advertised == 0U) || ((uint16_t)(window - sock->rx_wnd_advertised) >= (full_window / 2U));
+}
 
-        if (slot == NULL)
-        {
-            danp_log_message(DANP_LOG_ERROR, "Socket allocation failed: No free slots");
-            break; // Jump to cleanup
-        }
+/**
+ * @brief Append in-order data to the receive ring of a STREAM socket.
+ * @param sock Pointer to the socket.
+ * @param data Data to append.
+ * @param len Length of the data, at most the free space of the ring.
+ */
+static void danp_stream_rx_write(danp_socket_t *sock, const uint8_t *data, uint16_t len)
+{
+    uint16_t tail = (uint16_t)((sock->rx_head + sock->rx_count) % DANP_STREAM_RX_BUFFER_SIZE);
+    uint16_t first = (len < DANP_STREAM_RX_BUFFER_SIZE - tail) ? len : (uint16_t)(DANP_STREAM_RX_BUFFER_SIZE - tail);
 
-        if (socket_list == slot)
-        {
-            socket_list = slot->next;
-        }
-        else
-        {
-            for (int i = 0; i < DANP_MAX_SOCKET_COUNT; i++)
-            {
-                if (socket_pool[i].next == slot)
-                {
-                    socket_pool[i].next = slot->next;
-                    break;
-                }
-            }
-        }
+    memcpy(&sock->rx_buf[tail], data, first);
+    memcpy(sock->rx_buf, data + first, len - first);
+    sock->rx_count += len;
+}
 
-        rx_q = slot->rx_queue;
-        acc_q = slot->accept_queue;
-        sig = slot->signal;
+/**
+ * @brief Take data from the receive ring of a STREAM socket.
+ * @param sock Pointer to the socket.
+ * @param buffer Destination buffer.
+ * @param max_len Size of the destination buffer.
+ * @return Number of bytes copied.
+ */
+static uint16_t danp_stream_rx_read(danp_socket_t *sock, uint8_t *buffer, uint16_t max_len)
+{
+    uint16_t len = (max_len < sock->rx_count) ? max_len : sock->rx_count;
+    uint16_t first = (len < DANP_STREAM_RX_BUFFER_SIZE - sock->rx_head) ? len : (uint16_t)(DANP_STREAM_RX_BUFFER_SIZE - sock->rx_head);
 
-        memset(slot, 0, sizeof(danp_socket_t));
+    if (len == 0U)
+    {
+        // Sockets that were never connected have no ring.
+        return 0;
+    }
 
-        slot->rx_queue = rx_q;
-        slot->accept_queue = acc_q;
-        slot->signal = sig;
+    memcpy(buffer, &sock->rx_buf[sock->rx_head], first);
+    memcpy(buffer + first, sock->rx_buf, len - first);
+    sock->rx_head = (uint16_t)((sock->rx_head + len) % DANP_STREAM_RX_BUFFER_SIZE);
+    sock->rx_count -= len;
+    return len;
+}
 
-        slot->type = type;
-        slot->state = DANP_SOCK_OPEN; // Temporarily mark open
-        slot->local_node = danp_config.local_node;
+/**
+ * @brief Lend a receive ring to a STREAM connection that has none yet (mutex_socket held).
+ * @param sock Pointer to the socket.
+ * @return 0 on success, negative if every ring is in use.
+ */
+static int32_t danp_stream_ring_take(danp_socket_t *sock)
+{
+    if (sock->rx_buf)
+    {
+        return 0;
+    }
 
-        if (slot->rx_queue == NULL)
-        {
-            slot->rx_queue = osalMessageQueueCreate(10, sizeof(danp_packet_t *), &mq_attr);
-        }
-        if (slot->accept_queue == NULL)
-        {
-            slot->accept_queue = osalMessageQueueCreate(5, sizeof(danp_socket_t *), &mq_attr);
-        }
-        if (slot->signal == NULL)
+    for (int i = 0; i < DANP_STREAM_RX_RING_COUNT; i++)
+    {
+        if (!rx_ring_used[i])
         {
-            slot->signal = osalSemaphoreCreate(&sem_attr);
+            rx_ring_used[i] = true;
+            sock->rx_buf = rx_ring_pool[i];
+            return 0;
         }
+    }
 
-        if (slot->rx_queue == NULL || slot->accept_queue == NULL || slot->signal == NULL)
-        {
-            danp_log_message(DANP_LOG_ERROR, "Socket allocation failed: OS Resource Error");
+    return -1;
+}
 
-            slot->state = DANP_SOCK_CLOSED;
+/**
+ * @brief Give the receive ring of a socket back to the pool, discarding unread data (mutex_socket held).
+ * @param sock Pointer to the socket.
+ */
+static void danp_stream_ring_release(danp_socket_t *sock)
+{
+    if (sock->rx_buf)
+    {
+        rx_ring_used[(sock->rx_buf - &rx_ring_pool[0][0]) / DANP_STREAM_RX_BUFFER_SIZE] = false;
+        sock->rx_buf = NULL;
+    }
+    sock->rx_head = 0;
+    sock->rx_count = 0;
+}
 
-            break; // Jump to cleanup
-        }
+/**
+ * @brief Recover a full sequence number from the low byte carried by a legacy peer.
+ * @param ref Sequence number the received one is expected to be close to.
+ * @param wire Low byte received on the wire.
+ * @return Sequence number nearest to ref with the given low byte.
+ */
+static uint16_t danp_stream_seq_extend(uint16_t ref, uint8_t wire)
+{
+    return (uint16_t)(ref + (int8_t)(uint8_t)(wire - (uint8_t)ref));
+}
 
-        danp_packet_t *garbage_pkt;
-        danp_socket_t *garbage_sock;
+/**
+ * @brief Write a v2 STREAM header at the start of a packet payload.
+ *
+ * The ACK number and window always reflect the current receive state, so a
+ * header written here acknowledges everything received so far.
+ *
+ * @param sock Pointer to the socket.
+ * @param pkt Packet to write the header into.
+ * @param seq Sequence number of the segment.
+ */
+static void danp_stream_write_header(danp_socket_t *sock, danp_packet_t *pkt, uint16_t seq)
+{
+    uint16_t ack = (uint16_t)(sock->rx_expected_seq - 1U);
 
-        while (osalMessageQueueReceive(slot->rx_queue, &garbage_pkt, 0) == 0)
-        {
-            danp_buffer_free(garbage_pkt);
-        }
-        while (osalMessageQueueReceive(slot->accept_queue, &garbage_sock, 0) == 0)
-        {
-            // Just drain
-        }
+    sock->rx_wnd_advertised = danp_stream_rx_window(sock);
 
-        slot->next = socket_list;
-        socket_list = slot;
+    pkt->payload[DANP_STREAM_HDR_VER_OPT] = (uint8_t)(DANP_STREAM_V2 << DANP_STREAM_VERSION_SHIFT);
+    pkt->payload[DANP_STREAM_HDR_SEQ] = (uint8_t)(seq >> 8);
+    pkt->payload[DANP_STREAM_HDR_SEQ + 1] = (uint8_t)seq;
+    pkt->payload[DANP_STREAM_HDR_ACK] = (uint8_t)(ack >> 8);
+    pkt->payload[DANP_STREAM_HDR_ACK + 1] = (uint8_t)ack;
+    pkt->payload[DANP_STREAM_HDR_WND] = (uint8_t)(sock->rx_wnd_advertised >> 8);
+    pkt->payload[DANP_STREAM_HDR_WND + 1] = (uint8_t)sock->rx_wnd_advertised;
+}
 
-        created_socket = slot;
+/**
+ * @brief Parse a v2 STREAM header.
+ * @param pkt Received packet.
+ * @param seq Pointer to store the sequence number.
+ * @param ack Pointer to store the ACK number.
+ * @param wnd Pointer to store the advertised window.
+ * @return true if the packet starts with a valid v2 header.
+ */
+static bool danp_stream_parse_header(const danp_packet_t *pkt, uint16_t *seq, uint16_t *ack, uint16_t *wnd)
+{
+    if (pkt->length < DANP_STREAM_HEADER_SIZE ||
+        (pkt->payload[DANP_STREAM_HDR_VER_OPT] >> DANP_STREAM_VERSION_SHIFT) != DANP_STREAM_V2)
+    {
+        return false;
+    }
 
-        break;
+    // Option bits other than FIN are reserved: ignored on receive, sent as zero.
+    *seq = (uint16_t)((pkt->payload[DANP_STREAM_HDR_SEQ] << 8) | pkt->payload[DANP_STREAM_HDR_SEQ + 1]);
+    *ack = (uint16_t)((pkt->payload[DANP_STREAM_HDR_ACK] << 8) | pkt->payload[DANP_STREAM_HDR_ACK + 1]);
+    *wnd = (uint16_t)((pkt->payload[DANP_STREAM_HDR_WND] << 8) | pkt->payload[DANP_STREAM_HDR_WND + 1]);
+    return true;
+}
+
+/**
+ * @brief Hold a packet for transmission once the caller has released its locks.
+ *
+ * Transmitting on a loopback or synchronous driver re-enters the input path,
+ * which locks the receiving socket; doing that under another socket lock
+ * would let two threads deadlock. The packet is copied, so the caller keeps
+ * ownership of it.
+ *
+ * @param pkt Packet to transmit.
+ */
+static void danp_tx_defer(const danp_packet_t *pkt)
+{
+    danp_packet_t *slot;
+
+    if (osalMutexLock(mutex_tx, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+    {
+        /* LCOV_EXCL_START */
+        return;
+        /* LCOV_EXCL_STOP */
     }
 
-    if (is_mutex_taken)
+    if (tx_backlog_count >= DANP_TX_BACKLOG_SIZE)
     {
-        osalMutexUnlock(mutex_socket);
+        // Retransmission recovers the packet, as it would a loss on the link.
+        tx_backlog_drops++;
+        osalMutexUnlock(mutex_tx);
+        danp_log_message(DANP_LOG_WARN, "Transmit backlog full. Dropping packet.");
+        return;
     }
 
-    return created_socket;
+    slot = &tx_backlog[(tx_backlog_head + tx_backlog_count) % DANP_TX_BACKLOG_SIZE];
+    slot->header_raw = pkt->header_raw;
+    slot->length = pkt->length;
+    slot->rx_interface = NULL;
+    memcpy(slot->payload, pkt->payload, pkt->length);
+    tx_backlog_count++;
+
+    osalMutexUnlock(mutex_tx);
 }
 
 /**
- * @brief Bind a socket to a local port.
- * @param sock Pointer to the socket.
- * @param port Local port to bind to.
- * @return 0 on success, negative on error.
+ * @brief Transmit the packets held by danp_tx_defer().
+ *
+ * Must be called with no socket lock held. Only one thread transmits at a
+ * time, which keeps the packets in order; packets deferred meanwhile, also
+ * from the input path re-entered by a loopback driver, are sent by that
+ * thread before it returns.
  */
-int32_t danp_bind(danp_socket_t *sock, uint16_t port)
+static void danp_tx_flush(void)
 {
-    int32_t ret = 0;
-    osalStatus_t osal_status;
-    bool is_mutex_taken = false;
+    danp_packet_t pkt;
 
-    for (;;)
+    // Callers expect their packets to be handed to the driver on return; if another thread is
+    // draining, wait for it. The lock is recursive, so a loopback re-entering here passes.
+    if (osalMutexLock(mutex_tx_drain, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
     {
-        osal_status = osalMutexLock(mutex_socket, OSAL_WAIT_FOREVER);
-        if (osal_status != OSAL_SUCCESS)
-        {
-            danp_log_message(DANP_LOG_ERROR, "Socket bind failed: Mutex Lock Error");
-            ret = -1;
-            break;
-        }
-        is_mutex_taken = true;
+        /* LCOV_EXCL_START */
+        return;
+        /* LCOV_EXCL_STOP */
+    }
 
-        if (port == 0)
-        {
-            uint16_t start_port = next_ephemeral_port;
+    if (osalMutexLock(mutex_tx, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+    {
+        /* LCOV_EXCL_START */
+        osalMutexUnlock(mutex_tx_drain);
+        return;
+        /* LCOV_EXCL_STOP */
+    }
+
+    if (tx_backlog_draining)
+    {
+        // Re-entered from the driver: the outer loop sends what was just queued.
+        osalMutexUnlock(mutex_tx);
+        osalMutexUnlock(mutex_tx_drain);
+        return;
+    }
+    tx_backlog_draining = true;
+
+    while (tx_backlog_count > 0U)
+    {
+        danp_packet_t *head = &tx_backlog[tx_backlog_head];
+
+        pkt.header_raw = head->header_raw;
+        pkt.length = head->length;
+        pkt.rx_interface = NULL;
+        memcpy(pkt.payload, head->payload, head->length);
+        tx_backlog_head = (uint16_t)((tx_backlog_head + 1U) % DANP_TX_BACKLOG_SIZE);
+        tx_backlog_count--;
+
+        osalMutexUnlock(mutex_tx);
+        danp_route_tx(&pkt);
+        while (osalMutexLock(mutex_tx, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+        {
+            /* LCOV_EXCL_START */
+            osalDelayMs(1);
+            /* LCOV_EXCL_STOP */
+        }
+    }
+
+    tx_backlog_draining = false;
+    osalMutexUnlock(mutex_tx);
+    osalMutexUnlock(mutex_tx_drain);
+}
+
+/**
+ * @brief Make sure the timer thread wakes up by a deadline.
+ * @param deadline_ms Tick at which a timer was just armed to expire.
+ */
+static void danp_timer_wake(uint32_t deadline_ms)
+{
+    if (!timer_signal)
+    {
+        // The application drives the timers through danp_timer_tick().
+        return;
+    }
+
+    if (osalMutexLock(mutex_timer, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+    {
+        /* LCOV_EXCL_START */
+        return;
+        /* LCOV_EXCL_STOP */
+    }
+
+    if (timer_sweeping || timer_idle || (int32_t)(deadline_ms - timer_wake_ms) < 0)
+    {
+        if (!timer_sweeping)
+        {
+            timer_idle = false;
+            timer_wake_ms = deadline_ms;
+        }
+        osalSemaphoreGive(timer_signal);
+    }
+
+    osalMutexUnlock(mutex_timer);
+}
+
+/**
+ * @brief Start or restart a protocol timer of a socket.
+ *
+ * Must be called with the socket lock held.
+ *
+ * @param sock Pointer to the socket.
+ * @param id Timer to start.
+ * @param deadline_ms Tick at which the timer expires.
+ */
+static void danp_timer_arm(danp_socket_t *sock, danp_timer_id_t id, uint32_t deadline_ms)
+{
+    sock->timer_deadline_ms[id] = deadline_ms;
+    sock->timers_armed |= (uint8_t)(1U << id);
+    danp_timer_wake(deadline_ms);
+}
+
+/**
+ * @brief Stop a protocol timer of a socket.
+ * @param sock Pointer to the socket.
+ * @param id Timer to stop.
+ */
+static void danp_timer_cancel(danp_socket_t *sock, danp_timer_id_t id)
+{
+    sock->timers_armed &= (uint8_t)~(1U << id);
+}
+
+/**
+ * @brief Check whether a protocol timer of a socket is running.
+ * @param sock Pointer to the socket.
+ * @param id Timer to check.
+ * @return true if the timer is running.
+ */
+static bool danp_timer_running(const danp_socket_t *sock, danp_timer_id_t id)
+{
+    return (sock->timers_armed & (1U << id)) != 0U;
+}
+
+/**
+ * @brief Check whether a running protocol timer of a socket has expired.
+ * @param sock Pointer to the socket.
+ * @param id Timer to check.
+ * @param now Current tick.
+ * @return true if the timer is running and its deadline has passed.
+ */
+static bool danp_timer_expired(const danp_socket_t *sock, danp_timer_id_t id, uint32_t now)
+{
+    return danp_timer_running(sock, id) && (int32_t)(now - sock->timer_deadline_ms[id]) >= 0;
+}
+
+/**
+ * @brief Send a control packet.
+ *
+ * On v2 STREAM connections SYN and ACK packets carry a full transport header;
+ * a SYN with that header is how a node offers v2 to its peer.
+ *
+ * @param sock Pointer to the socket.
+ * @param flags Control flags to send.
+ * @param seq_num Sequence number (for ACK packets on legacy connections).
+ */
+static void danp_send_control(danp_socket_t *sock, uint8_t flags, uint16_t seq_num)
+{
+    // The transmit backlog takes a copy, so a stack packet spares the pool.
+    danp_packet_t pkt;
+
+    pkt.header_raw = danp_pack_header(
+        0,
+        sock->remote_node,
+        sock->local_node,
+        sock->remote_port,
+        sock->local_port,
+        flags);
+    pkt.rx_interface = NULL;
+
+    if (sock->type == DANP_TYPE_STREAM && sock->version == DANP_STREAM_V2 && !(flags & DANP_FLAG_RST))
+    {
+        danp_stream_write_header(sock, &pkt, sock->snd_nxt);
+        pkt.length = DANP_STREAM_HEADER_SIZE;
+    }
+    else if ((flags & DANP_FLAG_ACK) && sock->type == DANP_TYPE_STREAM)
+    {
+        pkt.payload[0] = (uint8_t)seq_num;
+        pkt.length = DANP_STREAM_V1_HEADER_SIZE;
+    }
+    else
+    {
+        pkt.length = 0;
+    }
+
+    if (flags & DANP_FLAG_ACK)
+    {
+        // Any ACK we send supersedes the one being held back.
+        sock->ack_pending = false;
+        sock->ack_unsent_count = 0;
+        danp_timer_cancel(sock, DANP_TIMER_ACK);
+    }
+
+    danp_tx_defer(&pkt);
+}
+
+/**
+ * @brief Send the delayed ACK of a socket now, if one is pending.
+ * @param sock Pointer to the socket.
+ */
+static void danp_ack_flush(danp_socket_t *sock)
+{
+    if (sock->ack_pending)
+    {
+        danp_send_control(sock, DANP_FLAG_ACK, sock->ack_seq);
+    }
+}
+
+/**
+ * @brief Account for an in-order segment and ACK it now or later.
+ *
+ * The ACK is held back for up to DANP_ACK_DELAY_MS so that it can ride on
+ * reverse-direction data, and is sent immediately once
+ * DANP_ACK_COALESCE_COUNT segments are covered by it.
+ *
+ * @param sock Pointer to the socket.
+ * @param seq Sequence number of the accepted segment.
+ */
+static void danp_ack_schedule(danp_socket_t *sock, uint16_t seq)
+{
+    sock->ack_seq = seq;
+    sock->ack_unsent_count++;
+
+    if (!sock->ack_pending)
+    {
+        sock->ack_pending = true;
+        danp_timer_arm(sock, DANP_TIMER_ACK, osalGetTickMs() + DANP_ACK_DELAY_MS);
+    }
+
+    if (sock->ack_unsent_count >= DANP_ACK_COALESCE_COUNT)
+    {
+        danp_ack_flush(sock);
+    }
+}
+
+/**
+ * @brief Release every segment held in the send window.
+ * @param sock Pointer to the socket.
+ */
+static void danp_stream_release_tx(danp_socket_t *sock)
+{
+    for (int i = 0; i < DANP_STREAM_TX_WINDOW; i++)
+    {
+        if (sock->tx_queue[i].pkt)
+        {
+            danp_buffer_free(sock->tx_queue[i].pkt);
+            sock->tx_queue[i].pkt = NULL;
+        }
+    }
+}
+
+/**
+ * @brief Reset the reliability and congestion state of a STREAM socket.
+ * @param sock Pointer to the socket.
+ */
+static void danp_stream_reset(danp_socket_t *sock)
+{
+    danp_stream_release_tx(sock);
+
+    sock->tx_seq = 0;
+    sock->rx_expected_seq = 0;
+    sock->snd_una = 0;
+    sock->snd_nxt = 0;
+    sock->snd_max = 0;
+    sock->dupack_count = 0;
+    sock->retries = 0;
+    sock->rto_ms = DANP_ACK_TIMEOUT_MS;
+    sock->srtt_ms = 0;
+    sock->rttvar_ms = 0;
+    sock->ack_pending = false;
+    sock->ack_unsent_count = 0;
+    sock->timers_armed = 0;
+    sock->fin_pending = false;
+    sock->peer_fin = false;
+
+    // Offer v2 until the peer shows it only speaks the legacy format.
+    sock->version = DANP_STREAM_V2;
+
+    // The peer advertises its real window during the handshake.
+    sock->peer_wnd = 1;
+    sock->rx_head = 0;
+    sock->rx_count = 0;
+    sock->rx_wnd_advertised = danp_stream_rx_window(sock);
+
+    if (!sock->cc_ops)
+    {
+        sock->cc_ops = danp_congestion_get_default();
+    }
+    sock->cc_ops->init(sock);
+}
+
+/**
+ * @brief Check whether a connection is still where its handshake left it.
+ * @param sock Pointer to the socket.
+ * @return true if nothing has been sent or received past the initial sequence numbers.
+ */
+static bool danp_stream_fresh(const danp_socket_t *sock)
+{
+    return sock->tx_seq == 0U && sock->rx_expected_seq == 0U;
+}
+
+/**
+ * @brief Wake every thread blocked in danp_poll() to re-evaluate readiness.
+ */
+static void danp_poll_notify(void)
+{
+    if (osalMutexLock(mutex_poll, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+    {
+        /* LCOV_EXCL_START */
+        return;
+        /* LCOV_EXCL_STOP */
+    }
+
+    for (int i = 0; i < DANP_POLL_MAX_WAITERS; i++)
+    {
+        if (poll_waiters[i].in_use)
+        {
+            osalSemaphoreGive(poll_waiters[i].signal);
+        }
+    }
+
+    osalMutexUnlock(mutex_poll);
+}
+
+/**
+ * @brief Report an event to the callback of a socket, if it has one.
+ * @param sock Pointer to the socket.
+ * @param event Event that occurred.
+ */
+static void danp_socket_event(danp_socket_t *sock, danp_socket_event_t event)
+{
+    if (sock->event_cb)
+    {
+        sock->event_cb(sock, event, sock->event_cb_data);
+    }
+}
+
+/**
+ * @brief Count a datagram taken from the receive queue outside the socket lock.
+ * @param sock Pointer to the socket.
+ */
+static void danp_socket_dequeued(danp_socket_t *sock)
+{
+    if (osalMutexLock(sock->lock, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+    {
+        /* LCOV_EXCL_START */
+        return;
+        /* LCOV_EXCL_STOP */
+    }
+
+    if (sock->rx_pending > 0U)
+    {
+        sock->rx_pending--;
+    }
+
+    osalMutexUnlock(sock->lock);
+}
+
+/**
+ * @brief Append a new connection to the backlog of its listener.
+ *
+ * Backlogs belong to the socket index, so mutex_socket must be held.
+ *
+ * @param listener Pointer to the listening socket.
+ * @param child Pointer to the new connection.
+ */
+static void danp_backlog_push(danp_socket_t *listener, danp_socket_t *child)
+{
+    danp_socket_t **link = &listener->accept_head;
+
+    while (*link)
+    {
+        link = &(*link)->accept_next;
+    }
+    *link = child;
+    child->accept_next = NULL;
+    child->listener = listener;
+    listener->accept_pending++;
+}
+
+/**
+ * @brief Take a connection out of the backlog it waits in, if any (mutex_socket held).
+ * @param child Pointer to the connection.
+ */
+static void danp_backlog_remove(danp_socket_t *child)
+{
+    danp_socket_t *listener = child->listener;
+    danp_socket_t **link;
+
+    if (!listener)
+    {
+        return;
+    }
+
+    for (link = &listener->accept_head; *link; link = &(*link)->accept_next)
+    {
+        if (*link == child)
+        {
+            *link = child->accept_next;
+            listener->accept_pending--;
+            break;
+        }
+    }
+    child->accept_next = NULL;
+    child->listener = NULL;
+}
+
+/**
+ * @brief Take a socket out of the socket list and give its slot back (mutex_socket held).
+ *
+ * A connection that closed first leaves a TIME_WAIT entry behind.
+ *
+ * @param sock Pointer to the socket.
+ */
+static void danp_socket_release_slot(danp_socket_t *sock)
+{
+    if (socket_list == sock)
+    {
+        socket_list = sock->next;
+    }
+    else
+    {
+        danp_socket_t *prev = socket_list;
+        while (prev && prev->next != sock)
+        {
+            prev = prev->next;
+        }
+        if (prev && prev->next == sock)
+        {
+            prev->next = sock->next;
+        }
+    }
+    sock->next = NULL;
+
+    if (sock->time_wait)
+    {
+        danp_time_wait_add(sock);
+        sock->time_wait = false;
+    }
+
+    danp_stream_ring_release(sock);
+    sock->state = DANP_SOCK_CLOSED;
+    sock->local_port = 0;
+}
+
+/**
+ * @brief Tear down a STREAM connection and wake every thread blocked on it.
+ *
+ * Leaves any backlog, so both mutex_socket and the socket lock must be held.
+ *
+ * @param sock Pointer to the socket.
+ */
+static void danp_stream_drop(danp_socket_t *sock)
+{
+    danp_packet_t *null_pkt = NULL;
+
+    danp_stream_release_tx(sock);
+    sock->ack_pending = false;
+    sock->timers_armed = 0;
+    sock->fin_pending = false;
+    sock->time_wait = false;
+    sock->state = DANP_SOCK_CLOSED;
+
+    // The application may still close this handle, so the slot is handed out again only as a
+    // last resort. Connections reset before they were accepted or after they were closed have
+    // no owner and free it here.
+    if (sock->listener)
+    {
+        danp_backlog_remove(sock);
+        danp_stream_ring_release(sock);
+        sock->local_port = 0;
+    }
+    else if (sock->orphan)
+    {
+        danp_socket_release_slot(sock);
+    }
+
+    // Wake up any waiters on recv and send
+    if (sock->rx_queue)
+    {
+        osalMessageQueueSend(sock->rx_queue, &null_pkt, 0);
+    }
+    if (sock->signal)
+    {
+        osalSemaphoreGive(sock->signal);
+    }
+    danp_poll_notify();
+    danp_socket_event(sock, DANP_EVENT_RESET);
+}
+
+/**
+ * @brief Feed a round trip time sample into the RTO estimator (RFC 6298).
+ * @param sock Pointer to the socket.
+ * @param rtt_ms Measured round trip time.
+ */
+static void danp_stream_update_rtt(danp_socket_t *sock, uint32_t rtt_ms)
+{
+    uint32_t rto;
+
+    if (sock->srtt_ms == 0)
+    {
+        sock->srtt_ms = rtt_ms ? rtt_ms : 1U;
+        sock->rttvar_ms = rtt_ms / 2U;
+    }
+    else
+    {
+        uint32_t delta = (sock->srtt_ms > rtt_ms) ? (sock->srtt_ms - rtt_ms) : (rtt_ms - sock->srtt_ms);
+        sock->rttvar_ms = (3U * sock->rttvar_ms + delta) / 4U;
+        sock->srtt_ms = (7U * sock->srtt_ms + rtt_ms) / 8U;
+    }
+
+    rto = sock->srtt_ms + 4U * sock->rttvar_ms;
+    if (rto < DANP_RTO_MIN_MS)
+    {
+        rto = DANP_RTO_MIN_MS;
+    }
+    if (rto > DANP_RTO_MAX_MS)
+    {
+        rto = DANP_RTO_MAX_MS;
+    }
+    sock->rto_ms = rto;
+}
+
+/**
+ * @brief Transmit a queued segment.
+ *
+ * On v2 connections every segment carries the current ACK and window. Legacy
+ * peers cannot parse a piggybacked ACK, so their segments go out unchanged.
+ *
+ * @param sock Pointer to the socket.
+ * @param seg Segment to transmit.
+ */
+static void danp_stream_transmit(danp_socket_t *sock, danp_stream_segment_t *seg)
+{
+    danp_packet_t *pkt = seg->pkt;
+
+    if (sock->version == DANP_STREAM_V2)
+    {
+        uint16_t seq = (uint16_t)((pkt->payload[DANP_STREAM_HDR_SEQ] << 8) | pkt->payload[DANP_STREAM_HDR_SEQ + 1]);
+
+        pkt->header_raw = danp_pack_header(
+            0,
+            sock->remote_node,
+            sock->local_node,
+            sock->remote_port,
+            sock->local_port,
+            DANP_FLAG_ACK);
+        danp_stream_write_header(sock, pkt, seq);
+        if (seg->fin)
+        {
+            pkt->payload[DANP_STREAM_HDR_VER_OPT] |= DANP_STREAM_OPT_FIN;
+        }
+
+        sock->ack_pending = false;
+        sock->ack_unsent_count = 0;
+        danp_timer_cancel(sock, DANP_TIMER_ACK);
+    }
+
+    danp_tx_defer(pkt);
+}
+
+/**
+ * @brief Get the open tail segment that small writes may be merged into.
+ *
+ * Only a segment that has never been transmitted and has not been pushed
+ * qualifies, so coalescing can never change bytes already on the wire.
+ *
+ * @param sock Pointer to the socket.
+ * @return Tail segment with room left, or NULL.
+ */
+static danp_stream_segment_t *danp_stream_open_tail(danp_socket_t *sock)
+{
+    danp_stream_segment_t *tail;
+
+    if (!sock->coalesce || sock->tx_seq == sock->snd_max)
+    {
+        return NULL;
+    }
+
+    tail = &sock->tx_queue[(uint16_t)(sock->tx_seq - 1U) % DANP_STREAM_TX_WINDOW];
+    if (tail->push || tail->pkt->length - danp_stream_header_size(sock) >= sock->tx_mss)
+    {
+        return NULL;
+    }
+
+    return tail;
+}
+
+/**
+ * @brief Check whether small-write coalescing holds a segment back.
+ *
+ * A short open tail waits while earlier data is unacknowledged, so the next
+ * writes can join it; the ACK that empties the pipe releases it.
+ *
+ * @param sock Pointer to the socket.
+ * @param seq Sequence number about to be transmitted.
+ * @return true if the segment must not be sent yet.
+ */
+static bool danp_stream_segment_held(danp_socket_t *sock, uint16_t seq)
+{
+    return (uint16_t)(seq + 1U) == sock->tx_seq && sock->snd_una != sock->snd_max &&
+           danp_stream_open_tail(sock) != NULL;
+}
+
+/**
+ * @brief Transmit queued segments as far as the congestion and peer windows allow.
+ * @param sock Pointer to the socket.
+ */
+static void danp_stream_output(danp_socket_t *sock)
+{
+    uint16_t window = sock->cwnd;
+    uint32_t now = osalGetTickMs();
+
+    if (window > DANP_STREAM_TX_WINDOW)
+    {
+        window = DANP_STREAM_TX_WINDOW;
+    }
+    if (window == 0U)
+    {
+        window = 1U;
+    }
+    if (window > sock->peer_wnd)
+    {
+        window = sock->peer_wnd;
+    }
+
+    if (sock->version == DANP_STREAM_V1 && window > 1U)
+    {
+        // Legacy receivers ACK out-of-order segments individually, which only
+        // reads as a cumulative ACK with a single segment in flight.
+        window = 1U;
+    }
+
+    while (sock->snd_nxt != sock->tx_seq && (uint16_t)(sock->snd_nxt - sock->snd_una) < window)
+    {
+        danp_stream_segment_t *seg = &sock->tx_queue[sock->snd_nxt % DANP_STREAM_TX_WINDOW];
+
+        if (danp_stream_segment_held(sock, sock->snd_nxt))
+        {
+            break;
+        }
+
+        if (sock->snd_max != sock->snd_nxt)
+        {
+            seg->retransmitted = true;
+        }
+        seg->sent_ms = now;
+
+        // Account for the segment first: a loopback peer may ACK it before transmit returns.
+        sock->snd_nxt++;
+        if ((uint16_t)(sock->snd_nxt - sock->snd_una) > (uint16_t)(sock->snd_max - sock->snd_una))
+        {
+            sock->snd_max = sock->snd_nxt;
+        }
+
+        if (!danp_timer_running(sock, DANP_TIMER_RTO))
+        {
+            danp_timer_arm(sock, DANP_TIMER_RTO, now + sock->rto_ms);
+        }
+
+        danp_stream_transmit(sock, seg);
+    }
+
+    if (!danp_timer_running(sock, DANP_TIMER_RTO) && sock->peer_wnd == 0U && sock->tx_seq != sock->snd_una)
+    {
+        // Zero window with data waiting: the timer doubles as the persist timer.
+        danp_timer_arm(sock, DANP_TIMER_RTO, now + sock->rto_ms);
+    }
+}
+
+/**
+ * @brief Send the oldest unacknowledged segment to probe a zero receive window.
+ *
+ * The peer drops the probe if it is still full, but has to answer it with an
+ * ACK, so a lost window update cannot stall the connection.
+ *
+ * @param sock Pointer to the socket.
+ * @param now Current tick.
+ */
+static void danp_stream_probe(danp_socket_t *sock, uint32_t now)
+{
+    danp_stream_segment_t *seg = &sock->tx_queue[sock->snd_una % DANP_STREAM_TX_WINDOW];
+
+    if (seg->pkt)
+    {
+        if (sock->snd_max != sock->snd_una)
+        {
+            seg->retransmitted = true;
+        }
+        seg->sent_ms = now;
+
+        sock->snd_nxt = (uint16_t)(sock->snd_una + 1U);
+        if (sock->snd_max == sock->snd_una)
+        {
+            sock->snd_max = sock->snd_nxt;
+        }
+    }
+
+    danp_timer_arm(sock, DANP_TIMER_RTO, now + sock->rto_ms);
+
+    if (seg->pkt)
+    {
+        danp_stream_transmit(sock, seg);
+    }
+}
+
+/**
+ * @brief Queue the FIN of a connection whose sending side was shut down, once there is room for it.
+ *
+ * The FIN takes a sequence number and a slot of the send window like a data
+ * segment, so it is retransmitted and acknowledged the same way. If the
+ * window or the packet pool is full, the next ACK or timer sweep tries again.
+ *
+ * @param sock Pointer to the socket.
+ */
+static void danp_stream_queue_fin(danp_socket_t *sock)
+{
+    danp_packet_t *pkt;
+    danp_stream_segment_t *seg;
+
+    if (!sock->fin_pending || (uint16_t)(sock->tx_seq - sock->snd_una) >= DANP_STREAM_TX_WINDOW)
+    {
+        return;
+    }
+
+    pkt = danp_buffer_allocate();
+    if (!pkt)
+    {
+        return;
+    }
+
+    // Whatever coalescing holds back goes out ahead of the FIN.
+    if (sock->tx_seq != sock->snd_una)
+    {
+        sock->tx_queue[(uint16_t)(sock->tx_seq - 1U) % DANP_STREAM_TX_WINDOW].push = true;
+    }
+
+    pkt->header_raw = danp_pack_header(
+        0,
+        sock->remote_node,
+        sock->local_node,
+        sock->remote_port,
+        sock->local_port,
+        DANP_FLAG_NONE);
+    danp_stream_write_header(sock, pkt, sock->tx_seq);
+    pkt->payload[DANP_STREAM_HDR_VER_OPT] |= DANP_STREAM_OPT_FIN;
+    pkt->length = DANP_STREAM_HEADER_SIZE;
+
+    seg = &sock->tx_queue[sock->tx_seq % DANP_STREAM_TX_WINDOW];
+    seg->pkt = pkt;
+    seg->retransmitted = false;
+    seg->push = true;
+    seg->fin = true;
+    sock->tx_seq++;
+    sock->fin_pending = false;
+
+    danp_stream_output(sock);
+}
+
+/**
+ * @brief Shut down the sending side of a STREAM connection.
+ * @param sock Pointer to the socket.
+ * @return 0 on success (or if it was already shut down), negative if the connection cannot send a FIN.
+ */
+static int32_t danp_stream_start_shutdown(danp_socket_t *sock)
+{
+    if (sock->version != DANP_STREAM_V2)
+    {
+        // Legacy peers have no FIN; they only learn of a close through a reset.
+        return -1;
+    }
+
+    switch (sock->state)
+    {
+    case DANP_SOCK_ESTABLISHED:
+    case DANP_SOCK_SYN_RECEIVED:
+        sock->state = DANP_SOCK_FIN_WAIT;
+        break;
+    case DANP_SOCK_CLOSE_WAIT:
+        sock->state = DANP_SOCK_LAST_ACK;
+        break;
+    case DANP_SOCK_FIN_WAIT:
+    case DANP_SOCK_LAST_ACK:
+        return 0;
+    default:
+        return -1;
+    }
+
+    sock->fin_pending = true;
+    danp_stream_queue_fin(sock);
+
+    // Writers blocked on the send window give up now.
+    osalSemaphoreGive(sock->signal);
+
+    return 0;
+}
+
+/**
+ * @brief Check whether everything sent on a closing connection, FIN included, is acknowledged.
+ * @param sock Pointer to the socket.
+ * @return true if our FIN is acknowledged.
+ */
+static bool danp_stream_fin_acked(const danp_socket_t *sock)
+{
+    return (sock->state == DANP_SOCK_FIN_WAIT || sock->state == DANP_SOCK_LAST_ACK) && !sock->fin_pending &&
+           sock->snd_una == sock->tx_seq;
+}
+
+/**
+ * @brief Complete the orderly shutdown of a connection once both FINs are acknowledged.
+ *
+ * A connection the application already closed frees its slot, which needs
+ * mutex_socket to be held; otherwise the handle stays valid until it is
+ * closed and reads report the end of the stream.
+ *
+ * @param sock Pointer to the socket.
+ */
+static void danp_stream_finish(danp_socket_t *sock)
+{
+    danp_packet_t *wakeup = NULL;
+
+    if (!sock->peer_fin || !danp_stream_fin_acked(sock))
+    {
+        return;
+    }
+
+    danp_log_message(DANP_LOG_INFO, "Connection on Port %u closed", sock->local_port);
+
+    // Whoever sent the first FIN waits out stray segments of the connection.
+    sock->time_wait = (sock->state == DANP_SOCK_FIN_WAIT);
+    danp_stream_release_tx(sock);
+    sock->ack_pending = false;
+    sock->timers_armed = 0;
+    sock->state = DANP_SOCK_CLOSED;
+
+    if (sock->orphan)
+    {
+        danp_socket_release_slot(sock);
+    }
+    else
+    {
+        osalMessageQueueSend(sock->rx_queue, &wakeup, 0);
+        osalSemaphoreGive(sock->signal);
+    }
+    danp_poll_notify();
+}
+
+/**
+ * @brief Reset a closed connection whose shutdown did not complete in time.
+ * @param sock Pointer to the socket.
+ */
+static void danp_stream_close_timeout(danp_socket_t *sock)
+{
+    danp_log_message(DANP_LOG_WARN, "Shutdown timed out on Port %u. Resetting connection.", sock->local_port);
+    danp_send_control(sock, DANP_FLAG_RST, 0);
+    danp_stream_drop(sock);
+}
+
+/**
+ * @brief Process a cumulative ACK from the peer.
+ * @param sock Pointer to the socket.
+ * @param acked_seq Last sequence number the peer received in order.
+ * @param window Receive window advertised by the peer.
+ * @param pure The ACK came without data, so a repeated one signals loss.
+ */
+static void danp_stream_process_ack(danp_socket_t *sock, uint16_t acked_seq, uint16_t window, bool pure)
+{
+    uint16_t outstanding = (uint16_t)(sock->snd_max - sock->snd_una);
+    uint16_t newly_acked = (uint16_t)(acked_seq + 1U - sock->snd_una);
+    uint16_t previous_wnd = sock->peer_wnd;
+    bool was_full = (uint16_t)(sock->tx_seq - sock->snd_una) >= DANP_STREAM_TX_WINDOW;
+    int32_t rtt_sample = -1;
+    uint32_t now = osalGetTickMs();
+
+    if (newly_acked > outstanding)
+    {
+        // Stale or bogus ACK outside the send window.
+        return;
+    }
+
+    sock->peer_wnd = window;
+
+    if (newly_acked == 0U)
+    {
+        if (window == 0U)
+        {
+            // The peer is alive but full; keep probing without giving up on it.
+            sock->retries = 0;
+            sock->dupack_count = 0;
+            return;
+        }
+
+        if (previous_wnd == 0U)
+        {
+            // Window update: the peer drained its receive queue.
+            sock->dupack_count = 0;
+            sock->snd_nxt = sock->snd_una;
+            danp_timer_cancel(sock, DANP_TIMER_RTO);
+            danp_stream_output(sock);
+            osalSemaphoreGive(sock->signal);
+            return;
+        }
+
+        // Duplicate ACK: the peer is missing snd_una.
+        if (pure && outstanding > 0U && ++sock->dupack_count == DANP_DUPACK_THRESHOLD)
+        {
+            danp_log_message(DANP_LOG_DEBUG, "Fast retransmit of seq %u on Port %u", sock->snd_una, sock->local_port);
+            sock->cc_ops->on_loss(sock, DANP_CONGESTION_DUPACK);
+            sock->snd_nxt = sock->snd_una;
+            danp_timer_arm(sock, DANP_TIMER_RTO, now + sock->rto_ms);
+            danp_stream_output(sock);
+        }
+        return;
+    }
+
+    danp_stream_segment_t *last = &sock->tx_queue[acked_seq % DANP_STREAM_TX_WINDOW];
+    if (!last->retransmitted)
+    {
+        rtt_sample = (int32_t)(now - last->sent_ms);
+        danp_stream_update_rtt(sock, (uint32_t)rtt_sample);
+    }
+
+    for (uint16_t i = 0; i < newly_acked; i++)
+    {
+        danp_stream_segment_t *seg = &sock->tx_queue[(uint16_t)(sock->snd_una + i) % DANP_STREAM_TX_WINDOW];
+        if (seg->pkt)
+        {
+            danp_buffer_free(seg->pkt);
+            seg->pkt = NULL;
+        }
+        seg->retransmitted = false;
+    }
+
+    sock->snd_una = (uint16_t)(acked_seq + 1U);
+    if ((uint16_t)(sock->snd_nxt - sock->snd_una) > (uint16_t)(sock->snd_max - sock->snd_una))
+    {
+        // A go-back-N rewind fell behind the new ACK point.
+        sock->snd_nxt = sock->snd_una;
+    }
+    sock->dupack_count = 0;
+    sock->retries = 0;
+
+    sock->cc_ops->on_ack(sock, newly_acked, rtt_sample);
+    danp_stream_queue_fin(sock);
+
+    if (sock->snd_una == sock->snd_max)
+    {
+        danp_timer_cancel(sock, DANP_TIMER_RTO);
+    }
+    else
+    {
+        danp_timer_arm(sock, DANP_TIMER_RTO, now + sock->rto_ms);
+    }
+
+    danp_stream_output(sock);
+
+    // Room opened up in the send window.
+    osalSemaphoreGive(sock->signal);
+    if (was_full)
+    {
+        danp_socket_event(sock, DANP_EVENT_WRITABLE);
+    }
+}
+
+/**
+ * @brief Handle an expired retransmission timer.
+ * @param sock Pointer to the socket.
+ * @param now Current tick.
+ */
+static void danp_stream_timeout(danp_socket_t *sock, uint32_t now)
+{
+    sock->retries++;
+    if (sock->retries >= DANP_RETRY_LIMIT)
+    {
+        danp_log_message(DANP_LOG_WARN, "Retransmission limit reached on Port %u. Resetting connection.", sock->local_port);
+        danp_send_control(sock, DANP_FLAG_RST, 0);
+        danp_stream_drop(sock);
+        return;
+    }
+
+    if (sock->peer_wnd == 0U)
+    {
+        // Flow control, not congestion: the window stays as it is.
+        danp_stream_probe(sock, now);
+        return;
+    }
+
+    sock->cc_ops->on_loss(sock, DANP_CONGESTION_TIMEOUT);
+
+    sock->rto_ms *= 2U;
+    if (sock->rto_ms > DANP_RTO_MAX_MS)
+    {
+        sock->rto_ms = DANP_RTO_MAX_MS;
+    }
+
+    // Go back N: the receiver only accepts in-order segments.
+    sock->snd_nxt = sock->snd_una;
+    sock->dupack_count = 0;
+    danp_timer_arm(sock, DANP_TIMER_RTO, now + sock->rto_ms);
+    danp_stream_output(sock);
+}
+
+/**
+ * @brief Start watching a connection for idleness, if keepalive is enabled on it.
+ * @param sock Pointer to the socket.
+ * @param now Current tick.
+ */
+static void danp_keepalive_start(danp_socket_t *sock, uint32_t now)
+{
+    sock->last_rx_ms = now;
+    sock->keepalive_probes = 0;
+
+    if (sock->keepalive)
+    {
+        danp_timer_arm(sock, DANP_TIMER_KEEPALIVE, now + sock->keepalive_idle_ms);
+    }
+    else
+    {
+        danp_timer_cancel(sock, DANP_TIMER_KEEPALIVE);
+    }
+}
+
+/**
+ * @brief Send a keepalive probe.
+ *
+ * The probe carries one byte under a sequence number the peer has already
+ * received, so the peer discards it as a duplicate but answers with an ACK.
+ *
+ * @param sock Pointer to the socket.
+ */
+static void danp_keepalive_probe(danp_socket_t *sock)
+{
+    danp_packet_t pkt;
+    uint16_t seq = (uint16_t)(sock->snd_una - 1U);
+
+    pkt.rx_interface = NULL;
+
+    if (sock->version == DANP_STREAM_V2)
+    {
+        pkt.header_raw = danp_pack_header(
+            0,
+            sock->remote_node,
+            sock->local_node,
+            sock->remote_port,
+            sock->local_port,
+            DANP_FLAG_ACK);
+        danp_stream_write_header(sock, &pkt, seq);
+        pkt.length = DANP_STREAM_HEADER_SIZE;
+
+        sock->ack_pending = false;
+        sock->ack_unsent_count = 0;
+        danp_timer_cancel(sock, DANP_TIMER_ACK);
+    }
+    else
+    {
+        // Legacy peers expect either a bare ACK or data, never both.
+        pkt.header_raw = danp_pack_header(
+            0,
+            sock->remote_node,
+            sock->local_node,
+            sock->remote_port,
+            sock->local_port,
+            DANP_FLAG_NONE);
+        pkt.payload[0] = (uint8_t)seq;
+        pkt.length = DANP_STREAM_V1_HEADER_SIZE;
+    }
+
+    pkt.payload[pkt.length++] = 0;
+    danp_tx_defer(&pkt);
+}
+
+/**
+ * @brief Handle an expired keepalive timer.
+ * @param sock Pointer to the socket.
+ * @param now Current tick.
+ */
+static void danp_keepalive_timeout(danp_socket_t *sock, uint32_t now)
+{
+    if ((uint32_t)(now - sock->last_rx_ms) < sock->keepalive_idle_ms)
+    {
+        // The peer was heard from since the timer was armed.
+        danp_timer_arm(sock, DANP_TIMER_KEEPALIVE, sock->last_rx_ms + sock->keepalive_idle_ms);
+        return;
+    }
+
+    if (danp_timer_running(sock, DANP_TIMER_RTO))
+    {
+        // Unacknowledged data: retransmissions already find out whether the peer is there.
+        danp_timer_arm(sock, DANP_TIMER_KEEPALIVE, now + sock->keepalive_interval_ms);
+        return;
+    }
+
+    if (sock->keepalive_probes >= sock->keepalive_count)
+    {
+        danp_log_message(
+            DANP_LOG_WARN,
+            "No answer to %u keepalive probes on Port %u. Resetting connection.",
+            sock->keepalive_probes,
+            sock->local_port);
+        keepalive_resets++;
+        danp_send_control(sock, DANP_FLAG_RST, 0);
+        danp_stream_drop(sock);
+        return;
+    }
+
+    sock->keepalive_probes++;
+    danp_keepalive_probe(sock);
+    danp_timer_arm(sock, DANP_TIMER_KEEPALIVE, now + sock->keepalive_interval_ms);
+}
+
+/**
+ * @brief Time to wait for the SYN-ACK after a given number of SYN retries.
+ * @param retries SYNs retried so far.
+ * @return DANP_ACK_TIMEOUT_MS doubled per retry, capped at DANP_RTO_MAX_MS.
+ */
+static uint32_t danp_syn_timeout_ms(uint32_t retries)
+{
+    uint32_t timeout_ms = DANP_ACK_TIMEOUT_MS;
+
+    for (uint32_t i = 0; i < retries && timeout_ms < DANP_RTO_MAX_MS; i++)
+    {
+        timeout_ms *= 2U;
+    }
+    return (timeout_ms < DANP_RTO_MAX_MS) ? timeout_ms : DANP_RTO_MAX_MS;
+}
+
+/**
+ * @brief Handle an expired retransmission timer during the handshake.
+ * @param sock Pointer to the socket.
+ * @param now Current tick.
+ */
+static void danp_stream_connect_timeout(danp_socket_t *sock, uint32_t now)
+{
+    sock->retries++;
+    if (sock->retries < DANP_RETRY_LIMIT)
+    {
+        // The RTT is unknown until the handshake completes, so back off in case the path is just slow.
+        danp_log_message(DANP_LOG_DEBUG, "Retrying SYN on Port %u", sock->local_port);
+        danp_timer_arm(sock, DANP_TIMER_RTO, now + danp_syn_timeout_ms(sock->retries));
+        danp_send_control(sock, DANP_FLAG_SYN, 0);
+        return;
+    }
+
+    danp_log_message(DANP_LOG_WARN, "Connect Timeout on Port %u", sock->local_port);
+    danp_timer_cancel(sock, DANP_TIMER_RTO);
+    sock->state = DANP_SOCK_OPEN;
+    osalSemaphoreGive(sock->signal);
+    danp_poll_notify();
+    danp_socket_event(sock, DANP_EVENT_RESET);
+}
+
+/**
+ * @brief Run the expired timers of every socket.
+ * @return Milliseconds until the next timer expires, or DANP_WAIT_FOREVER if none is running.
+ */
+static uint32_t danp_timer_sweep(void)
+{
+    uint32_t next_ms = DANP_WAIT_FOREVER;
+
+    // The index stays locked for the sweep: an expiring connection may leave a backlog.
+    if (osalMutexLock(mutex_socket, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+    {
+        /* LCOV_EXCL_START */
+        return next_ms;
+        /* LCOV_EXCL_STOP */
+    }
+
+    uint32_t now = osalGetTickMs();
+
+    for (int i = 0; i < DANP_MAX_SOCKET_COUNT; i++)
+    {
+        danp_socket_t *sock = &socket_pool[i];
+
+        if (sock->state == DANP_SOCK_CLOSED || sock->type != DANP_TYPE_STREAM)
+        {
+            continue;
+        }
+
+        if (osalMutexLock(sock->lock, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+        {
+            /* LCOV_EXCL_START */
+            continue;
+            /* LCOV_EXCL_STOP */
+        }
+
+        if (sock->state == DANP_SOCK_SYN_SENT)
+        {
+            if (danp_timer_expired(sock, DANP_TIMER_RTO, now))
+            {
+                danp_stream_connect_timeout(sock, now);
+            }
+        }
+        else
+        {
+            if (danp_timer_expired(sock, DANP_TIMER_ACK, now))
+            {
+                danp_ack_flush(sock);
+            }
+
+            if (danp_timer_expired(sock, DANP_TIMER_RTO, now))
+            {
+                danp_stream_timeout(sock, now);
+            }
+
+            if (danp_timer_expired(sock, DANP_TIMER_KEEPALIVE, now))
+            {
+                danp_keepalive_timeout(sock, now);
+            }
+
+            if (danp_timer_expired(sock, DANP_TIMER_CLOSE, now))
+            {
+                danp_stream_close_timeout(sock);
+            }
+
+            // A FIN that found the packet pool empty is retried on every sweep.
+            danp_stream_queue_fin(sock);
+        }
+
+        for (int id = 0; id < DANP_TIMER_COUNT; id++)
+        {
+            if (danp_timer_running(sock, (danp_timer_id_t)id))
+            {
+                int32_t remaining = (int32_t)(sock->timer_deadline_ms[id] - now);
+                uint32_t due_ms = (remaining > 0) ? (uint32_t)remaining : 0U;
+                next_ms = (due_ms < next_ms) ? due_ms : next_ms;
+            }
+        }
+
+        osalMutexUnlock(sock->lock);
+    }
+
+    osalMutexUnlock(mutex_socket);
+    danp_tx_flush();
+
+    return next_ms;
+}
+
+/**
+ * @brief Service the protocol timers of every socket once.
+ * @return Milliseconds until the next timer expires, or DANP_WAIT_FOREVER if none is running.
+ */
+uint32_t danp_timer_tick(void)
+{
+    uint32_t next_ms = DANP_WAIT_FOREVER;
+
+    if (osalMutexLock(mutex_timer, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+    {
+        /* LCOV_EXCL_START */
+        return next_ms;
+        /* LCOV_EXCL_STOP */
+    }
+    timer_sweeping = true;
+    osalMutexUnlock(mutex_timer);
+
+    next_ms = danp_timer_sweep();
+
+    // Timers armed during the sweep have signalled the thread, so its next wait returns at once.
+    if (osalMutexLock(mutex_timer, OSAL_WAIT_FOREVER) == OSAL_SUCCESS)
+    {
+        timer_sweeping = false;
+        timer_idle = (next_ms == DANP_WAIT_FOREVER);
+        timer_wake_ms = osalGetTickMs() + next_ms;
+        osalMutexUnlock(mutex_timer);
+    }
+
+    return next_ms;
+}
+
+/**
+ * @brief Sleep until the earliest protocol timer is due, then service the timers.
+ * @param arg Unused.
+ */
+static void danp_socket_timer_routine(void *arg)
+{
+    uint32_t wait_ms = DANP_WAIT_FOREVER;
+
+    UNUSED(arg);
+
+    for (;;)
+    {
+        osalSemaphoreTake(timer_signal, (wait_ms == DANP_WAIT_FOREVER) ? OSAL_WAIT_FOREVER : wait_ms);
+        wait_ms = danp_timer_tick();
+    }
+}
+
+/**
+ * @brief Initialize the socket subsystem.
+ * @return int32_t
+ */
+int32_t danp_socket_init(void)
+{
+    osalMutexAttr_t attr = {
+        .name = "danpSocketMutex",
+        .attrBits = OSAL_MUTEX_RECURSIVE,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+    osalSemaphoreAttr_t sem_attr = { .name = "danpTimerSig", .maxCount = 1 };
+    osalThreadAttr_t thread_attr = {
+        .name = "danpSockTimer",
+        .stackSize = DANP_SOCKET_TIMER_STACK_SIZE,
+        .stackMem = NULL,
+        .priority = OSAL_THREAD_PRIORITY_NORMAL,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+
+    // The mutexes and timer thread outlive re-initialisation; the thread keeps using them.
+    if (!mutex_socket)
+    {
+        mutex_socket = osalMutexCreate(&attr);
+        if (!mutex_socket)
+        {
+            danp_log_message(DANP_LOG_ERROR, "Failed to create socket mutex");
+            return -1;
+        }
+    }
+    if (!mutex_tx)
+    {
+        attr.name = "danpSocketTxMutex";
+        mutex_tx = osalMutexCreate(&attr);
+        if (!mutex_tx)
+        {
+            danp_log_message(DANP_LOG_ERROR, "Failed to create transmit mutex");
+            return -1;
+        }
+    }
+    if (!mutex_tx_drain)
+    {
+        attr.name = "danpSocketTxDrainMutex";
+        mutex_tx_drain = osalMutexCreate(&attr);
+        if (!mutex_tx_drain)
+        {
+            danp_log_message(DANP_LOG_ERROR, "Failed to create transmit drain mutex");
+            return -1;
+        }
+    }
+    if (!mutex_poll)
+    {
+        attr.name = "danpSocketPollMutex";
+        mutex_poll = osalMutexCreate(&attr);
+        if (!mutex_poll)
+        {
+            danp_log_message(DANP_LOG_ERROR, "Failed to create poll mutex");
+            return -1;
+        }
+    }
+    if (!mutex_timer)
+    {
+        attr.name = "danpSocketTimerMutex";
+        mutex_timer = osalMutexCreate(&attr);
+        if (!mutex_timer)
+        {
+            danp_log_message(DANP_LOG_ERROR, "Failed to create timer mutex");
+            return -1;
+        }
+    }
+
+    if (osalMutexLock(mutex_socket, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+    {
+        /* LCOV_EXCL_START */
+        danp_log_message(DANP_LOG_ERROR, "Failed to lock socket mutex");
+        return -1;
+        /* LCOV_EXCL_STOP */
+    }
+
+    // Initialize socket pool
+    for (int i = 0; i < DANP_MAX_SOCKET_COUNT; i++)
+    {
+        socket_pool[i].state = DANP_SOCK_CLOSED;
+        socket_pool[i].next = NULL;
+        socket_pool[i].rx_buf = NULL;
+    }
+    memset(rx_ring_used, 0, sizeof(rx_ring_used));
+
+    socket_list = NULL;
+    memset(time_wait, 0, sizeof(time_wait));
+
+    osalMutexUnlock(mutex_socket);
+
+    if (!socket_timer_thread && !danp_config.external_timer_tick)
+    {
+        timer_signal = timer_signal ? timer_signal : osalSemaphoreCreate(&sem_attr);
+        if (!timer_signal)
+        {
+            danp_log_message(DANP_LOG_ERROR, "Failed to create timer semaphore");
+            return -1;
+        }
+        socket_timer_thread = osalThreadCreate(danp_socket_timer_routine, NULL, &thread_attr);
+        if (!socket_timer_thread)
+        {
+            danp_log_message(DANP_LOG_ERROR, "Failed to create socket timer thread");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Create the OS objects a socket needs that its slot does not have yet.
+ *
+ * Must be called with mutex_socket held.
+ *
+ * @param sock Pointer to the socket.
+ * @param need_queue The socket receives datagrams or STREAM wake-ups.
+ * @param need_signal The socket waits for a handshake, send window or connection.
+ * @return 0 on success, negative on error.
+ */
+static int32_t danp_socket_ensure_resources(danp_socket_t *sock, bool need_queue, bool need_signal)
+{
+    osalMessageQueueAttr_t mq_attr = { .name = "danpSockRx", .mqSize = 0 /*...*/ };
+    osalSemaphoreAttr_t sem_attr   = { .name = "danpSockSig", .maxCount = 1 /*...*/ };
+
+    if (need_queue && sock->rx_queue == NULL)
+    {
+        sock->rx_queue = osalMessageQueueCreate(DANP_RX_QUEUE_SIZE, sizeof(danp_packet_t *), &mq_attr);
+        if (sock->rx_queue)
+        {
+            created_queues++;
+        }
+    }
+    if (need_signal && sock->signal == NULL)
+    {
+        sock->signal = osalSemaphoreCreate(&sem_attr);
+        if (sock->signal)
+        {
+            created_semaphores++;
+        }
+    }
+
+    if ((need_queue && sock->rx_queue == NULL) || (need_signal && sock->signal == NULL))
+    {
+        /* LCOV_EXCL_START */
+        danp_log_message(DANP_LOG_ERROR, "Socket OS Resource Error");
+        return -1;
+        /* LCOV_EXCL_STOP */
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Create a new DANP socket.
+ * @param type Type of the socket (DGRAM or STREAM).
+ * @return Pointer to the created socket, or NULL on failure.
+ */
+danp_socket_t *danp_socket(danp_socket_type_t type)
+{
+    osalStatus_t osal_status;
+    bool is_mutex_taken = false;
+    danp_socket_t *created_socket = NULL;
+    danp_socket_t *slot = NULL;
+    bool is_slot_locked = false;
+    osalMessageQueueHandle_t rx_q = NULL;
+    osalSemaphoreHandle_t sig = NULL;
+    osalMutexHandle_t lock = NULL;
+    osalMutexAttr_t lock_attr = {
+        .name = "danpSockLock",
+        .attrBits = OSAL_MUTEX_RECURSIVE,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+
+    for (;;)
+    {
+        osal_status = osalMutexLock(mutex_socket, OSAL_WAIT_FOREVER);
+        if (osal_status != OSAL_SUCCESS)
+        {
+            danp_log_message(DANP_LOG_ERROR, "Socket allocation failed: Mutex Lock Error");
+            break; // Jump to cleanup
+        }
+        is_mutex_taken = true;
+
+        for (int i = 0; i < DANP_MAX_SOCKET_COUNT; i++)
+        {
+            if (socket_pool[i].state == DANP_SOCK_CLOSED && socket_pool[i].local_port == 0)
+            {
+                slot = &socket_pool[i];
+                break;
+            }
+            // A reset connection keeps its port until closed; reuse it only when nothing else is free.
+            if (socket_pool[i].state == DANP_SOCK_CLOSED && slot == NULL)
+            {
+                slot = &socket_pool[i];
+            }
+        }
+
+        if (slot == NULL)
+        {
+            danp_log_message(DANP_LOG_ERROR, "Socket allocation failed: No free slots");
+            break; // Jump to cleanup
+        }
+
+        // Every socket needs its lock, so it is the one object created up front.
+        if (slot->lock == NULL)
+        {
+            slot->lock = osalMutexCreate(&lock_attr);
+            if (slot->lock == NULL)
+            {
+                /* LCOV_EXCL_START */
+                danp_log_message(DANP_LOG_ERROR, "Socket allocation failed: OS Resource Error");
+                break; // Jump to cleanup
+                /* LCOV_EXCL_STOP */
+            }
+            created_mutexes++;
+        }
+
+        if (osalMutexLock(slot->lock, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+        {
+            /* LCOV_EXCL_START */
+            danp_log_message(DANP_LOG_ERROR, "Socket allocation failed: Mutex Lock Error");
+            break; // Jump to cleanup
+            /* LCOV_EXCL_STOP */
+        }
+        is_slot_locked = true;
+
+        if (socket_list == slot)
+        {
+            socket_list = slot->next;
+        }
+        else
+        {
+            for (int i = 0; i < DANP_MAX_SOCKET_COUNT; i++)
+            {
+                if (socket_pool[i].next == slot)
+                {
+                    socket_pool[i].next = slot->next;
+                    break;
+                }
+            }
+        }
+
+        rx_q = slot->rx_queue;
+        sig = slot->signal;
+        lock = slot->lock;
+
+        // A reset connection reused here may still hold its ring.
+        danp_stream_ring_release(slot);
+        memset(slot, 0, sizeof(danp_socket_t));
+
+        slot->rx_queue = rx_q;
+        slot->signal = sig;
+        slot->lock = lock;
+
+        slot->type = type;
+        slot->state = DANP_SOCK_OPEN; // Temporarily mark open
+        slot->local_node = danp_config.local_node;
+        slot->keepalive_count = DANP_KEEPALIVE_COUNT;
+        slot->keepalive_idle_ms = DANP_KEEPALIVE_IDLE_MS;
+        slot->keepalive_interval_ms = DANP_KEEPALIVE_INTERVAL_MS;
+        slot->linger_ms = DANP_LINGER_OFF;
+
+        // DGRAM sockets only ever need their queue; STREAM objects follow in listen/connect/accept.
+        if (danp_socket_ensure_resources(slot, type == DANP_TYPE_DGRAM, false) != 0)
+        {
+            /* LCOV_EXCL_START */
+            danp_log_message(DANP_LOG_ERROR, "Socket allocation failed: OS Resource Error");
+
+            slot->state = DANP_SOCK_CLOSED;
+
+            break; // Jump to cleanup
+            /* LCOV_EXCL_STOP */
+        }
+
+        danp_packet_t *garbage_pkt;
+
+        while (slot->rx_queue && osalMessageQueueReceive(slot->rx_queue, &garbage_pkt, 0) == 0)
+        {
+            if (garbage_pkt)
+            {
+                danp_buffer_free(garbage_pkt);
+            }
+        }
+
+        slot->next = socket_list;
+        socket_list = slot;
+
+        created_socket = slot;
+
+        break;
+    }
+
+    if (is_slot_locked)
+    {
+        osalMutexUnlock(slot->lock);
+    }
+
+    if (is_mutex_taken)
+    {
+        osalMutexUnlock(mutex_socket);
+    }
+
+    return created_socket;
+}
+
+/**
+ * @brief Bind a socket to a local port.
+ * @param sock Pointer to the socket.
+ * @param port Local port to bind to.
+ * @return 0 on success, negative on error.
+ */
+int32_t danp_bind(danp_socket_t *sock, uint16_t port)
+{
+    int32_t ret = 0;
+    osalStatus_t osal_status;
+    bool is_mutex_taken = false;
+
+    for (;;)
+    {
+        osal_status = osalMutexLock(mutex_socket, OSAL_WAIT_FOREVER);
+        if (osal_status != OSAL_SUCCESS)
+        {
+            danp_log_message(DANP_LOG_ERROR, "Socket bind failed: Mutex Lock Error");
+            ret = -1;
+            break;
+        }
+        is_mutex_taken = true;
+
+        if (port == 0)
+        {
+            uint16_t start_port = next_ephemeral_port;
             do
             {
-                if (!danp_port_in_use(next_ephemeral_port))
+                // A port in TIME_WAIT could still receive segments of its last connection.
+                if (!danp_port_in_use(next_ephemeral_port) && !danp_time_wait_find(next_ephemeral_port, 0, 0))
                 {
                     port = next_ephemeral_port;
                     next_ephemeral_port++;
@@ -341,331 +2161,1088 @@ int32_t danp_bind(danp_socket_t *sock, uint16_t port)
                     break;
                 }
 
-                next_ephemeral_port++;
-                if (next_ephemeral_port >= DANP_MAX_PORTS)
-                {
-                    next_ephemeral_port = 1;
-                }
-            } while (next_ephemeral_port != start_port);
+                next_ephemeral_port++;
+                if (next_ephemeral_port >= DANP_MAX_PORTS)
+                {
+                    next_ephemeral_port = 1;
+                }
+            } while (next_ephemeral_port != start_port);
+
+            if (port == 0)
+            {
+                danp_log_message(DANP_LOG_ERROR, "Socket bind failed: no ephemeral ports available");
+                ret = -1;
+                break;
+            }
+        }
+
+        if (port >= DANP_MAX_PORTS)
+        {
+            ret = -1;
+            break;
+        }
+
+        if (danp_port_in_use(port))
+        {
+            danp_log_message(DANP_LOG_ERROR, "Socket bind failed: port %u already in use", port);
+            ret = -1;
+            break;
+        }
+
+        sock->local_port = port;
+        danp_log_message(DANP_LOG_INFO, "Socket bound to port %u", port);
+
+        break;
+    }
+
+    if (is_mutex_taken)
+    {
+        osalMutexUnlock(mutex_socket);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Listen for incoming connections on a socket.
+ *
+ * SYNs beyond backlog connections waiting for danp_accept() are dropped and
+ * counted in syn_overflows.
+ *
+ * @param sock Pointer to the socket.
+ * @param backlog Maximum number of pending connections (0 or less for DANP_LISTEN_BACKLOG_DEFAULT).
+ * @return 0 on success, negative on error.
+ */
+int danp_listen(danp_socket_t *sock, int backlog)
+{
+    if (!sock)
+    {
+        return -1;
+    }
+
+    if (osalMutexLock(mutex_socket, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+    {
+        /* LCOV_EXCL_START */
+        return -1;
+        /* LCOV_EXCL_STOP */
+    }
+    if (osalMutexLock(sock->lock, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+    {
+        /* LCOV_EXCL_START */
+        osalMutexUnlock(mutex_socket);
+        return -1;
+        /* LCOV_EXCL_STOP */
+    }
+
+    // Listeners only wait for connections, so the receive queue is not needed.
+    if (danp_socket_ensure_resources(sock, false, true) != 0)
+    {
+        /* LCOV_EXCL_START */
+        osalMutexUnlock(sock->lock);
+        osalMutexUnlock(mutex_socket);
+        return -1;
+        /* LCOV_EXCL_STOP */
+    }
+
+    if (backlog <= 0)
+    {
+        sock->backlog = DANP_LISTEN_BACKLOG_DEFAULT;
+    }
+    else
+    {
+        sock->backlog = (backlog > UINT16_MAX) ? UINT16_MAX : (uint16_t)backlog;
+    }
+    sock->state = DANP_SOCK_LISTENING;
+
+    osalMutexUnlock(sock->lock);
+    osalMutexUnlock(mutex_socket);
+
+    return 0;
+}
+
+/**
+ * @brief Close a socket without transmitting what closing it produced.
+ * @param sock Pointer to the socket to close.
+ * @return 0 on success, negative on error.
+ */
+static int32_t danp_socket_close(danp_socket_t *sock)
+{
+    osalStatus_t osal_status;
+    bool is_mutex_taken = false;
+
+    osal_status = osalMutexLock(mutex_socket, OSAL_WAIT_FOREVER);
+    if (osal_status != OSAL_SUCCESS)
+    {
+        danp_log_message(DANP_LOG_ERROR, "Socket close failed: Mutex Lock Error");
+        return -1;
+    }
+    is_mutex_taken = true;
+
+    if (osalMutexLock(sock->lock, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+    {
+        /* LCOV_EXCL_START */
+        osalMutexUnlock(mutex_socket);
+        return -1;
+        /* LCOV_EXCL_STOP */
+    }
+
+    // Connections nobody accepted are reset with their listener.
+    while (sock->accept_head)
+    {
+        danp_socket_close(sock->accept_head);
+    }
+
+    // An accepted connection with a v2 peer shuts down in order; the library frees it once that is done.
+    if (sock->type == DANP_TYPE_STREAM && !sock->listener && sock->linger_ms != 0U &&
+        danp_stream_synchronized(sock) && danp_stream_start_shutdown(sock) == 0)
+    {
+        sock->orphan = true;
+        sock->event_cb = NULL;
+        if (!danp_timer_running(sock, DANP_TIMER_CLOSE))
+        {
+            danp_timer_arm(sock, DANP_TIMER_CLOSE, osalGetTickMs() + DANP_CLOSE_TIMEOUT_MS);
+        }
+
+        osalMutexUnlock(sock->lock);
+        osalMutexUnlock(mutex_socket);
+        return 0;
+    }
+    danp_backlog_remove(sock);
+
+    // Only send RST for STREAM sockets or connected DGRAM sockets that are actually in a state where RST makes sense.
+    // For DGRAM, we generally don't send RST on close unless we want to signal the peer to stop sending.
+    // However, standard UDP doesn't do this. Let's restrict RST to STREAM.
+    if (sock->type == DANP_TYPE_STREAM &&
+        (danp_stream_synchronized(sock) || sock->state == DANP_SOCK_SYN_SENT || sock->state == DANP_SOCK_SYN_RECEIVED))
+    {
+        danp_send_control(sock, DANP_FLAG_RST, 0);
+    }
+
+    // Clean up state for slot recycling
+    if (sock->type == DANP_TYPE_STREAM)
+    {
+        danp_stream_release_tx(sock);
+        sock->ack_pending = false;
+        sock->timers_armed = 0;
+        sock->fin_pending = false;
+    }
+    danp_socket_release_slot(sock);
+
+    // Note: Whatever lock, queue and semaphore the slot has are kept alive for quick reuse.
+
+    osalMutexUnlock(sock->lock);
+
+    if (is_mutex_taken)
+    {
+        osalMutexUnlock(mutex_socket);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Shut down sending and wait up to the linger time for the peer to acknowledge everything.
+ *
+ * A connection that runs out of time is reset, so closing it discards nothing more.
+ *
+ * @param sock Pointer to the socket.
+ * @return 0 if everything was acknowledged (or nothing had to be), negative if the connection was reset.
+ */
+static int32_t danp_stream_linger(danp_socket_t *sock)
+{
+    int32_t ret = 0;
+    uint32_t start_ms = osalGetTickMs();
+    uint32_t elapsed_ms = 0;
+
+    if (osalMutexLock(sock->lock, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+    {
+        /* LCOV_EXCL_START */
+        return -1;
+        /* LCOV_EXCL_STOP */
+    }
+
+    if (!danp_stream_synchronized(sock) || danp_stream_start_shutdown(sock) != 0)
+    {
+        osalMutexUnlock(sock->lock);
+        return 0;
+    }
+
+    while (danp_stream_synchronized(sock) && !danp_stream_fin_acked(sock) && elapsed_ms < sock->linger_ms)
+    {
+        osalMutexUnlock(sock->lock);
+        danp_tx_flush();
+        osalSemaphoreTake(sock->signal, sock->linger_ms - elapsed_ms);
+        elapsed_ms = osalGetTickMs() - start_ms;
+        while (osalMutexLock(sock->lock, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+        {
+            /* LCOV_EXCL_START */
+            osalDelayMs(1);
+            /* LCOV_EXCL_STOP */
+        }
+    }
+
+    if (danp_stream_synchronized(sock) && !danp_stream_fin_acked(sock))
+    {
+        danp_log_message(DANP_LOG_WARN, "Linger time passed on Port %u. Resetting connection.", sock->local_port);
+        danp_send_control(sock, DANP_FLAG_RST, 0);
+        sock->state = DANP_SOCK_CLOSED;
+        ret = -1;
+    }
+    else if (sock->state == DANP_SOCK_CLOSED && !sock->peer_fin)
+    {
+        // Reset by the peer or the retransmission limit while we waited.
+        ret = -1;
+    }
+
+    osalMutexUnlock(sock->lock);
+
+    return ret;
+}
+
+/**
+ * @brief Close a socket and release resources.
+ * @param sock Pointer to the socket to close.
+ * @return 0 on success, negative on error.
+ */
+int32_t danp_close(danp_socket_t *sock)
+{
+    int32_t ret = 0;
+
+    if (sock->groups && osalMutexLock(sock->lock, OSAL_WAIT_FOREVER) == OSAL_SUCCESS)
+    {
+        for (uint16_t i = 0; i < DANP_MULTICAST_COUNT && sock->groups; i++)
+        {
+            if (sock->groups & (1U << i))
+            {
+                sock->groups &= (uint16_t)~(1U << i);
+                danp_route_group_update((uint16_t)(DANP_MULTICAST_FIRST + i), false);
+            }
+        }
+        osalMutexUnlock(sock->lock);
+    }
+
+    if (sock->type == DANP_TYPE_STREAM && sock->linger_ms != 0U && sock->linger_ms != DANP_LINGER_OFF)
+    {
+        ret = danp_stream_linger(sock);
+    }
+
+    if (danp_socket_close(sock) != 0)
+    {
+        ret = -1;
+    }
+
+    // Send the RSTs and FINs once every lock is released.
+    danp_tx_flush();
+
+    return ret;
+}
+
+/**
+ * @brief Finish sending on a STREAM connection, but keep receiving.
+ * @param sock Pointer to the socket.
+ * @return 0 on success, negative on error.
+ */
+int32_t danp_shutdown(danp_socket_t *sock)
+{
+    int32_t ret;
+
+    if (!sock || sock->type != DANP_TYPE_STREAM)
+    {
+        return -1;
+    }
+
+    if (osalMutexLock(sock->lock, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+    {
+        /* LCOV_EXCL_START */
+        return -1;
+        /* LCOV_EXCL_STOP */
+    }
+
+    ret = danp_stream_start_shutdown(sock);
+
+    osalMutexUnlock(sock->lock);
+    danp_tx_flush();
+
+    return ret;
+}
+
+
+/**
+ * @brief Connect a socket to a remote node and port.
+ * @param sock Pointer to the socket.
+ * @param node Remote node address.
+ * @param port Remote port number.
+ * @return 0 on success, negative on error.
+ */
+int32_t danp_connect(danp_socket_t *sock, uint16_t node, uint16_t port)
+{
+    int32_t ret = 0;
+
+    for (;;)
+    {
+        if (sock->type == DANP_TYPE_STREAM && DANP_NODE_IS_GROUP(node))
+        {
+            danp_log_message(DANP_LOG_ERROR, "STREAM sockets cannot connect to group %u", node);
+            ret = -1;
+            break;
+        }
+        if (sock->local_port == 0)
+        {
+            danp_bind(sock, 0);
+        }
+        sock->remote_node = node;
+        sock->remote_port = port;
 
-            if (port == 0)
-            {
-                danp_log_message(DANP_LOG_ERROR, "Socket bind failed: no ephemeral ports available");
-                ret = -1;
-                break;
-            }
+        if (sock->type == DANP_TYPE_DGRAM)
+        {
+            // For DGRAM, "Connect" just sets the default destination.
+            // We use ESTABLISHED to indicate that the socket has a default peer,
+            // allowing danp_find_socket to match incoming packets from this peer specifically.
+            sock->state = DANP_SOCK_ESTABLISHED;
+            break;
         }
 
-        if (port >= DANP_MAX_PORTS)
+        danp_log_message(
+            DANP_LOG_INFO,
+            "Connecting to Node %d Port %d from Local Port %d",
+            node,
+            port,
+            sock->local_port);
+
+        if (osalMutexLock(mutex_socket, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
         {
+            /* LCOV_EXCL_START */
             ret = -1;
             break;
+            /* LCOV_EXCL_STOP */
         }
-
-        if (danp_port_in_use(port))
+        if (osalMutexLock(sock->lock, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
         {
-            danp_log_message(DANP_LOG_ERROR, "Socket bind failed: port %u already in use", port);
+            /* LCOV_EXCL_START */
+            osalMutexUnlock(mutex_socket);
+            ret = -1;
+            break;
+            /* LCOV_EXCL_STOP */
+        }
+        if (danp_socket_ensure_resources(sock, true, true) != 0)
+        {
+            /* LCOV_EXCL_START */
+            osalMutexUnlock(sock->lock);
+            osalMutexUnlock(mutex_socket);
             ret = -1;
             break;
+            /* LCOV_EXCL_STOP */
         }
+        if (danp_stream_ring_take(sock) != 0)
+        {
+            danp_log_message(DANP_LOG_ERROR, "Connect failed: No free receive ring");
+            osalMutexUnlock(sock->lock);
+            osalMutexUnlock(mutex_socket);
+            ret = -1;
+            break;
+        }
+        osalMutexUnlock(mutex_socket);
 
-        sock->local_port = port;
-        danp_log_message(DANP_LOG_INFO, "Socket bound to port %u", port);
+        danp_stream_reset(sock);
+        sock->state = DANP_SOCK_SYN_SENT;
+        // The socket timer retries the SYN and gives up after DANP_RETRY_LIMIT attempts.
+        danp_timer_arm(sock, DANP_TIMER_RTO, osalGetTickMs() + danp_syn_timeout_ms(0));
+        danp_send_control(sock, DANP_FLAG_SYN, 0);
+        osalMutexUnlock(sock->lock);
+        danp_tx_flush();
+
+        if (sock->nonblock)
+        {
+            ret = danp_stream_synchronized(sock) ? 0 : DANP_ERR_IN_PROGRESS;
+            break;
+        }
+
+        // The signal may hold a stale token from earlier use of the slot, so wait on the state.
+        uint32_t limit_ms = 0;
+        for (uint32_t attempt = 0; attempt < DANP_RETRY_LIMIT; attempt++)
+        {
+            limit_ms += danp_syn_timeout_ms(attempt);
+        }
+        uint32_t start_ms = osalGetTickMs();
+        uint32_t elapsed_ms = 0;
+        while (sock->state == DANP_SOCK_SYN_SENT && elapsed_ms < limit_ms)
+        {
+            osalSemaphoreTake(sock->signal, limit_ms - elapsed_ms);
+            elapsed_ms = osalGetTickMs() - start_ms;
+        }
+
+        // The peer may already have sent data and its FIN.
+        if (danp_stream_synchronized(sock))
+        {
+            danp_log_message(DANP_LOG_INFO, "Connection Established");
+            break;
+        }
+
+        if (osalMutexLock(sock->lock, OSAL_WAIT_FOREVER) == OSAL_SUCCESS)
+        {
+            if (sock->state == DANP_SOCK_SYN_SENT)
+            {
+                // Nobody serviced the timers in time (external tick).
+                danp_log_message(DANP_LOG_WARN, "Connect Timeout");
+                danp_timer_cancel(sock, DANP_TIMER_RTO);
+                sock->state = DANP_SOCK_OPEN;
+            }
+            osalMutexUnlock(sock->lock);
+        }
+
+        ret = -1;
 
         break;
     }
 
-    if (is_mutex_taken)
+    return ret;
+}
+
+/**
+ * @brief Accept a new connection on a listening socket.
+ * @param server_sock Pointer to the listening socket.
+ * @param timeout_ms Timeout in milliseconds.
+ * @return Pointer to the new connected socket, or NULL on timeout/error.
+ */
+danp_socket_t *danp_accept(danp_socket_t *server_sock, uint32_t timeout_ms)
+{
+    danp_socket_t *client = NULL;
+    uint32_t start_ms = osalGetTickMs();
+    uint32_t elapsed_ms = 0;
+
+    for (;;)
     {
+        if (osalMutexLock(mutex_socket, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+        {
+            /* LCOV_EXCL_START */
+            break;
+            /* LCOV_EXCL_STOP */
+        }
+
+        client = server_sock->accept_head;
+        if (client)
+        {
+            danp_backlog_remove(client);
+        }
+
         osalMutexUnlock(mutex_socket);
+
+        if (client || server_sock->nonblock || server_sock->state != DANP_SOCK_LISTENING)
+        {
+            break;
+        }
+
+        // The signal may hold a stale token, so the backlog is checked again after every one.
+        if (timeout_ms != DANP_WAIT_FOREVER && elapsed_ms >= timeout_ms)
+        {
+            break;
+        }
+        osalSemaphoreTake(
+            server_sock->signal,
+            (timeout_ms == DANP_WAIT_FOREVER) ? OSAL_WAIT_FOREVER : (timeout_ms - elapsed_ms));
+        elapsed_ms = osalGetTickMs() - start_ms;
     }
 
-    return ret;
+    return client;
 }
 
 /**
- * @brief Listen for incoming connections on a socket.
+ * @brief Queue one segment of a STREAM send, waiting for room in the send window.
+ *
+ * Must be called with the socket lock held; the lock is released while
+ * waiting and held again on return.
+ *
  * @param sock Pointer to the socket.
- * @param backlog Maximum number of pending connections (currently unused).
- * @return 0 on success, negative on error.
+ * @param data Pointer to the segment data.
+ * @param len Length of the segment data, at most one MSS.
+ * @return 0 on success, DANP_ERR_WOULD_BLOCK if a non-blocking socket has no room,
+ *         negative if the connection is not (or no longer) established.
  */
-int danp_listen(danp_socket_t *sock, int backlog)
+static int32_t danp_stream_queue_segment(danp_socket_t *sock, const uint8_t *data, uint16_t len)
 {
-    UNUSED(backlog);
-    sock->state = DANP_SOCK_LISTENING;
+    danp_packet_t *pkt = NULL;
+    uint16_t hdr_size;
+
+    // Wait for room in the send window; ACKs, resets and shutdowns signal us.
+    while (danp_stream_can_send(sock))
+    {
+        bool window_full = (uint16_t)(sock->tx_seq - sock->snd_una) >= DANP_STREAM_TX_WINDOW;
+
+        if (!window_full)
+        {
+            pkt = danp_buffer_allocate();
+            if (pkt)
+            {
+                break;
+            }
+        }
+
+        if (sock->nonblock)
+        {
+            return DANP_ERR_WOULD_BLOCK;
+        }
+
+        osalMutexUnlock(sock->lock);
+        danp_tx_flush();
+        if (window_full)
+        {
+            osalSemaphoreTake(sock->signal, DANP_ACK_TIMEOUT_MS);
+        }
+        else
+        {
+            osalDelayMs(10); // Pool exhausted, retry shortly
+        }
+        while (osalMutexLock(sock->lock, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+        {
+            /* LCOV_EXCL_START */
+            osalDelayMs(1);
+            /* LCOV_EXCL_STOP */
+        }
+    }
+
+    if (!pkt)
+    {
+        // Connection was reset, shut down or never established.
+        return -1;
+    }
+
+    hdr_size = danp_stream_header_size(sock);
+    if (len > DANP_MAX_PACKET_SIZE - hdr_size)
+    {
+        /* LCOV_EXCL_START */
+        danp_buffer_free(pkt);
+        return -1;
+        /* LCOV_EXCL_STOP */
+    }
+
+    pkt->header_raw = danp_pack_header(
+        0,
+        sock->remote_node,
+        sock->local_node,
+        sock->remote_port,
+        sock->local_port,
+        DANP_FLAG_NONE);
+    if (sock->version == DANP_STREAM_V2)
+    {
+        danp_stream_write_header(sock, pkt, sock->tx_seq);
+    }
+    else
+    {
+        pkt->payload[0] = (uint8_t)sock->tx_seq;
+    }
+    memcpy(pkt->payload + hdr_size, data, len);
+    pkt->length = len + hdr_size;
+
+    danp_stream_segment_t *seg = &sock->tx_queue[sock->tx_seq % DANP_STREAM_TX_WINDOW];
+    seg->pkt = pkt;
+    seg->retransmitted = false;
+    seg->push = false;
+    seg->fin = false;
+    sock->tx_seq++;
+
+    danp_stream_output(sock);
+
     return 0;
 }
 
 /**
- * @brief Close a socket and release resources.
- * @param sock Pointer to the socket to close.
- * @return 0 on success, negative on error.
+ * @brief Close the open tail segment to coalescing and send what the window allows.
+ * @param sock Pointer to the socket.
  */
-int32_t danp_close(danp_socket_t *sock)
+static void danp_stream_push(danp_socket_t *sock)
 {
-    osalStatus_t osal_status;
-    bool is_mutex_taken = false;
+    if (sock->tx_seq != sock->snd_max)
+    {
+        sock->tx_queue[(uint16_t)(sock->tx_seq - 1U) % DANP_STREAM_TX_WINDOW].push = true;
+        danp_stream_output(sock);
+    }
+}
 
-    osal_status = osalMutexLock(mutex_socket, OSAL_WAIT_FOREVER);
-    if (osal_status != OSAL_SUCCESS)
+/**
+ * @brief Send a buffer over a STREAM connection, split into segments.
+ * @param sock Pointer to the socket.
+ * @param data Pointer to the data to send.
+ * @param len Length of the data.
+ * @return Number of bytes queued (or acknowledged), or negative on error.
+ */
+static int32_t danp_stream_send(danp_socket_t *sock, const uint8_t *data, uint32_t len)
+{
+    uint32_t sent = 0;
+    uint16_t end_seq;
+    uint16_t max_payload;
+    uint16_t hdr_size;
+    uint16_t mss;
+    int32_t ret = 0;
+    danp_stream_segment_t *tail;
+
+    if (osalMutexLock(sock->lock, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
     {
-        danp_log_message(DANP_LOG_ERROR, "Socket close failed: Mutex Lock Error");
+        /* LCOV_EXCL_START */
         return -1;
+        /* LCOV_EXCL_STOP */
     }
-    is_mutex_taken = true;
 
-    // Only send RST for STREAM sockets or connected DGRAM sockets that are actually in a state where RST makes sense.
-    // For DGRAM, we generally don't send RST on close unless we want to signal the peer to stop sending.
-    // However, standard UDP doesn't do this. Let's restrict RST to STREAM.
-    if (sock->type == DANP_TYPE_STREAM &&
-        (sock->state == DANP_SOCK_ESTABLISHED || sock->state == DANP_SOCK_SYN_SENT ||
-         sock->state == DANP_SOCK_SYN_RECEIVED))
+    // Segments are sized to the path so the router never has to reject them.
+    max_payload = danp_route_get_max_payload(sock->remote_node);
+    hdr_size = danp_stream_header_size(sock);
+    if (max_payload <= hdr_size)
+    {
+        danp_log_message(DANP_LOG_ERROR, "No route to Node %u", sock->remote_node);
+        osalMutexUnlock(sock->lock);
+        return -1;
+    }
+    mss = (uint16_t)(max_payload - hdr_size);
+    sock->tx_mss = mss;
+
+    tail = danp_stream_open_tail(sock);
+    if (tail && len > 0U)
+    {
+        // Top up the unsent tail segment before opening new ones.
+        uint16_t room = (uint16_t)(mss - (tail->pkt->length - hdr_size));
+        uint16_t chunk = (len > room) ? room : (uint16_t)len;
+
+        memcpy(tail->pkt->payload + tail->pkt->length, data, chunk);
+        tail->pkt->length += chunk;
+        sent = chunk;
+    }
+
+    while (sent < len)
+    {
+        uint16_t chunk = (len - sent > mss) ? mss : (uint16_t)(len - sent);
+
+        ret = danp_stream_queue_segment(sock, data + sent, chunk);
+        if (ret != 0)
+        {
+            break;
+        }
+        sent += chunk;
+    }
+
+    if (sock->send_wait_ack && !sock->nonblock && sent == len)
+    {
+        // Return only once the peer has acknowledged the last segment of this call.
+        danp_stream_push(sock);
+        end_seq = sock->tx_seq;
+        while (danp_stream_can_send(sock) && sock->snd_una != end_seq)
+        {
+            osalMutexUnlock(sock->lock);
+            danp_tx_flush();
+            osalSemaphoreTake(sock->signal, DANP_ACK_TIMEOUT_MS);
+            while (osalMutexLock(sock->lock, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+            {
+                /* LCOV_EXCL_START */
+                osalDelayMs(1);
+                /* LCOV_EXCL_STOP */
+            }
+        }
+
+        if (sock->snd_una != end_seq)
+        {
+            sent = 0;
+        }
+    }
+
+    osalMutexUnlock(sock->lock);
+    danp_tx_flush();
+
+    if (sent == 0U && len > 0U)
+    {
+        return (ret == DANP_ERR_WOULD_BLOCK) ? DANP_ERR_WOULD_BLOCK : -1;
+    }
+
+    return (int32_t)sent;
+}
+
+/**
+ * @brief Send data over a connected socket.
+ * @param sock Pointer to the socket.
+ * @param data Pointer to the data to send.
+ * @param len Length of the data.
+ * @return Number of bytes sent, or negative on error.
+ */
+int32_t danp_send(danp_socket_t *sock, void *data, uint32_t len)
+{
+    int32_t ret = 0;
+
+    for (;;)
+    {
+        if (sock->type == DANP_TYPE_STREAM)
+        {
+            ret = (len > INT32_MAX) ? -1 : danp_stream_send(sock, (const uint8_t *)data, len);
+            break;
+        }
+
+        if (len > DANP_MAX_PACKET_SIZE - 1)
+        {
+            ret = -1;
+            break;
+        }
+
+        danp_packet_t *pkt = danp_buffer_allocate();
+        if (!pkt)
+        {
+            ret = -1;
+            break;
+        }
+        pkt->header_raw = danp_pack_header(
+            0,
+            sock->remote_node,
+            sock->local_node,
+            sock->remote_port,
+            sock->local_port,
+            DANP_FLAG_NONE);
+        memcpy(pkt->payload, data, len);
+        pkt->length = (uint16_t)len;
+        danp_route_tx(pkt);
+        danp_buffer_free(pkt);
+        ret = (int32_t)len;
+        break;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Send any data held back by small-write coalescing.
+ * @param sock Pointer to the socket.
+ * @return 0 on success, negative on error.
+ */
+int32_t danp_flush(danp_socket_t *sock)
+{
+    if (!sock || sock->type != DANP_TYPE_STREAM)
     {
-        danp_send_control(sock, DANP_FLAG_RST, 0);
+        return -1;
     }
 
-    // Unlink from global socket_list
-    if (socket_list == sock)
-    {
-        socket_list = sock->next;
-    }
-    else
+    if (osalMutexLock(sock->lock, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
     {
-        danp_socket_t *prev = socket_list;
-        while (prev && prev->next != sock)
-        {
-            prev = prev->next;
-        }
-        if (prev && prev->next == sock)
-        {
-            prev->next = sock->next;
-        }
+        /* LCOV_EXCL_START */
+        return -1;
+        /* LCOV_EXCL_STOP */
     }
-    sock->next = NULL;
-
-    // Clean up state for slot recycling
-    sock->state = DANP_SOCK_CLOSED;
-    sock->local_port = 0;
 
-    // Note: Queue and semaphore are kept alive for quick reuse of the slot.
-
-    if (is_mutex_taken)
+    if (danp_stream_can_send(sock))
     {
-        osalMutexUnlock(mutex_socket);
+        danp_stream_push(sock);
     }
 
+    osalMutexUnlock(sock->lock);
+    danp_tx_flush();
+
     return 0;
 }
 
-
 /**
- * @brief Connect a socket to a remote node and port.
+ * @brief Read from the receive ring of a STREAM socket, waiting for data if it is empty.
+ *
+ * A window update is sent as soon as a window advertised as closed opens
+ * again, so the sender does not have to wait for its persist timer.
+ *
  * @param sock Pointer to the socket.
- * @param node Remote node address.
- * @param port Remote port number.
- * @return 0 on success, negative on error.
+ * @param buffer Destination buffer.
+ * @param max_len Size of the destination buffer.
+ * @param timeout_ms Timeout in milliseconds.
+ * @return Number of bytes received, 0 on timeout, when the connection is closed or at the
+ *         end of the stream, or DANP_ERR_WOULD_BLOCK if a non-blocking socket has nothing buffered.
  */
-int32_t danp_connect(danp_socket_t *sock, uint16_t node, uint16_t port)
+static int32_t danp_stream_recv(danp_socket_t *sock, uint8_t *buffer, uint16_t max_len, uint32_t timeout_ms)
 {
     int32_t ret = 0;
+    bool closed = false;
+    danp_packet_t *wakeup;
+    uint32_t start_ms = osalGetTickMs();
+    uint32_t elapsed_ms = 0;
 
     for (;;)
     {
-        if (sock->local_port == 0)
+        if (osalMutexLock(sock->lock, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
         {
-            danp_bind(sock, 0);
+            /* LCOV_EXCL_START */
+            danp_log_message(DANP_LOG_ERROR, "Receive: Mutex Lock Error");
+            break;
+            /* LCOV_EXCL_STOP */
         }
-        sock->remote_node = node;
-        sock->remote_port = port;
 
-        if (sock->type == DANP_TYPE_DGRAM)
+        ret = danp_stream_rx_read(sock, buffer, max_len);
+
+        if (ret > 0 && danp_stream_synchronized(sock) && !sock->peer_fin && danp_stream_window_update_due(sock))
         {
-            // For DGRAM, "Connect" just sets the default destination.
-            // We use ESTABLISHED to indicate that the socket has a default peer,
-            // allowing danp_find_socket to match incoming packets from this peer specifically.
-            sock->state = DANP_SOCK_ESTABLISHED;
-            break;
+            danp_send_control(sock, DANP_FLAG_ACK, (uint16_t)(sock->rx_expected_seq - 1U));
         }
+        closed = (sock->state == DANP_SOCK_CLOSED) || sock->peer_fin;
 
-        danp_log_message(
-            DANP_LOG_INFO,
-            "Connecting to Node %d Port %d from Local Port %d",
-            node,
-            port,
-            sock->local_port);
-        sock->state = DANP_SOCK_SYN_SENT;
-        danp_send_control(sock, DANP_FLAG_SYN, 0);
+        osalMutexUnlock(sock->lock);
+        danp_tx_flush();
 
-        if (0 == osalSemaphoreTake(sock->signal, DANP_ACK_TIMEOUT_MS))
+        if (ret > 0 || closed || max_len == 0U)
         {
-            danp_log_message(DANP_LOG_INFO, "Connection Established");
             break;
         }
 
-        sock->state = DANP_SOCK_OPEN; // Reset state on timeout
-        danp_log_message(DANP_LOG_WARN, "Connect Timeout");
+        if (sock->nonblock)
+        {
+            ret = DANP_ERR_WOULD_BLOCK;
+            break;
+        }
 
-        ret = -1;
+        // Unconnected sockets may not own a queue, and nothing could arrive on them anyway.
+        if (sock->state == DANP_SOCK_OPEN || sock->state == DANP_SOCK_LISTENING)
+        {
+            break;
+        }
 
-        break;
+        // Wake-ups may be stale, so the ring is checked again after every one.
+        if (0 != osalMessageQueueReceive(
+                     sock->rx_queue,
+                     &wakeup,
+                     (timeout_ms == DANP_WAIT_FOREVER) ? timeout_ms : timeout_ms - elapsed_ms))
+        {
+            break;
+        }
+
+        elapsed_ms = osalGetTickMs() - start_ms;
+        if (timeout_ms != DANP_WAIT_FOREVER && elapsed_ms > timeout_ms)
+        {
+            elapsed_ms = timeout_ms;
+        }
     }
 
     return ret;
 }
 
 /**
- * @brief Accept a new connection on a listening socket.
- * @param server_sock Pointer to the listening socket.
+ * @brief Receive data from a connected socket.
+ * @param sock Pointer to the socket.
+ * @param buffer Pointer to the buffer to store received data.
+ * @param max_len Maximum length of the buffer.
  * @param timeout_ms Timeout in milliseconds.
- * @return Pointer to the new connected socket, or NULL on timeout/error.
+ * @return Number of bytes received, or negative on error/timeout.
  */
-danp_socket_t *danp_accept(danp_socket_t *server_sock, uint32_t timeout_ms)
+int32_t danp_recv(danp_socket_t *sock, void *buffer, uint16_t max_len, uint32_t timeout_ms)
 {
-    danp_socket_t *client = NULL;
+    int32_t ret = 0;
+    danp_packet_t *pkt = NULL;
+    int32_t copy_len = 0;
 
-    for (;;)
+    if (sock->type == DANP_TYPE_STREAM)
+    {
+        return danp_stream_recv(sock, buffer, max_len, timeout_ms);
+    }
+
+    if (0 == osalMessageQueueReceive(sock->rx_queue, &pkt, sock->nonblock ? 0U : timeout_ms))
     {
-        if (0 == osalMessageQueueReceive(server_sock->accept_queue, &client, timeout_ms))
+        if (pkt == NULL)
         {
-            break;
+            // Socket closed or reset
+            return 0;
         }
+        danp_socket_dequeued(sock);
 
-        break;
+        copy_len = (pkt->length > max_len) ? max_len : pkt->length;
+        memcpy(buffer, pkt->payload, copy_len);
+        danp_buffer_free(pkt);
+        ret = copy_len;
+    }
+    else if (sock->nonblock)
+    {
+        ret = DANP_ERR_WOULD_BLOCK;
     }
+    return ret;
+}
 
-    return client;
+/**
+ * @brief Pick the transport header version of a connection from the peer's SYN or SYN-ACK.
+ * @param sock Pointer to the socket.
+ * @param pkt SYN or SYN-ACK received from the peer.
+ */
+static void danp_stream_negotiate(danp_socket_t *sock, const danp_packet_t *pkt)
+{
+    uint16_t seq, ack, wnd;
+
+    if (danp_stream_parse_header(pkt, &seq, &ack, &wnd))
+    {
+        sock->version = DANP_STREAM_V2;
+        sock->peer_wnd = wnd;
+    }
+    else
+    {
+        // Legacy peers neither advertise a window nor take more than one segment at a time.
+        sock->version = DANP_STREAM_V1;
+        sock->peer_wnd = 1;
+        danp_log_message(DANP_LOG_INFO, "Peer Node %u Port %u uses the legacy STREAM header", sock->remote_node, sock->remote_port);
+    }
 }
 
 /**
- * @brief Send data over a connected socket.
+ * @brief Handle an ACK and/or data segment on a STREAM socket.
+ *
+ * Consumes the packet: in-order data is copied into the receive ring and
+ * the packet is freed.
+ *
  * @param sock Pointer to the socket.
- * @param data Pointer to the data to send.
- * @param len Length of the data.
- * @return Number of bytes sent, or negative on error.
+ * @param pkt Received packet.
+ * @param flags Header flags of the packet.
  */
-int32_t danp_send(danp_socket_t *sock, void *data, uint16_t len)
+static void danp_stream_input(danp_socket_t *sock, danp_packet_t *pkt, uint8_t flags)
 {
-    int32_t ret = 0;
-    int32_t retries = 0;
-    bool ack_received = false;
-    danp_packet_t *pkt = NULL;
+    uint16_t hdr_size = danp_stream_header_size(sock);
+    bool has_ack = (flags & DANP_FLAG_ACK) && !(flags & DANP_FLAG_SYN);
+    uint16_t seq = 0;
+    uint16_t ack = 0;
+    uint16_t wnd = sock->peer_wnd;
+    bool was_empty;
+    bool fin = false;
+    danp_packet_t *wakeup = NULL;
 
     for (;;)
     {
-        if (len > DANP_MAX_PACKET_SIZE - 1)
+        if (sock->version == DANP_STREAM_V2)
+        {
+            if (!danp_stream_parse_header(pkt, &seq, &ack, &wnd))
+            {
+                danp_log_message(DANP_LOG_WARN, "Malformed STREAM header on Port %u", sock->local_port);
+                break;
+            }
+            fin = (pkt->payload[DANP_STREAM_HDR_VER_OPT] & DANP_STREAM_OPT_FIN) != 0U;
+        }
+        else if (pkt->length >= DANP_STREAM_V1_HEADER_SIZE)
+        {
+            // Legacy peers send either a bare ACK or data, never both.
+            seq = danp_stream_seq_extend(sock->rx_expected_seq, pkt->payload[0]);
+            ack = danp_stream_seq_extend(sock->snd_una, pkt->payload[0]);
+        }
+        else
         {
-            ret = -1;
             break;
         }
 
-        if (sock->type == DANP_TYPE_DGRAM)
+        // Anything well-formed from the peer shows it is alive.
+        sock->last_rx_ms = osalGetTickMs();
+        sock->keepalive_probes = 0;
+
+        if (pkt->length > hdr_size && sock->state == DANP_SOCK_SYN_RECEIVED)
         {
-            danp_packet_t *pkt = danp_buffer_allocate();
-            if (!pkt)
+            sock->state = DANP_SOCK_ESTABLISHED;
+            danp_log_message(DANP_LOG_INFO, "Implicitly established connection via Data packet");
+            danp_socket_event(sock, DANP_EVENT_CONNECTED);
+        }
+
+        if (!danp_stream_synchronized(sock))
+        {
+            break;
+        }
+
+        if (has_ack)
+        {
+            danp_stream_process_ack(sock, ack, wnd, pkt->length == hdr_size && !fin);
+            danp_stream_finish(sock);
+            if (sock->state == DANP_SOCK_CLOSED)
             {
-                ret = -1;
                 break;
             }
-            pkt->header_raw = danp_pack_header(
-                0,
-                sock->remote_node,
-                sock->local_node,
-                sock->remote_port,
-                sock->local_port,
-                DANP_FLAG_NONE);
-            memcpy(pkt->payload, data, len);
-            pkt->length = len;
-            danp_route_tx(pkt);
-            danp_buffer_free(pkt);
-            ret = len;
+        }
+
+        if (pkt->length == hdr_size && !fin)
+        {
             break;
         }
 
-        while (retries < DANP_RETRY_LIMIT && !ack_received)
+        if (seq != sock->rx_expected_seq || sock->peer_fin)
         {
-            pkt = danp_buffer_allocate();
-            if (!pkt)
-            {
-                osalDelayMs(10);
-                continue;
-            }
-            pkt->header_raw = danp_pack_header(
-                0,
-                sock->remote_node,
-                sock->local_node,
-                sock->remote_port,
-                sock->local_port,
-                DANP_FLAG_NONE);
-            pkt->payload[0] = sock->tx_seq;
-            memcpy(pkt->payload + 1, data, len);
-            pkt->length = len + 1;
-            danp_route_tx(pkt);
-            danp_buffer_free(pkt);
+            // Out of order, duplicate or past the end of the stream: repeat the cumulative ACK at once.
+            danp_send_control(sock, DANP_FLAG_ACK, (uint16_t)(sock->rx_expected_seq - 1U));
+            break;
+        }
 
-            if (0 == osalSemaphoreTake(sock->signal, DANP_ACK_TIMEOUT_MS))
+        if (fin)
+        {
+            // The end of the stream takes a sequence number and is acknowledged at once.
+            sock->rx_expected_seq++;
+            sock->peer_fin = true;
+            danp_send_control(sock, DANP_FLAG_ACK, seq);
+            if (sock->state == DANP_SOCK_ESTABLISHED)
             {
-                ack_received = true;
+                sock->state = DANP_SOCK_CLOSE_WAIT;
             }
-            retries++;
+
+            osalMessageQueueSend(sock->rx_queue, &wakeup, 0);
+            danp_socket_event(sock, DANP_EVENT_DATA_READY);
+            danp_stream_finish(sock);
+            break;
         }
 
-        if (ack_received)
+        if (sock->orphan)
         {
-            sock->tx_seq++;
-            ret = len;
+            // Nobody is left to read it: tell the peer its data is lost.
+            danp_log_message(DANP_LOG_WARN, "Data for closed socket on Port %u. Resetting connection.", sock->local_port);
+            danp_send_control(sock, DANP_FLAG_RST, 0);
+            danp_stream_drop(sock);
             break;
         }
-        else
+
+        if (pkt->length - hdr_size > DANP_STREAM_RX_BUFFER_SIZE - sock->rx_count)
         {
-            ret = -1;
+            // Beyond the advertised window: drop unacknowledged and restate the window.
+            danp_send_control(sock, DANP_FLAG_ACK, (uint16_t)(sock->rx_expected_seq - 1U));
             break;
         }
 
+        // Coalesce into the receive ring; the pool packet is released right away.
+        was_empty = (sock->rx_count == 0U);
+        danp_stream_rx_write(sock, pkt->payload + hdr_size, pkt->length - hdr_size);
+        sock->rx_expected_seq++;
+        danp_ack_schedule(sock, seq);
+
+        if (was_empty)
+        {
+            osalMessageQueueSend(sock->rx_queue, &wakeup, 0);
+        }
+        danp_socket_event(sock, DANP_EVENT_DATA_READY);
         break;
     }
 
-    return ret;
+    danp_buffer_free(pkt);
 }
 
 /**
- * @brief Receive data from a connected socket.
- * @param sock Pointer to the socket.
- * @param buffer Pointer to the buffer to store received data.
- * @param max_len Maximum length of the buffer.
- * @param timeout_ms Timeout in milliseconds.
- * @return Number of bytes received, or negative on error/timeout.
+ * @brief Answer a segment of a connection in TIME_WAIT.
+ *
+ * A retransmitted FIN means our last ACK was lost, so it is acknowledged
+ * again; anything else is dropped without a reply.
+ *
+ * @param entry TIME_WAIT entry of the connection.
+ * @param pkt Received packet.
  */
-int32_t danp_recv(danp_socket_t *sock, void *buffer, uint16_t max_len, uint32_t timeout_ms)
+static void danp_time_wait_input(const danp_time_wait_t *entry, const danp_packet_t *pkt)
 {
-    int32_t ret = 0;
-    danp_packet_t *pkt = NULL;
-    int32_t copy_len = 0;
+    danp_packet_t ack_pkt;
+    uint16_t seq, ack, wnd;
+    uint16_t full_window = (uint16_t)(DANP_STREAM_RX_BUFFER_SIZE / (DANP_MAX_PACKET_SIZE - DANP_STREAM_HEADER_SIZE));
 
-    if (0 == osalMessageQueueReceive(sock->rx_queue, &pkt, timeout_ms))
+    if (!danp_stream_parse_header(pkt, &seq, &ack, &wnd) ||
+        !(pkt->payload[DANP_STREAM_HDR_VER_OPT] & DANP_STREAM_OPT_FIN))
     {
-        if (pkt == NULL)
-        {
-            // Socket closed or reset
-            return 0;
-        }
-
-        if (sock->type == DANP_TYPE_DGRAM)
-        {
-            copy_len = (pkt->length > max_len) ? max_len : pkt->length;
-            memcpy(buffer, pkt->payload, copy_len);
-        }
-        else
-        {
-            if (pkt->length > 0)
-            {
-                copy_len = (pkt->length - 1 > max_len) ? max_len : (pkt->length - 1);
-                memcpy(buffer, pkt->payload + 1, copy_len);
-            }
-        }
-        danp_buffer_free(pkt);
-        ret = copy_len;
+        return;
     }
-    return ret;
+
+    ack_pkt.header_raw = danp_pack_header(
+        0,
+        entry->remote_node,
+        danp_config.local_node,
+        entry->remote_port,
+        entry->local_port,
+        DANP_FLAG_ACK);
+    ack_pkt.rx_interface = NULL;
+    ack_pkt.payload[DANP_STREAM_HDR_VER_OPT] = (uint8_t)(DANP_STREAM_V2 << DANP_STREAM_VERSION_SHIFT);
+    ack_pkt.payload[DANP_STREAM_HDR_SEQ] = (uint8_t)(entry->snd_nxt >> 8);
+    ack_pkt.payload[DANP_STREAM_HDR_SEQ + 1] = (uint8_t)entry->snd_nxt;
+    ack_pkt.payload[DANP_STREAM_HDR_ACK] = (uint8_t)(seq >> 8);
+    ack_pkt.payload[DANP_STREAM_HDR_ACK + 1] = (uint8_t)seq;
+    ack_pkt.payload[DANP_STREAM_HDR_WND] = (uint8_t)(full_window >> 8);
+    ack_pkt.payload[DANP_STREAM_HDR_WND + 1] = (uint8_t)full_window;
+    ack_pkt.length = DANP_STREAM_HEADER_SIZE;
+
+    danp_tx_defer(&ack_pkt);
 }
 
 /**
@@ -679,12 +3256,13 @@ void danp_socket_input_handler(danp_packet_t *pkt)
     uint8_t dst_port = 0;
     uint8_t src_port = 0;
     uint8_t flags = 0;
-    uint8_t acked_seq = 0;
-    uint8_t seq = 0;
     // bool isConnected = false;
+    danp_socket_t *sock = NULL;
     danp_socket_t *child = NULL;
     danp_packet_t *garbage;
+    danp_time_wait_t *closed_conn;
     bool is_mutex_taken = false;
+    bool is_sock_locked = false;
     osalStatus_t osal_status;
 
     for (;;)
@@ -698,7 +3276,51 @@ void danp_socket_input_handler(danp_packet_t *pkt)
         is_mutex_taken = true;
 
         danp_unpack_header(pkt->header_raw, &dst, &src, &dst_port, &src_port, &flags);
-        danp_socket_t *sock = danp_find_socket(dst_port, src, src_port);
+        sock = danp_find_socket(dst_port, src, src_port);
+
+        if (sock && osalMutexLock(sock->lock, OSAL_WAIT_FOREVER) == OSAL_SUCCESS)
+        {
+            is_sock_locked = true;
+
+            // The lookup ran without the socket lock; it may have been reset since.
+            if (sock->state == DANP_SOCK_CLOSED || sock->local_port != dst_port)
+            {
+                osalMutexUnlock(sock->lock);
+                is_sock_locked = false;
+                sock = NULL;
+            }
+        }
+        else
+        {
+            sock = NULL;
+        }
+
+        // Broadcasts and group datagrams only reach DGRAM sockets, which never answer them.
+        if (DANP_NODE_IS_GROUP(dst) &&
+            (!sock || sock->type != DANP_TYPE_DGRAM || flags != DANP_FLAG_NONE ||
+             (dst != DANP_BROADCAST_NODE && !(sock->groups & (1U << (dst - DANP_MULTICAST_FIRST))))))
+        {
+            danp_log_message(DANP_LOG_DEBUG, "No member of group %u on Port %u", dst, dst_port);
+            danp_buffer_free(pkt);
+            break;
+        }
+
+        // Stray segments of a connection in TIME_WAIT never reach a listener or a new connection.
+        closed_conn = (!sock || sock->state == DANP_SOCK_LISTENING) ? danp_time_wait_find(dst_port, src, src_port) : NULL;
+        if (closed_conn && !(flags & (DANP_FLAG_RST | DANP_FLAG_SYN)))
+        {
+            danp_time_wait_input(closed_conn, pkt);
+            danp_buffer_free(pkt);
+            break;
+        }
+
+        // Only listeners, connections waiting in a backlog or closed by the application, and resets
+        // change the socket index.
+        if (!sock || (sock->state != DANP_SOCK_LISTENING && !sock->listener && !sock->orphan && flags != DANP_FLAG_RST))
+        {
+            osalMutexUnlock(mutex_socket);
+            is_mutex_taken = false;
+        }
 
         if (flags == DANP_FLAG_RST)
         {
@@ -707,18 +3329,18 @@ void danp_socket_input_handler(danp_packet_t *pkt)
                 // If remote_port is 0, it is a listener/unbound-source socket.
                 // isConnected = (sock->remote_port != 0);
 
-                if (sock->type == DANP_TYPE_STREAM)
+                if (sock->state == DANP_SOCK_LISTENING)
+                {
+                    // Only a connection can be reset; this one is already gone.
+                    danp_log_message(DANP_LOG_DEBUG, "Ignored RST on listening Port %u", dst_port);
+                }
+                else if (sock->type == DANP_TYPE_STREAM)
                 {
                     danp_log_message(
                         DANP_LOG_INFO,
                         "Received RST from peer. Closing socket to Port %u.",
                         dst_port);
-                    sock->state = DANP_SOCK_CLOSED;
-                    sock->local_port = 0;
-
-                    // Wake up any waiters on recv
-                    danp_packet_t *null_pkt = NULL;
-                    osalMessageQueueSend(sock->rx_queue, &null_pkt, 0);
+                    danp_stream_drop(sock);
                 }
                 else
                 {
@@ -737,25 +3359,45 @@ void danp_socket_input_handler(danp_packet_t *pkt)
             break;
         }
 
-        if ((sock->state == DANP_SOCK_ESTABLISHED || sock->state == DANP_SOCK_SYN_RECEIVED) &&
-            (flags & DANP_FLAG_SYN))
+        if (sock->state == DANP_SOCK_SYN_RECEIVED && (flags & DANP_FLAG_SYN))
+        {
+            // A retried SYN: our SYN-ACK was lost or is still on its way. Answer again and keep the state.
+            danp_log_message(DANP_LOG_DEBUG, "Duplicate SYN on Port %u. Resending SYN-ACK.", dst_port);
+            danp_send_control(sock, DANP_FLAG_ACK | DANP_FLAG_SYN, 0);
+            danp_buffer_free(pkt);
+            break;
+        }
+
+        if (sock->state == DANP_SOCK_ESTABLISHED && (flags & DANP_FLAG_SYN) &&
+            (flags != DANP_FLAG_SYN || danp_stream_fresh(sock)))
+        {
+            // A late SYN-ACK, or a SYN of the handshake that set up a connection which has not moved
+            // since. Either is a copy delayed or duplicated by the path; an ACK tells the peer where we are.
+            danp_log_message(DANP_LOG_DEBUG, "Stale SYN on established Port %u. Answering with ACK.", dst_port);
+            danp_send_control(sock, DANP_FLAG_ACK, 0);
+            danp_buffer_free(pkt);
+            break;
+        }
+
+        if (sock->state == DANP_SOCK_ESTABLISHED && (flags & DANP_FLAG_SYN))
         {
+            // The connection has carried data, so this SYN comes from a peer that restarted on the same port.
             danp_log_message(DANP_LOG_WARN, "Received SYN on active socket. Peer restart/resync. State reset.");
 
             if (sock->type == DANP_TYPE_STREAM)
             {
-                sock->tx_seq = 0;
-                sock->rx_expected_seq = 0;
+                danp_stream_reset(sock);
+                danp_stream_negotiate(sock, pkt);
+                danp_keepalive_start(sock, osalGetTickMs());
 
                 while (0 == osalMessageQueueReceive(sock->rx_queue, &garbage, 0))
                 {
-                    danp_buffer_free(garbage); // Clear out old data
+                    // Only wake-ups are queued on STREAM sockets.
                 }
             }
 
             danp_send_control(sock, DANP_FLAG_ACK | DANP_FLAG_SYN, 0);
             sock->state = DANP_SOCK_SYN_RECEIVED;
-
             danp_buffer_free(pkt);
             break;
         }
@@ -764,99 +3406,129 @@ void danp_socket_input_handler(danp_packet_t *pkt)
         {
             danp_log_message(DANP_LOG_INFO, "Received SYN from Node %d Port %d", src, src_port);
 
-            child = danp_socket(sock->type);
+            child = (sock->accept_pending < sock->backlog) ? danp_socket(sock->type) : NULL;
+            if (child && danp_socket_ensure_resources(child, true, child->type == DANP_TYPE_STREAM) != 0)
+            {
+                /* LCOV_EXCL_START */
+                danp_socket_close(child);
+                child = NULL;
+                /* LCOV_EXCL_STOP */
+            }
+            if (child && child->type == DANP_TYPE_STREAM && danp_stream_ring_take(child) != 0)
+            {
+                danp_socket_close(child);
+                child = NULL;
+            }
             if (!child)
             {
+                // No reply: the peer's connect times out and it can retry once we have caught up.
+                sock->syn_overflows++;
+                danp_log_message(
+                    DANP_LOG_WARN,
+                    "No room for a connection on Port %u (%u pending). Dropping SYN.",
+                    dst_port,
+                    sock->accept_pending);
+                danp_buffer_free(pkt);
+                break;
+            }
+
+            if (osalMutexLock(child->lock, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+            {
+                /* LCOV_EXCL_START */
                 danp_buffer_free(pkt);
                 break;
+                /* LCOV_EXCL_STOP */
             }
 
             child->local_node = danp_config.local_node;
             child->local_port = dst_port;
             child->remote_node = src;
             child->remote_port = src_port;
+            child->nonblock = sock->nonblock;
+            child->keepalive = sock->keepalive;
+            child->keepalive_count = sock->keepalive_count;
+            child->keepalive_idle_ms = sock->keepalive_idle_ms;
+            child->keepalive_interval_ms = sock->keepalive_interval_ms;
+            child->linger_ms = sock->linger_ms;
+            child->event_cb = sock->event_cb;
+            child->event_cb_data = sock->event_cb_data;
 
             child->state = DANP_SOCK_SYN_RECEIVED; // Set state and wait for final ACK
-
-            if (0 != osalMessageQueueSend(sock->accept_queue, &child, 0))
+            if (child->type == DANP_TYPE_STREAM)
             {
-                child->state = DANP_SOCK_CLOSED;
-                child->local_port = 0;
-                danp_buffer_free(pkt);
-                break;
+                danp_stream_reset(child);
+                danp_stream_negotiate(child, pkt);
+                danp_keepalive_start(child, osalGetTickMs());
             }
 
+            danp_backlog_push(sock, child);
+            osalSemaphoreGive(sock->signal);
+            danp_socket_event(sock, DANP_EVENT_ACCEPT);
+
             danp_send_control(child, DANP_FLAG_ACK | DANP_FLAG_SYN, 0);
+            osalMutexUnlock(child->lock);
             danp_buffer_free(pkt);
             break;
         }
 
-        if (sock->state == DANP_SOCK_SYN_SENT && (flags & DANP_FLAG_ACK))
+        if (sock->state == DANP_SOCK_SYN_SENT && flags != (DANP_FLAG_SYN | DANP_FLAG_ACK))
         {
-            sock->state = DANP_SOCK_ESTABLISHED;
-            danp_send_control(sock, DANP_FLAG_ACK, 0); // Send final ACK
-            osalSemaphoreGive(sock->signal);
+            // Only a SYN-ACK completes the handshake; an ACK here belongs to an older connection on this port.
+            danp_log_message(DANP_LOG_DEBUG, "Ignored non-SYN-ACK on connecting Port %u", dst_port);
             danp_buffer_free(pkt);
             break;
         }
 
-        if (sock->state == DANP_SOCK_SYN_RECEIVED && (flags & DANP_FLAG_ACK) &&
-            !(flags & DANP_FLAG_SYN))
+        if (sock->state == DANP_SOCK_SYN_SENT)
         {
-            // Final ACK received from client/resync, connection is fully active
+            if (sock->type == DANP_TYPE_STREAM)
+            {
+                danp_stream_negotiate(sock, pkt);
+            }
             sock->state = DANP_SOCK_ESTABLISHED;
+            danp_timer_cancel(sock, DANP_TIMER_RTO);
+            danp_keepalive_start(sock, osalGetTickMs());
+            danp_send_control(sock, DANP_FLAG_ACK, 0); // Send final ACK
+            osalSemaphoreGive(sock->signal);
+            danp_socket_event(sock, DANP_EVENT_CONNECTED);
             danp_buffer_free(pkt);
             break;
         }
 
-
-        // --- 2. DATA HANDLING ---
-        if ((flags & DANP_FLAG_ACK) && !(flags & DANP_FLAG_SYN) && pkt->length == 1)
+        if (sock->state == DANP_SOCK_SYN_RECEIVED && (flags & DANP_FLAG_ACK) &&
+            !(flags & DANP_FLAG_SYN) && pkt->length <= danp_stream_header_size(sock))
         {
-            if (sock->type == DANP_TYPE_STREAM)
+            // Final ACK received from client/resync, connection is fully active
+            uint16_t seq, ack, wnd;
+            if (sock->type == DANP_TYPE_STREAM && sock->version == DANP_STREAM_V2 &&
+                danp_stream_parse_header(pkt, &seq, &ack, &wnd))
             {
-                acked_seq = pkt->payload[0];
-                if (acked_seq == sock->tx_seq)
-                {
-                    osalSemaphoreGive(sock->signal);
-                }
+                sock->peer_wnd = wnd;
             }
+            sock->state = DANP_SOCK_ESTABLISHED;
+            danp_socket_event(sock, DANP_EVENT_CONNECTED);
             danp_buffer_free(pkt);
             break;
         }
 
-        if ((sock->state == DANP_SOCK_ESTABLISHED || sock->state == DANP_SOCK_SYN_RECEIVED ||
-             (sock->type == DANP_TYPE_DGRAM && sock->state == DANP_SOCK_OPEN)) &&
-            pkt->length > 0)
+
+        // --- 2. DATA HANDLING ---
+        if (sock->type == DANP_TYPE_STREAM)
+        {
+            danp_stream_input(sock, pkt, flags);
+            break;
+        }
+
+        if ((sock->state == DANP_SOCK_ESTABLISHED || sock->state == DANP_SOCK_OPEN) && pkt->length > 0)
         {
-            if (sock->type == DANP_TYPE_DGRAM)
+            if (0 != osalMessageQueueSend(sock->rx_queue, &pkt, 0))
             {
-                osalMessageQueueSend(sock->rx_queue, &pkt, 0);
+                danp_log_message(DANP_LOG_WARN, "Receive queue full on Port %u. Dropping datagram.", dst_port);
+                danp_buffer_free(pkt);
                 break;
             }
-            else if (sock->type == DANP_TYPE_STREAM)
-            {
-                seq = pkt->payload[0];
-
-                if (sock->state == DANP_SOCK_SYN_RECEIVED)
-                {
-                    sock->state = DANP_SOCK_ESTABLISHED;
-                    danp_log_message(DANP_LOG_INFO, "Implicitly established connection via Data packet");
-                }
-
-                if (seq == sock->rx_expected_seq)
-                {
-                    sock->rx_expected_seq++;
-                    danp_send_control(sock, DANP_FLAG_ACK, seq);
-                    osalMessageQueueSend(sock->rx_queue, &pkt, 0);
-                }
-                else
-                {
-                    danp_send_control(sock, DANP_FLAG_ACK, seq);
-                    danp_buffer_free(pkt);
-                }
-            }
-
+            sock->rx_pending++;
+            danp_socket_event(sock, DANP_EVENT_DATA_READY);
             break;
         }
 
@@ -865,10 +3537,19 @@ void danp_socket_input_handler(danp_packet_t *pkt)
         break;
     }
 
+    if (is_sock_locked)
+    {
+        danp_poll_notify();
+        osalMutexUnlock(sock->lock);
+    }
+
     if (is_mutex_taken)
     {
         osalMutexUnlock(mutex_socket);
     }
+
+    // Replies go out only now, with no socket lock held.
+    danp_tx_flush();
 }
 
 /**
@@ -952,8 +3633,9 @@ int32_t danp_recv_from(
             break;
         }
 
-        if (0 == osalMessageQueueReceive(sock->rx_queue, &pkt, timeout_ms))
+        if (0 == osalMessageQueueReceive(sock->rx_queue, &pkt, sock->nonblock ? 0U : timeout_ms))
         {
+            danp_socket_dequeued(sock);
             copy_len = (pkt->length > max_len) ? max_len : pkt->length;
             memcpy(buffer, pkt->payload, copy_len);
 
@@ -971,15 +3653,435 @@ int32_t danp_recv_from(
             danp_buffer_free(pkt);
             ret = copy_len;
         }
+        else if (sock->nonblock)
+        {
+            ret = DANP_ERR_WOULD_BLOCK;
+        }
+
+        break;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Get the readiness events of a socket.
+ * @param sock Pointer to the socket.
+ * @return danp_poll_event_t flags that are currently ready.
+ */
+static uint8_t danp_socket_poll_events(const danp_socket_t *sock)
+{
+    uint8_t events = 0;
+
+    if (sock->state == DANP_SOCK_LISTENING)
+    {
+        return (sock->accept_pending > 0U) ? (uint8_t)DANP_POLLACCEPT : 0U;
+    }
+
+    if (sock->type == DANP_TYPE_DGRAM)
+    {
+        return (uint8_t)(DANP_POLLOUT | ((sock->rx_pending > 0U) ? DANP_POLLIN : 0U));
+    }
+
+    if (sock->rx_count > 0U || sock->peer_fin)
+    {
+        // The end of the stream is readable too: danp_recv() returns 0 for it.
+        events |= DANP_POLLIN;
+    }
+    if ((sock->state == DANP_SOCK_ESTABLISHED || sock->state == DANP_SOCK_CLOSE_WAIT) &&
+        (uint16_t)(sock->tx_seq - sock->snd_una) < DANP_STREAM_TX_WINDOW)
+    {
+        events |= DANP_POLLOUT;
+    }
+    if ((sock->state == DANP_SOCK_CLOSED || sock->state == DANP_SOCK_OPEN) && sock->remote_port != 0U &&
+        !sock->peer_fin)
+    {
+        // Reset, timed out or never connected: danp_recv() returns at once, so it is also readable.
+        events |= DANP_POLLERR | DANP_POLLIN;
+    }
+
+    return events;
+}
+
+/**
+ * @brief Wait for readiness events on a set of sockets.
+ * @param fds Array of sockets and requested events.
+ * @param count Number of entries in fds.
+ * @param timeout_ms Timeout in milliseconds.
+ * @return Number of entries with events ready, 0 on timeout, or negative on error.
+ */
+int32_t danp_poll(danp_pollfd_t *fds, uint32_t count, uint32_t timeout_ms)
+{
+    osalSemaphoreAttr_t sem_attr = { .name = "danpPollSig", .maxCount = 1 };
+    danp_poll_waiter_t *waiter = NULL;
+    int32_t ready = 0;
+    uint32_t start_ms = osalGetTickMs();
+    uint32_t elapsed_ms = 0;
+
+    if (!fds && count > 0U)
+    {
+        return -1;
+    }
+
+    for (;;)
+    {
+        // The index lock keeps listener backlogs steady while they are counted.
+        if (osalMutexLock(mutex_socket, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+        {
+            /* LCOV_EXCL_START */
+            ready = -1;
+            break;
+            /* LCOV_EXCL_STOP */
+        }
+
+        ready = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            fds[i].revents = 0;
+            if (fds[i].sock && osalMutexLock(fds[i].sock->lock, OSAL_WAIT_FOREVER) == OSAL_SUCCESS)
+            {
+                fds[i].revents = danp_socket_poll_events(fds[i].sock) & (fds[i].events | DANP_POLLERR);
+                osalMutexUnlock(fds[i].sock->lock);
+            }
+            if (fds[i].revents != 0U)
+            {
+                ready++;
+            }
+        }
+
+        osalMutexUnlock(mutex_socket);
+
+        if (ready > 0 || timeout_ms == 0U)
+        {
+            break;
+        }
+
+        if (timeout_ms != DANP_WAIT_FOREVER)
+        {
+            elapsed_ms = osalGetTickMs() - start_ms;
+            if (elapsed_ms >= timeout_ms)
+            {
+                break;
+            }
+        }
+
+        if (waiter)
+        {
+            osalSemaphoreTake(
+                waiter->signal,
+                (timeout_ms == DANP_WAIT_FOREVER) ? OSAL_WAIT_FOREVER : (timeout_ms - elapsed_ms));
+            continue;
+        }
+
+        // Register, then check again: a notification sent in between is not lost.
+        if (osalMutexLock(mutex_poll, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+        {
+            /* LCOV_EXCL_START */
+            ready = -1;
+            break;
+            /* LCOV_EXCL_STOP */
+        }
+        for (int i = 0; !waiter && i < DANP_POLL_MAX_WAITERS; i++)
+        {
+            if (!poll_waiters[i].in_use)
+            {
+                if (!poll_waiters[i].signal)
+                {
+                    poll_waiters[i].signal = osalSemaphoreCreate(&sem_attr);
+                    if (!poll_waiters[i].signal)
+                    {
+                        /* LCOV_EXCL_START */
+                        break;
+                        /* LCOV_EXCL_STOP */
+                    }
+                }
+                poll_waiters[i].in_use = true;
+                waiter = &poll_waiters[i];
+            }
+        }
+        osalMutexUnlock(mutex_poll);
+
+        if (!waiter)
+        {
+            danp_log_message(DANP_LOG_ERROR, "Poll: No free waiter slot");
+            ready = -1;
+            break;
+        }
+    }
+
+    if (waiter && osalMutexLock(mutex_poll, OSAL_WAIT_FOREVER) == OSAL_SUCCESS)
+    {
+        waiter->in_use = false;
+        osalMutexUnlock(mutex_poll);
+    }
+
+    return ready;
+}
+
+/**
+ * @brief Join or leave a multicast group on a DGRAM socket.
+ * @param sock Pointer to the socket.
+ * @param group Group address.
+ * @param join true to join, false to leave.
+ * @return 0 on success, negative if the socket or group is invalid or nothing changes.
+ */
+static int32_t danp_socket_set_group(danp_socket_t *sock, uint32_t group, bool join)
+{
+    uint16_t bit = 0;
+    int32_t ret = 0;
+
+    if (sock->type != DANP_TYPE_DGRAM || group < DANP_MULTICAST_FIRST || group > DANP_MULTICAST_LAST)
+    {
+        return -1;
+    }
+    bit = (uint16_t)(1U << (group - DANP_MULTICAST_FIRST));
+
+    // The input handler reads the membership under the socket lock; the route lock nests inside it.
+    if (osalMutexLock(sock->lock, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+    {
+        /* LCOV_EXCL_START */
+        return -1;
+        /* LCOV_EXCL_STOP */
+    }
+    if (join == ((sock->groups & bit) != 0U))
+    {
+        ret = -1;
+    }
+    else if (danp_route_group_update((uint16_t)group, join) != 0)
+    {
+        /* LCOV_EXCL_START */
+        ret = -1;
+        /* LCOV_EXCL_STOP */
+    }
+    else
+    {
+        sock->groups = join ? (uint16_t)(sock->groups | bit) : (uint16_t)(sock->groups & ~bit);
+    }
+    osalMutexUnlock(sock->lock);
+
+    return ret;
+}
+
+/**
+ * @brief Set a socket option.
+ * @param sock Pointer to the socket.
+ * @param option Option to set.
+ * @param value New value of the option.
+ * @return 0 on success, negative on error.
+ */
+int32_t danp_setsockopt(danp_socket_t *sock, danp_socket_option_t option, uint32_t value)
+{
+    int32_t ret = 0;
+
+    if (!sock)
+    {
+        return -1;
+    }
+
+    switch (option)
+    {
+    case DANP_SO_SEND_WAIT_ACK:
+        sock->send_wait_ack = (value != 0U);
+        break;
+    case DANP_SO_NODELAY:
+        sock->coalesce = (value == 0U);
+        if (!sock->coalesce && sock->type == DANP_TYPE_STREAM)
+        {
+            // Do not leave data behind that nothing will ever push.
+            ret = danp_flush(sock);
+        }
+        break;
+    case DANP_SO_NONBLOCK:
+        sock->nonblock = (value != 0U);
+        break;
+    case DANP_SO_KEEPALIVE:
+        if (osalMutexLock(sock->lock, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+        {
+            /* LCOV_EXCL_START */
+            ret = -1;
+            break;
+            /* LCOV_EXCL_STOP */
+        }
+        sock->keepalive = (value != 0U);
+        if (sock->type == DANP_TYPE_STREAM && (danp_stream_synchronized(sock) || sock->state == DANP_SOCK_SYN_RECEIVED))
+        {
+            danp_keepalive_start(sock, osalGetTickMs());
+        }
+        osalMutexUnlock(sock->lock);
+        break;
+    case DANP_SO_KEEPIDLE:
+        if (value == 0U)
+        {
+            ret = -1;
+            break;
+        }
+        // A running timer picks the new value up when it next expires.
+        sock->keepalive_idle_ms = value;
+        break;
+    case DANP_SO_KEEPINTVL:
+        if (value == 0U)
+        {
+            ret = -1;
+            break;
+        }
+        sock->keepalive_interval_ms = value;
+        break;
+    case DANP_SO_KEEPCNT:
+        if (value == 0U || value > UINT8_MAX)
+        {
+            ret = -1;
+            break;
+        }
+        sock->keepalive_count = (uint8_t)value;
+        break;
+    case DANP_SO_LINGER:
+        sock->linger_ms = value;
+        break;
+    case DANP_SO_JOIN_GROUP:
+    case DANP_SO_LEAVE_GROUP:
+        ret = danp_socket_set_group(sock, value, option == DANP_SO_JOIN_GROUP);
+        break;
+    default:
+        ret = -1;
+        break;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Get a socket option.
+ * @param sock Pointer to the socket.
+ * @param option Option to read.
+ * @param value Pointer to store the value of the option.
+ * @return 0 on success, negative on error.
+ */
+int32_t danp_getsockopt(danp_socket_t *sock, danp_socket_option_t option, uint32_t *value)
+{
+    int32_t ret = 0;
+
+    if (!sock || !value)
+    {
+        return -1;
+    }
 
+    switch (option)
+    {
+    case DANP_SO_SEND_WAIT_ACK:
+        *value = sock->send_wait_ack ? 1U : 0U;
+        break;
+    case DANP_SO_NODELAY:
+        *value = sock->coalesce ? 0U : 1U;
+        break;
+    case DANP_SO_NONBLOCK:
+        *value = sock->nonblock ? 1U : 0U;
+        break;
+    case DANP_SO_KEEPALIVE:
+        *value = sock->keepalive ? 1U : 0U;
+        break;
+    case DANP_SO_KEEPIDLE:
+        *value = sock->keepalive_idle_ms;
+        break;
+    case DANP_SO_KEEPINTVL:
+        *value = sock->keepalive_interval_ms;
+        break;
+    case DANP_SO_KEEPCNT:
+        *value = sock->keepalive_count;
+        break;
+    case DANP_SO_LINGER:
+        *value = sock->linger_ms;
+        break;
+    default:
+        ret = -1;
         break;
     }
 
     return ret;
 }
 
+/**
+ * @brief Register a callback for the events of a socket.
+ * @param sock Pointer to the socket.
+ * @param callback Function to call, or NULL to remove the callback.
+ * @param user_data Pointer passed to every invocation.
+ * @return 0 on success, negative on error.
+ */
+int32_t danp_socket_set_callback(danp_socket_t *sock, danp_socket_callback_t callback, void *user_data)
+{
+    if (!sock)
+    {
+        return -1;
+    }
+
+    if (osalMutexLock(sock->lock, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+    {
+        /* LCOV_EXCL_START */
+        return -1;
+        /* LCOV_EXCL_STOP */
+    }
+
+    sock->event_cb = callback;
+    sock->event_cb_data = user_data;
+
+    osalMutexUnlock(sock->lock);
+
+    return 0;
+}
+
+/**
+ * @brief Select the congestion controller of a single STREAM socket.
+ * @param sock Pointer to the socket.
+ * @param ops Controller operations, or NULL for the current default.
+ * @return 0 on success, negative on error.
+ */
+int32_t danp_socket_set_congestion(danp_socket_t *sock, const danp_congestion_ops_t *ops)
+{
+    if (!sock || sock->type != DANP_TYPE_STREAM)
+    {
+        return -1;
+    }
+
+    if (osalMutexLock(sock->lock, OSAL_WAIT_FOREVER) != OSAL_SUCCESS)
+    {
+        /* LCOV_EXCL_START */
+        return -1;
+        /* LCOV_EXCL_STOP */
+    }
+
+    sock->cc_ops = ops ? ops : danp_congestion_get_default();
+    sock->cc_ops->init(sock);
+
+    osalMutexUnlock(sock->lock);
+
+    return 0;
+}
+
+/**
+ * @brief Report the RAM and OS objects used by the socket layer.
+ * @param footprint Filled with the current figures.
+ */
+void danp_socket_get_footprint(danp_socket_footprint_t *footprint)
+{
+    if (footprint == NULL)
+    {
+        return;
+    }
+
+    footprint->pool_bytes = (uint32_t)sizeof(socket_pool);
+    footprint->rx_ring_bytes = (uint32_t)(sizeof(rx_ring_pool) + sizeof(rx_ring_used));
+    footprint->tx_backlog_bytes = (uint32_t)sizeof(tx_backlog);
+    footprint->static_bytes = footprint->pool_bytes + footprint->rx_ring_bytes + footprint->tx_backlog_bytes +
+                              (uint32_t)(sizeof(time_wait) + sizeof(poll_waiters));
+    footprint->queues = created_queues;
+    footprint->semaphores = created_semaphores;
+    footprint->mutexes = created_mutexes;
+    footprint->queue_storage_bytes = (uint32_t)created_queues * DANP_RX_QUEUE_SIZE * (uint32_t)sizeof(danp_packet_t *);
+}
+
 void danp_print_stats(void (*print_func)(const char *fmt, ...))
 {
+    danp_socket_footprint_t footprint;
+
     if (print_func == NULL)
     {
         return;
@@ -988,16 +4090,47 @@ void danp_print_stats(void (*print_func)(const char *fmt, ...))
     print_func("DANP Socket Stats:\n");
     print_func("    Max Sockets: %d\n", DANP_MAX_SOCKET_COUNT);
     print_func("    Next Ephemeral Port: %u\n", next_ephemeral_port);
+    danp_socket_get_footprint(&footprint);
+    print_func("    Static RAM: %u bytes (socket pool %u, receive rings %u, transmit backlog %u)\n",
+        (unsigned int)footprint.static_bytes,
+        (unsigned int)footprint.pool_bytes,
+        (unsigned int)footprint.rx_ring_bytes,
+        (unsigned int)footprint.tx_backlog_bytes);
+    print_func("    OS Objects: %u queues (%u bytes of storage), %u semaphores, %u mutexes\n",
+        footprint.queues,
+        (unsigned int)footprint.queue_storage_bytes,
+        footprint.semaphores,
+        footprint.mutexes);
+    print_func("    Transmit Backlog Drops: %u\n", (unsigned int)tx_backlog_drops);
+    print_func("    Keepalive Resets: %u\n", (unsigned int)keepalive_resets);
+    for (int i = 0; i < DANP_TIME_WAIT_SLOTS; i++)
+    {
+        if (time_wait[i].local_port != 0U)
+        {
+            print_func("    TIME_WAIT: Local Port %u, Remote Node %u, Remote Port %u\n",
+                time_wait[i].local_port,
+                time_wait[i].remote_node,
+                time_wait[i].remote_port);
+        }
+    }
     print_func("    Active Sockets:\n");
     danp_socket_t *cur = socket_list;
     while (cur)
     {
-        print_func("      Socket on Local Port %u - State: %d, Type: %d, Remote Node: %u, Remote Port: %u\n",
+        print_func("      Socket on Local Port %u - State: %d, Type: %d, Remote Node: %u, Remote Port: %u, Cwnd: %u\n",
             cur->local_port,
             cur->state,
             cur->type,
             cur->remote_node,
-            cur->remote_port);
+            cur->remote_port,
+            cur->cwnd);
+        if (cur->state == DANP_SOCK_LISTENING)
+        {
+            print_func("        Backlog: %u/%u, SYN Overflows: %u\n",
+                cur->accept_pending,
+                cur->backlog,
+                (unsigned int)cur->syn_overflows);
+        }
         cur = cur->next;
     }
     print_func("\n");
@@ -0,0 +1,466 @@
+/* danp_emu.c - link emulator delaying, dropping, duplicating, reordering and rate-limiting another interface */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "osal/osal.h"
+#include "danp/danp.h"
+#include "../danp_debug.h"
+#include "danp/drivers/danp_emu.h"
+#include <stdbool.h>
+#include <string.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#define DANP_DRIVER_EMU_STACK_SIZE              (1024 * 4)
+#define DANP_DRIVER_EMU_TIMEOUT_MS              (5000)
+#define DANP_DRIVER_EMU_BITS_PER_BYTE           (8U)
+
+/* Types */
+
+/** @brief A queued packet and when it leaves. */
+typedef struct danp_emu_entry_s
+{
+    uint64_t due_us; /**< Release time on the emulator clock. */
+    uint32_t seq;    /**< Queue order, so packets due together leave first-in first-out. */
+    uint32_t slot;   /**< Index into danp_emu_context_t::slots. */
+} danp_emu_entry_t;
+
+/**
+ * @brief Emulator state: a min-heap of release times over private packet slots.
+ *
+ * Everything but the lower transmit is done under lock; the timer thread copies
+ * a due packet out, frees its slot and sends the copy without holding the lock,
+ * so senders are never blocked behind a slow lower driver.
+ */
+typedef struct danp_emu_context_s
+{
+    danp_emu_interface_t *iface;
+    danp_emu_params_t params;
+    danp_packet_t slots[DANP_EMU_QUEUE_DEPTH];
+    uint32_t free_slots[DANP_EMU_QUEUE_DEPTH];
+    uint32_t free_count;
+    danp_emu_entry_t heap[DANP_EMU_QUEUE_DEPTH];
+    uint32_t count;
+    uint32_t seq;
+    uint32_t rng;           /**< xorshift32 state, never 0. */
+    uint64_t clock_ms;      /**< OSAL tick extended to 64 bits. */
+    uint32_t clock_last;    /**< Tick seen by the last clock read. */
+    uint64_t link_free_us;  /**< When the emulated line finishes its current packet. */
+    uint64_t last_due_us;   /**< Release time of the last in-order packet. */
+    danp_packet_t out;      /**< Packet being handed to the lower interface. */
+    osalMutexHandle_t lock;
+    osalSemaphoreHandle_t signal;
+} danp_emu_context_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static danp_emu_context_t emu_contexts[DANP_EMU_MAX_INTERFACES];
+static uint32_t emu_context_count = 0;
+
+/* Functions */
+
+static bool danp_emu_params_valid(const danp_emu_params_t *params)
+{
+    return params->loss_ppm <= DANP_EMU_PPM &&
+           params->duplicate_ppm <= DANP_EMU_PPM &&
+           params->reorder_ppm <= DANP_EMU_PPM;
+}
+
+static void danp_emu_seed(danp_emu_context_t *ctx, uint32_t seed)
+{
+    // xorshift32 stays at 0 forever, so map that seed to another fixed one.
+    ctx->rng = (seed != 0) ? seed : 0x9E3779B9U;
+}
+
+static uint32_t danp_emu_random(danp_emu_context_t *ctx)
+{
+    uint32_t x = ctx->rng;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    ctx->rng = x;
+    return x;
+}
+
+static bool danp_emu_chance(danp_emu_context_t *ctx, uint32_t ppm)
+{
+    // No draw for the common 0 and certain cases, so enabling one impairment
+    // does not shift the decisions of another for the same seed.
+    if (ppm == 0)
+    {
+        return false;
+    }
+    if (ppm >= DANP_EMU_PPM)
+    {
+        return true;
+    }
+    return (danp_emu_random(ctx) % DANP_EMU_PPM) < ppm;
+}
+
+static uint64_t danp_emu_now_us(danp_emu_context_t *ctx)
+{
+    uint32_t tick = osalGetTickMs();
+
+    ctx->clock_ms += (uint32_t)(tick - ctx->clock_last);
+    ctx->clock_last = tick;
+    return ctx->clock_ms * 1000ULL;
+}
+
+static bool danp_emu_before(const danp_emu_entry_t *a, const danp_emu_entry_t *b)
+{
+    return (a->due_us < b->due_us) || (a->due_us == b->due_us && (int32_t)(a->seq - b->seq) < 0);
+}
+
+static void danp_emu_heap_push(danp_emu_context_t *ctx, danp_emu_entry_t entry)
+{
+    uint32_t i = ctx->count++;
+
+    while (i > 0)
+    {
+        uint32_t parent = (i - 1U) / 2U;
+        if (!danp_emu_before(&entry, &ctx->heap[parent]))
+        {
+            break;
+        }
+        ctx->heap[i] = ctx->heap[parent];
+        i = parent;
+    }
+    ctx->heap[i] = entry;
+}
+
+static danp_emu_entry_t danp_emu_heap_pop(danp_emu_context_t *ctx)
+{
+    danp_emu_entry_t top = ctx->heap[0];
+    danp_emu_entry_t last = ctx->heap[--ctx->count];
+    uint32_t i = 0;
+
+    for (;;)
+    {
+        uint32_t child = 2U * i + 1U;
+        if (child >= ctx->count)
+        {
+            break;
+        }
+        if (child + 1U < ctx->count && danp_emu_before(&ctx->heap[child + 1U], &ctx->heap[child]))
+        {
+            child++;
+        }
+        if (!danp_emu_before(&ctx->heap[child], &last))
+        {
+            break;
+        }
+        ctx->heap[i] = ctx->heap[child];
+        i = child;
+    }
+    if (ctx->count > 0)
+    {
+        ctx->heap[i] = last;
+    }
+    return top;
+}
+
+/**
+ * @brief Work out when one copy of a packet leaves and queue it; called with the lock held.
+ * @return true if the copy became the next packet due.
+ */
+static bool danp_emu_schedule(danp_emu_context_t *ctx, danp_packet_t *packet, uint64_t now_us, bool *queued)
+{
+    danp_emu_params_t *params = &ctx->params;
+    uint64_t ready_us = now_us;
+    uint64_t due_us = 0;
+    danp_emu_entry_t entry;
+
+    *queued = false;
+    if (ctx->free_count == 0)
+    {
+        ctx->iface->stats.tx_queue_drops++;
+        return false;
+    }
+
+    // The line carries one packet at a time: this one starts when the previous one is through.
+    if (params->rate_bps != 0)
+    {
+        uint64_t bits = (uint64_t)(packet->length + DANP_HEADER_SIZE) * DANP_DRIVER_EMU_BITS_PER_BYTE;
+        if (ctx->link_free_us > now_us)
+        {
+            ready_us = ctx->link_free_us;
+        }
+        ready_us += (bits * 1000000ULL + params->rate_bps - 1U) / params->rate_bps;
+        ctx->link_free_us = ready_us;
+    }
+
+    if (danp_emu_chance(ctx, params->reorder_ppm))
+    {
+        // Sent without the delay, so it overtakes what is queued; later packets still follow the others.
+        ctx->iface->stats.tx_reordered++;
+        due_us = ready_us;
+    }
+    else
+    {
+        due_us = ready_us + (uint64_t)params->delay_ms * 1000ULL;
+        if (params->jitter_ms != 0)
+        {
+            uint64_t span_us = (uint64_t)params->jitter_ms * 2000ULL + 1ULL;
+            uint64_t offset_us = danp_emu_random(ctx) % span_us;
+            uint64_t jitter_us = (uint64_t)params->jitter_ms * 1000ULL;
+            due_us = (due_us + offset_us > jitter_us) ? due_us + offset_us - jitter_us : 0;
+        }
+        // Jitter varies the delay but does not reorder, as on a single physical path.
+        if (due_us < ctx->last_due_us)
+        {
+            due_us = ctx->last_due_us;
+        }
+        ctx->last_due_us = due_us;
+    }
+
+    entry.due_us = due_us;
+    entry.seq = ctx->seq++;
+    entry.slot = ctx->free_slots[--ctx->free_count];
+    ctx->slots[entry.slot].header_raw = packet->header_raw;
+    ctx->slots[entry.slot].length = packet->length;
+    memcpy(ctx->slots[entry.slot].payload, packet->payload, packet->length);
+    danp_emu_heap_push(ctx, entry);
+    *queued = true;
+
+    return ctx->heap[0].seq == entry.seq;
+}
+
+static int32_t danp_emu_tx(void *iface_common, danp_packet_t *packet)
+{
+    danp_emu_interface_t *iface = (danp_emu_interface_t *)iface_common;
+    danp_emu_context_t *ctx = (danp_emu_context_t *)iface->context;
+    bool wake = false;
+    bool queued = false;
+    int32_t ret = 0;
+
+    danp_log_message(
+        DANP_LOG_VERBOSE,
+        "EMU TX: dst=%u port=%u flags=0x%02X len=%u",
+        (packet->header_raw >> 22) & 0xFF,
+        (packet->header_raw >> 8) & 0x3F,
+        packet->header_raw & 0x03,
+        packet->length);
+
+    osalMutexLock(ctx->lock, OSAL_WAIT_FOREVER);
+    uint64_t now_us = danp_emu_now_us(ctx);
+    iface->stats.tx_packets++;
+
+    if (danp_emu_chance(ctx, ctx->params.loss_ppm))
+    {
+        // Lost on the way, so the sender sees a successful transmit.
+        iface->stats.tx_lost++;
+    }
+    else
+    {
+        wake = danp_emu_schedule(ctx, packet, now_us, &queued);
+        if (!queued)
+        {
+            ret = -1;
+        }
+        else if (danp_emu_chance(ctx, ctx->params.duplicate_ppm))
+        {
+            bool dup_queued = false;
+            wake = danp_emu_schedule(ctx, packet, now_us, &dup_queued) || wake;
+            if (dup_queued)
+            {
+                iface->stats.tx_duplicated++;
+            }
+        }
+    }
+    osalMutexUnlock(ctx->lock);
+
+    if (wake)
+    {
+        osalSemaphoreGive(ctx->signal);
+    }
+
+    return ret;
+}
+
+static int32_t danp_emu_group(void *iface_common, uint16_t group, bool join)
+{
+    danp_emu_interface_t *iface = (danp_emu_interface_t *)iface_common;
+
+    return iface->lower->group_func(iface->lower, group, join);
+}
+
+static void danp_emu_timer_routine(void *arg)
+{
+    danp_emu_context_t *ctx = (danp_emu_context_t *)arg;
+    danp_emu_interface_t *iface = ctx->iface;
+
+    for (;;)
+    {
+        uint32_t wait_ms = DANP_DRIVER_EMU_TIMEOUT_MS;
+        bool send = false;
+
+        osalMutexLock(ctx->lock, OSAL_WAIT_FOREVER);
+        if (ctx->count > 0)
+        {
+            uint64_t now_us = danp_emu_now_us(ctx);
+            if (ctx->heap[0].due_us <= now_us)
+            {
+                danp_emu_entry_t entry = danp_emu_heap_pop(ctx);
+                danp_packet_t *slot = &ctx->slots[entry.slot];
+
+                ctx->out.header_raw = slot->header_raw;
+                ctx->out.length = slot->length;
+                memcpy(ctx->out.payload, slot->payload, slot->length);
+                ctx->free_slots[ctx->free_count++] = entry.slot;
+                send = true;
+            }
+            else
+            {
+                // Round up so the packet is never released early.
+                uint64_t remaining_ms = (ctx->heap[0].due_us - now_us + 999ULL) / 1000ULL;
+                wait_ms = (remaining_ms < DANP_DRIVER_EMU_TIMEOUT_MS) ? (uint32_t)remaining_ms : DANP_DRIVER_EMU_TIMEOUT_MS;
+            }
+        }
+        osalMutexUnlock(ctx->lock);
+
+        if (send)
+        {
+            // The lower driver copies or encodes the packet before returning, so out can be reused.
+            if (iface->lower->tx_func(iface->lower, &ctx->out) == 0)
+            {
+                __atomic_fetch_add(&iface->stats.tx_delivered, 1U, __ATOMIC_RELAXED);
+            }
+            else
+            {
+                __atomic_fetch_add(&iface->stats.tx_errors, 1U, __ATOMIC_RELAXED);
+            }
+            continue;
+        }
+
+        osalSemaphoreTake(ctx->signal, wait_ms);
+    }
+}
+
+int32_t danp_emu_init(danp_emu_interface_t *iface, const danp_emu_config_t *config)
+{
+    int32_t ret = 0;
+    danp_emu_context_t *ctx = NULL;
+    osalThreadAttr_t thread_attr =
+    {
+        .name = "danpEmu",
+        .stackSize = DANP_DRIVER_EMU_STACK_SIZE,
+        .stackMem = NULL,
+        .priority = OSAL_THREAD_PRIORITY_NORMAL,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+    osalMutexAttr_t mutex_attr =
+    {
+        .name = "danpEmuQueue",
+        .attrBits = OSAL_MUTEX_PRIO_INHERIT,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+    osalSemaphoreAttr_t sem_attr = { .name = "danpEmuTimer", .maxCount = 1 };
+
+    do
+    {
+        if (iface == NULL || config == NULL || config->lower == NULL || config->lower->tx_func == NULL ||
+            config->lower == &iface->common || !danp_emu_params_valid(&config->params))
+        {
+            ret = -1;
+            break;
+        }
+        if (emu_context_count >= DANP_EMU_MAX_INTERFACES)
+        {
+            danp_log_message(DANP_LOG_ERROR, "DANP EMU: No free interface context");
+            ret = -1;
+            break;
+        }
+
+        memset(iface, 0, sizeof(danp_emu_interface_t));
+        iface->lower = config->lower;
+        iface->common.address = config->lower->address;
+        iface->common.tx_func = danp_emu_tx;
+        iface->common.group_func = (config->lower->group_func != NULL) ? danp_emu_group : NULL;
+        iface->common.name = (config->name != NULL) ? config->name : "EMU";
+        iface->common.mtu = config->lower->mtu;
+
+        ctx = &emu_contexts[emu_context_count];
+        memset(ctx, 0, sizeof(danp_emu_context_t));
+        ctx->iface = iface;
+        ctx->params = config->params;
+        danp_emu_seed(ctx, config->params.seed);
+        for (uint32_t i = 0; i < DANP_EMU_QUEUE_DEPTH; i++)
+        {
+            ctx->free_slots[i] = i;
+        }
+        ctx->free_count = DANP_EMU_QUEUE_DEPTH;
+        ctx->clock_last = osalGetTickMs();
+
+        ctx->lock = osalMutexCreate(&mutex_attr);
+        ctx->signal = osalSemaphoreCreate(&sem_attr);
+        if (ctx->lock == NULL || ctx->signal == NULL)
+        {
+            /* LCOV_EXCL_START */
+            danp_log_message(DANP_LOG_ERROR, "DANP EMU: Failed to create queue primitives");
+            ret = -1;
+            break;
+            /* LCOV_EXCL_STOP */
+        }
+        iface->context = ctx;
+        emu_context_count++;
+
+        if (!osalThreadCreate(danp_emu_timer_routine, ctx, &thread_attr))
+        {
+            /* LCOV_EXCL_START */
+            danp_log_message(DANP_LOG_ERROR, "DANP EMU: Failed to create timer thread");
+            ret = -1;
+            break;
+            /* LCOV_EXCL_STOP */
+        }
+
+    } while (0);
+
+    return ret;
+}
+
+int32_t danp_emu_set_params(danp_emu_interface_t *iface, const danp_emu_params_t *params)
+{
+    danp_emu_context_t *ctx = NULL;
+
+    if (iface == NULL || iface->context == NULL || params == NULL || !danp_emu_params_valid(params))
+    {
+        return -1;
+    }
+
+    ctx = (danp_emu_context_t *)iface->context;
+    osalMutexLock(ctx->lock, OSAL_WAIT_FOREVER);
+    ctx->params = *params;
+    danp_emu_seed(ctx, params->seed);
+    osalMutexUnlock(ctx->lock);
+
+    return 0;
+}
+
+uint32_t danp_emu_pending(danp_emu_interface_t *iface)
+{
+    danp_emu_context_t *ctx = NULL;
+    uint32_t count = 0;
+
+    if (iface == NULL || iface->context == NULL)
+    {
+        return 0;
+    }
+
+    ctx = (danp_emu_context_t *)iface->context;
+    osalMutexLock(ctx->lock, OSAL_WAIT_FOREVER);
+    count = ctx->count;
+    osalMutexUnlock(ctx->lock);
+
+    return count;
+}
@@ -8,8 +8,11 @@
 #include "danp/danp.h"
 #include "../danp_debug.h"
 #include "danp/drivers/danp_lo.h"
+#include "danp_ring.h"
 #include <assert.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 
 /* Imports */
 
@@ -18,12 +21,29 @@
 
 #define DANP_DRIVER_LO_STACK_SIZE               (1024 * 4)
 #define DANP_DRIVER_LO_TIMEOUT_MS               (5000)
+#define DANP_DRIVER_LO_RING_MASK                (DANP_LO_RING_DEPTH - 1U)
+
+#if (DANP_LO_RING_DEPTH & DANP_DRIVER_LO_RING_MASK) != 0
+#error "DANP_LO_RING_DEPTH must be a power of two"
+#endif
 
 /* Types */
 
+/**
+ * @brief Loopback state: a single-consumer ring of pool packet pointers.
+ *
+ * head is only written by the RX thread and tail only by the producer holding
+ * tx_lock, so the consumer side never takes a lock. rx_waiting is the wake word
+ * of the ring (see danp_ring.h).
+ */
 typedef struct danp_lo_context_s
 {
-    osalMessageQueueHandle_t mq;
+    danp_packet_t *ring[DANP_LO_RING_DEPTH];
+    uint32_t head;
+    uint32_t tail;
+    uint32_t rx_waiting;
+    osalMutexHandle_t tx_lock;
+    osalSemaphoreHandle_t rx_signal;
     danp_lo_interface_t *iface;
 } danp_lo_context_t;
 
@@ -40,6 +60,8 @@ static int32_t danp_lo_tx(void *iface_common, danp_packet_t *packet)
 {
     danp_lo_interface_t *lo_iface = (danp_lo_interface_t *)iface_common;
     danp_lo_context_t *ctx = (danp_lo_context_t *)lo_iface->context;
+    danp_packet_t *pkt = NULL;
+    uint32_t tail = 0;
 
     danp_log_message(
         DANP_LOG_VERBOSE,
@@ -49,12 +71,40 @@ static int32_t danp_lo_tx(void *iface_common, danp_packet_t *packet)
         packet->header_raw & 0x03,
         packet->length);
 
-    osalStatus_t osalStatus = osalMessageQueueSend(ctx->mq, packet, OSAL_WAIT_FOREVER);
-    if (osalStatus != OSAL_SUCCESS)
+    // The caller keeps its packet, so take the one copy here; from now on only the pointer moves.
+    // A full ring is checked first so an overrunning sender does not also drain the pool.
+    if (!danp_ring_full(&ctx->head, __atomic_load_n(&ctx->tail, __ATOMIC_RELAXED), DANP_LO_RING_DEPTH))
+    {
+        pkt = danp_buffer_allocate();
+    }
+    if (pkt == NULL)
     {
-        danp_log_message(DANP_LOG_ERROR, "DANP LO: Failed to enqueue packet for RX");
+        __atomic_fetch_add(&lo_iface->tx_drops, 1U, __ATOMIC_RELAXED);
         return -1;
     }
+    pkt->header_raw = packet->header_raw;
+    pkt->length = packet->length;
+    memcpy(pkt->payload, packet->payload, packet->length);
+
+    // Several threads may transmit at once; serialize them so the ring keeps a single producer.
+    osalMutexLock(ctx->tx_lock, OSAL_WAIT_FOREVER);
+    tail = ctx->tail;
+    if (danp_ring_full(&ctx->head, tail, DANP_LO_RING_DEPTH))
+    {
+        // Blocking here could stall the RX thread's own replies.
+        osalMutexUnlock(ctx->tx_lock);
+        __atomic_fetch_add(&lo_iface->tx_drops, 1U, __ATOMIC_RELAXED);
+        danp_buffer_free(pkt);
+        return -1;
+    }
+    ctx->ring[tail & DANP_DRIVER_LO_RING_MASK] = pkt;
+    danp_ring_publish(&ctx->tail, tail + 1U);
+    osalMutexUnlock(ctx->tx_lock);
+
+    if (danp_ring_wake_needed(&ctx->rx_waiting))
+    {
+        osalSemaphoreGive(ctx->rx_signal);
+    }
 
     return 0;
 }
@@ -66,19 +116,30 @@ static void danp_lo_rx_routine(void *arg)
 
     for (;;)
     {
-        danp_packet_t pkt = {0};
-        if (0 == osalMessageQueueReceive(ctx->mq, &pkt, DANP_DRIVER_LO_TIMEOUT_MS))
+        uint32_t head = ctx->head;
+
+        if (head == __atomic_load_n(&ctx->tail, __ATOMIC_ACQUIRE))
         {
-            danp_log_message(
-                DANP_LOG_VERBOSE,
-                "LO RX: dst=%u port=%u flags=0x%02X len=%u",
-                (pkt.header_raw >> 22) & 0xFF,
-                (pkt.header_raw >> 8) & 0x3F,
-                pkt.header_raw & 0x03,
-                pkt.length);
-
-            danp_input(&lo_iface->common, (uint8_t *)&pkt, pkt.length + sizeof(pkt.header_raw));
+            if (danp_ring_sleep_begin(&ctx->rx_waiting, &ctx->tail, head))
+            {
+                osalSemaphoreTake(ctx->rx_signal, DANP_DRIVER_LO_TIMEOUT_MS);
+            }
+            danp_ring_sleep_end(&ctx->rx_waiting);
+            continue;
         }
+
+        danp_packet_t *pkt = ctx->ring[head & DANP_DRIVER_LO_RING_MASK];
+        __atomic_store_n(&ctx->head, head + 1U, __ATOMIC_RELEASE);
+
+        danp_log_message(
+            DANP_LOG_VERBOSE,
+            "LO RX: dst=%u port=%u flags=0x%02X len=%u",
+            (pkt->header_raw >> 22) & 0xFF,
+            (pkt->header_raw >> 8) & 0x3F,
+            pkt->header_raw & 0x03,
+            pkt->length);
+
+        danp_input_packet(&lo_iface->common, pkt);
     }
 }
 
@@ -95,14 +156,14 @@ int32_t danp_lo_init (danp_lo_interface_t *iface, uint16_t address)
         .cbMem = NULL,
         .cbSize = 0,
     };
-    osalMessageQueueAttr_t mq_attr =
+    osalMutexAttr_t mutex_attr =
     {
-        .name = "danpLoMq",
-        .mqMem = NULL,
-        .mqSize = 0,
+        .name = "danpLoTx",
+        .attrBits = OSAL_MUTEX_PRIO_INHERIT,
         .cbMem = NULL,
         .cbSize = 0,
     };
+    osalSemaphoreAttr_t sem_attr = { .name = "danpLoRx", .maxCount = 1 };
 
     do
     {
@@ -120,11 +181,15 @@ int32_t danp_lo_init (danp_lo_interface_t *iface, uint16_t address)
         iface->context = &danp_lo_context;
 
         danp_lo_context.iface = iface;
+        danp_lo_context.head = 0;
+        danp_lo_context.tail = 0;
+        danp_lo_context.rx_waiting = 0U;
 
-        danp_lo_context.mq = osalMessageQueueCreate(2, sizeof(danp_packet_t), &mq_attr);
-        if (danp_lo_context.mq == NULL)
+        danp_lo_context.tx_lock = osalMutexCreate(&mutex_attr);
+        danp_lo_context.rx_signal = osalSemaphoreCreate(&sem_attr);
+        if (danp_lo_context.tx_lock == NULL || danp_lo_context.rx_signal == NULL)
         {
-            danp_log_message(DANP_LOG_ERROR, "DANP LO: Failed to create message queue");
+            danp_log_message(DANP_LOG_ERROR, "DANP LO: Failed to create ring primitives");
             ret = -1;
             break;
         }
@@ -0,0 +1,100 @@
+/* danp_ring.h - index protocol of the single-consumer frame rings the drivers queue on */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_RING_H
+#define INC_DANP_RING_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+
+/* Types */
+
+
+/* External Declarations */
+
+/*
+ * A ring is a power-of-two slot array and two free-running indices: producers
+ * advance tail under their own lock, the one consumer thread advances head.
+ * Before the consumer sleeps it sets a wake word and looks at tail once more;
+ * a producer looks at the wake word after publishing. Both use sequentially
+ * consistent accesses, so either the consumer sees the new frame or the
+ * producer sees it sleeping, and no frame waits for the consumer's timeout.
+ */
+
+/**
+ * @brief Check whether a ring has no free slot; called by the producer holding its lock.
+ * @param head Consumer index.
+ * @param tail Producer index.
+ * @param depth Number of slots.
+ * @return true if the ring is full.
+ */
+static inline bool danp_ring_full(const uint32_t *head, uint32_t tail, uint32_t depth)
+{
+    return (tail - __atomic_load_n(head, __ATOMIC_ACQUIRE)) >= depth;
+}
+
+/**
+ * @brief Make the slots before a new tail visible to the consumer.
+ * @param tail Producer index.
+ * @param value New value of the producer index.
+ */
+static inline void danp_ring_publish(uint32_t *tail, uint32_t value)
+{
+    __atomic_store_n(tail, value, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Check after publishing whether the consumer must be woken.
+ *
+ * Only one producer wins a sleep, so concurrent producers send one wake-up.
+ *
+ * @param sleeping Wake word of the ring.
+ * @return true if the caller must wake the consumer.
+ */
+static inline bool danp_ring_wake_needed(uint32_t *sleeping)
+{
+    return __atomic_load_n(sleeping, __ATOMIC_SEQ_CST) != 0U &&
+           __atomic_exchange_n(sleeping, 0U, __ATOMIC_SEQ_CST) != 0U;
+}
+
+/**
+ * @brief Announce that the consumer is about to sleep.
+ * @param sleeping Wake word of the ring.
+ * @param tail Producer index.
+ * @param head Index up to which the consumer has taken frames.
+ * @return true if the ring is still empty and the consumer may sleep.
+ */
+static inline bool danp_ring_sleep_begin(uint32_t *sleeping, const uint32_t *tail, uint32_t head)
+{
+    __atomic_store_n(sleeping, 1U, __ATOMIC_SEQ_CST);
+    return head == __atomic_load_n(tail, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Withdraw the announcement once the consumer runs again.
+ * @param sleeping Wake word of the ring.
+ */
+static inline void danp_ring_sleep_end(uint32_t *sleeping)
+{
+    __atomic_store_n(sleeping, 0U, __ATOMIC_RELAXED);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_RING_H */
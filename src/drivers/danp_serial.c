@@ -0,0 +1,703 @@
+/* danp_serial.c - DANP over serial lines (UART, pseudo-terminals) with COBS or KISS framing */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* cfmakeraw */
+#endif
+
+#include "osal/osal.h"
+#include "danp/danp.h"
+#include "../danp_debug.h"
+#include "danp/drivers/danp_serial.h"
+#ifdef DANP_URING_SUPPORT
+#include "danp/drivers/danp_uring.h"
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#define DANP_DRIVER_SERIAL_STACK_SIZE           (1024 * 4)
+#define DANP_DRIVER_SERIAL_RETRY_MS             (100)
+#define DANP_DRIVER_SERIAL_BITS_PER_BYTE        (10U) /* 8N1: start, 8 data, stop */
+#define DANP_DRIVER_SERIAL_CRC_INIT             (0xFFFFU)
+
+#define DANP_DRIVER_SERIAL_COBS_DELIMITER       (0x00U)
+#define DANP_DRIVER_SERIAL_COBS_BLOCK_MAX       (0xFFU)
+
+#define DANP_DRIVER_SERIAL_KISS_FEND            (0xC0U)
+#define DANP_DRIVER_SERIAL_KISS_FESC            (0xDBU)
+#define DANP_DRIVER_SERIAL_KISS_TFEND           (0xDCU)
+#define DANP_DRIVER_SERIAL_KISS_TFESC           (0xDDU)
+#define DANP_DRIVER_SERIAL_KISS_DATA            (0x00U)
+
+/* Types */
+
+#ifdef DANP_URING_SUPPORT
+/* Frames are queued to the loop in one piece, so the largest must fit its slots. */
+typedef char danp_serial_frame_fits_uring_t[(DANP_URING_FRAME_SIZE >= DANP_SERIAL_FRAME_MAX) ? 1 : -1];
+#endif
+
+/**
+ * @brief Incremental frame decoder.
+ *
+ * Decoded bytes go straight into a pool packet, which is allocated when the
+ * first of them is known to be frame data. The last two decoded bytes are held
+ * back until the next one arrives, so when the delimiter comes they are the CRC
+ * and never touch the packet.
+ */
+typedef struct danp_serial_decoder_s
+{
+    danp_packet_t *pkt;    /**< Packet being filled, or NULL. */
+    uint16_t length;       /**< Header and payload bytes written to pkt. */
+    uint16_t crc;          /**< CRC of the bytes written to pkt. */
+    uint8_t held[DANP_SERIAL_CRC_SIZE];
+    uint8_t held_count;
+    bool discard;          /**< Ignore bytes until the next delimiter. */
+    uint8_t block_left;    /**< COBS: data bytes left in the current block. */
+    bool zero_pending;     /**< COBS: the current block ends with an encoded zero. */
+    bool in_frame;         /**< KISS: an opening FEND was seen. */
+    bool need_command;     /**< KISS: the next byte is the command byte. */
+    bool escaped;          /**< KISS: the previous byte was FESC. */
+} danp_serial_decoder_t;
+
+/** @brief Driver state of one serial interface. */
+typedef struct danp_serial_context_s
+{
+    danp_serial_interface_t *iface;
+    osalMutexHandle_t tx_lock;
+    uint32_t chunk_us; /**< Time DANP_SERIAL_RX_CHUNK bytes take on the line; 0 if unknown. */
+    danp_serial_decoder_t rx;
+    danp_packet_t *burst[DANP_SERIAL_RX_BURST];
+    uint32_t burst_count;
+    uint8_t read_buffer[DANP_SERIAL_READ_SIZE];
+} danp_serial_context_t;
+
+/** @brief A supported line rate. */
+typedef struct danp_serial_speed_s
+{
+    uint32_t baud;
+    speed_t speed;
+} danp_serial_speed_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static danp_serial_context_t serial_contexts[DANP_SERIAL_MAX_INTERFACES];
+static uint32_t serial_context_count = 0;
+
+static const danp_serial_speed_t serial_speeds[] = {
+    { 1200, B1200 },       { 2400, B2400 },       { 4800, B4800 },       { 9600, B9600 },
+    { 19200, B19200 },     { 38400, B38400 },     { 57600, B57600 },     { 115200, B115200 },
+    { 230400, B230400 },   { 460800, B460800 },   { 921600, B921600 },   { 1000000, B1000000 },
+    { 2000000, B2000000 }, { 3000000, B3000000 }, { 4000000, B4000000 },
+};
+
+/* Functions */
+
+/**
+ * @brief Add one byte to a CRC-16/CCITT-FALSE (polynomial 0x1021, MSB first).
+ */
+static uint16_t danp_serial_crc_update(uint16_t crc, uint8_t byte)
+{
+    crc ^= (uint16_t)(byte << 8);
+    for (uint32_t bit = 0; bit < 8; bit++)
+    {
+        crc = (crc & 0x8000U) ? (uint16_t)((crc << 1) ^ 0x1021U) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+/**
+ * @brief Byte i of a packet on the line: header, payload, then the CRC high byte first.
+ */
+static uint8_t danp_serial_raw_byte(const danp_packet_t *packet, uint16_t crc, uint32_t i)
+{
+    uint32_t payload_end = DANP_HEADER_SIZE + packet->length;
+
+    if (i < DANP_HEADER_SIZE)
+    {
+        return ((const uint8_t *)&packet->header_raw)[i];
+    }
+    if (i < payload_end)
+    {
+        return packet->payload[i - DANP_HEADER_SIZE];
+    }
+    return (i == payload_end) ? (uint8_t)(crc >> 8) : (uint8_t)crc;
+}
+
+/**
+ * @brief Encode a packet as one frame.
+ * @param framing Frame delimiting.
+ * @param packet Packet to encode.
+ * @param out Buffer of at least DANP_SERIAL_FRAME_MAX bytes.
+ * @return Encoded length.
+ */
+static uint32_t danp_serial_encode(danp_serial_framing_t framing, const danp_packet_t *packet, uint8_t *out)
+{
+    uint32_t raw_len = DANP_HEADER_SIZE + packet->length + DANP_SERIAL_CRC_SIZE;
+    uint16_t crc = DANP_DRIVER_SERIAL_CRC_INIT;
+    uint32_t pos = 0;
+
+    for (uint32_t i = 0; i < raw_len - DANP_SERIAL_CRC_SIZE; i++)
+    {
+        crc = danp_serial_crc_update(crc, danp_serial_raw_byte(packet, crc, i));
+    }
+
+    if (framing == DANP_SERIAL_FRAMING_KISS)
+    {
+        out[pos++] = DANP_DRIVER_SERIAL_KISS_FEND;
+        out[pos++] = DANP_DRIVER_SERIAL_KISS_DATA;
+        for (uint32_t i = 0; i < raw_len; i++)
+        {
+            uint8_t byte = danp_serial_raw_byte(packet, crc, i);
+
+            if (byte == DANP_DRIVER_SERIAL_KISS_FEND)
+            {
+                out[pos++] = DANP_DRIVER_SERIAL_KISS_FESC;
+                out[pos++] = DANP_DRIVER_SERIAL_KISS_TFEND;
+            }
+            else if (byte == DANP_DRIVER_SERIAL_KISS_FESC)
+            {
+                out[pos++] = DANP_DRIVER_SERIAL_KISS_FESC;
+                out[pos++] = DANP_DRIVER_SERIAL_KISS_TFESC;
+            }
+            else
+            {
+                out[pos++] = byte;
+            }
+        }
+        out[pos++] = DANP_DRIVER_SERIAL_KISS_FEND;
+        return pos;
+    }
+
+    // COBS: each block starts with the distance to the next zero, which it replaces.
+    uint32_t code_pos = pos++;
+    uint8_t code = 1;
+    for (uint32_t i = 0; i < raw_len; i++)
+    {
+        uint8_t byte = danp_serial_raw_byte(packet, crc, i);
+
+        if (byte != DANP_DRIVER_SERIAL_COBS_DELIMITER)
+        {
+            out[pos++] = byte;
+            code++;
+        }
+        if (byte == DANP_DRIVER_SERIAL_COBS_DELIMITER || code == DANP_DRIVER_SERIAL_COBS_BLOCK_MAX)
+        {
+            out[code_pos] = code;
+            code_pos = pos++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+    out[pos++] = DANP_DRIVER_SERIAL_COBS_DELIMITER;
+
+    return pos;
+}
+
+/**
+ * @brief Hand the decoded frames collected so far to the stack.
+ */
+static void danp_serial_flush_burst(danp_serial_context_t *ctx)
+{
+    if (ctx->burst_count > 0)
+    {
+        __atomic_fetch_add(&ctx->iface->stats.rx_frames, ctx->burst_count, __ATOMIC_RELAXED);
+        danp_input_burst(&ctx->iface->common, ctx->burst, ctx->burst_count);
+        ctx->burst_count = 0;
+    }
+}
+
+/**
+ * @brief Drop the rest of the current frame, counting it once.
+ */
+static void danp_serial_discard(danp_serial_context_t *ctx)
+{
+    if (!ctx->rx.discard)
+    {
+        ctx->rx.discard = true;
+        __atomic_fetch_add(&ctx->iface->stats.rx_drops, 1U, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Take one decoded byte of the current frame.
+ */
+static void danp_serial_emit(danp_serial_context_t *ctx, uint8_t byte)
+{
+    danp_serial_decoder_t *rx = &ctx->rx;
+    uint8_t out = 0;
+
+    if (rx->discard)
+    {
+        return;
+    }
+    if (rx->held_count < DANP_SERIAL_CRC_SIZE)
+    {
+        rx->held[rx->held_count++] = byte;
+        return;
+    }
+
+    // The oldest held byte is frame data, not CRC.
+    out = rx->held[0];
+    rx->held[0] = rx->held[1];
+    rx->held[1] = byte;
+    if (rx->length >= DANP_HEADER_SIZE + DANP_MAX_PACKET_SIZE)
+    {
+        danp_serial_discard(ctx);
+        return;
+    }
+    if (rx->pkt == NULL)
+    {
+        rx->pkt = danp_buffer_allocate();
+        if (rx->pkt == NULL)
+        {
+            danp_serial_discard(ctx);
+            return;
+        }
+    }
+    if (rx->length < DANP_HEADER_SIZE)
+    {
+        ((uint8_t *)&rx->pkt->header_raw)[rx->length] = out;
+    }
+    else
+    {
+        rx->pkt->payload[rx->length - DANP_HEADER_SIZE] = out;
+    }
+    rx->length++;
+    rx->crc = danp_serial_crc_update(rx->crc, out);
+}
+
+/**
+ * @brief Close the current frame at a delimiter and start the next one.
+ */
+static void danp_serial_end_frame(danp_serial_context_t *ctx)
+{
+    danp_serial_decoder_t *rx = &ctx->rx;
+    uint16_t received_crc = (uint16_t)((rx->held[0] << 8) | rx->held[1]);
+
+    if (rx->discard || (rx->length == 0 && rx->held_count == 0))
+    {
+        // Dropped already, or an empty frame between two delimiters.
+    }
+    else if (rx->length < DANP_HEADER_SIZE || rx->held_count < DANP_SERIAL_CRC_SIZE)
+    {
+        __atomic_fetch_add(&ctx->iface->stats.rx_drops, 1U, __ATOMIC_RELAXED);
+    }
+    else if (received_crc != rx->crc)
+    {
+        __atomic_fetch_add(&ctx->iface->stats.rx_crc_errors, 1U, __ATOMIC_RELAXED);
+    }
+    else
+    {
+        rx->pkt->length = (uint16_t)(rx->length - DANP_HEADER_SIZE);
+        ctx->burst[ctx->burst_count++] = rx->pkt;
+        rx->pkt = NULL;
+        if (ctx->burst_count == DANP_SERIAL_RX_BURST)
+        {
+            danp_serial_flush_burst(ctx);
+        }
+    }
+
+    if (rx->pkt != NULL)
+    {
+        danp_buffer_free(rx->pkt);
+        rx->pkt = NULL;
+    }
+    rx->length = 0;
+    rx->crc = DANP_DRIVER_SERIAL_CRC_INIT;
+    rx->held_count = 0;
+    rx->discard = false;
+    rx->block_left = 0;
+    rx->zero_pending = false;
+    rx->escaped = false;
+}
+
+static void danp_serial_feed_cobs(danp_serial_context_t *ctx, uint8_t byte)
+{
+    danp_serial_decoder_t *rx = &ctx->rx;
+
+    if (byte == DANP_DRIVER_SERIAL_COBS_DELIMITER)
+    {
+        // A block cut short by the delimiter means bytes were lost.
+        if (rx->block_left != 0)
+        {
+            danp_serial_discard(ctx);
+        }
+        danp_serial_end_frame(ctx);
+    }
+    else if (rx->block_left == 0)
+    {
+        // A code byte: the zero the previous block ended with was real, since data follows.
+        if (rx->zero_pending)
+        {
+            danp_serial_emit(ctx, DANP_DRIVER_SERIAL_COBS_DELIMITER);
+        }
+        rx->block_left = (uint8_t)(byte - 1U);
+        rx->zero_pending = (byte != DANP_DRIVER_SERIAL_COBS_BLOCK_MAX);
+    }
+    else
+    {
+        danp_serial_emit(ctx, byte);
+        rx->block_left--;
+    }
+}
+
+static void danp_serial_feed_kiss(danp_serial_context_t *ctx, uint8_t byte)
+{
+    danp_serial_decoder_t *rx = &ctx->rx;
+
+    if (byte == DANP_DRIVER_SERIAL_KISS_FEND)
+    {
+        if (rx->escaped)
+        {
+            danp_serial_discard(ctx);
+        }
+        danp_serial_end_frame(ctx);
+        rx->in_frame = true;
+        rx->need_command = true;
+    }
+    else if (!rx->in_frame)
+    {
+        // Line noise before the first FEND.
+    }
+    else if (rx->need_command)
+    {
+        rx->need_command = false;
+        // Other commands configure a TNC and carry no packet.
+        rx->discard = (byte != DANP_DRIVER_SERIAL_KISS_DATA);
+    }
+    else if (rx->escaped)
+    {
+        rx->escaped = false;
+        if (byte == DANP_DRIVER_SERIAL_KISS_TFEND)
+        {
+            danp_serial_emit(ctx, DANP_DRIVER_SERIAL_KISS_FEND);
+        }
+        else if (byte == DANP_DRIVER_SERIAL_KISS_TFESC)
+        {
+            danp_serial_emit(ctx, DANP_DRIVER_SERIAL_KISS_FESC);
+        }
+        else
+        {
+            danp_serial_discard(ctx);
+        }
+    }
+    else if (byte == DANP_DRIVER_SERIAL_KISS_FESC)
+    {
+        rx->escaped = true;
+    }
+    else
+    {
+        danp_serial_emit(ctx, byte);
+    }
+}
+
+/**
+ * @brief Decode bytes read from the line and deliver the frames they complete.
+ */
+static void danp_serial_decode(danp_serial_context_t *ctx, const uint8_t *data, uint32_t length)
+{
+    __atomic_fetch_add(&ctx->iface->stats.rx_reads, 1U, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&ctx->iface->stats.rx_bytes, length, __ATOMIC_RELAXED);
+
+    for (uint32_t i = 0; i < length; i++)
+    {
+        if (ctx->iface->framing == DANP_SERIAL_FRAMING_KISS)
+        {
+            danp_serial_feed_kiss(ctx, data[i]);
+        }
+        else
+        {
+            danp_serial_feed_cobs(ctx, data[i]);
+        }
+    }
+    danp_serial_flush_burst(ctx);
+}
+
+static int32_t danp_serial_tx(void *iface_common, danp_packet_t *packet)
+{
+    danp_serial_interface_t *iface = (danp_serial_interface_t *)iface_common;
+    danp_serial_context_t *ctx = (danp_serial_context_t *)iface->context;
+    uint8_t frame[DANP_SERIAL_FRAME_MAX];
+    uint32_t length = danp_serial_encode(iface->framing, packet, frame);
+    uint32_t done = 0;
+    int error = 0;
+
+    danp_log_message(
+        DANP_LOG_VERBOSE,
+        "SERIAL TX: dst=%u port=%u flags=0x%02X len=%u",
+        (packet->header_raw >> 22) & 0xFF,
+        (packet->header_raw >> 8) & 0x3F,
+        packet->header_raw & 0x03,
+        packet->length);
+
+#ifdef DANP_URING_SUPPORT
+    if (iface->uring != NULL)
+    {
+        if (danp_uring_send(iface->uring, iface->uring_source, frame, length, NULL, 0) != 0)
+        {
+            __atomic_fetch_add(&iface->stats.tx_drops, 1U, __ATOMIC_RELAXED);
+            return -1;
+        }
+        __atomic_fetch_add(&iface->stats.tx_frames, 1U, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&iface->stats.tx_bytes, length, __ATOMIC_RELAXED);
+        return 0;
+    }
+#endif
+
+    // One write per frame keeps frames of different threads from interleaving.
+    osalMutexLock(ctx->tx_lock, OSAL_WAIT_FOREVER);
+    while (done < length)
+    {
+        ssize_t written = write(iface->fd, frame + done, length - done);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            error = errno;
+            break;
+        }
+        done += (uint32_t)written;
+    }
+    osalMutexUnlock(ctx->tx_lock);
+
+    if (done < length)
+    {
+        // A partial frame fails its CRC at the receiver, which resynchronises on the next delimiter.
+        danp_log_message(DANP_LOG_WARN, "DANP SERIAL: write failed, errno %d", error);
+        __atomic_fetch_add(&iface->stats.tx_drops, 1U, __ATOMIC_RELAXED);
+        return -1;
+    }
+    __atomic_fetch_add(&iface->stats.tx_frames, 1U, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&iface->stats.tx_bytes, length, __ATOMIC_RELAXED);
+
+    return 0;
+}
+
+static void danp_serial_rx_routine(void *arg)
+{
+    danp_serial_context_t *ctx = (danp_serial_context_t *)arg;
+    danp_serial_interface_t *iface = ctx->iface;
+
+    for (;;)
+    {
+        // VMIN 1: block for the first byte, then return everything the terminal has buffered.
+        ssize_t received = read(iface->fd, ctx->read_buffer, sizeof(ctx->read_buffer));
+        if (received <= 0)
+        {
+            if (received < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            // Hang-up or device error; retry rather than spin until the line is back.
+            osalDelayMs(DANP_DRIVER_SERIAL_RETRY_MS);
+            continue;
+        }
+        danp_serial_decode(ctx, ctx->read_buffer, (uint32_t)received);
+
+        // Inside a frame on a slow line, let a chunk accumulate instead of waking per byte.
+        bool mid_frame = ctx->rx.held_count > 0 || ctx->rx.block_left > 0 || ctx->rx.escaped || ctx->rx.discard;
+        if (mid_frame && ctx->chunk_us > 0 && received < DANP_SERIAL_RX_CHUNK)
+        {
+            usleep(ctx->chunk_us);
+        }
+    }
+}
+
+#ifdef DANP_URING_SUPPORT
+static void danp_serial_on_read(void *arg, const uint8_t *data, uint32_t length)
+{
+    danp_serial_decode((danp_serial_context_t *)arg, data, length);
+}
+#endif
+
+/**
+ * @brief Switch a terminal to raw 8N1 at the given rate.
+ */
+static int32_t danp_serial_configure(int32_t fd, uint32_t baud)
+{
+    struct termios tio;
+    speed_t speed = B0;
+
+    if (baud != 0)
+    {
+        for (uint32_t i = 0; i < sizeof(serial_speeds) / sizeof(serial_speeds[0]); i++)
+        {
+            if (serial_speeds[i].baud == baud)
+            {
+                speed = serial_speeds[i].speed;
+            }
+        }
+        if (speed == B0)
+        {
+            danp_log_message(DANP_LOG_ERROR, "DANP SERIAL: Unsupported baud rate %u", baud);
+            return -1;
+        }
+    }
+
+    if (tcgetattr(fd, &tio) != 0)
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP SERIAL: Not a terminal, errno %d", errno);
+        return -1;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(tcflag_t)(CSTOPB | CRTSCTS);
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    if (speed != B0 && (cfsetispeed(&tio, speed) != 0 || cfsetospeed(&tio, speed) != 0))
+    {
+        /* LCOV_EXCL_START */
+        return -1;
+        /* LCOV_EXCL_STOP */
+    }
+    if (tcsetattr(fd, TCSANOW, &tio) != 0)
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP SERIAL: tcsetattr failed, errno %d", errno);
+        return -1;
+    }
+
+    return 0;
+}
+
+int32_t danp_serial_init(danp_serial_interface_t *iface, const danp_serial_config_t *config)
+{
+    int32_t ret = 0;
+    danp_serial_context_t *ctx = NULL;
+    osalThreadAttr_t thread_attr =
+    {
+        .name = "danpSerialRx",
+        .stackSize = DANP_DRIVER_SERIAL_STACK_SIZE,
+        .stackMem = NULL,
+        .priority = OSAL_THREAD_PRIORITY_NORMAL,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+    osalMutexAttr_t mutex_attr =
+    {
+        .name = "danpSerialTx",
+        .attrBits = OSAL_MUTEX_PRIO_INHERIT,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+
+    do
+    {
+        if (iface == NULL || config == NULL ||
+            (config->framing != DANP_SERIAL_FRAMING_COBS && config->framing != DANP_SERIAL_FRAMING_KISS))
+        {
+            ret = -1;
+            break;
+        }
+#ifndef DANP_URING_SUPPORT
+        if (config->uring != NULL)
+        {
+            danp_log_message(DANP_LOG_ERROR, "DANP SERIAL: Built without io_uring support");
+            ret = -1;
+            break;
+        }
+#endif
+        if (serial_context_count >= DANP_SERIAL_MAX_INTERFACES)
+        {
+            danp_log_message(DANP_LOG_ERROR, "DANP SERIAL: No free interface context");
+            ret = -1;
+            break;
+        }
+
+        memset(iface, 0, sizeof(danp_serial_interface_t));
+        iface->fd = config->fd;
+        if (config->device != NULL)
+        {
+            iface->fd = open(config->device, O_RDWR | O_NOCTTY | O_CLOEXEC);
+            if (iface->fd < 0)
+            {
+                danp_log_message(DANP_LOG_ERROR, "DANP SERIAL: open(%s) failed, errno %d", config->device, errno);
+                ret = -1;
+                break;
+            }
+        }
+        if (danp_serial_configure(iface->fd, config->baud) != 0)
+        {
+            if (config->device != NULL)
+            {
+                close(iface->fd);
+            }
+            iface->fd = -1;
+            ret = -1;
+            break;
+        }
+        if (config->device != NULL)
+        {
+            // Bytes that arrived before anyone listened belong to no frame we can trust.
+            tcflush(iface->fd, TCIFLUSH);
+        }
+
+        iface->framing = config->framing;
+        iface->common.address = config->address;
+        iface->common.tx_func = danp_serial_tx;
+        iface->common.name = (config->name != NULL) ? config->name : "SERIAL";
+        iface->common.mtu = DANP_MAX_PACKET_SIZE;
+
+        ctx = &serial_contexts[serial_context_count];
+        memset(ctx, 0, sizeof(danp_serial_context_t));
+        ctx->iface = iface;
+        ctx->rx.crc = DANP_DRIVER_SERIAL_CRC_INIT;
+        if (config->baud != 0)
+        {
+            ctx->chunk_us = (uint32_t)((uint64_t)DANP_SERIAL_RX_CHUNK * DANP_DRIVER_SERIAL_BITS_PER_BYTE * 1000000ULL / config->baud);
+        }
+        ctx->tx_lock = osalMutexCreate(&mutex_attr);
+        if (ctx->tx_lock == NULL)
+        {
+            /* LCOV_EXCL_START */
+            danp_log_message(DANP_LOG_ERROR, "DANP SERIAL: Failed to create TX lock");
+            ret = -1;
+            break;
+            /* LCOV_EXCL_STOP */
+        }
+        iface->context = ctx;
+        serial_context_count++;
+
+#ifdef DANP_URING_SUPPORT
+        if (config->uring != NULL)
+        {
+            iface->uring = config->uring;
+            iface->uring_source = danp_uring_add_stream(config->uring, iface->fd, danp_serial_on_read, ctx);
+            if (iface->uring_source < 0)
+            {
+                iface->uring = NULL;
+                ret = -1;
+            }
+            break;
+        }
+#endif
+
+        if (!osalThreadCreate(danp_serial_rx_routine, ctx, &thread_attr))
+        {
+            /* LCOV_EXCL_START */
+            danp_log_message(DANP_LOG_ERROR, "DANP SERIAL: Failed to create RX thread");
+            ret = -1;
+            break;
+            /* LCOV_EXCL_STOP */
+        }
+
+    } while (0);
+
+    return ret;
+}
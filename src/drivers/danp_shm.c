@@ -0,0 +1,406 @@
+/* danp_shm.c - DANP between processes on one host over shared-memory rings */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* syscall */
+#endif
+
+#include "osal/osal.h"
+#include "danp/danp.h"
+#include "../danp_debug.h"
+#include "danp/drivers/danp_shm.h"
+#include "danp_ring.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#define DANP_DRIVER_SHM_STACK_SIZE              (1024 * 4)
+#define DANP_DRIVER_SHM_TIMEOUT_MS              (5000)
+#define DANP_DRIVER_SHM_ATTACH_MS               (1000)
+#define DANP_DRIVER_SHM_FRAME_SIZE              (DANP_HEADER_SIZE + DANP_MAX_PACKET_SIZE)
+#define DANP_DRIVER_SHM_RING_MASK               (DANP_SHM_RING_DEPTH - 1U)
+#define DANP_DRIVER_SHM_CACHE_LINE              (64)
+#define DANP_DRIVER_SHM_MAGIC                   (0x44414E50U) /* "DANP" */
+
+#define DANP_DRIVER_SHM_STATE_EMPTY             (0U)
+#define DANP_DRIVER_SHM_STATE_FORMATTING        (1U)
+#define DANP_DRIVER_SHM_STATE_READY             (2U)
+
+#if (DANP_SHM_RING_DEPTH & DANP_DRIVER_SHM_RING_MASK) != 0
+#error "DANP_SHM_RING_DEPTH must be a power of two"
+#endif
+
+/* Types */
+
+/** @brief One frame slot in shared memory. */
+typedef struct danp_shm_frame_s
+{
+    uint16_t length;
+    uint8_t data[DANP_DRIVER_SHM_FRAME_SIZE];
+} danp_shm_frame_t;
+
+/**
+ * @brief One direction of a segment: written by one process, read by the other.
+ *
+ * The indices and the sleep flag sit on their own cache lines so the two
+ * processes do not bounce a line on every frame.
+ */
+typedef struct danp_shm_ring_s
+{
+    uint32_t tail; /**< Next slot the producer fills. */
+    uint8_t pad_tail[DANP_DRIVER_SHM_CACHE_LINE - sizeof(uint32_t)];
+    uint32_t head; /**< Next slot the consumer reads. */
+    uint8_t pad_head[DANP_DRIVER_SHM_CACHE_LINE - sizeof(uint32_t)];
+    uint32_t rx_sleeping; /**< Futex word: 1 while the consumer waits for frames. */
+    uint8_t pad_sleep[DANP_DRIVER_SHM_CACHE_LINE - sizeof(uint32_t)];
+    danp_shm_frame_t slots[DANP_SHM_RING_DEPTH];
+} danp_shm_ring_t;
+
+/** @brief Layout of the shared object; rings[0] carries frames from the lower address. */
+typedef struct danp_shm_segment_s
+{
+    uint32_t magic;
+    uint32_t state;
+    uint32_t depth;
+    uint32_t frame_size;
+    uint8_t pad[DANP_DRIVER_SHM_CACHE_LINE - 4 * sizeof(uint32_t)];
+    danp_shm_ring_t rings[2];
+} danp_shm_segment_t;
+
+/** @brief Process-local state of one interface. */
+typedef struct danp_shm_context_s
+{
+    danp_shm_interface_t *iface;
+    danp_shm_segment_t *segment;
+    danp_shm_ring_t *tx_ring;
+    danp_shm_ring_t *rx_ring;
+    osalMutexHandle_t tx_lock;
+} danp_shm_context_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static danp_shm_context_t shm_contexts[DANP_SHM_MAX_INTERFACES];
+static uint32_t shm_context_count = 0;
+
+/* Functions */
+
+static void danp_shm_futex_wait(uint32_t *word, uint32_t expected, uint32_t timeout_ms)
+{
+    struct timespec timeout = {
+        .tv_sec = timeout_ms / 1000U,
+        .tv_nsec = (long)(timeout_ms % 1000U) * 1000000L,
+    };
+
+    // Shared (not FUTEX_PRIVATE) so a wake from the other process reaches us.
+    syscall(SYS_futex, word, FUTEX_WAIT, expected, &timeout, NULL, 0);
+}
+
+static void danp_shm_futex_wake(uint32_t *word)
+{
+    syscall(SYS_futex, word, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+static int32_t danp_shm_tx(void *iface_common, danp_packet_t *packet)
+{
+    danp_shm_interface_t *iface = (danp_shm_interface_t *)iface_common;
+    danp_shm_context_t *ctx = (danp_shm_context_t *)iface->context;
+    danp_shm_ring_t *ring = ctx->tx_ring;
+    danp_shm_frame_t *frame = NULL;
+    uint32_t tail = 0;
+
+    danp_log_message(
+        DANP_LOG_VERBOSE,
+        "SHM TX: dst=%u port=%u flags=0x%02X len=%u",
+        (packet->header_raw >> 22) & 0xFF,
+        (packet->header_raw >> 8) & 0x3F,
+        packet->header_raw & 0x03,
+        packet->length);
+
+    // The ring has one producer per process; this lock makes the threads of this process that one.
+    osalMutexLock(ctx->tx_lock, OSAL_WAIT_FOREVER);
+    tail = ring->tail;
+    if (danp_ring_full(&ring->head, tail, DANP_SHM_RING_DEPTH))
+    {
+        // The peer is slow or gone; drop rather than stall the stack.
+        osalMutexUnlock(ctx->tx_lock);
+        __atomic_fetch_add(&iface->stats.tx_drops, 1U, __ATOMIC_RELAXED);
+        return -1;
+    }
+    frame = &ring->slots[tail & DANP_DRIVER_SHM_RING_MASK];
+    memcpy(frame->data, &packet->header_raw, DANP_HEADER_SIZE);
+    memcpy(frame->data + DANP_HEADER_SIZE, packet->payload, packet->length);
+    frame->length = (uint16_t)(DANP_HEADER_SIZE + packet->length);
+    danp_ring_publish(&ring->tail, tail + 1U);
+    osalMutexUnlock(ctx->tx_lock);
+    __atomic_fetch_add(&iface->stats.tx_packets, 1U, __ATOMIC_RELAXED);
+
+    if (danp_ring_wake_needed(&ring->rx_sleeping))
+    {
+        danp_shm_futex_wake(&ring->rx_sleeping);
+        __atomic_fetch_add(&iface->stats.tx_wakeups, 1U, __ATOMIC_RELAXED);
+    }
+
+    return 0;
+}
+
+static void danp_shm_rx_routine(void *arg)
+{
+    danp_shm_context_t *ctx = (danp_shm_context_t *)arg;
+    danp_shm_interface_t *iface = ctx->iface;
+    danp_shm_ring_t *ring = ctx->rx_ring;
+
+    for (;;)
+    {
+        uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+
+        if (head == __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE))
+        {
+            if (danp_ring_sleep_begin(&ring->rx_sleeping, &ring->tail, head))
+            {
+                __atomic_fetch_add(&iface->stats.rx_wakeups, 1U, __ATOMIC_RELAXED);
+                danp_shm_futex_wait(&ring->rx_sleeping, 1U, DANP_DRIVER_SHM_TIMEOUT_MS);
+            }
+            danp_ring_sleep_end(&ring->rx_sleeping);
+            continue;
+        }
+
+        const danp_shm_frame_t *frame = &ring->slots[head & DANP_DRIVER_SHM_RING_MASK];
+        uint16_t length = frame->length;
+        danp_packet_t *pkt = NULL;
+
+        // The other process writes this memory, so nothing in it is trusted.
+        if (length >= DANP_HEADER_SIZE && length <= DANP_DRIVER_SHM_FRAME_SIZE)
+        {
+            pkt = danp_buffer_allocate();
+        }
+        if (pkt != NULL)
+        {
+            memcpy(&pkt->header_raw, frame->data, DANP_HEADER_SIZE);
+            pkt->length = (uint16_t)(length - DANP_HEADER_SIZE);
+            memcpy(pkt->payload, frame->data + DANP_HEADER_SIZE, pkt->length);
+        }
+        // Give the slot back before the stack works on the packet.
+        __atomic_store_n(&ring->head, head + 1U, __ATOMIC_RELEASE);
+
+        if (pkt == NULL)
+        {
+            __atomic_fetch_add(&iface->stats.rx_drops, 1U, __ATOMIC_RELAXED);
+            continue;
+        }
+        __atomic_fetch_add(&iface->stats.rx_packets, 1U, __ATOMIC_RELAXED);
+
+        danp_log_message(
+            DANP_LOG_VERBOSE,
+            "SHM RX: dst=%u port=%u flags=0x%02X len=%u",
+            (pkt->header_raw >> 22) & 0xFF,
+            (pkt->header_raw >> 8) & 0x3F,
+            pkt->header_raw & 0x03,
+            pkt->length);
+
+        danp_input_packet(&iface->common, pkt);
+    }
+}
+
+/**
+ * @brief Open, size and map a segment, formatting it if this process is first.
+ * @param name Shared-memory object name.
+ * @return Mapped segment, or NULL on error.
+ */
+static danp_shm_segment_t *danp_shm_attach(const char *name)
+{
+    danp_shm_segment_t *segment = NULL;
+    uint32_t expected = DANP_DRIVER_SHM_STATE_EMPTY;
+    int fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+
+    if (fd < 0)
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP SHM: shm_open(%s) failed, errno %d", name, errno);
+        return NULL;
+    }
+
+    // Both processes size the object the same way; growing it zero-fills, so the state reads EMPTY.
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        ((size_t)st.st_size < sizeof(danp_shm_segment_t) && ftruncate(fd, sizeof(danp_shm_segment_t)) != 0))
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP SHM: Sizing %s failed, errno %d", name, errno);
+        close(fd);
+        return NULL;
+    }
+    if ((size_t)st.st_size > sizeof(danp_shm_segment_t))
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP SHM: %s has a different geometry", name);
+        close(fd);
+        return NULL;
+    }
+
+    segment = (danp_shm_segment_t *)mmap(NULL, sizeof(danp_shm_segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (segment == MAP_FAILED)
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP SHM: mmap(%s) failed, errno %d", name, errno);
+        return NULL;
+    }
+
+    if (__atomic_compare_exchange_n(
+            &segment->state, &expected, DANP_DRIVER_SHM_STATE_FORMATTING, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+        segment->magic = DANP_DRIVER_SHM_MAGIC;
+        segment->depth = DANP_SHM_RING_DEPTH;
+        segment->frame_size = DANP_DRIVER_SHM_FRAME_SIZE;
+        __atomic_store_n(&segment->state, DANP_DRIVER_SHM_STATE_READY, __ATOMIC_RELEASE);
+    }
+    else
+    {
+        // The other process is formatting it; wait until it is done.
+        for (uint32_t waited = 0;
+             __atomic_load_n(&segment->state, __ATOMIC_ACQUIRE) != DANP_DRIVER_SHM_STATE_READY;
+             waited++)
+        {
+            if (waited >= DANP_DRIVER_SHM_ATTACH_MS)
+            {
+                danp_log_message(DANP_LOG_ERROR, "DANP SHM: %s was never formatted", name);
+                munmap(segment, sizeof(danp_shm_segment_t));
+                return NULL;
+            }
+            osalDelayMs(1);
+        }
+    }
+
+    if (segment->magic != DANP_DRIVER_SHM_MAGIC ||
+        segment->depth != DANP_SHM_RING_DEPTH ||
+        segment->frame_size != DANP_DRIVER_SHM_FRAME_SIZE)
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP SHM: %s has a different geometry", name);
+        munmap(segment, sizeof(danp_shm_segment_t));
+        return NULL;
+    }
+
+    return segment;
+}
+
+int32_t danp_shm_init(danp_shm_interface_t *iface, const danp_shm_config_t *config)
+{
+    int32_t ret = 0;
+    danp_shm_context_t *ctx = NULL;
+    danp_shm_segment_t *segment = NULL;
+    osalThreadAttr_t thread_attr =
+    {
+        .name = "danpShmRx",
+        .stackSize = DANP_DRIVER_SHM_STACK_SIZE,
+        .stackMem = NULL,
+        .priority = OSAL_THREAD_PRIORITY_NORMAL,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+    osalMutexAttr_t mutex_attr =
+    {
+        .name = "danpShmTx",
+        .attrBits = OSAL_MUTEX_PRIO_INHERIT,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+
+    do
+    {
+        if (iface == NULL || config == NULL || config->address == config->peer)
+        {
+            ret = -1;
+            break;
+        }
+        if (shm_context_count >= DANP_SHM_MAX_INTERFACES)
+        {
+            danp_log_message(DANP_LOG_ERROR, "DANP SHM: No free interface context");
+            ret = -1;
+            break;
+        }
+
+        memset(iface, 0, sizeof(danp_shm_interface_t));
+        if (config->segment != NULL)
+        {
+            if (strlen(config->segment) >= sizeof(iface->segment))
+            {
+                ret = -1;
+                break;
+            }
+            strcpy(iface->segment, config->segment);
+        }
+        else
+        {
+            uint16_t low = (config->address < config->peer) ? config->address : config->peer;
+            uint16_t high = (config->address < config->peer) ? config->peer : config->address;
+            snprintf(iface->segment, sizeof(iface->segment), "/danp-%u-%u", low, high);
+        }
+        iface->peer = config->peer;
+        iface->common.address = config->address;
+        iface->common.tx_func = danp_shm_tx;
+        iface->common.name = (config->name != NULL) ? config->name : "SHM";
+        iface->common.mtu = DANP_MAX_PACKET_SIZE;
+
+        segment = danp_shm_attach(iface->segment);
+        if (segment == NULL)
+        {
+            ret = -1;
+            break;
+        }
+
+        ctx = &shm_contexts[shm_context_count];
+        memset(ctx, 0, sizeof(danp_shm_context_t));
+        ctx->iface = iface;
+        ctx->segment = segment;
+        ctx->tx_ring = &segment->rings[(config->address < config->peer) ? 0 : 1];
+        ctx->rx_ring = &segment->rings[(config->address < config->peer) ? 1 : 0];
+        ctx->tx_lock = osalMutexCreate(&mutex_attr);
+        if (ctx->tx_lock == NULL)
+        {
+            /* LCOV_EXCL_START */
+            danp_log_message(DANP_LOG_ERROR, "DANP SHM: Failed to create TX lock");
+            munmap(segment, sizeof(danp_shm_segment_t));
+            ret = -1;
+            break;
+            /* LCOV_EXCL_STOP */
+        }
+        iface->context = ctx;
+        shm_context_count++;
+
+        if (!osalThreadCreate(danp_shm_rx_routine, ctx, &thread_attr))
+        {
+            /* LCOV_EXCL_START */
+            danp_log_message(DANP_LOG_ERROR, "DANP SHM: Failed to create RX thread");
+            ret = -1;
+            break;
+            /* LCOV_EXCL_STOP */
+        }
+
+    } while (0);
+
+    return ret;
+}
+
+int32_t danp_shm_unlink(const char *segment)
+{
+    if (segment == NULL || shm_unlink(segment) != 0)
+    {
+        return -1;
+    }
+    return 0;
+}
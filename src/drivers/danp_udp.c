@@ -0,0 +1,638 @@
+/* danp_udp.c - DANP over UDP/IPv4 with batched send and receive */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* sendmmsg, recvmmsg */
+#endif
+
+#include "osal/osal.h"
+#include "danp/danp.h"
+#include "../danp_debug.h"
+#include "danp/drivers/danp_udp.h"
+#include "danp_ring.h"
+#ifdef DANP_URING_SUPPORT
+#include "danp/drivers/danp_uring.h"
+#endif
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#define DANP_DRIVER_UDP_STACK_SIZE              (1024 * 8)
+#define DANP_DRIVER_UDP_TIMEOUT_MS              (5000)
+#define DANP_DRIVER_UDP_FRAME_SIZE              (DANP_HEADER_SIZE + DANP_MAX_PACKET_SIZE)
+#define DANP_DRIVER_UDP_RING_MASK               (DANP_UDP_TX_RING_DEPTH - 1U)
+
+#if (DANP_UDP_TX_RING_DEPTH & DANP_DRIVER_UDP_RING_MASK) != 0
+#error "DANP_UDP_TX_RING_DEPTH must be a power of two"
+#endif
+
+// The io_uring path sends straight from header_raw.
+__extension__ _Static_assert(
+    offsetof(danp_packet_t, payload) == DANP_HEADER_SIZE,
+    "danp_packet_t payload must directly follow header_raw");
+
+/* Types */
+
+/** @brief A packet serialised for the wire, with the endpoint it goes to. */
+typedef struct danp_udp_frame_s
+{
+    struct sockaddr_in to;
+    uint16_t length;
+    uint8_t data[DANP_DRIVER_UDP_FRAME_SIZE];
+} danp_udp_frame_t;
+
+/** @brief One receive thread and the recvmmsg() vectors it fills. */
+typedef struct danp_udp_rx_lane_s
+{
+    danp_udp_interface_t *iface;
+    int32_t fd;
+    bool drop_own; /**< Drop datagrams sent by this interface, which multicast loops back. */
+    struct mmsghdr msgs[DANP_UDP_BATCH];
+    struct iovec iov[DANP_UDP_BATCH];
+    uint8_t buffers[DANP_UDP_BATCH][DANP_DRIVER_UDP_FRAME_SIZE];
+} danp_udp_rx_lane_t;
+
+/**
+ * @brief Driver state of one UDP interface.
+ *
+ * Transmitters append frames to the ring under tx_lock; the transmit thread is
+ * the only consumer and sends everything queued with one sendmmsg() call, so the
+ * batch grows with the load. tx_waiting is the wake word of the ring (see danp_ring.h).
+ */
+typedef struct danp_udp_context_s
+{
+    danp_udp_interface_t *iface;
+    danp_udp_frame_t ring[DANP_UDP_TX_RING_DEPTH];
+    uint32_t head;
+    uint32_t tail;
+    uint32_t tx_waiting;
+    osalMutexHandle_t tx_lock;
+    osalSemaphoreHandle_t tx_signal;
+    struct mmsghdr tx_msgs[DANP_UDP_BATCH];
+    struct iovec tx_iov[DANP_UDP_BATCH];
+    danp_udp_rx_lane_t lanes[DANP_UDP_MAX_RX_THREADS];
+    danp_udp_rx_lane_t group_lane;
+} danp_udp_context_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static danp_udp_context_t udp_contexts[DANP_UDP_MAX_INTERFACES];
+static uint32_t udp_context_count = 0;
+
+/* Functions */
+
+static const danp_udp_peer_t *danp_udp_find_peer(const danp_udp_interface_t *iface, uint16_t node)
+{
+    uint32_t count = __atomic_load_n(&iface->peer_count, __ATOMIC_ACQUIRE);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (iface->peers[i].node == node)
+        {
+            return &iface->peers[i];
+        }
+    }
+    return NULL;
+}
+
+static int32_t danp_udp_tx(void *iface_common, danp_packet_t *packet)
+{
+    danp_udp_interface_t *iface = (danp_udp_interface_t *)iface_common;
+    danp_udp_context_t *ctx = (danp_udp_context_t *)iface->context;
+    uint16_t dst = (packet->header_raw >> 22) & 0xFF;
+    const danp_udp_peer_t *peer = danp_udp_find_peer(iface, dst);
+    danp_udp_peer_t group = { .node = dst, .udp_port = iface->mcast_port, .ipv4 = iface->mcast_net | dst };
+    danp_udp_frame_t *frame = NULL;
+    uint32_t tail = 0;
+
+    danp_log_message(
+        DANP_LOG_VERBOSE,
+        "UDP TX: dst=%u port=%u flags=0x%02X len=%u",
+        dst,
+        (packet->header_raw >> 8) & 0x3F,
+        packet->header_raw & 0x03,
+        packet->length);
+
+    if (peer == NULL && iface->mcast_fd >= 0 && DANP_NODE_IS_GROUP(dst))
+    {
+        peer = &group;
+    }
+    if (peer == NULL)
+    {
+        danp_log_message(DANP_LOG_WARN, "DANP UDP: No endpoint for node %u", dst);
+        __atomic_fetch_add(&iface->stats.tx_drops, 1U, __ATOMIC_RELAXED);
+        return -1;
+    }
+
+#ifdef DANP_URING_SUPPORT
+    if (iface->uring != NULL)
+    {
+        struct sockaddr_in to;
+
+        memset(&to, 0, sizeof(to));
+        to.sin_family = AF_INET;
+        to.sin_port = htons(peer->udp_port);
+        to.sin_addr.s_addr = htonl(peer->ipv4);
+        // header_raw and payload are contiguous, so the packet already is the wire frame.
+        if (danp_uring_send(
+                iface->uring,
+                iface->uring_source,
+                &packet->header_raw,
+                DANP_HEADER_SIZE + packet->length,
+                &to,
+                sizeof(to)) != 0)
+        {
+            __atomic_fetch_add(&iface->stats.tx_drops, 1U, __ATOMIC_RELAXED);
+            return -1;
+        }
+        __atomic_fetch_add(&iface->stats.tx_packets, 1U, __ATOMIC_RELAXED);
+        return 0;
+    }
+#endif
+
+    osalMutexLock(ctx->tx_lock, OSAL_WAIT_FOREVER);
+    tail = ctx->tail;
+    if (danp_ring_full(&ctx->head, tail, DANP_UDP_TX_RING_DEPTH))
+    {
+        osalMutexUnlock(ctx->tx_lock);
+        __atomic_fetch_add(&iface->stats.tx_drops, 1U, __ATOMIC_RELAXED);
+        return -1;
+    }
+    frame = &ctx->ring[tail & DANP_DRIVER_UDP_RING_MASK];
+    memset(&frame->to, 0, sizeof(frame->to));
+    frame->to.sin_family = AF_INET;
+    frame->to.sin_port = htons(peer->udp_port);
+    frame->to.sin_addr.s_addr = htonl(peer->ipv4);
+    memcpy(frame->data, &packet->header_raw, DANP_HEADER_SIZE);
+    memcpy(frame->data + DANP_HEADER_SIZE, packet->payload, packet->length);
+    frame->length = (uint16_t)(DANP_HEADER_SIZE + packet->length);
+    danp_ring_publish(&ctx->tail, tail + 1U);
+    osalMutexUnlock(ctx->tx_lock);
+
+    if (danp_ring_wake_needed(&ctx->tx_waiting))
+    {
+        osalSemaphoreGive(ctx->tx_signal);
+    }
+
+    return 0;
+}
+
+static void danp_udp_tx_routine(void *arg)
+{
+    danp_udp_context_t *ctx = (danp_udp_context_t *)arg;
+    danp_udp_interface_t *iface = ctx->iface;
+
+    for (;;)
+    {
+        uint32_t head = ctx->head;
+        uint32_t count = __atomic_load_n(&ctx->tail, __ATOMIC_ACQUIRE) - head;
+
+        if (count == 0)
+        {
+            if (danp_ring_sleep_begin(&ctx->tx_waiting, &ctx->tail, head))
+            {
+                osalSemaphoreTake(ctx->tx_signal, DANP_DRIVER_UDP_TIMEOUT_MS);
+            }
+            danp_ring_sleep_end(&ctx->tx_waiting);
+            continue;
+        }
+
+        if (count > DANP_UDP_BATCH)
+        {
+            count = DANP_UDP_BATCH;
+        }
+        for (uint32_t i = 0; i < count; i++)
+        {
+            danp_udp_frame_t *frame = &ctx->ring[(head + i) & DANP_DRIVER_UDP_RING_MASK];
+
+            ctx->tx_iov[i].iov_base = frame->data;
+            ctx->tx_iov[i].iov_len = frame->length;
+            memset(&ctx->tx_msgs[i], 0, sizeof(ctx->tx_msgs[i]));
+            ctx->tx_msgs[i].msg_hdr.msg_name = &frame->to;
+            ctx->tx_msgs[i].msg_hdr.msg_namelen = sizeof(frame->to);
+            ctx->tx_msgs[i].msg_hdr.msg_iov = &ctx->tx_iov[i];
+            ctx->tx_msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        uint32_t done = 0;
+        while (done < count)
+        {
+            int sent = sendmmsg(iface->fds[0], &ctx->tx_msgs[done], count - done, 0);
+            if (sent < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                // The first unsent datagram failed (e.g. ICMP unreachable reported late); skip it.
+                danp_log_message(DANP_LOG_WARN, "DANP UDP: sendmmsg failed, errno %d", errno);
+                __atomic_fetch_add(&iface->stats.tx_drops, 1U, __ATOMIC_RELAXED);
+                done++;
+                continue;
+            }
+            done += (uint32_t)sent;
+            __atomic_fetch_add(&iface->stats.tx_packets, (uint32_t)sent, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&iface->stats.tx_batches, 1U, __ATOMIC_RELAXED);
+        }
+
+        // Slots are only handed back once the kernel has copied them.
+        __atomic_store_n(&ctx->head, head + count, __ATOMIC_RELEASE);
+    }
+}
+
+static void danp_udp_rx_routine(void *arg)
+{
+    danp_udp_rx_lane_t *lane = (danp_udp_rx_lane_t *)arg;
+    danp_udp_interface_t *iface = lane->iface;
+
+    for (uint32_t i = 0; i < DANP_UDP_BATCH; i++)
+    {
+        lane->iov[i].iov_base = lane->buffers[i];
+        lane->iov[i].iov_len = sizeof(lane->buffers[i]);
+    }
+
+    for (;;)
+    {
+        for (uint32_t i = 0; i < DANP_UDP_BATCH; i++)
+        {
+            memset(&lane->msgs[i].msg_hdr, 0, sizeof(lane->msgs[i].msg_hdr));
+            lane->msgs[i].msg_hdr.msg_iov = &lane->iov[i];
+            lane->msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        // Block for the first datagram, then take whatever else is already queued.
+        int received = recvmmsg(lane->fd, lane->msgs, DANP_UDP_BATCH, MSG_WAITFORONE, NULL);
+        if (received <= 0)
+        {
+            continue;
+        }
+        __atomic_fetch_add(&iface->stats.rx_packets, (uint32_t)received, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&iface->stats.rx_batches, 1U, __ATOMIC_RELAXED);
+
+        for (int i = 0; i < received; i++)
+        {
+            uint32_t len = lane->msgs[i].msg_len;
+
+            if ((lane->msgs[i].msg_hdr.msg_flags & MSG_TRUNC) || len < DANP_HEADER_SIZE)
+            {
+                danp_log_message(DANP_LOG_WARN, "DANP UDP: Dropping malformed datagram of %u bytes", len);
+                continue;
+            }
+            if (lane->drop_own)
+            {
+                uint32_t header = 0;
+
+                memcpy(&header, lane->buffers[i], DANP_HEADER_SIZE);
+                if (((header >> 14) & 0xFF) == iface->common.address)
+                {
+                    continue;
+                }
+            }
+            danp_input(&iface->common, lane->buffers[i], (uint16_t)len);
+        }
+    }
+}
+
+static void danp_udp_close_sockets(danp_udp_interface_t *iface)
+{
+    for (uint32_t i = 0; i < DANP_UDP_MAX_RX_THREADS; i++)
+    {
+        if (iface->fds[i] >= 0)
+        {
+            close(iface->fds[i]);
+            iface->fds[i] = -1;
+        }
+    }
+    if (iface->mcast_fd >= 0)
+    {
+        close(iface->mcast_fd);
+        iface->mcast_fd = -1;
+    }
+}
+
+/**
+ * @brief Join or leave the IPv4 multicast address of a DANP group.
+ */
+static int32_t danp_udp_membership(danp_udp_interface_t *iface, uint16_t group, bool join)
+{
+    struct ip_mreq mreq;
+
+    memset(&mreq, 0, sizeof(mreq));
+    mreq.imr_multiaddr.s_addr = htonl(iface->mcast_net | group);
+    mreq.imr_interface.s_addr = htonl(iface->mcast_if);
+    if (setsockopt(iface->mcast_fd, IPPROTO_IP, join ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP, &mreq, sizeof(mreq)) != 0)
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP UDP: Multicast membership of group %u failed, errno %d", group, errno);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int32_t danp_udp_group(void *iface_common, uint16_t group, bool join)
+{
+    return danp_udp_membership((danp_udp_interface_t *)iface_common, group, join);
+}
+
+/**
+ * @brief Open the socket that receives group packets and point multicast sends at the bound address.
+ */
+static int32_t danp_udp_open_multicast(danp_udp_interface_t *iface, const danp_udp_config_t *config, uint32_t local_ipv4)
+{
+    struct in_addr net;
+    struct in_addr out_if = { .s_addr = htonl(local_ipv4) };
+    struct sockaddr_in local;
+    int one = 1;
+    int zero = 0;
+
+    if (inet_pton(AF_INET, config->multicast_net, &net) != 1 || !IN_MULTICAST(ntohl(net.s_addr)) ||
+        config->multicast_port == 0)
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP UDP: Invalid multicast block %s", config->multicast_net);
+        return -1;
+    }
+    iface->mcast_net = ntohl(net.s_addr) & 0xFFFFFF00U;
+    iface->mcast_if = local_ipv4;
+    iface->mcast_port = config->multicast_port;
+
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port = htons(config->multicast_port);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    iface->mcast_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (iface->mcast_fd < 0)
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP UDP: socket() failed, errno %d", errno);
+        return -1;
+    }
+    // Every node on the host listens on the same port; only joined groups may reach this one.
+    if (setsockopt(iface->mcast_fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0 ||
+        setsockopt(iface->mcast_fd, IPPROTO_IP, IP_MULTICAST_ALL, &zero, sizeof(zero)) != 0 ||
+        bind(iface->mcast_fd, (struct sockaddr *)&local, sizeof(local)) != 0)
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP UDP: Multicast socket setup failed, errno %d", errno);
+        return -1;
+    }
+    if (setsockopt(iface->fds[0], IPPROTO_IP, IP_MULTICAST_IF, &out_if, sizeof(out_if)) != 0)
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP UDP: IP_MULTICAST_IF failed, errno %d", errno);
+        return -1;
+    }
+
+    return danp_udp_membership(iface, DANP_BROADCAST_NODE, true);
+}
+
+static int32_t danp_udp_open_sockets(danp_udp_interface_t *iface, const danp_udp_config_t *config)
+{
+    struct sockaddr_in local;
+    socklen_t local_len = sizeof(local);
+    int one = 1;
+
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port = htons(config->bind_port);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (config->bind_host != NULL && inet_pton(AF_INET, config->bind_host, &local.sin_addr) != 1)
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP UDP: Invalid bind address %s", config->bind_host);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < iface->rx_threads; i++)
+    {
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd < 0)
+        {
+            danp_log_message(DANP_LOG_ERROR, "DANP UDP: socket() failed, errno %d", errno);
+            return -1;
+        }
+        iface->fds[i] = fd;
+
+        // Every socket joins the same port so the kernel spreads flows across the receive threads.
+        if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0)
+        {
+            danp_log_message(DANP_LOG_ERROR, "DANP UDP: SO_REUSEPORT failed, errno %d", errno);
+            return -1;
+        }
+        if (bind(fd, (struct sockaddr *)&local, sizeof(local)) != 0)
+        {
+            danp_log_message(DANP_LOG_ERROR, "DANP UDP: bind() failed, errno %d", errno);
+            return -1;
+        }
+        if (i == 0)
+        {
+            // With port 0 the kernel picked one; the other sockets must share it.
+            if (getsockname(fd, (struct sockaddr *)&local, &local_len) != 0)
+            {
+                /* LCOV_EXCL_START */
+                return -1;
+                /* LCOV_EXCL_STOP */
+            }
+            iface->bound_port = ntohs(local.sin_port);
+        }
+    }
+
+    if (config->multicast_net != NULL)
+    {
+        return danp_udp_open_multicast(iface, config, ntohl(local.sin_addr.s_addr));
+    }
+
+    return 0;
+}
+
+int32_t danp_udp_init(danp_udp_interface_t *iface, const danp_udp_config_t *config)
+{
+    int32_t ret = 0;
+    danp_udp_context_t *ctx = NULL;
+    osalThreadAttr_t thread_attr =
+    {
+        .name = "danpUdpRx",
+        .stackSize = DANP_DRIVER_UDP_STACK_SIZE,
+        .stackMem = NULL,
+        .priority = OSAL_THREAD_PRIORITY_NORMAL,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+    osalMutexAttr_t mutex_attr =
+    {
+        .name = "danpUdpTx",
+        .attrBits = OSAL_MUTEX_PRIO_INHERIT,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+    osalSemaphoreAttr_t sem_attr = { .name = "danpUdpTxSig", .maxCount = 1 };
+
+    do
+    {
+        if (iface == NULL || config == NULL || config->rx_threads > DANP_UDP_MAX_RX_THREADS)
+        {
+            ret = -1;
+            break;
+        }
+#ifndef DANP_URING_SUPPORT
+        if (config->uring != NULL)
+        {
+            danp_log_message(DANP_LOG_ERROR, "DANP UDP: Built without io_uring support");
+            ret = -1;
+            break;
+        }
+#endif
+        if (config->uring != NULL && (config->rx_threads > 1 || config->multicast_net != NULL))
+        {
+            danp_log_message(DANP_LOG_ERROR, "DANP UDP: An io_uring loop services a single socket");
+            ret = -1;
+            break;
+        }
+        if (config->uring == NULL && udp_context_count >= DANP_UDP_MAX_INTERFACES)
+        {
+            danp_log_message(DANP_LOG_ERROR, "DANP UDP: No free interface context");
+            ret = -1;
+            break;
+        }
+
+        memset(iface, 0, sizeof(danp_udp_interface_t));
+        for (uint32_t i = 0; i < DANP_UDP_MAX_RX_THREADS; i++)
+        {
+            iface->fds[i] = -1;
+        }
+        iface->mcast_fd = -1;
+        iface->rx_threads = (config->rx_threads == 0) ? 1U : config->rx_threads;
+        iface->common.address = config->address;
+        iface->common.tx_func = danp_udp_tx;
+        iface->common.name = (config->name != NULL) ? config->name : "UDP";
+        iface->common.mtu = DANP_MAX_PACKET_SIZE;
+
+        if (danp_udp_open_sockets(iface, config) != 0)
+        {
+            danp_udp_close_sockets(iface);
+            ret = -1;
+            break;
+        }
+
+#ifdef DANP_URING_SUPPORT
+        if (config->uring != NULL)
+        {
+            iface->uring = config->uring;
+            iface->uring_source = danp_uring_add_datagram(config->uring, &iface->common, iface->fds[0]);
+            if (iface->uring_source < 0)
+            {
+                danp_udp_close_sockets(iface);
+                iface->uring = NULL;
+                ret = -1;
+            }
+            break;
+        }
+#endif
+
+        ctx = &udp_contexts[udp_context_count];
+        memset(ctx, 0, sizeof(danp_udp_context_t));
+        ctx->iface = iface;
+        ctx->tx_lock = osalMutexCreate(&mutex_attr);
+        ctx->tx_signal = osalSemaphoreCreate(&sem_attr);
+        if (ctx->tx_lock == NULL || ctx->tx_signal == NULL)
+        {
+            /* LCOV_EXCL_START */
+            danp_log_message(DANP_LOG_ERROR, "DANP UDP: Failed to create ring primitives");
+            danp_udp_close_sockets(iface);
+            ret = -1;
+            break;
+            /* LCOV_EXCL_STOP */
+        }
+        iface->context = ctx;
+        udp_context_count++;
+
+        thread_attr.name = "danpUdpTx";
+        if (!osalThreadCreate(danp_udp_tx_routine, ctx, &thread_attr))
+        {
+            /* LCOV_EXCL_START */
+            danp_log_message(DANP_LOG_ERROR, "DANP UDP: Failed to create TX thread");
+            ret = -1;
+            break;
+            /* LCOV_EXCL_STOP */
+        }
+
+        thread_attr.name = "danpUdpRx";
+        for (uint32_t i = 0; i < iface->rx_threads; i++)
+        {
+            ctx->lanes[i].iface = iface;
+            ctx->lanes[i].fd = iface->fds[i];
+            if (!osalThreadCreate(danp_udp_rx_routine, &ctx->lanes[i], &thread_attr))
+            {
+                /* LCOV_EXCL_START */
+                danp_log_message(DANP_LOG_ERROR, "DANP UDP: Failed to create RX thread");
+                ret = -1;
+                break;
+                /* LCOV_EXCL_STOP */
+            }
+        }
+
+        if (iface->mcast_fd >= 0 && ret == 0)
+        {
+            ctx->group_lane.iface = iface;
+            ctx->group_lane.fd = iface->mcast_fd;
+            ctx->group_lane.drop_own = true;
+            if (!osalThreadCreate(danp_udp_rx_routine, &ctx->group_lane, &thread_attr))
+            {
+                /* LCOV_EXCL_START */
+                danp_log_message(DANP_LOG_ERROR, "DANP UDP: Failed to create multicast RX thread");
+                ret = -1;
+                break;
+                /* LCOV_EXCL_STOP */
+            }
+            iface->common.group_func = danp_udp_group;
+        }
+
+    } while (0);
+
+    return ret;
+}
+
+int32_t danp_udp_add_peer(danp_udp_interface_t *iface, uint16_t node, const char *host, uint16_t udp_port)
+{
+    struct in_addr addr;
+    danp_udp_peer_t *peer = NULL;
+
+    if (iface == NULL || host == NULL || inet_pton(AF_INET, host, &addr) != 1)
+    {
+        return -1;
+    }
+
+    peer = (danp_udp_peer_t *)danp_udp_find_peer(iface, node);
+    if (peer != NULL)
+    {
+        peer->udp_port = udp_port;
+        peer->ipv4 = ntohl(addr.s_addr);
+        return 0;
+    }
+    if (iface->peer_count >= DANP_UDP_MAX_PEERS)
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP UDP: Peer table full");
+        return -1;
+    }
+
+    peer = &iface->peers[iface->peer_count];
+    peer->node = node;
+    peer->udp_port = udp_port;
+    peer->ipv4 = ntohl(addr.s_addr);
+    // Publish the entry only once it is complete.
+    __atomic_store_n(&iface->peer_count, iface->peer_count + 1U, __ATOMIC_RELEASE);
+
+    return 0;
+}
@@ -0,0 +1,802 @@
+/* danp_uring.c - io_uring event loop that services the file descriptors of many DANP drivers */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* syscall */
+#endif
+
+#include "osal/osal.h"
+#include "danp/danp.h"
+#include "danp/danp_buffer.h"
+#include "../danp_debug.h"
+#include "danp/drivers/danp_uring.h"
+#include "danp_ring.h"
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#define DANP_DRIVER_URING_STACK_SIZE            (1024 * 16)
+#define DANP_DRIVER_URING_RING_MASK             (DANP_URING_TX_RING_DEPTH - 1U)
+#define DANP_DRIVER_URING_BUF_MASK              (DANP_URING_RX_BUFFERS - 1U)
+#define DANP_DRIVER_URING_BUF_GROUP             (0)
+#define DANP_DRIVER_URING_RETRY_NS              (10 * 1000 * 1000)
+
+/*
+ * A lent packet receives the frame at header_raw, which the payload directly
+ * follows. One byte more than the largest frame is offered so an oversized
+ * datagram shows up as such; that byte lands on the length field, which is
+ * written before the packet is used.
+ */
+#define DANP_DRIVER_URING_RX_LEN                (DANP_HEADER_SIZE + DANP_MAX_PACKET_SIZE + 1)
+
+/* user_data of a request: its kind in the upper half, the source or slot index in the lower one */
+#define DANP_DRIVER_URING_OP_WAKE               (1ULL)
+#define DANP_DRIVER_URING_OP_RECV               (2ULL)
+#define DANP_DRIVER_URING_OP_READ               (3ULL)
+#define DANP_DRIVER_URING_OP_SEND               (4ULL)
+#define DANP_DRIVER_URING_OP_RETRY              (5ULL)
+#define DANP_DRIVER_URING_USER_DATA(op, index)  (((op) << 32) | (uint64_t)(index))
+
+#if (DANP_URING_TX_RING_DEPTH & DANP_DRIVER_URING_RING_MASK) != 0
+#error "DANP_URING_TX_RING_DEPTH must be a power of two"
+#endif
+
+#if (DANP_URING_RX_BUFFERS & DANP_DRIVER_URING_BUF_MASK) != 0
+#error "DANP_URING_RX_BUFFERS must be a power of two"
+#endif
+
+#if (DANP_URING_RX_BUFFERS + DANP_URING_POOL_RESERVE) > DANP_POOL_SIZE
+#error "DANP_URING_RX_BUFFERS and DANP_URING_POOL_RESERVE exceed DANP_POOL_SIZE"
+#endif
+
+// Receives land on header_raw and sends start there, so the frame must be contiguous in the packet.
+__extension__ _Static_assert(
+    offsetof(danp_packet_t, payload) == DANP_HEADER_SIZE,
+    "danp_packet_t payload must directly follow header_raw");
+__extension__ _Static_assert(
+    offsetof(danp_packet_t, length) == offsetof(danp_packet_t, payload) + DANP_MAX_PACKET_SIZE,
+    "danp_packet_t length must directly follow payload");
+
+/* Types */
+
+/** @brief A file descriptor the loop services. */
+typedef struct danp_uring_source_s
+{
+    int32_t fd;
+    danp_interface_t *iface;       /**< Datagram source: where frames are delivered. */
+    danp_uring_read_cb_t on_read;  /**< Stream source: where bytes are delivered. */
+    void *arg;
+    bool armed;                    /**< A receive or read is outstanding. */
+    bool stopped;                  /**< Stream source hit end of file or an error. */
+    bool tx_busy;                  /**< Stream source has a write outstanding. */
+    uint8_t buffer[DANP_URING_READ_SIZE];
+} danp_uring_source_t;
+
+/** @brief A frame waiting to be sent, kept until the kernel completes the send. */
+typedef struct danp_uring_slot_s
+{
+    int32_t source;
+    bool busy;
+    uint32_t length;
+    struct sockaddr_storage addr;
+    uint32_t addr_len;
+    struct msghdr msg;
+    struct iovec iov;
+    uint8_t data[DANP_URING_FRAME_SIZE];
+} danp_uring_slot_t;
+
+/** @brief The mapped submission and completion rings. */
+typedef struct danp_uring_rings_s
+{
+    int32_t fd;
+    uint32_t *sq_head;
+    uint32_t *sq_tail;
+    uint32_t sq_mask;
+    uint32_t *sq_array;
+    struct io_uring_sqe *sqes;
+    uint32_t sq_local_tail;
+    uint32_t *cq_head;
+    uint32_t *cq_tail;
+    uint32_t cq_mask;
+    struct io_uring_cqe *cqes;
+    struct io_uring_buf_ring *buf_ring;
+    uint16_t buf_tail;
+} danp_uring_rings_t;
+
+/**
+ * @brief State of one loop.
+ *
+ * Only the loop thread touches the ring. Transmitters append frames to the slot
+ * ring under tx_lock; the loop turns slots between submitted and tail into
+ * requests and frees them from head once their sends complete. sleeping is the
+ * wake word of the slot ring (see danp_ring.h); the loop is woken through wake_fd.
+ */
+typedef struct danp_uring_context_s
+{
+    danp_uring_t *loop;
+    danp_uring_rings_t rings;
+    int32_t setup_status;
+    osalSemaphoreHandle_t ready;
+    int32_t wake_fd;
+    uint64_t wake_value;
+    bool wake_armed;
+    bool retry_armed;
+    struct __kernel_timespec retry_ts;
+    uint32_t sleeping;
+    danp_packet_t *lent[DANP_URING_RX_BUFFERS];
+    uint32_t lent_count;
+    danp_uring_source_t sources[DANP_URING_MAX_SOURCES];
+    uint32_t source_count;
+    osalMutexHandle_t tx_lock;
+    danp_uring_slot_t slots[DANP_URING_TX_RING_DEPTH];
+    uint32_t head;
+    uint32_t submitted;
+    uint32_t tail;
+} danp_uring_context_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static danp_uring_context_t uring_contexts[DANP_URING_MAX_LOOPS];
+static uint32_t uring_context_count = 0;
+
+/* Functions */
+
+static int danp_uring_enter(int32_t fd, uint32_t to_submit, uint32_t min_complete)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, IORING_ENTER_GETEVENTS, NULL, 0);
+}
+
+static struct io_uring_sqe *danp_uring_get_sqe(danp_uring_rings_t *rings)
+{
+    uint32_t head = __atomic_load_n(rings->sq_head, __ATOMIC_ACQUIRE);
+    struct io_uring_sqe *sqe = NULL;
+
+    if ((rings->sq_local_tail - head) > rings->sq_mask)
+    {
+        return NULL;
+    }
+    sqe = &rings->sqes[rings->sq_local_tail & rings->sq_mask];
+    rings->sq_array[rings->sq_local_tail & rings->sq_mask] = rings->sq_local_tail & rings->sq_mask;
+    rings->sq_local_tail++;
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+/**
+ * @brief Map the rings and lend the kernel its receive buffers; runs on the loop thread.
+ */
+static int32_t danp_uring_setup(danp_uring_context_t *ctx)
+{
+    danp_uring_rings_t *rings = &ctx->rings;
+    struct io_uring_params params;
+    struct io_uring_buf_reg buf_reg;
+    size_t ring_size = 0;
+    uint8_t *ring_mem = NULL;
+
+    // Only this thread submits, so the kernel may defer completion work until it asks for events.
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+    rings->fd = (int32_t)syscall(__NR_io_uring_setup, DANP_URING_QUEUE_DEPTH, &params);
+    if (rings->fd < 0 && errno == EINVAL)
+    {
+        memset(&params, 0, sizeof(params));
+        rings->fd = (int32_t)syscall(__NR_io_uring_setup, DANP_URING_QUEUE_DEPTH, &params);
+    }
+    if (rings->fd < 0)
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP URING: io_uring_setup failed, errno %d", errno);
+        return -1;
+    }
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0)
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP URING: Kernel too old");
+        return -1;
+    }
+
+    ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    if (params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe) > ring_size)
+    {
+        ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    }
+    ring_mem = mmap(NULL, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, rings->fd, IORING_OFF_SQ_RING);
+    rings->sqes = mmap(
+        NULL,
+        params.sq_entries * sizeof(struct io_uring_sqe),
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        rings->fd,
+        IORING_OFF_SQES);
+    if (ring_mem == MAP_FAILED || rings->sqes == MAP_FAILED)
+    {
+        /* LCOV_EXCL_START */
+        danp_log_message(DANP_LOG_ERROR, "DANP URING: Failed to map the rings, errno %d", errno);
+        return -1;
+        /* LCOV_EXCL_STOP */
+    }
+    rings->sq_head = (uint32_t *)(ring_mem + params.sq_off.head);
+    rings->sq_tail = (uint32_t *)(ring_mem + params.sq_off.tail);
+    rings->sq_mask = *(uint32_t *)(ring_mem + params.sq_off.ring_mask);
+    rings->sq_array = (uint32_t *)(ring_mem + params.sq_off.array);
+    rings->sq_local_tail = *rings->sq_tail;
+    rings->cq_head = (uint32_t *)(ring_mem + params.cq_off.head);
+    rings->cq_tail = (uint32_t *)(ring_mem + params.cq_off.tail);
+    rings->cq_mask = *(uint32_t *)(ring_mem + params.cq_off.ring_mask);
+    rings->cqes = (struct io_uring_cqe *)(ring_mem + params.cq_off.cqes);
+
+    // Receive buffers are pool packets, published through a ring the kernel reads.
+    rings->buf_ring = mmap(
+        NULL,
+        DANP_URING_RX_BUFFERS * sizeof(struct io_uring_buf),
+        PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS,
+        -1,
+        0);
+    if (rings->buf_ring == MAP_FAILED)
+    {
+        /* LCOV_EXCL_START */
+        return -1;
+        /* LCOV_EXCL_STOP */
+    }
+    memset(&buf_reg, 0, sizeof(buf_reg));
+    buf_reg.ring_addr = (uint64_t)(uintptr_t)rings->buf_ring;
+    buf_reg.ring_entries = DANP_URING_RX_BUFFERS;
+    buf_reg.bgid = DANP_DRIVER_URING_BUF_GROUP;
+    if (syscall(__NR_io_uring_register, rings->fd, IORING_REGISTER_PBUF_RING, &buf_reg, 1) != 0)
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP URING: Provided buffer rings unsupported, errno %d", errno);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Lend free pool packets to the kernel for the slots it has used up.
+ */
+static void danp_uring_replenish(danp_uring_context_t *ctx)
+{
+    danp_uring_rings_t *rings = &ctx->rings;
+    uint16_t tail = rings->buf_tail;
+
+    for (uint16_t bid = 0; bid < DANP_URING_RX_BUFFERS; bid++)
+    {
+        if (ctx->lent[bid] != NULL)
+        {
+            continue;
+        }
+        // Leave the stack enough packets to keep sending while the kernel holds ours.
+        if (danp_buffer_get_free_count() <= DANP_URING_POOL_RESERVE)
+        {
+            break;
+        }
+        danp_packet_t *pkt = danp_buffer_allocate();
+        if (pkt == NULL)
+        {
+            /* LCOV_EXCL_START */
+            break;
+            /* LCOV_EXCL_STOP */
+        }
+
+        struct io_uring_buf *buf = &rings->buf_ring->bufs[tail & DANP_DRIVER_URING_BUF_MASK];
+        buf->addr = (uint64_t)(uintptr_t)&pkt->header_raw;
+        buf->len = DANP_DRIVER_URING_RX_LEN;
+        buf->bid = bid;
+        ctx->lent[bid] = pkt;
+        ctx->lent_count++;
+        tail++;
+    }
+
+    if (tail != rings->buf_tail)
+    {
+        rings->buf_tail = tail;
+        __atomic_store_n(&rings->buf_ring->tail, tail, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * @brief Start receives and reads that are not running, and the wake-up read.
+ */
+static void danp_uring_arm(danp_uring_context_t *ctx)
+{
+    uint32_t count = __atomic_load_n(&ctx->source_count, __ATOMIC_ACQUIRE);
+    struct io_uring_sqe *sqe = NULL;
+
+    if (!ctx->wake_armed && (sqe = danp_uring_get_sqe(&ctx->rings)) != NULL)
+    {
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = ctx->wake_fd;
+        sqe->addr = (uint64_t)(uintptr_t)&ctx->wake_value;
+        sqe->len = sizeof(ctx->wake_value);
+        sqe->user_data = DANP_DRIVER_URING_USER_DATA(DANP_DRIVER_URING_OP_WAKE, 0);
+        ctx->wake_armed = true;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        danp_uring_source_t *src = &ctx->sources[i];
+
+        if (src->armed || src->stopped)
+        {
+            continue;
+        }
+        if (src->iface != NULL && ctx->lent_count == 0)
+        {
+            // The kernel has no buffer to receive into; come back once the stack freed some.
+            if (!ctx->retry_armed && (sqe = danp_uring_get_sqe(&ctx->rings)) != NULL)
+            {
+                ctx->retry_ts.tv_sec = 0;
+                ctx->retry_ts.tv_nsec = DANP_DRIVER_URING_RETRY_NS;
+                sqe->opcode = IORING_OP_TIMEOUT;
+                sqe->fd = -1;
+                sqe->addr = (uint64_t)(uintptr_t)&ctx->retry_ts;
+                sqe->len = 1;
+                sqe->user_data = DANP_DRIVER_URING_USER_DATA(DANP_DRIVER_URING_OP_RETRY, 0);
+                ctx->retry_armed = true;
+            }
+            continue;
+        }
+        if ((sqe = danp_uring_get_sqe(&ctx->rings)) == NULL)
+        {
+            /* LCOV_EXCL_START */
+            break;
+            /* LCOV_EXCL_STOP */
+        }
+
+        sqe->fd = src->fd;
+        if (src->iface != NULL)
+        {
+            // One request keeps producing a completion per datagram until the buffers run out.
+            sqe->opcode = IORING_OP_RECV;
+            sqe->ioprio = IORING_RECV_MULTISHOT;
+            sqe->flags = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = DANP_DRIVER_URING_BUF_GROUP;
+            sqe->user_data = DANP_DRIVER_URING_USER_DATA(DANP_DRIVER_URING_OP_RECV, i);
+        }
+        else
+        {
+            sqe->opcode = IORING_OP_READ;
+            sqe->addr = (uint64_t)(uintptr_t)src->buffer;
+            sqe->len = sizeof(src->buffer);
+            sqe->off = (uint64_t)-1;
+            sqe->user_data = DANP_DRIVER_URING_USER_DATA(DANP_DRIVER_URING_OP_READ, i);
+        }
+        src->armed = true;
+    }
+}
+
+/**
+ * @brief Turn queued frames into send requests, in order.
+ */
+static void danp_uring_queue_tx(danp_uring_context_t *ctx)
+{
+    uint32_t tail = __atomic_load_n(&ctx->tail, __ATOMIC_ACQUIRE);
+
+    while (ctx->submitted != tail)
+    {
+        danp_uring_slot_t *slot = &ctx->slots[ctx->submitted & DANP_DRIVER_URING_RING_MASK];
+        danp_uring_source_t *src = &ctx->sources[slot->source];
+        struct io_uring_sqe *sqe = NULL;
+
+        // A stream takes one write at a time so its bytes cannot be reordered.
+        if (src->iface == NULL && src->tx_busy)
+        {
+            break;
+        }
+        if ((sqe = danp_uring_get_sqe(&ctx->rings)) == NULL)
+        {
+            /* LCOV_EXCL_START */
+            break;
+            /* LCOV_EXCL_STOP */
+        }
+
+        sqe->fd = src->fd;
+        sqe->user_data = DANP_DRIVER_URING_USER_DATA(DANP_DRIVER_URING_OP_SEND, ctx->submitted & DANP_DRIVER_URING_RING_MASK);
+        if (src->iface != NULL)
+        {
+            memset(&slot->msg, 0, sizeof(slot->msg));
+            slot->iov.iov_base = slot->data;
+            slot->iov.iov_len = slot->length;
+            slot->msg.msg_name = (slot->addr_len > 0) ? &slot->addr : NULL;
+            slot->msg.msg_namelen = slot->addr_len;
+            slot->msg.msg_iov = &slot->iov;
+            slot->msg.msg_iovlen = 1;
+            sqe->opcode = IORING_OP_SENDMSG;
+            sqe->addr = (uint64_t)(uintptr_t)&slot->msg;
+            sqe->len = 1;
+        }
+        else
+        {
+            sqe->opcode = IORING_OP_WRITE;
+            sqe->addr = (uint64_t)(uintptr_t)slot->data;
+            sqe->len = slot->length;
+            sqe->off = (uint64_t)-1;
+            src->tx_busy = true;
+        }
+        slot->busy = true;
+        ctx->submitted++;
+    }
+}
+
+static void danp_uring_complete_recv(danp_uring_context_t *ctx, danp_uring_source_t *src, const struct io_uring_cqe *cqe)
+{
+    danp_uring_t *loop = ctx->loop;
+
+    if ((cqe->flags & IORING_CQE_F_MORE) == 0)
+    {
+        src->armed = false;
+        __atomic_fetch_add(&loop->stats.rx_rearms, 1U, __ATOMIC_RELAXED);
+    }
+    if ((cqe->flags & IORING_CQE_F_BUFFER) == 0)
+    {
+        if (cqe->res < 0 && cqe->res != -ENOBUFS)
+        {
+            danp_log_message(DANP_LOG_WARN, "DANP URING: Receive on fd %d failed, errno %d", src->fd, -cqe->res);
+        }
+        return;
+    }
+
+    uint16_t bid = (uint16_t)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+    danp_packet_t *pkt = ctx->lent[bid];
+    ctx->lent[bid] = NULL;
+    ctx->lent_count--;
+
+    if (cqe->res < DANP_HEADER_SIZE || cqe->res >= DANP_DRIVER_URING_RX_LEN)
+    {
+        danp_log_message(DANP_LOG_WARN, "DANP URING: Dropping malformed datagram of %d bytes", cqe->res);
+        __atomic_fetch_add(&loop->stats.rx_drops, 1U, __ATOMIC_RELAXED);
+        danp_buffer_free(pkt);
+        return;
+    }
+    pkt->length = (uint16_t)(cqe->res - DANP_HEADER_SIZE);
+    __atomic_fetch_add(&loop->stats.rx_packets, 1U, __ATOMIC_RELAXED);
+    danp_input_packet(src->iface, pkt);
+}
+
+static void danp_uring_complete_read(danp_uring_context_t *ctx, danp_uring_source_t *src, const struct io_uring_cqe *cqe)
+{
+    src->armed = false;
+    if (cqe->res <= 0)
+    {
+        if (cqe->res == -EINTR || cqe->res == -EAGAIN)
+        {
+            return;
+        }
+        danp_log_message(DANP_LOG_WARN, "DANP URING: Stream on fd %d stopped, result %d", src->fd, cqe->res);
+        src->stopped = true;
+        return;
+    }
+    __atomic_fetch_add(&ctx->loop->stats.rx_reads, 1U, __ATOMIC_RELAXED);
+    src->on_read(src->arg, src->buffer, (uint32_t)cqe->res);
+}
+
+static void danp_uring_complete_send(danp_uring_context_t *ctx, uint32_t index, const struct io_uring_cqe *cqe)
+{
+    danp_uring_slot_t *slot = &ctx->slots[index];
+    danp_uring_t *loop = ctx->loop;
+
+    if (cqe->res < 0 || (uint32_t)cqe->res != slot->length)
+    {
+        danp_log_message(DANP_LOG_WARN, "DANP URING: Send on fd %d failed, result %d", ctx->sources[slot->source].fd, cqe->res);
+        __atomic_fetch_add(&loop->stats.tx_drops, 1U, __ATOMIC_RELAXED);
+    }
+    else
+    {
+        __atomic_fetch_add(&loop->stats.tx_packets, 1U, __ATOMIC_RELAXED);
+    }
+    ctx->sources[slot->source].tx_busy = false;
+    slot->busy = false;
+
+    // Slots go back to transmitters in order, once every older send has completed too.
+    uint32_t head = ctx->head;
+    while (head != ctx->submitted && !ctx->slots[head & DANP_DRIVER_URING_RING_MASK].busy)
+    {
+        head++;
+    }
+    __atomic_store_n(&ctx->head, head, __ATOMIC_RELEASE);
+}
+
+static void danp_uring_reap(danp_uring_context_t *ctx)
+{
+    danp_uring_rings_t *rings = &ctx->rings;
+    uint32_t head = *rings->cq_head;
+    uint32_t tail = __atomic_load_n(rings->cq_tail, __ATOMIC_ACQUIRE);
+
+    while (head != tail)
+    {
+        const struct io_uring_cqe *cqe = &rings->cqes[head & rings->cq_mask];
+        uint32_t op = (uint32_t)(cqe->user_data >> 32);
+        uint32_t index = (uint32_t)(cqe->user_data & 0xFFFFFFFFU);
+
+        switch (op)
+        {
+        case DANP_DRIVER_URING_OP_WAKE:
+            ctx->wake_armed = false;
+            break;
+        case DANP_DRIVER_URING_OP_RETRY:
+            ctx->retry_armed = false;
+            break;
+        case DANP_DRIVER_URING_OP_RECV:
+            danp_uring_complete_recv(ctx, &ctx->sources[index], cqe);
+            break;
+        case DANP_DRIVER_URING_OP_READ:
+            danp_uring_complete_read(ctx, &ctx->sources[index], cqe);
+            break;
+        case DANP_DRIVER_URING_OP_SEND:
+            danp_uring_complete_send(ctx, index, cqe);
+            break;
+        default:
+            /* LCOV_EXCL_START */
+            break;
+            /* LCOV_EXCL_STOP */
+        }
+        head++;
+    }
+    __atomic_store_n(rings->cq_head, head, __ATOMIC_RELEASE);
+}
+
+static void danp_uring_routine(void *arg)
+{
+    danp_uring_context_t *ctx = (danp_uring_context_t *)arg;
+    danp_uring_rings_t *rings = &ctx->rings;
+    uint32_t submitted_sqes = 0;
+
+    ctx->setup_status = danp_uring_setup(ctx);
+    osalSemaphoreGive(ctx->ready);
+    if (ctx->setup_status != 0)
+    {
+        return;
+    }
+
+    for (;;)
+    {
+        danp_uring_replenish(ctx);
+        danp_uring_arm(ctx);
+        danp_uring_queue_tx(ctx);
+
+        uint32_t to_submit = rings->sq_local_tail - submitted_sqes;
+        __atomic_store_n(rings->sq_tail, rings->sq_local_tail, __ATOMIC_RELEASE);
+
+        // Wait for a completion only if no frame is left to turn into a request.
+        uint32_t min_complete = danp_ring_sleep_begin(&ctx->sleeping, &ctx->tail, ctx->submitted) ? 1U : 0U;
+
+        // One system call submits everything prepared above and waits for the next completion.
+        int ret = danp_uring_enter(rings->fd, to_submit, min_complete);
+        danp_ring_sleep_end(&ctx->sleeping);
+        __atomic_fetch_add(&ctx->loop->stats.enters, 1U, __ATOMIC_RELAXED);
+        if (ret >= 0)
+        {
+            submitted_sqes += (uint32_t)ret;
+        }
+        else if (errno != EINTR && errno != EBUSY && errno != EAGAIN)
+        {
+            /* LCOV_EXCL_START */
+            danp_log_message(DANP_LOG_ERROR, "DANP URING: io_uring_enter failed, errno %d", errno);
+            /* LCOV_EXCL_STOP */
+        }
+
+        danp_uring_reap(ctx);
+    }
+}
+
+static void danp_uring_wake(danp_uring_context_t *ctx)
+{
+    uint64_t one = 1;
+
+    if (danp_ring_wake_needed(&ctx->sleeping))
+    {
+        if (write(ctx->wake_fd, &one, sizeof(one)) != sizeof(one))
+        {
+            /* LCOV_EXCL_START */
+            danp_log_message(DANP_LOG_WARN, "DANP URING: Wake-up failed, errno %d", errno);
+            /* LCOV_EXCL_STOP */
+        }
+    }
+}
+
+static int32_t danp_uring_add_source(
+    danp_uring_t *loop,
+    int32_t fd,
+    danp_interface_t *iface,
+    danp_uring_read_cb_t on_read,
+    void *arg)
+{
+    danp_uring_context_t *ctx = NULL;
+    danp_uring_source_t *src = NULL;
+    int32_t index = -1;
+
+    if (loop == NULL || loop->context == NULL || fd < 0)
+    {
+        return -1;
+    }
+    ctx = (danp_uring_context_t *)loop->context;
+
+    osalMutexLock(ctx->tx_lock, OSAL_WAIT_FOREVER);
+    if (ctx->source_count < DANP_URING_MAX_SOURCES)
+    {
+        index = (int32_t)ctx->source_count;
+        src = &ctx->sources[index];
+        memset(src, 0, sizeof(*src));
+        src->fd = fd;
+        src->iface = iface;
+        src->on_read = on_read;
+        src->arg = arg;
+        // The loop walks the table without tx_lock, so count the entry only once it is filled in.
+        __atomic_store_n(&ctx->source_count, ctx->source_count + 1U, __ATOMIC_SEQ_CST);
+    }
+    osalMutexUnlock(ctx->tx_lock);
+
+    if (index < 0)
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP URING: Source table full");
+        return -1;
+    }
+    danp_uring_wake(ctx);
+
+    return index;
+}
+
+int32_t danp_uring_add_datagram(danp_uring_t *loop, danp_interface_t *iface, int32_t fd)
+{
+    if (iface == NULL)
+    {
+        return -1;
+    }
+    return danp_uring_add_source(loop, fd, iface, NULL, NULL);
+}
+
+int32_t danp_uring_add_stream(danp_uring_t *loop, int32_t fd, danp_uring_read_cb_t on_read, void *arg)
+{
+    if (on_read == NULL)
+    {
+        return -1;
+    }
+    return danp_uring_add_source(loop, fd, NULL, on_read, arg);
+}
+
+int32_t danp_uring_send(
+    danp_uring_t *loop,
+    int32_t source,
+    const void *data,
+    uint32_t length,
+    const void *addr,
+    uint32_t addr_len)
+{
+    danp_uring_context_t *ctx = NULL;
+    danp_uring_slot_t *slot = NULL;
+    uint32_t tail = 0;
+
+    if (loop == NULL || loop->context == NULL || data == NULL || length > DANP_URING_FRAME_SIZE ||
+        addr_len > sizeof(struct sockaddr_storage))
+    {
+        return -1;
+    }
+    ctx = (danp_uring_context_t *)loop->context;
+    if (source < 0 || (uint32_t)source >= __atomic_load_n(&ctx->source_count, __ATOMIC_ACQUIRE))
+    {
+        return -1;
+    }
+
+    osalMutexLock(ctx->tx_lock, OSAL_WAIT_FOREVER);
+    tail = ctx->tail;
+    if (danp_ring_full(&ctx->head, tail, DANP_URING_TX_RING_DEPTH))
+    {
+        osalMutexUnlock(ctx->tx_lock);
+        __atomic_fetch_add(&loop->stats.tx_drops, 1U, __ATOMIC_RELAXED);
+        return -1;
+    }
+    slot = &ctx->slots[tail & DANP_DRIVER_URING_RING_MASK];
+    slot->source = source;
+    slot->length = length;
+    slot->addr_len = (addr != NULL) ? addr_len : 0U;
+    if (slot->addr_len > 0)
+    {
+        memcpy(&slot->addr, addr, slot->addr_len);
+    }
+    memcpy(slot->data, data, length);
+    danp_ring_publish(&ctx->tail, tail + 1U);
+    osalMutexUnlock(ctx->tx_lock);
+
+    danp_uring_wake(ctx);
+
+    return 0;
+}
+
+int32_t danp_uring_init(danp_uring_t *loop)
+{
+    int32_t ret = 0;
+    danp_uring_context_t *ctx = NULL;
+    osalThreadAttr_t thread_attr =
+    {
+        .name = "danpUring",
+        .stackSize = DANP_DRIVER_URING_STACK_SIZE,
+        .stackMem = NULL,
+        .priority = OSAL_THREAD_PRIORITY_NORMAL,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+    osalMutexAttr_t mutex_attr =
+    {
+        .name = "danpUringTx",
+        .attrBits = OSAL_MUTEX_PRIO_INHERIT,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+    osalSemaphoreAttr_t sem_attr = { .name = "danpUringReady", .maxCount = 1 };
+
+    do
+    {
+        if (loop == NULL)
+        {
+            ret = -1;
+            break;
+        }
+        if (uring_context_count >= DANP_URING_MAX_LOOPS)
+        {
+            danp_log_message(DANP_LOG_ERROR, "DANP URING: No free loop context");
+            ret = -1;
+            break;
+        }
+
+        memset(loop, 0, sizeof(danp_uring_t));
+        ctx = &uring_contexts[uring_context_count];
+        memset(ctx, 0, sizeof(danp_uring_context_t));
+        ctx->loop = loop;
+        ctx->rings.fd = -1;
+        ctx->wake_fd = eventfd(0, EFD_CLOEXEC);
+        ctx->tx_lock = osalMutexCreate(&mutex_attr);
+        ctx->ready = osalSemaphoreCreate(&sem_attr);
+        if (ctx->wake_fd < 0 || ctx->tx_lock == NULL || ctx->ready == NULL)
+        {
+            /* LCOV_EXCL_START */
+            danp_log_message(DANP_LOG_ERROR, "DANP URING: Failed to create loop primitives");
+            ret = -1;
+            break;
+            /* LCOV_EXCL_STOP */
+        }
+
+        // The ring belongs to the thread that submits to it, so that thread sets it up.
+        if (!osalThreadCreate(danp_uring_routine, ctx, &thread_attr))
+        {
+            /* LCOV_EXCL_START */
+            danp_log_message(DANP_LOG_ERROR, "DANP URING: Failed to create loop thread");
+            ret = -1;
+            break;
+            /* LCOV_EXCL_STOP */
+        }
+        osalSemaphoreTake(ctx->ready, OSAL_WAIT_FOREVER);
+        if (ctx->setup_status != 0)
+        {
+            if (ctx->rings.fd >= 0)
+            {
+                close(ctx->rings.fd);
+            }
+            close(ctx->wake_fd);
+            ret = -1;
+            break;
+        }
+
+        loop->context = ctx;
+        uring_context_count++;
+
+    } while (0);
+
+    return ret;
+}
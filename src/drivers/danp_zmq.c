@@ -6,11 +6,15 @@
 
 #include "osal/osal.h"
 #include "danp/danp.h"
+#include "danp/danp_buffer.h"
 #include "../danp_debug.h"
 #include "danp/drivers/danp_zmq.h"
-#include <assert.h>
-#include <pthread.h>
+#include <fcntl.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
 #include <zmq.h>
 
 /* LCOV_EXCL_START */ /* Requires live ZMQ endpoints; excluded from unit coverage */
@@ -20,9 +24,65 @@
 
 /* Definitions */
 
+#define DANP_DRIVER_ZMQ_STACK_SIZE              (1024 * 8)
+#define DANP_DRIVER_ZMQ_MIN_FRAME               (DANP_ZMQ_TOPIC_SIZE + DANP_HEADER_SIZE)
+#define DANP_DRIVER_ZMQ_MAX_FRAME               (DANP_DRIVER_ZMQ_MIN_FRAME + DANP_MAX_PACKET_SIZE)
+#define DANP_DRIVER_ZMQ_ENTRY_PREFIX            (2)
+#define DANP_DRIVER_ZMQ_BURST                   (16)
+#define DANP_DRIVER_ZMQ_NO_DEADLINE             (UINT64_MAX)
 
 /* Types */
 
+/* A transmit frame is built in a spare pool packet used as plain storage, so it must fit one. */
+typedef char danp_zmq_frame_fits_packet_t[(sizeof(danp_packet_t) >= DANP_DRIVER_ZMQ_MAX_FRAME) ? 1 : -1];
+
+/** @brief An aggregated message being filled for one destination node. */
+typedef struct danp_zmq_bundle_s
+{
+    uint8_t node;         /**< Destination node; valid while frames > 0. */
+    uint32_t frames;      /**< Frames in data. */
+    uint32_t length;      /**< Bytes in data, topic included. */
+    uint64_t deadline_us; /**< When the message leaves even if not full. */
+    uint8_t data[DANP_ZMQ_AGG_MAX_BYTES];
+} danp_zmq_bundle_t;
+
+/**
+ * @brief Driver state of one ZMQ interface.
+ *
+ * ZMQ sockets are not thread-safe, so every send on the PUB socket happens under
+ * tx_lock, which also guards the bundles. The SUB socket belongs to the loop
+ * thread once the context is published, so group changes are left in
+ * groups_wanted for the loop to apply. iface is cleared on shutdown, so a late
+ * transmit on a closed interface fails instead of touching a closed socket.
+ */
+typedef struct danp_zmq_context_s
+{
+    danp_zmq_interface_t *iface;
+    osalMutexHandle_t tx_lock;
+    uint32_t max_bytes;
+    uint32_t delay_us;
+    uint16_t groups_wanted;     /**< Multicast groups to subscribe, one bit per group. */
+    uint16_t groups_subscribed; /**< Multicast groups the SUB socket subscribes; loop thread only. */
+    danp_zmq_bundle_t bundles[DANP_ZMQ_AGG_BUNDLES];
+} danp_zmq_context_t;
+
+/**
+ * @brief The thread that receives on every ZMQ interface and sends due bundles.
+ *
+ * Other threads wake it through a non-blocking pipe polled next to the SUB
+ * sockets. wake_pending coalesces wake-ups, so a burst of them costs one write.
+ * sleep_until_us is the deadline the loop sleeps towards; a transmit that opens
+ * a bundle due earlier wakes it to shorten the sleep.
+ */
+typedef struct danp_zmq_loop_s
+{
+    bool running;
+    bool stop;
+    int wake_pipe[2];
+    uint32_t wake_pending;
+    uint64_t sleep_until_us;
+    osalSemaphoreHandle_t stopped;
+} danp_zmq_loop_t;
 
 /* Forward Declarations */
 
@@ -30,70 +90,576 @@
 /* Variables */
 
 static void *zmq_context = NULL;
+static danp_zmq_context_t zmq_contexts[DANP_ZMQ_MAX_INTERFACES];
+static uint32_t zmq_context_count = 0;
+static danp_zmq_loop_t zmq_loop = { .wake_pipe = { -1, -1 } };
+static uint32_t zmq_pool_frames_held = 0;
 
 /* Functions */
 
-static int32_t danp_zmq_tx(void *iface_common, danp_packet_t *packet)
+static uint64_t danp_zmq_now_us(void)
 {
-    danp_zmq_interface_t *iface = (danp_zmq_interface_t *)iface_common;
-    uint8_t buffer[DANP_MAX_PACKET_SIZE + 4];
-    memcpy(buffer, &packet->header_raw, 4);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+/**
+ * @brief Make the loop run a pass; safe from any thread, including the loop itself.
+ */
+static void danp_zmq_wake_loop(void)
+{
+    uint8_t token = 1;
+
+    if (__atomic_exchange_n(&zmq_loop.wake_pending, 1U, __ATOMIC_ACQ_REL) == 0U)
+    {
+        // A full pipe already holds a wake-up, so a failed write loses nothing.
+        (void)write(zmq_loop.wake_pipe[1], &token, sizeof(token));
+    }
+}
+
+/**
+ * @brief Return a frame's pool packet once ZMQ has sent it; runs on a ZMQ I/O thread.
+ */
+static void danp_zmq_free_frame(void *data, void *hint)
+{
+    (void)data;
+    danp_buffer_free((danp_packet_t *)hint);
+    __atomic_fetch_sub(&zmq_pool_frames_held, 1U, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Send a bundle and empty it; called with tx_lock held.
+ */
+static void danp_zmq_flush_bundle(danp_zmq_context_t *ctx, danp_zmq_bundle_t *bundle)
+{
+    danp_zmq_interface_t *iface = ctx->iface;
+
+    if (bundle->frames == 0)
+    {
+        return;
+    }
+    if (zmq_send(iface->pub_sock, bundle->data, bundle->length, 0) < 0)
+    {
+        danp_log_message(DANP_LOG_WARN, "DANP ZMQ: Bundle send failed, errno %d", zmq_errno());
+        __atomic_fetch_add(&iface->stats.tx_drops, bundle->frames, __ATOMIC_RELAXED);
+    }
+    else
+    {
+        __atomic_fetch_add(&iface->stats.tx_bundled, bundle->frames, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&iface->stats.tx_bundles, 1U, __ATOMIC_RELAXED);
+    }
+    bundle->frames = 0;
+    bundle->length = 0;
+}
+
+/**
+ * @brief Append a packet to the bundle of its destination; called with tx_lock held.
+ * @return Deadline of the bundle if this packet opened it, else DANP_DRIVER_ZMQ_NO_DEADLINE.
+ */
+static uint64_t danp_zmq_bundle_packet(danp_zmq_context_t *ctx, uint8_t node, const danp_packet_t *packet)
+{
+    danp_zmq_bundle_t *bundle = NULL;
+    danp_zmq_bundle_t *empty = NULL;
+    danp_zmq_bundle_t *oldest = &ctx->bundles[0];
+    uint16_t entry_len = (uint16_t)(DANP_HEADER_SIZE + packet->length);
+    uint64_t opened_us = DANP_DRIVER_ZMQ_NO_DEADLINE;
+
+    for (uint32_t i = 0; i < DANP_ZMQ_AGG_BUNDLES && bundle == NULL; i++)
+    {
+        danp_zmq_bundle_t *candidate = &ctx->bundles[i];
+
+        if (candidate->frames == 0)
+        {
+            empty = (empty == NULL) ? candidate : empty;
+        }
+        else if (candidate->node == node)
+        {
+            bundle = candidate;
+        }
+        else if (candidate->deadline_us < oldest->deadline_us)
+        {
+            oldest = candidate;
+        }
+    }
+    if (bundle == NULL)
+    {
+        // With every slot busy for other nodes, the one closest to its deadline goes now.
+        bundle = (empty != NULL) ? empty : oldest;
+        danp_zmq_flush_bundle(ctx, bundle);
+    }
+    if (bundle->frames > 0 && bundle->length + DANP_DRIVER_ZMQ_ENTRY_PREFIX + entry_len > ctx->max_bytes)
+    {
+        danp_zmq_flush_bundle(ctx, bundle);
+    }
+    if (bundle->frames == 0)
+    {
+        bundle->node = node;
+        bundle->data[0] = node;
+        bundle->data[1] = DANP_ZMQ_KIND_BUNDLE;
+        bundle->length = DANP_ZMQ_TOPIC_SIZE;
+        bundle->deadline_us = danp_zmq_now_us() + ctx->delay_us;
+        opened_us = bundle->deadline_us;
+    }
+
+    // Big-endian, so nodes of either byte order read the same bundle.
+    bundle->data[bundle->length] = (uint8_t)(entry_len >> 8);
+    bundle->data[bundle->length + 1] = (uint8_t)entry_len;
+    memcpy(bundle->data + bundle->length + DANP_DRIVER_ZMQ_ENTRY_PREFIX, &packet->header_raw, DANP_HEADER_SIZE);
+    if (packet->length > 0)
+    {
+        memcpy(bundle->data + bundle->length + DANP_DRIVER_ZMQ_ENTRY_PREFIX + DANP_HEADER_SIZE, packet->payload, packet->length);
+    }
+    bundle->length += DANP_DRIVER_ZMQ_ENTRY_PREFIX + entry_len;
+    bundle->frames++;
+
+    // Leave as soon as not even an empty packet would fit.
+    if (bundle->length + DANP_DRIVER_ZMQ_ENTRY_PREFIX + DANP_HEADER_SIZE > ctx->max_bytes)
+    {
+        danp_zmq_flush_bundle(ctx, bundle);
+        opened_us = DANP_DRIVER_ZMQ_NO_DEADLINE;
+    }
+
+    return opened_us;
+}
+
+/**
+ * @brief Send one packet as its own message; called with tx_lock held.
+ */
+static int32_t danp_zmq_send_single(danp_zmq_interface_t *iface, uint8_t node, const danp_packet_t *packet)
+{
+    size_t frame_len = DANP_DRIVER_ZMQ_MIN_FRAME + packet->length;
+    danp_packet_t *storage = NULL;
+    uint8_t stack_frame[DANP_DRIVER_ZMQ_MAX_FRAME];
+    uint8_t *frame = stack_frame;
+    zmq_msg_t msg;
+    int rc = 0;
+
+    // The stack keeps its packet, so the frame is copied once into a spare pool packet that ZMQ
+    // holds on to until it is sent. That spares ZMQ the allocation and copy of zmq_send().
+    if (danp_buffer_get_free_count() > DANP_ZMQ_POOL_RESERVE)
+    {
+        if (__atomic_add_fetch(&zmq_pool_frames_held, 1U, __ATOMIC_RELAXED) <= DANP_ZMQ_POOL_FRAMES)
+        {
+            storage = danp_buffer_allocate();
+        }
+        if (storage == NULL)
+        {
+            __atomic_fetch_sub(&zmq_pool_frames_held, 1U, __ATOMIC_RELAXED);
+        }
+    }
+    if (storage != NULL)
+    {
+        frame = (uint8_t *)storage;
+    }
+
+    frame[0] = node;
+    frame[1] = DANP_ZMQ_KIND_SINGLE;
+    memcpy(frame + DANP_ZMQ_TOPIC_SIZE, &packet->header_raw, DANP_HEADER_SIZE);
     if (packet->length > 0)
     {
-        memcpy(buffer + 4, packet->payload, packet->length);
+        memcpy(frame + DANP_DRIVER_ZMQ_MIN_FRAME, packet->payload, packet->length);
     }
 
-    // Manually unpack for logging (Shift values changed!)
-    uint16_t dst = (packet->header_raw >> 22) & 0xFF;
-    uint8_t d_port = (packet->header_raw >> 8) & 0x3F;
-    uint8_t flags = packet->header_raw & 0x03;
+    if (storage != NULL)
+    {
+        zmq_msg_init_data(&msg, frame, frame_len, danp_zmq_free_frame, storage);
+        rc = zmq_msg_send(&msg, iface->pub_sock, 0);
+        if (rc < 0)
+        {
+            // Ownership stays with us on failure; closing the message runs the free function.
+            zmq_msg_close(&msg);
+        }
+        else
+        {
+            __atomic_fetch_add(&iface->stats.tx_pool_frames, 1U, __ATOMIC_RELAXED);
+        }
+    }
+    else
+    {
+        rc = zmq_send(iface->pub_sock, frame, frame_len, 0);
+        if (rc >= 0)
+        {
+            __atomic_fetch_add(&iface->stats.tx_copied, 1U, __ATOMIC_RELAXED);
+        }
+    }
+
+    if (rc < 0)
+    {
+        danp_log_message(DANP_LOG_WARN, "DANP ZMQ: Send failed, errno %d", zmq_errno());
+        __atomic_fetch_add(&iface->stats.tx_drops, 1U, __ATOMIC_RELAXED);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int32_t danp_zmq_tx(void *iface_common, danp_packet_t *packet)
+{
+    danp_zmq_interface_t *iface = (danp_zmq_interface_t *)iface_common;
+    danp_zmq_context_t *ctx = (danp_zmq_context_t *)iface->context;
+    uint8_t node = (packet->header_raw >> 22) & 0xFF; // Destination node
+    int32_t ret = -1;
+    uint64_t opened_us = DANP_DRIVER_ZMQ_NO_DEADLINE;
 
     danp_log_message(
         DANP_LOG_VERBOSE,
         "ZMQ TX: dst=%u port=%u flags=0x%02X len=%u",
-        dst,
-        d_port,
-        flags,
+        node,
+        (packet->header_raw >> 8) & 0x3F,
+        packet->header_raw & 0x03,
         packet->length);
 
-    // ZMQ Topic    // 1. Send Topic (2 bytes, NodeID)
-    uint16_t topic = packet->header_raw >> 22 & 0xFF; // Extract DST Node
-    zmq_send(iface->pub_sock, &topic, 2, ZMQ_SNDMORE);
-    zmq_send(iface->pub_sock, buffer, 4 + packet->length, 0);
+    if (ctx == NULL)
+    {
+        return -1;
+    }
+
+    osalMutexLock(ctx->tx_lock, OSAL_WAIT_FOREVER);
+    if (ctx->iface != iface)
+    {
+        // Shut down, and the slot possibly handed to another interface since.
+        ret = -1;
+    }
+    else if (ctx->max_bytes > 0)
+    {
+        opened_us = danp_zmq_bundle_packet(ctx, node, packet);
+        ret = 0;
+    }
+    else
+    {
+        ret = danp_zmq_send_single(iface, node, packet);
+    }
+    osalMutexUnlock(ctx->tx_lock);
+
+    // The loop stored its deadline before it looked at our bundles, so reading it after them is enough.
+    if (opened_us < __atomic_load_n(&zmq_loop.sleep_until_us, __ATOMIC_SEQ_CST))
+    {
+        danp_zmq_wake_loop();
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Allocate pool packets for the frames of a bundle and deliver them as bursts.
+ */
+static void danp_zmq_input_bundle(danp_zmq_interface_t *iface, const uint8_t *data, uint32_t len)
+{
+    danp_packet_t *pkts[DANP_DRIVER_ZMQ_BURST];
+    uint32_t count = 0;
+    uint32_t offset = DANP_ZMQ_TOPIC_SIZE;
+
+    __atomic_fetch_add(&iface->stats.rx_bundles, 1U, __ATOMIC_RELAXED);
+    while (offset < len)
+    {
+        uint16_t entry_len = 0;
+
+        if (offset + DANP_DRIVER_ZMQ_ENTRY_PREFIX > len)
+        {
+            entry_len = 0; // Truncated prefix; rejected below
+        }
+        else
+        {
+            entry_len = (uint16_t)((data[offset] << 8) | data[offset + 1]);
+        }
+        if (entry_len < DANP_HEADER_SIZE || entry_len > DANP_HEADER_SIZE + DANP_MAX_PACKET_SIZE ||
+            offset + DANP_DRIVER_ZMQ_ENTRY_PREFIX + entry_len > len)
+        {
+            danp_log_message(DANP_LOG_WARN, "ZMQ RX: Dropping malformed bundle tail at offset %u", offset);
+            __atomic_fetch_add(&iface->stats.rx_drops, 1U, __ATOMIC_RELAXED);
+            break;
+        }
+
+        danp_packet_t *pkt = danp_buffer_allocate();
+        if (pkt == NULL)
+        {
+            __atomic_fetch_add(&iface->stats.rx_drops, 1U, __ATOMIC_RELAXED);
+        }
+        else
+        {
+            memcpy(&pkt->header_raw, data + offset + DANP_DRIVER_ZMQ_ENTRY_PREFIX, DANP_HEADER_SIZE);
+            pkt->length = (uint16_t)(entry_len - DANP_HEADER_SIZE);
+            memcpy(pkt->payload, data + offset + DANP_DRIVER_ZMQ_ENTRY_PREFIX + DANP_HEADER_SIZE, pkt->length);
+            pkts[count++] = pkt;
+        }
+        offset += DANP_DRIVER_ZMQ_ENTRY_PREFIX + entry_len;
+
+        if (count == DANP_DRIVER_ZMQ_BURST)
+        {
+            __atomic_fetch_add(&iface->stats.rx_packets, count, __ATOMIC_RELAXED);
+            danp_input_burst(&iface->common, pkts, count);
+            count = 0;
+        }
+    }
+
+    if (count > 0)
+    {
+        __atomic_fetch_add(&iface->stats.rx_packets, count, __ATOMIC_RELAXED);
+        danp_input_burst(&iface->common, pkts, count);
+    }
+}
+
+static void danp_zmq_input_single(danp_zmq_interface_t *iface, const uint8_t *frame, uint32_t len)
+{
+    if (len > DANP_DRIVER_ZMQ_MAX_FRAME)
+    {
+        danp_log_message(DANP_LOG_WARN, "ZMQ RX: Dropping malformed frame of %u bytes", len);
+        __atomic_fetch_add(&iface->stats.rx_drops, 1U, __ATOMIC_RELAXED);
+        return;
+    }
+
+    danp_packet_t *pkt = danp_buffer_allocate();
+    if (pkt == NULL)
+    {
+        __atomic_fetch_add(&iface->stats.rx_drops, 1U, __ATOMIC_RELAXED);
+        return;
+    }
+    memcpy(&pkt->header_raw, frame + DANP_ZMQ_TOPIC_SIZE, DANP_HEADER_SIZE);
+    pkt->length = (uint16_t)(len - DANP_DRIVER_ZMQ_MIN_FRAME);
+    memcpy(pkt->payload, frame + DANP_DRIVER_ZMQ_MIN_FRAME, pkt->length);
+
+    danp_log_message(
+        DANP_LOG_VERBOSE,
+        "ZMQ RX: [dst]=%u, [port]=%u [flags]=0x%02X [len]=%u",
+        (pkt->header_raw >> 22) & 0xFF,
+        (pkt->header_raw >> 8) & 0x3F,
+        pkt->header_raw & 0x03,
+        pkt->length);
+    __atomic_fetch_add(&iface->stats.rx_packets, 1U, __ATOMIC_RELAXED);
+    danp_input_packet(&iface->common, pkt);
+}
+
+/**
+ * @brief Hand one received message to the stack.
+ */
+static void danp_zmq_input_message(danp_zmq_interface_t *iface, zmq_msg_t *msg, int len)
+{
+    const uint8_t *frame = (const uint8_t *)zmq_msg_data(msg);
+
+    if (len < DANP_DRIVER_ZMQ_MIN_FRAME)
+    {
+        danp_log_message(DANP_LOG_WARN, "ZMQ RX: Dropping malformed frame of %d bytes", len);
+        __atomic_fetch_add(&iface->stats.rx_drops, 1U, __ATOMIC_RELAXED);
+    }
+    else if (frame[1] == DANP_ZMQ_KIND_BUNDLE)
+    {
+        danp_zmq_input_bundle(iface, frame, (uint32_t)len);
+    }
+    else
+    {
+        danp_zmq_input_single(iface, frame, (uint32_t)len);
+    }
+}
+
+/**
+ * @brief Ask the loop to subscribe to or drop the topic of a multicast group.
+ */
+static int32_t danp_zmq_group(void *iface_common, uint16_t group, bool join)
+{
+    danp_zmq_interface_t *iface = (danp_zmq_interface_t *)iface_common;
+    danp_zmq_context_t *ctx = (danp_zmq_context_t *)iface->context;
+    uint16_t bit = (uint16_t)(1U << (group - DANP_MULTICAST_FIRST));
+
+    if (join)
+    {
+        __atomic_fetch_or(&ctx->groups_wanted, bit, __ATOMIC_RELEASE);
+    }
+    else
+    {
+        __atomic_fetch_and(&ctx->groups_wanted, (uint16_t)~bit, __ATOMIC_RELEASE);
+    }
+    danp_zmq_wake_loop();
+
     return 0;
 }
 
-static void danp_zmq_rx_routine(void *arg)
+/**
+ * @brief Bring the group subscriptions of every SUB socket up to date; loop thread only.
+ */
+static void danp_zmq_apply_groups(uint32_t count)
 {
-    danp_zmq_interface_t *iface = (danp_zmq_interface_t *)arg;
-    while (1)
+    for (uint32_t i = 0; i < count; i++)
     {
-        zmq_recv(iface->sub_sock, NULL, 0, 0);
-        uint8_t buffer[256];
-        int32_t len = zmq_recv(iface->sub_sock, buffer, sizeof(buffer), 0);
-        if (len >= 4)
+        danp_zmq_context_t *ctx = &zmq_contexts[i];
+        uint16_t wanted = __atomic_load_n(&ctx->groups_wanted, __ATOMIC_ACQUIRE);
+        uint16_t changed = (uint16_t)(wanted ^ ctx->groups_subscribed);
+
+        for (uint32_t g = 0; g < DANP_MULTICAST_COUNT && changed != 0U; g++)
         {
-            uint32_t header_raw;
-            memcpy(&header_raw, buffer, 4);
+            uint8_t topic = (uint8_t)(DANP_MULTICAST_FIRST + g);
+
+            if ((changed & (1U << g)) == 0U)
+            {
+                continue;
+            }
+            zmq_setsockopt(
+                ctx->iface->sub_sock,
+                (wanted & (1U << g)) ? ZMQ_SUBSCRIBE : ZMQ_UNSUBSCRIBE,
+                &topic,
+                sizeof(topic));
+        }
+        ctx->groups_subscribed = wanted;
+    }
+}
 
-            uint16_t dst = (header_raw >> 22) & 0xFF;
-            uint8_t d_port = (header_raw >> 8) & 0x3F;
-            uint8_t flags = header_raw & 0x03;
+/**
+ * @brief Send the bundles of every interface that are due.
+ * @return Earliest deadline still pending, or DANP_DRIVER_ZMQ_NO_DEADLINE.
+ */
+static uint64_t danp_zmq_flush_due(uint32_t count, bool flush_all)
+{
+    uint64_t next_us = DANP_DRIVER_ZMQ_NO_DEADLINE;
+    uint64_t now_us = danp_zmq_now_us();
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        danp_zmq_context_t *ctx = &zmq_contexts[i];
+
+        osalMutexLock(ctx->tx_lock, OSAL_WAIT_FOREVER);
+        for (uint32_t j = 0; j < DANP_ZMQ_AGG_BUNDLES; j++)
+        {
+            danp_zmq_bundle_t *bundle = &ctx->bundles[j];
 
-            danp_log_message(
-                DANP_LOG_VERBOSE,
-                "ZMQ RX: [dst]=%u, [port]=%u [flags]=0x%02X [len]=%d",
-                dst,
-                d_port,
-                flags,
-                len - 4);
-            danp_input((danp_interface_t *)iface, buffer, len);
+            if (bundle->frames == 0)
+            {
+                continue;
+            }
+            if (flush_all || bundle->deadline_us <= now_us)
+            {
+                danp_zmq_flush_bundle(ctx, bundle);
+            }
+            else if (bundle->deadline_us < next_us)
+            {
+                next_us = bundle->deadline_us;
+            }
         }
-        else
+        osalMutexUnlock(ctx->tx_lock);
+    }
+
+    return next_us;
+}
+
+static void danp_zmq_loop_routine(void *arg)
+{
+    zmq_pollitem_t items[DANP_ZMQ_MAX_INTERFACES + 1];
+    zmq_msg_t msg;
+    uint8_t drain[16];
+
+    (void)arg;
+    zmq_msg_init(&msg);
+
+    while (!__atomic_load_n(&zmq_loop.stop, __ATOMIC_ACQUIRE))
+    {
+        uint32_t count = __atomic_load_n(&zmq_context_count, __ATOMIC_ACQUIRE);
+        long timeout_ms = -1;
+
+        danp_zmq_apply_groups(count);
+
+        // Publish "no deadline" first: a bundle opened while we look is then either seen or wakes us.
+        __atomic_store_n(&zmq_loop.sleep_until_us, DANP_DRIVER_ZMQ_NO_DEADLINE, __ATOMIC_SEQ_CST);
+        uint64_t next_us = danp_zmq_flush_due(count, false);
+        __atomic_store_n(&zmq_loop.sleep_until_us, next_us, __ATOMIC_SEQ_CST);
+        if (next_us != DANP_DRIVER_ZMQ_NO_DEADLINE)
+        {
+            uint64_t now_us = danp_zmq_now_us();
+            // zmq_poll counts in milliseconds, so a bundle may leave up to 1 ms after its deadline.
+            timeout_ms = (next_us > now_us) ? (long)((next_us - now_us + 999ULL) / 1000ULL) : 0;
+        }
+
+        items[0].socket = NULL;
+        items[0].fd = zmq_loop.wake_pipe[0];
+        items[0].events = ZMQ_POLLIN;
+        items[0].revents = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            items[i + 1].socket = zmq_contexts[i].iface->sub_sock;
+            items[i + 1].fd = 0;
+            items[i + 1].events = ZMQ_POLLIN;
+            items[i + 1].revents = 0;
+        }
+
+        if (zmq_poll(items, (int)count + 1, timeout_ms) < 0)
+        {
+            continue;
+        }
+
+        if (items[0].revents & ZMQ_POLLIN)
+        {
+            // Clear the flag before draining, so a wake-up after this point writes again.
+            __atomic_store_n(&zmq_loop.wake_pending, 0U, __ATOMIC_RELEASE);
+            while (read(zmq_loop.wake_pipe[0], drain, sizeof(drain)) > 0)
+            {
+            }
+        }
+
+        for (uint32_t i = 0; i < count; i++)
         {
-            danp_log_message(DANP_LOG_WARN, "ZMQ RX: received packet too short");
+            danp_zmq_interface_t *iface = zmq_contexts[i].iface;
+
+            if ((items[i + 1].revents & ZMQ_POLLIN) == 0)
+            {
+                continue;
+            }
+            // A bounded batch per socket keeps one busy link from starving the others.
+            for (uint32_t n = 0; n < DANP_ZMQ_RX_BATCH; n++)
+            {
+                // The message owns the data, so nothing is truncated or copied to the stack.
+                int len = zmq_msg_recv(&msg, iface->sub_sock, ZMQ_DONTWAIT);
+                if (len < 0)
+                {
+                    break;
+                }
+                danp_zmq_input_message(iface, &msg, len);
+            }
         }
     }
+
+    zmq_msg_close(&msg);
+    osalSemaphoreGive(zmq_loop.stopped);
+}
+
+/**
+ * @brief Create the wake-up pipe and start the loop thread, once per process.
+ */
+static int32_t danp_zmq_start_loop(void)
+{
+    osalThreadAttr_t thread_attr =
+    {
+        .name = "danpZmqLoop",
+        .stackSize = DANP_DRIVER_ZMQ_STACK_SIZE,
+        .stackMem = NULL,
+        .priority = OSAL_THREAD_PRIORITY_NORMAL,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+    osalSemaphoreAttr_t sem_attr = { .name = "danpZmqStop", .maxCount = 1 };
+
+    if (zmq_loop.stopped == NULL)
+    {
+        zmq_loop.stopped = osalSemaphoreCreate(&sem_attr);
+    }
+    if (zmq_loop.stopped == NULL || pipe(zmq_loop.wake_pipe) != 0)
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP ZMQ: Failed to create loop wake-up");
+        return -1;
+    }
+    fcntl(zmq_loop.wake_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(zmq_loop.wake_pipe[1], F_SETFL, O_NONBLOCK);
+
+    zmq_loop.stop = false;
+    zmq_loop.wake_pending = 0;
+    zmq_loop.sleep_until_us = DANP_DRIVER_ZMQ_NO_DEADLINE;
+    if (!osalThreadCreate(danp_zmq_loop_routine, NULL, &thread_attr))
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP ZMQ: Failed to create loop thread");
+        close(zmq_loop.wake_pipe[0]);
+        close(zmq_loop.wake_pipe[1]);
+        return -1;
+    }
+    zmq_loop.running = true;
+
+    return 0;
 }
 
 void danp_zmq_init(
@@ -103,6 +669,16 @@ void danp_zmq_init(
     int32_t sub_count,
     uint16_t node_id)
 {
+    danp_zmq_context_t *ctx = NULL;
+    osalMutexHandle_t tx_lock = NULL;
+    osalMutexAttr_t mutex_attr =
+    {
+        .name = "danpZmqTx",
+        .attrBits = OSAL_MUTEX_PRIO_INHERIT,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+
     if (zmq_context == NULL)
     {
         zmq_context = zmq_ctx_new();
@@ -112,6 +688,25 @@ void danp_zmq_init(
             return;
         }
     }
+    if (zmq_context_count >= DANP_ZMQ_MAX_INTERFACES)
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP ZMQ: No free interface context");
+        return;
+    }
+    ctx = &zmq_contexts[zmq_context_count];
+
+    // Slots are reused after a shutdown; OSAL cannot delete a mutex, so keep the one it has.
+    tx_lock = (ctx->tx_lock != NULL) ? ctx->tx_lock : osalMutexCreate(&mutex_attr);
+    if (tx_lock == NULL)
+    {
+        danp_log_message(DANP_LOG_ERROR, "DANP ZMQ: Failed to create TX lock");
+        return;
+    }
+    memset(ctx, 0, sizeof(danp_zmq_context_t));
+    ctx->tx_lock = tx_lock;
+    ctx->iface = iface;
+    iface->context = ctx;
+    memset(&iface->stats, 0, sizeof(iface->stats));
 
     // PUB
     iface->pub_sock = zmq_socket(zmq_context, ZMQ_PUB);
@@ -124,19 +719,109 @@ void danp_zmq_init(
         zmq_connect(iface->sub_sock, sub_connect_endpoints[i]);
     }
 
-    // Filter: Subscribe to My Node ID
-    uint16_t topic = node_id;
-    zmq_setsockopt(iface->sub_sock, ZMQ_SUBSCRIBE, &topic, 2);
+    // Filter: the first topic byte of each message is its destination node
+    uint8_t topic = (uint8_t)node_id;
+    zmq_setsockopt(iface->sub_sock, ZMQ_SUBSCRIBE, &topic, sizeof(topic));
 
-    // Also subscribe to Broadcast (0xFF) if needed, or Promiscuous mode
-    // For now, just specific node.
+    // Broadcasts reach every node; groups are subscribed as local sockets join them
+    topic = DANP_BROADCAST_NODE;
+    zmq_setsockopt(iface->sub_sock, ZMQ_SUBSCRIBE, &topic, sizeof(topic));
 
     iface->common.name = "ZMQ";
     iface->common.address = node_id;
     iface->common.mtu = DANP_MAX_PACKET_SIZE;
     iface->common.tx_func = danp_zmq_tx;
+    iface->common.group_func = danp_zmq_group;
+
+    // Publishing the slot hands the SUB socket over to the loop thread.
+    __atomic_store_n(&zmq_context_count, zmq_context_count + 1U, __ATOMIC_SEQ_CST);
+    if (!zmq_loop.running)
+    {
+        danp_zmq_start_loop();
+    }
+    else
+    {
+        danp_zmq_wake_loop();
+    }
+}
+
+int32_t danp_zmq_set_aggregation(danp_zmq_interface_t *iface, uint32_t max_bytes, uint32_t delay_us)
+{
+    danp_zmq_context_t *ctx = NULL;
+    int32_t ret = 0;
+
+    if (iface == NULL || iface->context == NULL || max_bytes > DANP_ZMQ_AGG_MAX_BYTES ||
+        (max_bytes > 0 && max_bytes < DANP_ZMQ_TOPIC_SIZE + DANP_DRIVER_ZMQ_ENTRY_PREFIX + DANP_HEADER_SIZE + DANP_MAX_PACKET_SIZE))
+    {
+        return -1;
+    }
+    ctx = (danp_zmq_context_t *)iface->context;
 
-    pthread_create((pthread_t*)&iface->rx_thread_id, NULL, danp_zmq_rx_routine, iface);
+    osalMutexLock(ctx->tx_lock, OSAL_WAIT_FOREVER);
+    if (ctx->iface != iface)
+    {
+        ret = -1;
+    }
+    else
+    {
+        for (uint32_t i = 0; i < DANP_ZMQ_AGG_BUNDLES; i++)
+        {
+            danp_zmq_flush_bundle(ctx, &ctx->bundles[i]);
+        }
+        ctx->max_bytes = max_bytes;
+        ctx->delay_us = delay_us;
+    }
+    osalMutexUnlock(ctx->tx_lock);
+
+    return ret;
+}
+
+int32_t danp_zmq_shutdown(void)
+{
+    int linger = DANP_ZMQ_LINGER_MS;
+    uint32_t count = zmq_context_count;
+
+    if (!zmq_loop.running)
+    {
+        return -1;
+    }
+
+    __atomic_store_n(&zmq_loop.stop, true, __ATOMIC_RELEASE);
+    danp_zmq_wake_loop();
+    osalSemaphoreTake(zmq_loop.stopped, OSAL_WAIT_FOREVER);
+    zmq_loop.running = false;
+    close(zmq_loop.wake_pipe[0]);
+    close(zmq_loop.wake_pipe[1]);
+    zmq_loop.wake_pipe[0] = -1;
+    zmq_loop.wake_pipe[1] = -1;
+
+    // The loop has exited, so the SUB sockets are ours again.
+    danp_zmq_flush_due(count, true);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        danp_zmq_context_t *ctx = &zmq_contexts[i];
+        danp_zmq_interface_t *iface = ctx->iface;
+
+        osalMutexLock(ctx->tx_lock, OSAL_WAIT_FOREVER);
+        ctx->iface = NULL;
+        zmq_setsockopt(iface->pub_sock, ZMQ_LINGER, &linger, sizeof(linger));
+        zmq_close(iface->pub_sock);
+        iface->pub_sock = NULL;
+        osalMutexUnlock(ctx->tx_lock);
+
+        zmq_setsockopt(iface->sub_sock, ZMQ_LINGER, &linger, sizeof(linger));
+        zmq_close(iface->sub_sock);
+        iface->sub_sock = NULL;
+    }
+
+    // Returns once queued messages are sent or the linger expired; their pool packets come back then.
+    zmq_ctx_term(zmq_context);
+    zmq_context = NULL;
+    __atomic_store_n(&zmq_context_count, 0U, __ATOMIC_SEQ_CST);
+
+    danp_log_message(DANP_LOG_INFO, "DANP ZMQ: Shut down %u interfaces", count);
+
+    return 0;
 }
 
 /* LCOV_EXCL_STOP */
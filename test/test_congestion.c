@@ -0,0 +1,468 @@
+/**
+ * @file test_congestion.c
+ * @brief STREAM congestion control tests for DANP library
+ *
+ * This file contains unit tests for DANP congestion control including:
+ * - NewReno slow start, congestion avoidance and loss reaction
+ * - Pluggable controller selection
+ * - Fair sharing of a bandwidth-limited link between several connections
+ */
+
+#include "danp/danp.h"
+#include "osal/osal.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+
+/* ============================================================================
+ * Test Configuration
+ * ============================================================================
+ */
+
+/* Test node and port identifiers */
+#define TEST_NODE_ID 60          /* Local node ID for all tests */
+#define SERVER_PORT 40           /* Port of the shared server */
+#define CLIENT_PORT_BASE 41      /* First client port of the fairness scenario */
+
+/* Bandwidth-limited link: one frame every LINK_FRAME_TIME_MS, tail drop */
+#define LINK_QUEUE_DEPTH 10
+#define LINK_FRAME_TIME_MS 1
+
+/* Fairness scenario */
+#define FLOW_COUNT 3
+#define FLOW_DURATION_MS 1500
+#define FLOW_CHUNK_SIZE 64
+
+void danp_log_message_with_func_name(
+    danp_log_level_t level,
+    const char *func_name,
+    const char *message,
+    va_list args);
+
+/* ============================================================================
+ * Bandwidth-Limited Test Link
+ * ============================================================================
+ */
+
+typedef struct link_frame_s
+{
+    uint16_t length;
+    uint8_t data[DANP_HEADER_SIZE + DANP_MAX_PACKET_SIZE];
+} link_frame_t;
+
+static danp_interface_t link_iface;
+static bool link_registered = false;
+static osalMutexHandle_t link_mutex;
+static link_frame_t link_queue[LINK_QUEUE_DEPTH];
+static uint32_t link_head = 0;
+static uint32_t link_count = 0;
+static volatile uint32_t link_drops = 0;
+
+static int32_t link_tx(void *iface_common, danp_packet_t *packet)
+{
+    (void)iface_common;
+
+    osalMutexLock(link_mutex, OSAL_WAIT_FOREVER);
+    if (link_count == LINK_QUEUE_DEPTH)
+    {
+        link_drops++;
+        osalMutexUnlock(link_mutex);
+        return -1;
+    }
+
+    link_frame_t *frame = &link_queue[(link_head + link_count) % LINK_QUEUE_DEPTH];
+    memcpy(frame->data, &packet->header_raw, DANP_HEADER_SIZE);
+    memcpy(frame->data + DANP_HEADER_SIZE, packet->payload, packet->length);
+    frame->length = DANP_HEADER_SIZE + packet->length;
+    link_count++;
+    osalMutexUnlock(link_mutex);
+
+    return 0;
+}
+
+/**
+ * @brief Deliver at most one queued frame per frame time
+ */
+static void link_routine(void *arg)
+{
+    (void)arg;
+    link_frame_t frame;
+
+    for (;;)
+    {
+        osalDelayMs(LINK_FRAME_TIME_MS);
+
+        osalMutexLock(link_mutex, OSAL_WAIT_FOREVER);
+        if (link_count == 0)
+        {
+            osalMutexUnlock(link_mutex);
+            continue;
+        }
+        frame = link_queue[link_head];
+        link_head = (link_head + 1) % LINK_QUEUE_DEPTH;
+        link_count--;
+        osalMutexUnlock(link_mutex);
+
+        danp_input(&link_iface, frame.data, frame.length);
+    }
+}
+
+/**
+ * @brief Wait until frames still queued on the link (e.g. RSTs from closes) are delivered
+ */
+static void drain_link(void)
+{
+    for (int i = 0; i < 100; i++)
+    {
+        osalMutexLock(link_mutex, OSAL_WAIT_FOREVER);
+        uint32_t pending = link_count;
+        osalMutexUnlock(link_mutex);
+        if (pending == 0)
+        {
+            break;
+        }
+        osalDelayMs(LINK_FRAME_TIME_MS * 5);
+    }
+    osalDelayMs(LINK_FRAME_TIME_MS * 5);
+}
+
+static void setup_link_interface(void)
+{
+    if (!link_registered)
+    {
+        osalMutexAttr_t mutex_attr = {.name = "testLink", .attrBits = 0, .cbMem = NULL, .cbSize = 0};
+        osalThreadAttr_t thread_attr = {
+            .name = "testLink",
+            .stackSize = 1024 * 8,
+            .stackMem = NULL,
+            .priority = OSAL_THREAD_PRIORITY_NORMAL,
+            .cbMem = NULL,
+            .cbSize = 0,
+        };
+
+        link_mutex = osalMutexCreate(&mutex_attr);
+        TEST_ASSERT_NOT_NULL(link_mutex);
+
+        memset(&link_iface, 0, sizeof(link_iface));
+        link_iface.name = "TEST_LIMITED_LINK";
+        link_iface.address = TEST_NODE_ID;
+        link_iface.mtu = 128;
+        link_iface.tx_func = link_tx;
+        danp_register_interface(&link_iface);
+
+        TEST_ASSERT_NOT_NULL(osalThreadCreate(link_routine, NULL, &thread_attr));
+        link_registered = true;
+    }
+
+    char route_entry[32];
+    int written = snprintf(route_entry, sizeof(route_entry), "%u:%s", TEST_NODE_ID, link_iface.name);
+    TEST_ASSERT_TRUE(written > 0 && written < (int)sizeof(route_entry));
+    TEST_ASSERT_EQUAL_INT32(0, danp_route_table_load(route_entry));
+}
+
+/* ============================================================================
+ * Counting Controller (pluggability)
+ * ============================================================================
+ */
+
+static uint32_t counting_init_calls = 0;
+static uint32_t counting_ack_calls = 0;
+
+static void counting_init(danp_socket_t *sock)
+{
+    counting_init_calls++;
+    sock->cwnd = 1;
+    sock->ssthresh = 1;
+}
+
+static void counting_on_ack(danp_socket_t *sock, uint16_t acked, int32_t rtt_ms)
+{
+    (void)sock;
+    (void)acked;
+    (void)rtt_ms;
+    counting_ack_calls++;
+}
+
+static void counting_on_loss(danp_socket_t *sock, danp_congestion_event_t event)
+{
+    (void)sock;
+    (void)event;
+}
+
+static const danp_congestion_ops_t counting_ops = {
+    .name = "counting",
+    .init = counting_init,
+    .on_ack = counting_on_ack,
+    .on_loss = counting_on_loss,
+};
+
+/* ============================================================================
+ * Test Setup and Teardown
+ * ============================================================================
+ */
+
+/**
+ * @brief Setup function called before each test
+ *
+ * Initializes the DANP core and routes the local node over the
+ * bandwidth-limited test link.
+ */
+void setUp(void)
+{
+    danp_config_t config = {.local_node = TEST_NODE_ID, .log_function = NULL};
+    danp_init(&config);
+
+    setup_link_interface();
+}
+
+/**
+ * @brief Teardown function called after each test
+ */
+void tearDown(void)
+{
+    danp_congestion_set_default(NULL);
+    drain_link();
+}
+
+/* ============================================================================
+ * NewReno Unit Tests
+ * ============================================================================
+ */
+
+/**
+ * @brief Test slow start growth and the cap at the send window
+ */
+void test_newreno_slow_start_grows_per_ack(void)
+{
+    danp_socket_t sock;
+    memset(&sock, 0, sizeof(sock));
+
+    danp_congestion_newreno.init(&sock);
+    TEST_ASSERT_EQUAL_UINT16(DANP_CWND_INITIAL, sock.cwnd);
+
+    danp_congestion_newreno.on_ack(&sock, 1, 10);
+    TEST_ASSERT_EQUAL_UINT16(DANP_CWND_INITIAL + 1, sock.cwnd);
+
+    danp_congestion_newreno.on_ack(&sock, 100, 10);
+    TEST_ASSERT_EQUAL_UINT16(DANP_STREAM_TX_WINDOW, sock.cwnd);
+}
+
+/**
+ * @brief Test multiplicative decrease on duplicate ACKs and restart on timeout
+ */
+void test_newreno_loss_reaction(void)
+{
+    danp_socket_t sock;
+    memset(&sock, 0, sizeof(sock));
+
+    danp_congestion_newreno.init(&sock);
+    sock.cwnd = DANP_STREAM_TX_WINDOW;
+    sock.snd_una = 250;
+    sock.snd_max = (uint8_t)(250 + DANP_STREAM_TX_WINDOW); /* wraps */
+
+    danp_congestion_newreno.on_loss(&sock, DANP_CONGESTION_DUPACK);
+    TEST_ASSERT_EQUAL_UINT16(DANP_STREAM_TX_WINDOW / 2, sock.ssthresh);
+    TEST_ASSERT_EQUAL_UINT16(sock.ssthresh, sock.cwnd);
+
+    danp_congestion_newreno.on_loss(&sock, DANP_CONGESTION_TIMEOUT);
+    TEST_ASSERT_EQUAL_UINT16(1, sock.cwnd);
+
+    /* Congestion avoidance: one segment per window of ACKs */
+    sock.cwnd = sock.ssthresh;
+    danp_congestion_newreno.on_ack(&sock, (uint16_t)(sock.cwnd - 1), 10);
+    TEST_ASSERT_EQUAL_UINT16(sock.ssthresh, sock.cwnd);
+    danp_congestion_newreno.on_ack(&sock, 1, 10);
+    TEST_ASSERT_EQUAL_UINT16(sock.ssthresh + 1, sock.cwnd);
+}
+
+/**
+ * @brief Test that a custom controller is used by new connections
+ */
+void test_congestion_controller_is_pluggable(void)
+{
+    counting_init_calls = 0;
+    counting_ack_calls = 0;
+    danp_congestion_set_default(&counting_ops);
+    TEST_ASSERT_EQUAL_PTR(&counting_ops, danp_congestion_get_default());
+
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, SERVER_PORT);
+    danp_listen(server_socket, 5);
+
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, CLIENT_PORT_BASE);
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, SERVER_PORT));
+    TEST_ASSERT_EQUAL_PTR(&counting_ops, client_socket->cc_ops);
+
+    danp_socket_t *accepted_socket = danp_accept(server_socket, 1000);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+    TEST_ASSERT_EQUAL_PTR(&counting_ops, accepted_socket->cc_ops);
+    TEST_ASSERT_TRUE(counting_init_calls >= 2);
+
+    TEST_ASSERT_EQUAL(4, danp_send(client_socket, "data", 4));
+    char buffer[8];
+    TEST_ASSERT_EQUAL(4, danp_recv(accepted_socket, buffer, sizeof(buffer), 1000));
+
+    /* Wait for the delayed ACK to reach the client */
+    for (int i = 0; i < 50 && counting_ack_calls == 0; i++)
+    {
+        osalDelayMs(10);
+    }
+    TEST_ASSERT_TRUE(counting_ack_calls > 0);
+
+    /* Per-socket override falls back to the default when NULL */
+    danp_congestion_set_default(NULL);
+    TEST_ASSERT_EQUAL(0, danp_socket_set_congestion(client_socket, NULL));
+    TEST_ASSERT_EQUAL_PTR(&danp_congestion_newreno, client_socket->cc_ops);
+
+    danp_close(client_socket);
+    danp_close(accepted_socket);
+    danp_close(server_socket);
+}
+
+/* ============================================================================
+ * Fairness Scenario
+ * ============================================================================
+ */
+
+typedef struct flow_s
+{
+    danp_socket_t *client;
+    danp_socket_t *server;
+    volatile uint32_t received;
+    volatile bool sender_done;
+    volatile bool receiver_done;
+} flow_t;
+
+static flow_t flows[FLOW_COUNT];
+static volatile bool flows_running = false;
+
+static void flow_sender(void *arg)
+{
+    flow_t *flow = (flow_t *)arg;
+    uint8_t chunk[FLOW_CHUNK_SIZE];
+
+    memset(chunk, 0xA5, sizeof(chunk));
+    while (flows_running)
+    {
+        if (danp_send(flow->client, chunk, sizeof(chunk)) < 0)
+        {
+            break;
+        }
+    }
+    flow->sender_done = true;
+}
+
+static void flow_receiver(void *arg)
+{
+    flow_t *flow = (flow_t *)arg;
+    uint8_t buffer[DANP_MAX_PACKET_SIZE];
+
+    while (flows_running)
+    {
+        int32_t len = danp_recv(flow->server, buffer, sizeof(buffer), 50);
+        if (len > 0)
+        {
+            flow->received += (uint32_t)len;
+        }
+    }
+    flow->receiver_done = true;
+}
+
+/**
+ * @brief Test that several connections share a bottleneck link fairly
+ *
+ * Three connections push data as fast as they can over a link that carries
+ * one frame per millisecond and tail-drops beyond LINK_QUEUE_DEPTH frames.
+ * Congestion control must keep every flow alive and the split even, which
+ * is measured with Jain's fairness index.
+ */
+void test_congestion_fair_share_on_limited_link(void)
+{
+    osalThreadAttr_t thread_attr = {
+        .name = "testFlow",
+        .stackSize = 1024 * 8,
+        .stackMem = NULL,
+        .priority = OSAL_THREAD_PRIORITY_NORMAL,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    TEST_ASSERT_EQUAL(0, danp_bind(server_socket, SERVER_PORT));
+    danp_listen(server_socket, FLOW_COUNT);
+
+    memset(flows, 0, sizeof(flows));
+    for (int i = 0; i < FLOW_COUNT; i++)
+    {
+        flows[i].client = danp_socket(DANP_TYPE_STREAM);
+        TEST_ASSERT_NOT_NULL(flows[i].client);
+        TEST_ASSERT_EQUAL(0, danp_bind(flows[i].client, (uint16_t)(CLIENT_PORT_BASE + i)));
+        TEST_ASSERT_EQUAL(0, danp_connect(flows[i].client, TEST_NODE_ID, SERVER_PORT));
+        flows[i].server = danp_accept(server_socket, 1000);
+        TEST_ASSERT_NOT_NULL(flows[i].server);
+    }
+
+    link_drops = 0;
+    flows_running = true;
+    for (int i = 0; i < FLOW_COUNT; i++)
+    {
+        TEST_ASSERT_NOT_NULL(osalThreadCreate(flow_receiver, &flows[i], &thread_attr));
+        TEST_ASSERT_NOT_NULL(osalThreadCreate(flow_sender, &flows[i], &thread_attr));
+    }
+
+    osalDelayMs(FLOW_DURATION_MS);
+    flows_running = false;
+
+    for (int i = 0; i < FLOW_COUNT; i++)
+    {
+        for (int wait = 0; wait < 200 && !(flows[i].sender_done && flows[i].receiver_done); wait++)
+        {
+            osalDelayMs(10);
+        }
+        TEST_ASSERT_TRUE(flows[i].sender_done && flows[i].receiver_done);
+    }
+
+    double sum = 0.0;
+    double sum_sq = 0.0;
+    for (int i = 0; i < FLOW_COUNT; i++)
+    {
+        TEST_ASSERT_TRUE(flows[i].received > 0);
+        sum += (double)flows[i].received;
+        sum_sq += (double)flows[i].received * (double)flows[i].received;
+    }
+    double jain = (sum * sum) / (FLOW_COUNT * sum_sq);
+
+    char message[64];
+    snprintf(message, sizeof(message), "Jain fairness index %.3f, link drops %u", jain, link_drops);
+    TEST_ASSERT_TRUE_MESSAGE(jain > 0.8, message);
+
+    for (int i = 0; i < FLOW_COUNT; i++)
+    {
+        danp_close(flows[i].client);
+        danp_close(flows[i].server);
+    }
+    danp_close(server_socket);
+}
+
+/* ============================================================================
+ * Test Runner
+ * ============================================================================
+ */
+
+/**
+ * @brief Main test runner
+ *
+ * Executes all congestion control tests in sequence
+ */
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_newreno_slow_start_grows_per_ack);
+    RUN_TEST(test_newreno_loss_reaction);
+    RUN_TEST(test_congestion_controller_is_pluggable);
+    RUN_TEST(test_congestion_fair_share_on_limited_link);
+
+    return UNITY_END();
+}
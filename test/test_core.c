@@ -10,6 +10,7 @@
 
 #include "danp/danp.h"
 #include "danp/danp_buffer.h"
+#include "osal/osal.h"
 #include "unity.h"
 #include <stdarg.h>
 #include <string.h>
@@ -322,6 +323,70 @@ void test_danp_input_drops_packets_for_other_nodes(void)
     TEST_ASSERT_EQUAL_UINT32(DANP_POOL_SIZE, danp_buffer_get_free_count());
 }
 
+void test_danp_input_packet_takes_ownership(void)
+{
+    ensure_core_interface(1);
+    danp_socket_t *sock = danp_socket(DANP_TYPE_DGRAM);
+    TEST_ASSERT_NOT_NULL(sock);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sock, 7));
+
+    /* A packet for this node is queued on the socket as is */
+    danp_packet_t *pkt = danp_buffer_allocate();
+    TEST_ASSERT_NOT_NULL(pkt);
+    pkt->header_raw = danp_pack_header(DANP_PRIORITY_NORMAL, 1, 2, 7, 9, DANP_FLAG_NONE);
+    pkt->length = 2;
+    pkt->payload[0] = 0xAA;
+    pkt->payload[1] = 0xBB;
+    danp_input_packet(&core_loopback_iface, pkt);
+    TEST_ASSERT_EQUAL_UINT32(DANP_POOL_SIZE - 1, danp_buffer_get_free_count());
+
+    uint8_t buffer[4] = {0};
+    TEST_ASSERT_EQUAL_INT32(2, danp_recv(sock, buffer, sizeof(buffer), 0));
+    TEST_ASSERT_EQUAL_HEX8(0xAA, buffer[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xBB, buffer[1]);
+    TEST_ASSERT_EQUAL_UINT32(DANP_POOL_SIZE, danp_buffer_get_free_count());
+
+    /* A packet for another node goes straight back to the pool */
+    pkt = danp_buffer_allocate();
+    TEST_ASSERT_NOT_NULL(pkt);
+    pkt->header_raw = danp_pack_header(DANP_PRIORITY_NORMAL, 2, 1, 7, 9, DANP_FLAG_NONE);
+    pkt->length = 0;
+    danp_input_packet(&core_loopback_iface, pkt);
+    TEST_ASSERT_EQUAL_UINT32(DANP_POOL_SIZE, danp_buffer_get_free_count());
+
+    danp_close(sock);
+}
+
+void test_danp_input_burst_delivers_in_order(void)
+{
+    ensure_core_interface(1);
+    danp_socket_t *sock = danp_socket(DANP_TYPE_DGRAM);
+    TEST_ASSERT_NOT_NULL(sock);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sock, 8));
+
+    /* The middle packet is for another node and is dropped on the way */
+    danp_packet_t *pkts[3];
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        pkts[i] = danp_buffer_allocate();
+        TEST_ASSERT_NOT_NULL(pkts[i]);
+        pkts[i]->header_raw = danp_pack_header(DANP_PRIORITY_NORMAL, (i == 1) ? 2 : 1, 2, 8, 9, DANP_FLAG_NONE);
+        pkts[i]->length = 1;
+        pkts[i]->payload[0] = (uint8_t)(0x10 + i);
+    }
+    danp_input_burst(&core_loopback_iface, pkts, 3);
+    TEST_ASSERT_EQUAL_UINT32(DANP_POOL_SIZE - 2, danp_buffer_get_free_count());
+
+    uint8_t value = 0;
+    TEST_ASSERT_EQUAL_INT32(1, danp_recv(sock, &value, 1, 0));
+    TEST_ASSERT_EQUAL_HEX8(0x10, value);
+    TEST_ASSERT_EQUAL_INT32(1, danp_recv(sock, &value, 1, 0));
+    TEST_ASSERT_EQUAL_HEX8(0x12, value);
+    TEST_ASSERT_EQUAL_UINT32(DANP_POOL_SIZE, danp_buffer_get_free_count());
+
+    danp_close(sock);
+}
+
 void test_buffer_free_handles_invalid_and_double_free(void)
 {
     danp_packet_t *pkt = danp_buffer_allocate();
@@ -366,6 +431,69 @@ void test_bind_detects_port_in_use(void)
     danp_close(second);
 }
 
+void test_socket_resources_follow_socket_type(void)
+{
+    danp_socket_footprint_t before;
+    danp_socket_footprint_t after;
+    danp_socket_t *socks[32];
+    danp_socket_t *listener;
+    danp_socket_t *idle;
+    uint32_t count = 0;
+    uint32_t start_ms;
+    uint8_t byte;
+
+    danp_socket_get_footprint(&before);
+    while (count < 32U && (socks[count] = danp_socket(DANP_TYPE_DGRAM)) != NULL)
+    {
+        TEST_ASSERT_NOT_NULL(socks[count]->rx_queue);
+        TEST_ASSERT_NULL(socks[count]->rx_buf);
+        count++;
+    }
+
+    // Every slot now holds exactly one queue and DGRAM sockets never need a semaphore.
+    danp_socket_get_footprint(&after);
+    TEST_ASSERT_EQUAL_UINT16(count, after.queues);
+    TEST_ASSERT_EQUAL_UINT16(before.semaphores, after.semaphores);
+    TEST_ASSERT_EQUAL_UINT32(count * DANP_RX_QUEUE_SIZE * sizeof(danp_packet_t *), after.queue_storage_bytes);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, after.pool_bytes);
+    TEST_ASSERT_EQUAL_UINT32(DANP_TX_BACKLOG_SIZE * sizeof(danp_packet_t), after.tx_backlog_bytes);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(DANP_STREAM_RX_RING_COUNT * DANP_STREAM_RX_BUFFER_SIZE, after.rx_ring_bytes);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(after.pool_bytes + after.rx_ring_bytes + after.tx_backlog_bytes, after.static_bytes);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        danp_close(socks[i]);
+    }
+
+    // Reused slots keep their objects.
+    for (uint32_t i = 0; i < count; i++)
+    {
+        socks[i] = danp_socket(DANP_TYPE_DGRAM);
+        TEST_ASSERT_NOT_NULL(socks[i]);
+    }
+    danp_socket_get_footprint(&before);
+    TEST_ASSERT_EQUAL_UINT16(after.queues, before.queues);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        danp_close(socks[i]);
+    }
+
+    // A listener gets its semaphore; an unconnected STREAM socket has nothing to wait for.
+    listener = danp_socket(DANP_TYPE_STREAM);
+    idle = danp_socket(DANP_TYPE_STREAM);
+    TEST_ASSERT_NOT_NULL(listener);
+    TEST_ASSERT_NOT_NULL(idle);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(listener, 7));
+    TEST_ASSERT_EQUAL_INT32(0, danp_listen(listener, 1));
+    TEST_ASSERT_NOT_NULL(listener->signal);
+
+    start_ms = osalGetTickMs();
+    TEST_ASSERT_EQUAL_INT32(0, danp_recv(idle, &byte, sizeof(byte), 1000));
+    TEST_ASSERT_LESS_THAN_UINT32(1000, osalGetTickMs() - start_ms);
+
+    danp_close(idle);
+    danp_close(listener);
+}
+
 void test_danp_print_stats_invokes_callback(void)
 {
     core_stats_print_calls = 0;
@@ -400,10 +528,13 @@ int main(void)
     RUN_TEST(test_danp_input_drops_short_packets);
     RUN_TEST(test_danp_input_handles_no_memory);
     RUN_TEST(test_danp_input_drops_packets_for_other_nodes);
+    RUN_TEST(test_danp_input_packet_takes_ownership);
+    RUN_TEST(test_danp_input_burst_delivers_in_order);
     RUN_TEST(test_buffer_free_handles_invalid_and_double_free);
     RUN_TEST(test_buffer_get_free_count_tracks_allocations);
     RUN_TEST(test_bind_rejects_invalid_port);
     RUN_TEST(test_bind_detects_port_in_use);
+    RUN_TEST(test_socket_resources_follow_socket_type);
     RUN_TEST(test_danp_print_stats_invokes_callback);
 
     return UNITY_END();
@@ -254,6 +254,117 @@ void test_dgram_recv_timeout_returns_error(void)
     danp_close(socket);
 }
 
+static volatile uint32_t data_ready_events = 0;
+
+static void count_data_ready(danp_socket_t *sock, danp_socket_event_t event, void *user_data)
+{
+    (void)sock;
+    (void)user_data;
+
+    if (event == DANP_EVENT_DATA_READY)
+    {
+        data_ready_events++;
+    }
+}
+
+/**
+ * @brief Test that a non-blocking DGRAM socket never waits and reports arrivals
+ */
+void test_dgram_nonblocking_recv_and_data_ready_event(void)
+{
+    char buffer[16];
+    uint16_t src_node = 0;
+    uint16_t src_port = 0;
+
+    danp_socket_t *socket_a = danp_socket(DANP_TYPE_DGRAM);
+    danp_bind(socket_a, PORT_A);
+    danp_socket_t *socket_b = danp_socket(DANP_TYPE_DGRAM);
+    danp_bind(socket_b, PORT_B);
+
+    data_ready_events = 0;
+    TEST_ASSERT_EQUAL_INT32(0, danp_setsockopt(socket_b, DANP_SO_NONBLOCK, 1));
+    TEST_ASSERT_EQUAL_INT32(0, danp_socket_set_callback(socket_b, count_data_ready, NULL));
+
+    TEST_ASSERT_EQUAL_INT32(
+        DANP_ERR_WOULD_BLOCK,
+        danp_recv_from(socket_b, buffer, sizeof(buffer), &src_node, &src_port, DANP_WAIT_FOREVER));
+    TEST_ASSERT_EQUAL_INT32(DANP_ERR_WOULD_BLOCK, danp_recv(socket_b, buffer, sizeof(buffer), DANP_WAIT_FOREVER));
+
+    TEST_ASSERT_EQUAL_INT32(3, danp_send_to(socket_a, "abc", 3, TEST_NODE_ID, PORT_B));
+    TEST_ASSERT_EQUAL_UINT32(1, data_ready_events);
+    TEST_ASSERT_EQUAL_INT32(3, danp_recv_from(socket_b, buffer, sizeof(buffer), &src_node, &src_port, 0));
+    TEST_ASSERT_EQUAL(PORT_A, src_port);
+
+    danp_close(socket_a);
+    danp_close(socket_b);
+}
+
+/**
+ * @brief Test that broadcasts reach every DGRAM socket and groups only their members
+ */
+void test_dgram_broadcast_and_multicast_groups(void)
+{
+    char buffer[16];
+    uint16_t src_node = 0;
+    uint16_t src_port = 0;
+
+    setup_loopback_interface();
+    danp_socket_t *socket_a = danp_socket(DANP_TYPE_DGRAM);
+    danp_bind(socket_a, PORT_A);
+    danp_socket_t *socket_b = danp_socket(DANP_TYPE_DGRAM);
+    danp_bind(socket_b, PORT_B);
+
+    TEST_ASSERT_EQUAL_INT32(3, danp_send_to(socket_a, "all", 3, DANP_BROADCAST_NODE, PORT_B));
+    TEST_ASSERT_EQUAL_INT32(3, danp_recv_from(socket_b, buffer, sizeof(buffer), &src_node, &src_port, 0));
+    TEST_ASSERT_EQUAL(TEST_NODE_ID, src_node);
+    TEST_ASSERT_EQUAL(PORT_A, src_port);
+
+    // Not a member yet, so the group datagram is dropped.
+    TEST_ASSERT_EQUAL_INT32(3, danp_send_to(socket_a, "grp", 3, 0xF1, PORT_B));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_recv_from(socket_b, buffer, sizeof(buffer), &src_node, &src_port, 0));
+
+    TEST_ASSERT_EQUAL_INT32(0, danp_setsockopt(socket_b, DANP_SO_JOIN_GROUP, 0xF1));
+    TEST_ASSERT_EQUAL_INT32(3, danp_send_to(socket_a, "grp", 3, 0xF1, PORT_B));
+    TEST_ASSERT_EQUAL_INT32(3, danp_recv_from(socket_b, buffer, sizeof(buffer), &src_node, &src_port, 0));
+    TEST_ASSERT_EQUAL_MEMORY("grp", buffer, 3);
+
+    TEST_ASSERT_EQUAL_INT32(3, danp_send_to(socket_a, "grp", 3, 0xF2, PORT_B));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_recv_from(socket_b, buffer, sizeof(buffer), &src_node, &src_port, 0));
+
+    TEST_ASSERT_EQUAL_INT32(0, danp_setsockopt(socket_b, DANP_SO_LEAVE_GROUP, 0xF1));
+    TEST_ASSERT_EQUAL_INT32(3, danp_send_to(socket_a, "grp", 3, 0xF1, PORT_B));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_recv_from(socket_b, buffer, sizeof(buffer), &src_node, &src_port, 0));
+
+    danp_close(socket_a);
+    danp_close(socket_b);
+}
+
+/**
+ * @brief Test that invalid group memberships and group connections are rejected
+ */
+void test_dgram_group_options_reject_invalid_use(void)
+{
+    danp_socket_t *dgram = danp_socket(DANP_TYPE_DGRAM);
+    danp_socket_t *stream = danp_socket(DANP_TYPE_STREAM);
+
+    TEST_ASSERT_EQUAL_INT32(-1, danp_setsockopt(dgram, DANP_SO_JOIN_GROUP, DANP_BROADCAST_NODE));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_setsockopt(dgram, DANP_SO_JOIN_GROUP, TEST_NODE_ID));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_setsockopt(dgram, DANP_SO_LEAVE_GROUP, 0xF4));
+    TEST_ASSERT_EQUAL_INT32(0, danp_setsockopt(dgram, DANP_SO_JOIN_GROUP, 0xF4));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_setsockopt(dgram, DANP_SO_JOIN_GROUP, 0xF4));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_setsockopt(stream, DANP_SO_JOIN_GROUP, 0xF4));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_connect(stream, DANP_BROADCAST_NODE, PORT_B));
+
+    // Closing leaves the group, so a fresh socket can join it again.
+    danp_close(dgram);
+    dgram = danp_socket(DANP_TYPE_DGRAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_setsockopt(dgram, DANP_SO_JOIN_GROUP, 0xF4));
+    TEST_ASSERT_EQUAL_INT32(0, danp_setsockopt(dgram, DANP_SO_LEAVE_GROUP, 0xF4));
+
+    danp_close(dgram);
+    danp_close(stream);
+}
+
 /* ============================================================================
  * Test Runner
  * ============================================================================
@@ -274,6 +385,9 @@ int main(void)
     RUN_TEST(test_dgram_socket_creation_and_binding);
     RUN_TEST(test_dgram_send_to_rejects_large_payload);
     RUN_TEST(test_dgram_recv_timeout_returns_error);
+    RUN_TEST(test_dgram_nonblocking_recv_and_data_ready_event);
+    RUN_TEST(test_dgram_broadcast_and_multicast_groups);
+    RUN_TEST(test_dgram_group_options_reject_invalid_use);
 
     return UNITY_END();
 }
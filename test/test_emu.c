@@ -0,0 +1,455 @@
+/**
+ * @file test_emu.c
+ * @brief Link emulator driver tests for DANP library
+ *
+ * The emulator "emu" sits in front of the loopback driver, so every packet the
+ * stack sends to node 1 is impaired on its way out and delivered back to the
+ * same node. The driver threads cannot be stopped, so the interfaces are
+ * created once and shared by all tests; each test sets its own impairments.
+ */
+
+#include "danp/danp.h"
+#include "danp/drivers/danp_emu.h"
+#include "danp/drivers/danp_lo.h"
+#include "osal/osal.h"
+#include "unity.h"
+#include <string.h>
+
+/* ============================================================================
+ * Test Configuration
+ * ============================================================================
+ */
+
+#define NODE_A 1
+#define PORT_TX 30
+#define PORT_RX 31
+
+static danp_lo_interface_t lo;
+static danp_emu_interface_t emu;
+static bool emu_ready = false;
+
+static void setup_emu_interface(void)
+{
+    if (!emu_ready)
+    {
+        danp_emu_config_t config = {
+            .name = "emu",
+            .lower = &lo.common,
+        };
+
+        TEST_ASSERT_EQUAL_INT32(0, danp_lo_init(&lo, NODE_A));
+        TEST_ASSERT_EQUAL_INT32(0, danp_emu_init(&emu, &config));
+        danp_register_interface(&emu);
+        emu_ready = true;
+    }
+
+    TEST_ASSERT_EQUAL_INT32(0, danp_route_table_load("1:emu"));
+}
+
+/**
+ * @brief Apply impairments and start the counters from zero
+ */
+static void set_params(const danp_emu_params_t *params)
+{
+    TEST_ASSERT_EQUAL_INT32(0, danp_emu_set_params(&emu, params));
+    memset(&emu.stats, 0, sizeof(emu.stats));
+}
+
+/**
+ * @brief Send count datagrams numbered 0..count-1 and collect what arrives, in arrival order
+ * @return Number of datagrams received before the link stayed quiet for quiet_ms.
+ */
+static uint32_t exchange(uint32_t count, uint8_t *order, uint32_t quiet_ms)
+{
+    danp_socket_t *sender = danp_socket(DANP_TYPE_DGRAM);
+    danp_socket_t *receiver = danp_socket(DANP_TYPE_DGRAM);
+    uint32_t received = 0;
+    uint8_t buffer[8];
+    uint16_t src_node = 0;
+    uint16_t src_port = 0;
+
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sender, PORT_TX));
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(receiver, PORT_RX));
+
+    // Collect while sending, so undelayed runs do not overflow the socket queue or the pool.
+    for (uint32_t i = 0; i <= count; i++)
+    {
+        if (i < count)
+        {
+            uint8_t seq = (uint8_t)i;
+            TEST_ASSERT_EQUAL_INT32(1, danp_send_to(sender, &seq, 1, NODE_A, PORT_RX));
+        }
+        for (;;)
+        {
+            int32_t len = danp_recv_from(receiver, buffer, sizeof(buffer), &src_node, &src_port, (i < count) ? 1 : quiet_ms);
+            if (len <= 0)
+            {
+                break;
+            }
+            TEST_ASSERT_EQUAL_INT32(1, len);
+            order[received++] = buffer[0];
+        }
+    }
+
+    danp_close(sender);
+    danp_close(receiver);
+    return received;
+}
+
+/* ============================================================================
+ * Test Setup and Teardown
+ * ============================================================================
+ */
+
+void setUp(void)
+{
+    danp_config_t config = {.local_node = NODE_A};
+    danp_init(&config);
+
+    setup_emu_interface();
+}
+
+void tearDown(void)
+{
+}
+
+/* ============================================================================
+ * Link Emulator Tests
+ * ============================================================================
+ */
+
+/**
+ * @brief Without impairments every packet passes in order
+ */
+void test_emu_passes_packets_unchanged(void)
+{
+    danp_emu_params_t params = {0};
+    uint8_t order[16];
+
+    set_params(&params);
+    TEST_ASSERT_EQUAL_UINT32(10, exchange(10, order, 100));
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(i, order[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(10, emu.stats.tx_packets);
+    TEST_ASSERT_EQUAL_UINT32(10, emu.stats.tx_delivered);
+    TEST_ASSERT_EQUAL_STRING("emu", emu.common.name);
+    TEST_ASSERT_EQUAL_UINT16(NODE_A, emu.common.address);
+    TEST_ASSERT_EQUAL_UINT16(lo.common.mtu, emu.common.mtu);
+}
+
+/**
+ * @brief Packets are held for the configured delay, and jitter does not reorder them
+ */
+void test_emu_delay_and_jitter(void)
+{
+    danp_emu_params_t params = {.delay_ms = 80};
+    danp_socket_t *sock = danp_socket(DANP_TYPE_DGRAM);
+    uint8_t order[16];
+    char buffer[8];
+
+    set_params(&params);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sock, PORT_RX));
+    uint32_t start_ms = osalGetTickMs();
+    TEST_ASSERT_EQUAL_INT32(4, danp_send_to(sock, "late", 4, NODE_A, PORT_RX));
+    TEST_ASSERT_EQUAL_UINT32(1, danp_emu_pending(&emu));
+    TEST_ASSERT_EQUAL_INT32(4, danp_recv(sock, buffer, sizeof(buffer), 1000));
+    uint32_t elapsed_ms = osalGetTickMs() - start_ms;
+    TEST_ASSERT_TRUE(elapsed_ms >= 80);
+    TEST_ASSERT_TRUE(elapsed_ms < 500);
+    danp_close(sock);
+
+    params.delay_ms = 20;
+    params.jitter_ms = 15;
+    params.seed = 3;
+    set_params(&params);
+    TEST_ASSERT_EQUAL_UINT32(16, exchange(16, order, 200));
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(i, order[i]);
+    }
+}
+
+/**
+ * @brief Lost packets never arrive, yet the sender sees them as sent
+ */
+void test_emu_loss(void)
+{
+    danp_emu_params_t params = {.loss_ppm = DANP_EMU_PPM};
+    uint8_t order[32];
+
+    set_params(&params);
+    TEST_ASSERT_EQUAL_UINT32(0, exchange(5, order, 100));
+    TEST_ASSERT_EQUAL_UINT32(5, emu.stats.tx_lost);
+
+    params.loss_ppm = DANP_EMU_PPM / 4U;
+    params.seed = 11;
+    set_params(&params);
+    uint32_t received = exchange(32, order, 100);
+    TEST_ASSERT_EQUAL_UINT32(32 - emu.stats.tx_lost, received);
+    TEST_ASSERT_TRUE(emu.stats.tx_lost > 0);
+    TEST_ASSERT_TRUE(emu.stats.tx_lost < 32);
+}
+
+/**
+ * @brief The same seed loses the same packets
+ */
+void test_emu_seed_repeats_run(void)
+{
+    danp_emu_params_t params = {.loss_ppm = DANP_EMU_PPM / 3U, .seed = 42};
+    uint8_t first[32];
+    uint8_t second[32];
+
+    set_params(&params);
+    uint32_t first_count = exchange(32, first, 100);
+    set_params(&params);
+    uint32_t second_count = exchange(32, second, 100);
+
+    TEST_ASSERT_EQUAL_UINT32(first_count, second_count);
+    TEST_ASSERT_EQUAL_MEMORY(first, second, first_count);
+}
+
+/**
+ * @brief Duplicated packets arrive twice
+ */
+void test_emu_duplication(void)
+{
+    danp_emu_params_t params = {.duplicate_ppm = DANP_EMU_PPM};
+    uint8_t order[16];
+
+    set_params(&params);
+    TEST_ASSERT_EQUAL_UINT32(8, exchange(4, order, 100));
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(i, order[2 * i]);
+        TEST_ASSERT_EQUAL_UINT8(i, order[2 * i + 1]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(4, emu.stats.tx_duplicated);
+}
+
+/**
+ * @brief Reordered packets overtake the delayed ones and nothing is lost
+ */
+void test_emu_reordering(void)
+{
+    danp_emu_params_t params = {.delay_ms = 40, .reorder_ppm = DANP_EMU_PPM / 4U, .seed = 5};
+    uint8_t order[16];
+    uint32_t inversions = 0;
+    uint32_t seen = 0;
+
+    set_params(&params);
+    TEST_ASSERT_EQUAL_UINT32(16, exchange(16, order, 200));
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        seen |= 1U << order[i];
+        if (i > 0 && order[i] < order[i - 1])
+        {
+            inversions++;
+        }
+    }
+    TEST_ASSERT_EQUAL_HEX32(0xFFFF, seen);
+    TEST_ASSERT_TRUE(emu.stats.tx_reordered > 0);
+    TEST_ASSERT_TRUE(inversions > 0);
+}
+
+/**
+ * @brief The line rate spaces packets by their serialization time
+ */
+void test_emu_rate_limit(void)
+{
+    // 8 bytes of header and payload take 8 ms at 8000 bit/s.
+    danp_emu_params_t params = {.rate_bps = 8000};
+    danp_socket_t *sender = danp_socket(DANP_TYPE_DGRAM);
+    danp_socket_t *receiver = danp_socket(DANP_TYPE_DGRAM);
+    char buffer[8];
+
+    set_params(&params);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sender, PORT_TX));
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(receiver, PORT_RX));
+    uint32_t start_ms = osalGetTickMs();
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        TEST_ASSERT_EQUAL_INT32(4, danp_send_to(sender, "rate", 4, NODE_A, PORT_RX));
+    }
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        TEST_ASSERT_EQUAL_INT32(4, danp_recv(receiver, buffer, sizeof(buffer), 1000));
+    }
+    uint32_t elapsed_ms = osalGetTickMs() - start_ms;
+    TEST_ASSERT_TRUE(elapsed_ms >= 80);
+    TEST_ASSERT_TRUE(elapsed_ms < 1000);
+
+    danp_close(sender);
+    danp_close(receiver);
+}
+
+/**
+ * @brief A full queue drops further packets
+ */
+void test_emu_queue_overflow(void)
+{
+    danp_emu_params_t params = {.delay_ms = 100};
+    danp_socket_t *sock = danp_socket(DANP_TYPE_DGRAM);
+    uint8_t seq = 0;
+
+    set_params(&params);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sock, PORT_TX));
+    for (uint32_t i = 0; i < DANP_EMU_QUEUE_DEPTH + 3U; i++)
+    {
+        TEST_ASSERT_EQUAL_INT32(1, danp_send_to(sock, &seq, 1, NODE_A, PORT_RX));
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, emu.stats.tx_queue_drops);
+    TEST_ASSERT_EQUAL_UINT32(DANP_EMU_QUEUE_DEPTH, danp_emu_pending(&emu));
+
+    // Nobody listens on PORT_RX; wait for the queue to drain into the stack.
+    for (uint32_t i = 0; i < 100 && danp_emu_pending(&emu) > 0; i++)
+    {
+        osalDelayMs(10);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, danp_emu_pending(&emu));
+    danp_close(sock);
+}
+
+/**
+ * @brief A STREAM transfer completes over a delayed, lossy link
+ */
+void test_emu_stream_over_lossy_link(void)
+{
+    danp_emu_params_t params = {.delay_ms = 5, .loss_ppm = DANP_EMU_PPM / 20U, .seed = 9};
+    uint8_t data[600];
+    uint8_t received[600];
+    uint32_t total = 0;
+
+    for (uint32_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)(i * 13U);
+    }
+    set_params(&params);
+
+    danp_socket_t *server = danp_socket(DANP_TYPE_STREAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(server, 41));
+    TEST_ASSERT_EQUAL_INT32(0, danp_listen(server, 1));
+
+    danp_socket_t *client = danp_socket(DANP_TYPE_STREAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(client, 40));
+    TEST_ASSERT_EQUAL_INT32(0, danp_connect(client, NODE_A, 41));
+
+    danp_socket_t *conn = danp_accept(server, 1000);
+    TEST_ASSERT_NOT_NULL(conn);
+
+    TEST_ASSERT_EQUAL_INT32((int32_t)sizeof(data), danp_send(client, data, sizeof(data)));
+    while (total < sizeof(received))
+    {
+        int32_t len = danp_recv(conn, received + total, (uint16_t)(sizeof(received) - total), 5000);
+        TEST_ASSERT_TRUE(len > 0);
+        total += (uint32_t)len;
+    }
+    TEST_ASSERT_EQUAL_MEMORY(data, received, sizeof(data));
+
+    danp_setsockopt(client, DANP_SO_LINGER, 0);
+    danp_close(client);
+    danp_close(conn);
+    danp_close(server);
+}
+
+/**
+ * @brief A STREAM connection survives a round trip longer than the SYN retry interval
+ *
+ * With 300 ms each way the client retries its SYN before the SYN-ACK is back, so
+ * the listener sees a duplicate SYN while half-open and the client a second
+ * SYN-ACK once established. Neither may reset the connection.
+ */
+void test_emu_stream_over_geo_delay(void)
+{
+    danp_emu_params_t params = {.delay_ms = 300, .seed = 11};
+    uint8_t data[400];
+    uint8_t received[400];
+    uint32_t total = 0;
+
+    for (uint32_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)(i * 7U);
+    }
+    set_params(&params);
+
+    danp_socket_t *server = danp_socket(DANP_TYPE_STREAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(server, 43));
+    TEST_ASSERT_EQUAL_INT32(0, danp_listen(server, 1));
+
+    danp_socket_t *client = danp_socket(DANP_TYPE_STREAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(client, 42));
+    TEST_ASSERT_EQUAL_INT32(0, danp_connect(client, NODE_A, 43));
+
+    danp_socket_t *conn = danp_accept(server, 2000);
+    TEST_ASSERT_NOT_NULL(conn);
+
+    TEST_ASSERT_EQUAL_INT32((int32_t)sizeof(data), danp_send(client, data, sizeof(data)));
+    while (total < sizeof(received))
+    {
+        int32_t len = danp_recv(conn, received + total, (uint16_t)(sizeof(received) - total), 5000);
+        TEST_ASSERT_TRUE(len > 0);
+        total += (uint32_t)len;
+    }
+    TEST_ASSERT_EQUAL_MEMORY(data, received, sizeof(data));
+
+    // Let the late SYN-ACK land, then check nothing was torn down or accepted twice.
+    osalDelayMs(700);
+    TEST_ASSERT_EQUAL(DANP_SOCK_ESTABLISHED, client->state);
+    TEST_ASSERT_EQUAL(DANP_SOCK_ESTABLISHED, conn->state);
+    TEST_ASSERT_NULL(danp_accept(server, 0));
+
+    danp_setsockopt(client, DANP_SO_LINGER, 0);
+    danp_close(client);
+    danp_close(conn);
+    danp_close(server);
+}
+
+/**
+ * @brief Invalid settings are rejected
+ */
+void test_emu_rejects_invalid_configuration(void)
+{
+    danp_emu_interface_t scratch;
+    danp_emu_params_t params = {.loss_ppm = DANP_EMU_PPM + 1U};
+    danp_emu_config_t config = {.lower = NULL};
+
+    TEST_ASSERT_EQUAL_INT32(-1, danp_emu_init(&scratch, &config));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_emu_init(NULL, &config));
+    config.lower = &scratch.common;
+    TEST_ASSERT_EQUAL_INT32(-1, danp_emu_init(&scratch, &config));
+    config.lower = &lo.common;
+    config.params = params;
+    TEST_ASSERT_EQUAL_INT32(-1, danp_emu_init(&scratch, &config));
+
+    TEST_ASSERT_EQUAL_INT32(-1, danp_emu_set_params(&emu, &params));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_emu_set_params(&emu, NULL));
+    TEST_ASSERT_EQUAL_UINT32(0, danp_emu_pending(NULL));
+}
+
+/* ============================================================================
+ * Test Runner
+ * ============================================================================
+ */
+
+/**
+ * @brief Main test runner
+ */
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_emu_passes_packets_unchanged);
+    RUN_TEST(test_emu_delay_and_jitter);
+    RUN_TEST(test_emu_loss);
+    RUN_TEST(test_emu_seed_repeats_run);
+    RUN_TEST(test_emu_duplication);
+    RUN_TEST(test_emu_reordering);
+    RUN_TEST(test_emu_rate_limit);
+    RUN_TEST(test_emu_queue_overflow);
+    RUN_TEST(test_emu_stream_over_lossy_link);
+    RUN_TEST(test_emu_stream_over_geo_delay);
+    RUN_TEST(test_emu_rejects_invalid_configuration);
+
+    return UNITY_END();
+}
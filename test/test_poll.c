@@ -0,0 +1,278 @@
+/**
+ * @file test_poll.c
+ * @brief Readiness multiplexing tests for DANP library
+ *
+ * This file contains unit tests for danp_poll() including:
+ * - DGRAM readability and timeouts
+ * - Acceptable listeners and readable/writable STREAM connections
+ * - Error reporting after a reset
+ * - Wake-up of a blocked poll by input from another thread
+ */
+
+#include "danp/danp.h"
+#include "osal/osal.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+
+/* ============================================================================
+ * Test Configuration
+ * ============================================================================
+ */
+
+/* Test node and port identifiers */
+#define TEST_NODE_ID 10  /* Local node ID for all tests */
+#define PORT_A 20        /* First test port */
+#define PORT_B 21        /* Second test port */
+#define PORT_C 22        /* Third test port */
+
+static danp_interface_t loopback_iface;
+static bool loopback_registered = false;
+
+static int32_t loopback_tx(void *iface_common, danp_packet_t *packet)
+{
+    danp_interface_t *iface = (danp_interface_t *)iface_common;
+    uint8_t buffer[DANP_HEADER_SIZE + DANP_MAX_PACKET_SIZE];
+
+    memcpy(buffer, &packet->header_raw, DANP_HEADER_SIZE);
+    if (packet->length > 0)
+    {
+        memcpy(buffer + DANP_HEADER_SIZE, packet->payload, packet->length);
+    }
+
+    danp_input(iface, buffer, DANP_HEADER_SIZE + packet->length);
+    return 0;
+}
+
+static void setup_loopback_interface(void)
+{
+    if (!loopback_registered)
+    {
+        memset(&loopback_iface, 0, sizeof(loopback_iface));
+        loopback_iface.name = "TEST_LOOPBACK_POLL";
+        loopback_iface.address = TEST_NODE_ID;
+        loopback_iface.mtu = 128;
+        loopback_iface.tx_func = loopback_tx;
+        loopback_iface.next = NULL;
+        danp_register_interface(&loopback_iface);
+        loopback_registered = true;
+    }
+
+    char route_entry[32];
+    int written = snprintf(route_entry, sizeof(route_entry), "%u:%s", TEST_NODE_ID, loopback_iface.name);
+    TEST_ASSERT_TRUE(written > 0 && written < (int)sizeof(route_entry));
+    TEST_ASSERT_EQUAL_INT32(0, danp_route_table_load(route_entry));
+}
+
+/* ============================================================================
+ * Test Setup and Teardown
+ * ============================================================================
+ */
+
+/**
+ * @brief Setup function called before each test
+ */
+void setUp(void)
+{
+    danp_config_t config = {.local_node = TEST_NODE_ID};
+    danp_init(&config);
+
+    setup_loopback_interface();
+}
+
+/**
+ * @brief Teardown function called after each test
+ */
+void tearDown(void)
+{
+    /* No cleanup needed for current tests */
+}
+
+/* ============================================================================
+ * Poll Tests
+ * ============================================================================
+ */
+
+/**
+ * @brief Test that a DGRAM socket polls readable once a datagram is queued
+ *
+ * Only the socket the datagram was sent to is reported, and it stops being
+ * readable once the datagram is received.
+ */
+void test_poll_dgram_readable(void)
+{
+    char buffer[16];
+
+    danp_socket_t *socket_a = danp_socket(DANP_TYPE_DGRAM);
+    danp_bind(socket_a, PORT_A);
+    danp_socket_t *socket_b = danp_socket(DANP_TYPE_DGRAM);
+    danp_bind(socket_b, PORT_B);
+
+    danp_pollfd_t fds[2] = {
+        {.sock = socket_a, .events = DANP_POLLIN},
+        {.sock = socket_b, .events = DANP_POLLIN},
+    };
+
+    TEST_ASSERT_EQUAL(0, danp_poll(fds, 2, 20));
+    TEST_ASSERT_EQUAL_UINT8(0, fds[0].revents);
+    TEST_ASSERT_EQUAL_UINT8(0, fds[1].revents);
+
+    TEST_ASSERT_EQUAL(4, danp_send_to(socket_a, "ping", 4, TEST_NODE_ID, PORT_B));
+
+    TEST_ASSERT_EQUAL(1, danp_poll(fds, 2, 0));
+    TEST_ASSERT_EQUAL_UINT8(0, fds[0].revents);
+    TEST_ASSERT_EQUAL_UINT8(DANP_POLLIN, fds[1].revents);
+
+    TEST_ASSERT_EQUAL(4, danp_recv(socket_b, buffer, sizeof(buffer), 0));
+    TEST_ASSERT_EQUAL(0, danp_poll(fds, 2, 0));
+
+    danp_close(socket_a);
+    danp_close(socket_b);
+}
+
+/**
+ * @brief Test listener, STREAM data and send window readiness
+ */
+void test_poll_stream_accept_readable_writable(void)
+{
+    char buffer[16];
+
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, PORT_A);
+    danp_listen(server_socket, 5);
+
+    danp_pollfd_t listen_fd = {.sock = server_socket, .events = DANP_POLLACCEPT};
+    TEST_ASSERT_EQUAL(0, danp_poll(&listen_fd, 1, 0));
+
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, PORT_B);
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, PORT_A));
+
+    TEST_ASSERT_EQUAL(1, danp_poll(&listen_fd, 1, 0));
+    TEST_ASSERT_EQUAL_UINT8(DANP_POLLACCEPT, listen_fd.revents);
+
+    danp_socket_t *accepted_socket = danp_accept(server_socket, 0);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+    TEST_ASSERT_EQUAL(0, danp_poll(&listen_fd, 1, 0));
+
+    danp_pollfd_t fds[2] = {
+        {.sock = client_socket, .events = DANP_POLLOUT},
+        {.sock = accepted_socket, .events = DANP_POLLIN},
+    };
+    TEST_ASSERT_EQUAL(1, danp_poll(fds, 2, 0));
+    TEST_ASSERT_EQUAL_UINT8(DANP_POLLOUT, fds[0].revents);
+    TEST_ASSERT_EQUAL_UINT8(0, fds[1].revents);
+
+    TEST_ASSERT_EQUAL(5, danp_send(client_socket, "hello", 5));
+    TEST_ASSERT_EQUAL(2, danp_poll(fds, 2, 0));
+    TEST_ASSERT_EQUAL_UINT8(DANP_POLLIN, fds[1].revents);
+
+    TEST_ASSERT_EQUAL(5, danp_recv(accepted_socket, buffer, sizeof(buffer), 0));
+    TEST_ASSERT_EQUAL(1, danp_poll(fds, 2, 0));
+    TEST_ASSERT_EQUAL_UINT8(0, fds[1].revents);
+
+    danp_close(client_socket);
+    danp_close(server_socket);
+}
+
+/**
+ * @brief Test that a reset connection reports DANP_POLLERR without asking for it
+ */
+void test_poll_reports_reset(void)
+{
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, PORT_A);
+    danp_listen(server_socket, 5);
+
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, PORT_B);
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, PORT_A));
+
+    danp_socket_t *accepted_socket = danp_accept(server_socket, 0);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+
+    /* A linger time of 0 resets the connection instead of shutting it down */
+    TEST_ASSERT_EQUAL(0, danp_setsockopt(client_socket, DANP_SO_LINGER, 0));
+    danp_close(client_socket);
+
+    danp_pollfd_t fd = {.sock = accepted_socket, .events = DANP_POLLOUT};
+    TEST_ASSERT_EQUAL(1, danp_poll(&fd, 1, 0));
+    TEST_ASSERT_EQUAL_UINT8(DANP_POLLERR, fd.revents);
+
+    danp_close(server_socket);
+}
+
+static danp_socket_t *delayed_sender;
+
+static void delayed_send_task(void *arg)
+{
+    (void)arg;
+
+    osalDelayMs(50);
+    danp_send_to(delayed_sender, "late", 4, TEST_NODE_ID, PORT_C);
+}
+
+/**
+ * @brief Test that input processed on another thread wakes a blocked poll
+ *
+ * One thread watches several sockets; the datagram arrives well before the
+ * timeout and only its socket is reported.
+ */
+void test_poll_wakes_on_input_from_other_thread(void)
+{
+    osalThreadAttr_t thread_attr = {
+        .name = "testPollTx",
+        .stackSize = 1024 * 8,
+        .stackMem = NULL,
+        .priority = OSAL_THREAD_PRIORITY_NORMAL,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+
+    danp_socket_t *socket_a = danp_socket(DANP_TYPE_DGRAM);
+    danp_bind(socket_a, PORT_A);
+    danp_socket_t *socket_b = danp_socket(DANP_TYPE_DGRAM);
+    danp_bind(socket_b, PORT_B);
+    danp_socket_t *socket_c = danp_socket(DANP_TYPE_DGRAM);
+    danp_bind(socket_c, PORT_C);
+
+    danp_pollfd_t fds[2] = {
+        {.sock = socket_b, .events = DANP_POLLIN},
+        {.sock = socket_c, .events = DANP_POLLIN},
+    };
+
+    delayed_sender = socket_a;
+    TEST_ASSERT_NOT_NULL(osalThreadCreate(delayed_send_task, NULL, &thread_attr));
+
+    uint32_t start_ms = osalGetTickMs();
+    TEST_ASSERT_EQUAL(1, danp_poll(fds, 2, 2000));
+    TEST_ASSERT_TRUE(osalGetTickMs() - start_ms < 1000);
+    TEST_ASSERT_EQUAL_UINT8(0, fds[0].revents);
+    TEST_ASSERT_EQUAL_UINT8(DANP_POLLIN, fds[1].revents);
+
+    danp_close(socket_a);
+    danp_close(socket_b);
+    danp_close(socket_c);
+}
+
+/* ============================================================================
+ * Test Runner
+ * ============================================================================
+ */
+
+/**
+ * @brief Main test runner
+ *
+ * Executes all poll tests in sequence
+ */
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_poll_dgram_readable);
+    RUN_TEST(test_poll_stream_accept_readable_writable);
+    RUN_TEST(test_poll_reports_reset);
+    RUN_TEST(test_poll_wakes_on_input_from_other_thread);
+
+    return UNITY_END();
+}
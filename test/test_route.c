@@ -17,6 +17,8 @@ static bool interfaces_registered = false;
 
 static uint32_t iface_a_tx_count = 0;
 static uint32_t iface_b_tx_count = 0;
+static uint32_t iface_a_group_calls = 0;
+static bool iface_a_group_joined = false;
 
 static int32_t iface_a_tx(void *iface_common, danp_packet_t *packet)
 {
@@ -34,6 +36,15 @@ static int32_t iface_b_tx(void *iface_common, danp_packet_t *packet)
     return 0;
 }
 
+static int32_t iface_a_group(void *iface_common, uint16_t group, bool join)
+{
+    (void)iface_common;
+    (void)group;
+    iface_a_group_calls++;
+    iface_a_group_joined = join;
+    return 0;
+}
+
 static void init_test_interfaces(void)
 {
     if (!interfaces_registered)
@@ -42,6 +53,7 @@ static void init_test_interfaces(void)
         iface_a.address = 1;
         iface_a.mtu = 128;
         iface_a.tx_func = iface_a_tx;
+        iface_a.group_func = iface_a_group;
         iface_a.next = NULL;
 
         iface_b.name = "IFACE_B";
@@ -192,6 +204,52 @@ void test_route_tx_handles_missing_inputs(void)
     TEST_ASSERT_EQUAL_INT32(-1, danp_route_tx(&pkt));
 }
 
+void test_route_tx_sends_group_packets_on_every_interface(void)
+{
+    danp_packet_t pkt;
+
+    prepare_packet(&pkt, DANP_BROADCAST_NODE, 8);
+    TEST_ASSERT_EQUAL_INT32(0, danp_route_tx(&pkt));
+    TEST_ASSERT_EQUAL_UINT32(1, iface_a_tx_count);
+    TEST_ASSERT_EQUAL_UINT32(1, iface_b_tx_count);
+
+    iface_b.mtu = 16;
+    TEST_ASSERT_EQUAL_UINT16(16 - DANP_HEADER_SIZE, danp_route_get_max_payload(0xF3));
+    prepare_packet(&pkt, 0xF3, 32);
+    TEST_ASSERT_EQUAL_INT32(0, danp_route_tx(&pkt));
+    TEST_ASSERT_EQUAL_UINT32(2, iface_a_tx_count);
+    TEST_ASSERT_EQUAL_UINT32(1, iface_b_tx_count);
+
+    // An explicit route confines the group to one link.
+    TEST_ASSERT_EQUAL_INT32(0, danp_route_table_load("255:IFACE_B"));
+    prepare_packet(&pkt, DANP_BROADCAST_NODE, 8);
+    TEST_ASSERT_EQUAL_INT32(0, danp_route_tx(&pkt));
+    TEST_ASSERT_EQUAL_UINT32(2, iface_a_tx_count);
+    TEST_ASSERT_EQUAL_UINT32(2, iface_b_tx_count);
+}
+
+void test_route_group_update_notifies_on_first_join_and_last_leave(void)
+{
+    iface_a_group_calls = 0;
+
+    TEST_ASSERT_EQUAL_INT32(0, danp_route_group_update(0xF1, true));
+    TEST_ASSERT_EQUAL_UINT32(1, iface_a_group_calls);
+    TEST_ASSERT_TRUE(iface_a_group_joined);
+    TEST_ASSERT_EQUAL_INT32(0, danp_route_group_update(0xF1, true));
+    TEST_ASSERT_EQUAL_UINT32(1, iface_a_group_calls);
+
+    TEST_ASSERT_EQUAL_INT32(0, danp_route_group_update(0xF1, false));
+    TEST_ASSERT_EQUAL_UINT32(1, iface_a_group_calls);
+    TEST_ASSERT_EQUAL_INT32(0, danp_route_group_update(0xF1, false));
+    TEST_ASSERT_EQUAL_UINT32(2, iface_a_group_calls);
+    TEST_ASSERT_FALSE(iface_a_group_joined);
+
+    TEST_ASSERT_EQUAL_INT32(-1, danp_route_group_update(0xF1, false));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_route_group_update(DANP_BROADCAST_NODE, true));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_route_group_update(42, true));
+    TEST_ASSERT_EQUAL_UINT32(2, iface_a_group_calls);
+}
+
 /* ============================================================================
  * Test Runner
  * ============================================================================
@@ -207,6 +265,8 @@ int main(void)
     RUN_TEST(test_route_register_interface_validates_inputs);
     RUN_TEST(test_route_table_load_errors_and_whitespace);
     RUN_TEST(test_route_tx_handles_missing_inputs);
+    RUN_TEST(test_route_tx_sends_group_packets_on_every_interface);
+    RUN_TEST(test_route_group_update_notifies_on_first_join_and_last_leave);
 
     return UNITY_END();
 }
@@ -0,0 +1,441 @@
+/**
+ * @file test_serial.c
+ * @brief Serial driver tests for DANP library
+ *
+ * Two pseudo-terminal pairs stand in for UART links, one per framing:
+ * - serA (address 1) on the COBS pair's master talks to serB (address 2),
+ *   which opens the slave by its device path at 115200 baud
+ * - serC (address 3) on the KISS pair's master talks to serD (address 4) on
+ *   the slave, serviced by an io_uring loop when the build and kernel have it
+ * The stack has a single node, so every interface delivers what is addressed
+ * to its own address. The driver threads cannot be stopped, so the interfaces
+ * are created once and shared by all tests.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* posix_openpt, ptsname */
+#endif
+
+#include "danp/danp.h"
+#include "danp/drivers/danp_serial.h"
+#ifdef DANP_URING_SUPPORT
+#include "danp/drivers/danp_uring.h"
+#endif
+#include "osal/osal.h"
+#include "unity.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ============================================================================
+ * Test Configuration
+ * ============================================================================
+ */
+
+#define NODE_A 1
+#define NODE_B 2
+#define NODE_C 3
+#define NODE_D 4
+
+static danp_serial_interface_t ser_a;
+static danp_serial_interface_t ser_b;
+static danp_serial_interface_t ser_c;
+static danp_serial_interface_t ser_d;
+static bool serial_ready = false;
+#ifdef DANP_URING_SUPPORT
+static danp_uring_t loop;
+#endif
+
+static int open_pty_master(void)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    TEST_ASSERT_TRUE(master >= 0);
+    TEST_ASSERT_EQUAL_INT(0, grantpt(master));
+    TEST_ASSERT_EQUAL_INT(0, unlockpt(master));
+    return master;
+}
+
+static void setup_serial_interfaces(void)
+{
+    if (!serial_ready)
+    {
+        int cobs_master = open_pty_master();
+        int kiss_master = open_pty_master();
+        int kiss_slave = open(ptsname(kiss_master), O_RDWR | O_NOCTTY);
+        TEST_ASSERT_TRUE(kiss_slave >= 0);
+
+        danp_serial_config_t config_a = {
+            .name = "serA",
+            .address = NODE_A,
+            .fd = cobs_master,
+            .framing = DANP_SERIAL_FRAMING_COBS,
+        };
+        danp_serial_config_t config_b = {
+            .name = "serB",
+            .address = NODE_B,
+            .device = ptsname(cobs_master),
+            .baud = 115200,
+            .framing = DANP_SERIAL_FRAMING_COBS,
+        };
+        danp_serial_config_t config_c = {
+            .name = "serC",
+            .address = NODE_C,
+            .fd = kiss_master,
+            .framing = DANP_SERIAL_FRAMING_KISS,
+        };
+        danp_serial_config_t config_d = {
+            .name = "serD",
+            .address = NODE_D,
+            .fd = kiss_slave,
+            .framing = DANP_SERIAL_FRAMING_KISS,
+        };
+#ifdef DANP_URING_SUPPORT
+        if (danp_uring_init(&loop) == 0)
+        {
+            config_d.uring = &loop;
+        }
+#endif
+
+        TEST_ASSERT_EQUAL_INT32(0, danp_serial_init(&ser_a, &config_a));
+        TEST_ASSERT_EQUAL_INT32(0, danp_serial_init(&ser_b, &config_b));
+        TEST_ASSERT_EQUAL_INT32(0, danp_serial_init(&ser_c, &config_c));
+        TEST_ASSERT_EQUAL_INT32(0, danp_serial_init(&ser_d, &config_d));
+        danp_register_interface(&ser_a);
+        danp_register_interface(&ser_b);
+        danp_register_interface(&ser_c);
+        danp_register_interface(&ser_d);
+        serial_ready = true;
+    }
+
+    TEST_ASSERT_EQUAL_INT32(0, danp_route_table_load("2:serA, 1:serB, 4:serC, 3:serD"));
+}
+
+/* ============================================================================
+ * Reference Encoder
+ * ============================================================================
+ */
+
+static uint16_t reference_crc(const uint8_t *data, uint32_t length)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (uint32_t i = 0; i < length; i++)
+    {
+        crc ^= (uint16_t)(data[i] << 8);
+        for (uint32_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000U) ? (uint16_t)((crc << 1) ^ 0x1021U) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief COBS-encode header, payload and the given CRC, as a peer would put them on the line
+ */
+static uint32_t reference_cobs_frame(uint32_t header, const char *payload, uint16_t crc, uint8_t *out)
+{
+    uint8_t raw[DANP_HEADER_SIZE + DANP_MAX_PACKET_SIZE + DANP_SERIAL_CRC_SIZE];
+    uint32_t length = (uint32_t)strlen(payload);
+    uint32_t code_pos = 0;
+    uint32_t pos = 1;
+
+    memcpy(raw, &header, DANP_HEADER_SIZE);
+    memcpy(raw + DANP_HEADER_SIZE, payload, length);
+    length += DANP_HEADER_SIZE;
+    raw[length++] = (uint8_t)(crc >> 8);
+    raw[length++] = (uint8_t)crc;
+
+    for (uint32_t i = 0; i < length; i++)
+    {
+        if (raw[i] == 0)
+        {
+            out[code_pos] = (uint8_t)(pos - code_pos);
+            code_pos = pos++;
+        }
+        else
+        {
+            out[pos++] = raw[i];
+        }
+    }
+    out[code_pos] = (uint8_t)(pos - code_pos);
+    out[pos++] = 0;
+    return pos;
+}
+
+/* ============================================================================
+ * Test Setup and Teardown
+ * ============================================================================
+ */
+
+void setUp(void)
+{
+    danp_config_t config = {.local_node = NODE_A};
+    danp_init(&config);
+
+    setup_serial_interfaces();
+}
+
+void tearDown(void)
+{
+}
+
+/* ============================================================================
+ * Serial Driver Tests
+ * ============================================================================
+ */
+
+static void assert_round_trip(uint16_t node_from, uint16_t node_to, uint8_t port_from, uint8_t port_to)
+{
+    danp_socket_t *sock_from = danp_socket(DANP_TYPE_DGRAM);
+    danp_socket_t *sock_to = danp_socket(DANP_TYPE_DGRAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sock_from, port_from));
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sock_to, port_to));
+
+    TEST_ASSERT_EQUAL_INT32(4, danp_send_to(sock_from, "ping", 4, node_to, port_to));
+
+    char buffer[16] = {0};
+    uint16_t src_node = 0;
+    uint16_t src_port = 0;
+    TEST_ASSERT_EQUAL_INT32(4, danp_recv_from(sock_to, buffer, sizeof(buffer), &src_node, &src_port, 1000));
+    TEST_ASSERT_EQUAL_MEMORY("ping", buffer, 4);
+    TEST_ASSERT_EQUAL_UINT16(port_from, src_port);
+
+    TEST_ASSERT_EQUAL_INT32(4, danp_send_to(sock_to, "pong", 4, node_from, port_from));
+    TEST_ASSERT_EQUAL_INT32(4, danp_recv_from(sock_from, buffer, sizeof(buffer), &src_node, &src_port, 1000));
+    TEST_ASSERT_EQUAL_MEMORY("pong", buffer, 4);
+
+    danp_close(sock_from);
+    danp_close(sock_to);
+}
+
+/**
+ * @brief A datagram and its reply cross the COBS pair in both directions
+ */
+void test_serial_cobs_dgram_round_trip(void)
+{
+    uint32_t tx_frames = ser_a.stats.tx_frames;
+
+    assert_round_trip(NODE_A, NODE_B, 30, 31);
+    TEST_ASSERT_EQUAL_UINT32(tx_frames + 1, ser_a.stats.tx_frames);
+    TEST_ASSERT_TRUE(ser_b.stats.rx_frames >= 1);
+}
+
+/**
+ * @brief A datagram and its reply cross the KISS pair in both directions
+ */
+void test_serial_kiss_dgram_round_trip(void)
+{
+    assert_round_trip(NODE_C, NODE_D, 32, 33);
+}
+
+/**
+ * @brief Payloads full of delimiter and escape bytes arrive unchanged with either framing
+ */
+void test_serial_payloads_with_framing_bytes_are_transparent(void)
+{
+    static const uint8_t specials[] = {0x00, 0xC0, 0xDB, 0xDC, 0xDD, 0xFF, 0x01};
+    uint8_t payload[DANP_MAX_PACKET_SIZE - DANP_HEADER_SIZE];
+    uint8_t received[DANP_MAX_PACKET_SIZE - DANP_HEADER_SIZE];
+    uint16_t src_node = 0;
+    uint16_t src_port = 0;
+
+    for (uint32_t i = 0; i < sizeof(payload); i++)
+    {
+        payload[i] = specials[i % sizeof(specials)];
+    }
+
+    danp_socket_t *sender = danp_socket(DANP_TYPE_DGRAM);
+    danp_socket_t *receiver = danp_socket(DANP_TYPE_DGRAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sender, 34));
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(receiver, 35));
+
+    const uint16_t nodes[] = {NODE_B, NODE_D};
+    for (uint32_t n = 0; n < 2; n++)
+    {
+        TEST_ASSERT_EQUAL_INT32(
+            (int32_t)sizeof(payload), danp_send_to(sender, payload, sizeof(payload), nodes[n], 35));
+        memset(received, 0x55, sizeof(received));
+        TEST_ASSERT_EQUAL_INT32(
+            (int32_t)sizeof(received),
+            danp_recv_from(receiver, received, sizeof(received), &src_node, &src_port, 1000));
+        TEST_ASSERT_EQUAL_MEMORY(payload, received, sizeof(payload));
+    }
+
+    // A payload without a single zero is one long COBS block.
+    memset(payload, 0xFF, sizeof(payload));
+    TEST_ASSERT_EQUAL_INT32((int32_t)sizeof(payload), danp_send_to(sender, payload, sizeof(payload), NODE_B, 35));
+    TEST_ASSERT_EQUAL_INT32(
+        (int32_t)sizeof(received), danp_recv_from(receiver, received, sizeof(received), &src_node, &src_port, 1000));
+    TEST_ASSERT_EQUAL_MEMORY(payload, received, sizeof(payload));
+
+    danp_close(sender);
+    danp_close(receiver);
+}
+
+/**
+ * @brief Line noise and corrupted frames are dropped, and a frame trickling in byte by byte survives
+ */
+void test_serial_rejects_noise_and_bad_crc(void)
+{
+    uint8_t frame[DANP_SERIAL_FRAME_MAX];
+    uint8_t raw[DANP_HEADER_SIZE + 6];
+    uint32_t header = danp_pack_header(DANP_PRIORITY_NORMAL, NODE_B, 9, 36, 37, DANP_FLAG_NONE);
+    char buffer[16] = {0};
+    uint16_t src_node = 0;
+    uint16_t src_port = 0;
+
+    memcpy(raw, &header, DANP_HEADER_SIZE);
+    memcpy(raw + DANP_HEADER_SIZE, "serial", 6);
+    uint16_t crc = reference_crc(raw, sizeof(raw));
+
+    danp_socket_t *sock = danp_socket(DANP_TYPE_DGRAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sock, 36));
+    uint32_t crc_errors = ser_b.stats.rx_crc_errors;
+    uint32_t drops = ser_b.stats.rx_drops;
+
+    // The master end writes what serB reads: noise, a frame with a wrong CRC, then a good frame.
+    TEST_ASSERT_EQUAL_INT(4, write(ser_a.fd, "\x11\x22\x33\x00", 4));
+    uint32_t length = reference_cobs_frame(header, "serial", (uint16_t)(crc ^ 0x0100U), frame);
+    TEST_ASSERT_EQUAL_INT((int)length, write(ser_a.fd, frame, length));
+    length = reference_cobs_frame(header, "serial", crc, frame);
+    for (uint32_t i = 0; i < length; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(1, write(ser_a.fd, &frame[i], 1));
+        osalDelayMs(1);
+    }
+
+    TEST_ASSERT_EQUAL_INT32(6, danp_recv_from(sock, buffer, sizeof(buffer), &src_node, &src_port, 1000));
+    TEST_ASSERT_EQUAL_MEMORY("serial", buffer, 6);
+    TEST_ASSERT_EQUAL_UINT16(9, src_node);
+    TEST_ASSERT_EQUAL_INT32(-1, danp_recv_from(sock, buffer, sizeof(buffer), &src_node, &src_port, 50));
+    TEST_ASSERT_EQUAL_UINT32(crc_errors + 1, ser_b.stats.rx_crc_errors);
+    TEST_ASSERT_EQUAL_UINT32(drops + 1, ser_b.stats.rx_drops);
+
+    danp_close(sock);
+}
+
+/**
+ * @brief KISS frames with another command byte than data are ignored
+ */
+void test_serial_kiss_ignores_command_frames(void)
+{
+    danp_socket_t *sender = danp_socket(DANP_TYPE_DGRAM);
+    danp_socket_t *receiver = danp_socket(DANP_TYPE_DGRAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sender, 38));
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(receiver, 39));
+    uint32_t drops = ser_d.stats.rx_drops;
+
+    // TXDELAY command, then a data frame from the stack.
+    TEST_ASSERT_EQUAL_INT(4, write(ser_c.fd, "\xC0\x01\x32\xC0", 4));
+    TEST_ASSERT_EQUAL_INT32(3, danp_send_to(sender, "tnc", 3, NODE_D, 39));
+
+    char buffer[8] = {0};
+    TEST_ASSERT_EQUAL_INT32(3, danp_recv(receiver, buffer, sizeof(buffer), 1000));
+    TEST_ASSERT_EQUAL_MEMORY("tnc", buffer, 3);
+    TEST_ASSERT_EQUAL_UINT32(drops, ser_d.stats.rx_drops);
+
+    danp_close(sender);
+    danp_close(receiver);
+}
+
+/**
+ * @brief A STREAM connection is established and carries data over the COBS pair
+ *
+ * Replies are sourced from the single local node, so both directions of the
+ * connection address node 1 and cross the line from serB to serA.
+ */
+void test_serial_stream_transfer(void)
+{
+    uint8_t data[600];
+    uint8_t received[600];
+    uint32_t total = 0;
+
+    for (uint32_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)(i * 7U);
+    }
+
+    danp_socket_t *server = danp_socket(DANP_TYPE_STREAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(server, 41));
+    TEST_ASSERT_EQUAL_INT32(0, danp_listen(server, 1));
+
+    danp_socket_t *client = danp_socket(DANP_TYPE_STREAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(client, 40));
+    TEST_ASSERT_EQUAL_INT32(0, danp_connect(client, NODE_A, 41));
+
+    danp_socket_t *conn = danp_accept(server, 1000);
+    TEST_ASSERT_NOT_NULL(conn);
+
+    TEST_ASSERT_EQUAL_INT32((int32_t)sizeof(data), danp_send(client, data, sizeof(data)));
+    while (total < sizeof(received))
+    {
+        int32_t len = danp_recv(conn, received + total, (uint16_t)(sizeof(received) - total), 2000);
+        TEST_ASSERT_TRUE(len > 0);
+        total += (uint32_t)len;
+    }
+    TEST_ASSERT_EQUAL_MEMORY(data, received, sizeof(data));
+
+    danp_setsockopt(client, DANP_SO_LINGER, 0);
+    danp_close(client);
+    danp_close(conn);
+    danp_close(server);
+}
+
+/**
+ * @brief Invalid settings and devices are rejected
+ */
+void test_serial_rejects_invalid_configuration(void)
+{
+    danp_serial_interface_t scratch;
+    int pipe_fds[2];
+    int master = open_pty_master();
+    danp_serial_config_t config = {
+        .address = 9,
+        .fd = master,
+        .baud = 12345,
+        .framing = DANP_SERIAL_FRAMING_COBS,
+    };
+
+    TEST_ASSERT_EQUAL_INT32(-1, danp_serial_init(&scratch, &config));
+    config.baud = 0;
+    config.framing = (danp_serial_framing_t)7;
+    TEST_ASSERT_EQUAL_INT32(-1, danp_serial_init(&scratch, &config));
+    config.framing = DANP_SERIAL_FRAMING_KISS;
+    config.device = "/dev/danp-no-such-tty";
+    TEST_ASSERT_EQUAL_INT32(-1, danp_serial_init(&scratch, &config));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_serial_init(NULL, &config));
+
+    TEST_ASSERT_EQUAL_INT(0, pipe(pipe_fds));
+    config.device = NULL;
+    config.fd = pipe_fds[0];
+    TEST_ASSERT_EQUAL_INT32(-1, danp_serial_init(&scratch, &config));
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    close(master);
+}
+
+/* ============================================================================
+ * Test Runner
+ * ============================================================================
+ */
+
+/**
+ * @brief Main test runner
+ */
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_serial_cobs_dgram_round_trip);
+    RUN_TEST(test_serial_kiss_dgram_round_trip);
+    RUN_TEST(test_serial_payloads_with_framing_bytes_are_transparent);
+    RUN_TEST(test_serial_rejects_noise_and_bad_crc);
+    RUN_TEST(test_serial_kiss_ignores_command_frames);
+    RUN_TEST(test_serial_stream_transfer);
+    RUN_TEST(test_serial_rejects_invalid_configuration);
+
+    return UNITY_END();
+}
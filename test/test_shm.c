@@ -0,0 +1,332 @@
+/**
+ * @file test_shm.c
+ * @brief Shared-memory driver tests for DANP library
+ *
+ * The tests run two processes on one host. The test binary re-executes itself
+ * as the peer (node 2), which echoes datagrams on PEER_ECHO_PORT and STREAM
+ * data on PEER_STREAM_PORT; the tests run as node 1 and talk to it through
+ * a segment private to this run.
+ */
+
+#include "danp/danp.h"
+#include "danp/drivers/danp_shm.h"
+#include "osal/osal.h"
+#include "unity.h"
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* ============================================================================
+ * Test Configuration
+ * ============================================================================
+ */
+
+#define NODE_LOCAL 1
+#define NODE_PEER 2
+#define LOCAL_PORT 20
+#define PEER_ECHO_PORT 30
+#define PEER_STREAM_PORT 31
+#define PEER_ARG "--shm-peer"
+
+static danp_shm_interface_t shm_iface;
+static char segment_name[DANP_SHM_NAME_MAX];
+static pid_t peer_pid = -1;
+static bool peer_ready = false;
+
+/* ============================================================================
+ * Peer Process
+ * ============================================================================
+ */
+
+static void peer_dgram_echo_task(void *arg)
+{
+    danp_socket_t *sock = (danp_socket_t *)arg;
+    uint8_t buffer[DANP_MAX_PACKET_SIZE];
+    uint16_t src_node = 0;
+    uint16_t src_port = 0;
+
+    for (;;)
+    {
+        int32_t len = danp_recv_from(sock, buffer, sizeof(buffer), &src_node, &src_port, DANP_WAIT_FOREVER);
+        if (len > 0)
+        {
+            danp_send_to(sock, buffer, (uint16_t)len, src_node, src_port);
+        }
+    }
+}
+
+/**
+ * @brief Body of the peer process: echo services on node 2 until killed
+ */
+static int run_peer(const char *segment)
+{
+    static danp_shm_interface_t peer_iface;
+    danp_config_t config = {.local_node = NODE_PEER};
+    danp_shm_config_t shm_config = {
+        .address = NODE_PEER,
+        .peer = NODE_LOCAL,
+        .segment = segment,
+    };
+    osalThreadAttr_t thread_attr = {
+        .name = "shmPeerEcho",
+        .stackSize = 1024 * 16,
+        .stackMem = NULL,
+        .priority = OSAL_THREAD_PRIORITY_NORMAL,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+    uint8_t buffer[256];
+
+    danp_init(&config);
+    if (danp_shm_init(&peer_iface, &shm_config) != 0)
+    {
+        return 1;
+    }
+    danp_register_interface(&peer_iface);
+    danp_route_table_load("1:SHM");
+
+    danp_socket_t *echo = danp_socket(DANP_TYPE_DGRAM);
+    danp_bind(echo, PEER_ECHO_PORT);
+    osalThreadCreate(peer_dgram_echo_task, echo, &thread_attr);
+
+    danp_socket_t *server = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server, PEER_STREAM_PORT);
+    danp_listen(server, 1);
+    for (;;)
+    {
+        danp_socket_t *conn = danp_accept(server, DANP_WAIT_FOREVER);
+        if (conn == NULL)
+        {
+            continue;
+        }
+        for (;;)
+        {
+            int32_t len = danp_recv(conn, buffer, sizeof(buffer), DANP_WAIT_FOREVER);
+            if (len <= 0 || danp_send(conn, buffer, (uint32_t)len) != len)
+            {
+                break;
+            }
+        }
+        danp_close(conn);
+    }
+
+    return 0;
+}
+
+static void start_peer(void)
+{
+    snprintf(segment_name, sizeof(segment_name), "/danp-test-%d", (int)getpid());
+    danp_shm_unlink(segment_name);
+
+    peer_pid = fork();
+    TEST_ASSERT_TRUE(peer_pid >= 0);
+    if (peer_pid == 0)
+    {
+        execl("/proc/self/exe", "test_shm", PEER_ARG, segment_name, (char *)NULL);
+        _exit(127);
+    }
+}
+
+static void stop_peer(void)
+{
+    if (peer_pid > 0)
+    {
+        kill(peer_pid, SIGKILL);
+        waitpid(peer_pid, NULL, 0);
+        peer_pid = -1;
+    }
+    danp_shm_unlink(segment_name);
+}
+
+/* ============================================================================
+ * Test Setup and Teardown
+ * ============================================================================
+ */
+
+void setUp(void)
+{
+    danp_config_t config = {.local_node = NODE_LOCAL};
+    danp_init(&config);
+
+    if (peer_pid < 0)
+    {
+        danp_shm_config_t shm_config = {
+            .address = NODE_LOCAL,
+            .peer = NODE_PEER,
+            .segment = NULL,
+        };
+
+        start_peer();
+        shm_config.segment = segment_name;
+        TEST_ASSERT_EQUAL_INT32(0, danp_shm_init(&shm_iface, &shm_config));
+        danp_register_interface(&shm_iface);
+    }
+    TEST_ASSERT_EQUAL_INT32(0, danp_route_table_load("2:SHM"));
+}
+
+void tearDown(void)
+{
+    /* The peer process serves every test and is stopped from main() */
+}
+
+/**
+ * @brief Send a datagram to the echo service and wait for it to come back
+ */
+static int32_t echo_once(danp_socket_t *sock, const void *data, uint16_t len, void *reply, uint32_t timeout_ms)
+{
+    danp_send_to(sock, (void *)data, len, NODE_PEER, PEER_ECHO_PORT);
+    return danp_recv(sock, reply, DANP_MAX_PACKET_SIZE, timeout_ms);
+}
+
+/* ============================================================================
+ * Shared-Memory Driver Tests
+ * ============================================================================
+ */
+
+/**
+ * @brief A datagram crosses to the peer process and its echo comes back
+ */
+void test_shm_dgram_round_trip_between_processes(void)
+{
+    danp_socket_t *sock = danp_socket(DANP_TYPE_DGRAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sock, LOCAL_PORT));
+    uint8_t reply[DANP_MAX_PACKET_SIZE] = {0};
+    int32_t len = -1;
+
+    /* The peer binds its sockets some time after start; probe until it answers */
+    for (uint32_t attempt = 0; attempt < 50 && len <= 0; attempt++)
+    {
+        len = echo_once(sock, "ping", 4, reply, 100);
+    }
+    TEST_ASSERT_EQUAL_INT32(4, len);
+    TEST_ASSERT_EQUAL_MEMORY("ping", reply, 4);
+    peer_ready = true;
+
+    TEST_ASSERT_EQUAL_UINT32(0, shm_iface.stats.tx_drops);
+    TEST_ASSERT_TRUE(shm_iface.stats.rx_packets >= 1);
+
+    danp_close(sock);
+}
+
+/**
+ * @brief A burst is echoed completely and in order
+ */
+void test_shm_burst_is_echoed_in_order(void)
+{
+    const uint32_t burst = DANP_RX_QUEUE_SIZE - 2; /* stays within the receiver queues */
+    TEST_ASSERT_TRUE(peer_ready);
+    danp_socket_t *sock = danp_socket(DANP_TYPE_DGRAM);
+    /* A port of its own, so a late echo of a probe cannot land here */
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sock, LOCAL_PORT + 2));
+    uint32_t tx_packets = shm_iface.stats.tx_packets;
+
+    for (uint32_t i = 0; i < burst; i++)
+    {
+        uint8_t value = (uint8_t)i;
+        TEST_ASSERT_EQUAL_INT32(1, danp_send_to(sock, &value, 1, NODE_PEER, PEER_ECHO_PORT));
+    }
+    for (uint32_t i = 0; i < burst; i++)
+    {
+        uint8_t value = 0xFF;
+        TEST_ASSERT_EQUAL_INT32(1, danp_recv(sock, &value, 1, 1000));
+        TEST_ASSERT_EQUAL_UINT8((uint8_t)i, value);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(burst, shm_iface.stats.tx_packets - tx_packets);
+    /* A sender only pays for a wake-up when the peer was asleep */
+    TEST_ASSERT_TRUE(shm_iface.stats.tx_wakeups <= shm_iface.stats.tx_packets);
+
+    danp_close(sock);
+}
+
+/**
+ * @brief A STREAM connection to the peer process carries data both ways
+ */
+void test_shm_stream_echo_between_processes(void)
+{
+    uint8_t data[600];
+    uint8_t received[600];
+    uint32_t total = 0;
+
+    TEST_ASSERT_TRUE(peer_ready);
+    for (uint32_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)(i * 13U);
+    }
+
+    danp_socket_t *client = danp_socket(DANP_TYPE_STREAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(client, LOCAL_PORT + 1));
+    TEST_ASSERT_EQUAL_INT32(0, danp_connect(client, NODE_PEER, PEER_STREAM_PORT));
+    TEST_ASSERT_EQUAL_INT32((int32_t)sizeof(data), danp_send(client, data, sizeof(data)));
+
+    while (total < sizeof(received))
+    {
+        int32_t len = danp_recv(client, received + total, (uint16_t)(sizeof(received) - total), 2000);
+        TEST_ASSERT_TRUE(len > 0);
+        total += (uint32_t)len;
+    }
+    TEST_ASSERT_EQUAL_MEMORY(data, received, sizeof(data));
+
+    danp_setsockopt(client, DANP_SO_LINGER, 0);
+    danp_close(client);
+}
+
+/**
+ * @brief Invalid settings and segments formatted for another geometry are rejected
+ */
+void test_shm_rejects_invalid_configuration(void)
+{
+    danp_shm_interface_t scratch;
+    danp_shm_config_t config = {
+        .address = 5,
+        .peer = 5,
+        .segment = NULL,
+    };
+    char bogus[DANP_SHM_NAME_MAX];
+
+    TEST_ASSERT_EQUAL_INT32(-1, danp_shm_init(&scratch, &config));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_shm_init(NULL, &config));
+
+    /* A larger object than this build's layout belongs to someone else */
+    snprintf(bogus, sizeof(bogus), "/danp-bogus-%d", (int)getpid());
+    int fd = shm_open(bogus, O_RDWR | O_CREAT, 0600);
+    TEST_ASSERT_TRUE(fd >= 0);
+    TEST_ASSERT_EQUAL_INT(0, ftruncate(fd, 64 * 1024 * 1024));
+    close(fd);
+
+    config.peer = 6;
+    config.segment = bogus;
+    TEST_ASSERT_EQUAL_INT32(-1, danp_shm_init(&scratch, &config));
+    TEST_ASSERT_EQUAL_INT32(0, danp_shm_unlink(bogus));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_shm_unlink(bogus));
+}
+
+/* ============================================================================
+ * Test Runner
+ * ============================================================================
+ */
+
+/**
+ * @brief Main test runner, or the peer process when started with PEER_ARG
+ */
+int main(int argc, char **argv)
+{
+    if (argc > 2 && strcmp(argv[1], PEER_ARG) == 0)
+    {
+        return run_peer(argv[2]);
+    }
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_shm_dgram_round_trip_between_processes);
+    RUN_TEST(test_shm_burst_is_echoed_in_order);
+    RUN_TEST(test_shm_stream_echo_between_processes);
+    RUN_TEST(test_shm_rejects_invalid_configuration);
+
+    stop_peer();
+    return UNITY_END();
+}
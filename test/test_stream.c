@@ -6,11 +6,12 @@
  * - Socket creation and state transitions
  * - Connection establishment (three-way handshake)
  * - Reliable data transfer
- * - Connection termination (RST)
+ * - Connection termination (RST and orderly shutdown)
  * - Bidirectional communication
  */
 
 #include "danp/danp.h"
+#include "danp/danp_buffer.h"
 #include "unity.h"
 #include <stdio.h>
 #include <string.h>
@@ -34,10 +35,160 @@ void danp_log_message_with_func_name(
 static danp_interface_t loopback_iface;
 static bool loopback_registered = false;
 
+/* Control traffic observed on the loopback, used by the delayed ACK tests */
+static volatile uint32_t loopback_pure_ack_count = 0;
+static volatile uint32_t loopback_piggyback_count = 0;
+static volatile uint8_t loopback_last_ack_src_port = 0;
+static volatile uint16_t loopback_last_ack_seq = 0;
+static volatile uint16_t loopback_last_ack_wnd = 0;
+static volatile uint16_t loopback_last_synack_len = 0;
+
+/* Number of upcoming SYNs the loopback loses, used by the timer tests */
+static volatile uint32_t loopback_drop_syns = 0;
+
+/* Number of upcoming SYN-ACKs the loopback holds back until released, emulating a slow path */
+static volatile uint32_t loopback_hold_synacks = 0;
+static uint8_t loopback_held[4][DANP_HEADER_SIZE + DANP_MAX_PACKET_SIZE];
+static uint16_t loopback_held_len[4];
+static uint32_t loopback_held_count = 0;
+
+/* Port whose traffic the loopback loses, emulating a peer that vanished (0: none) */
+static volatile uint8_t loopback_blackhole_port = 0;
+
+/* Port served by an emulated node that only speaks the legacy (v1) STREAM format */
+#define LEGACY_PEER_PORT 30
+static volatile uint16_t legacy_peer_last_len = 0;
+static volatile uint8_t legacy_peer_last_seq = 0;
+static volatile uint32_t legacy_peer_segments = 0;
+
+static void loopback_reset_counters(void)
+{
+    loopback_pure_ack_count = 0;
+    loopback_piggyback_count = 0;
+    loopback_last_ack_src_port = 0;
+    loopback_last_ack_seq = 0;
+    loopback_last_ack_wnd = 0;
+    loopback_last_synack_len = 0;
+}
+
+static uint16_t read_u16(const uint8_t *bytes)
+{
+    return (uint16_t)((bytes[0] << 8) | bytes[1]);
+}
+
+static void loopback_observe(const danp_packet_t *packet)
+{
+    uint16_t dst, src;
+    uint8_t dst_port, src_port, flags;
+    danp_unpack_header(packet->header_raw, &dst, &src, &dst_port, &src_port, &flags);
+
+    if (flags == (DANP_FLAG_SYN | DANP_FLAG_ACK))
+    {
+        loopback_last_synack_len = packet->length;
+        return;
+    }
+
+    if (flags != DANP_FLAG_ACK)
+    {
+        return;
+    }
+
+    if (packet->length == 1)
+    {
+        /* Legacy ACK: [seq] */
+        loopback_pure_ack_count++;
+        loopback_last_ack_src_port = src_port;
+        loopback_last_ack_seq = packet->payload[0];
+    }
+    else if (packet->length >= DANP_STREAM_HEADER_SIZE)
+    {
+        /* v2 header: [ver|opts][seq:16][ack:16][wnd:16] */
+        if (packet->length == DANP_STREAM_HEADER_SIZE)
+        {
+            loopback_pure_ack_count++;
+        }
+        else
+        {
+            loopback_piggyback_count++;
+        }
+        loopback_last_ack_src_port = src_port;
+        loopback_last_ack_seq = read_u16(&packet->payload[3]);
+        loopback_last_ack_wnd = read_u16(&packet->payload[5]);
+    }
+}
+
+static void send_raw(uint8_t dst_port, uint8_t src_port, uint8_t flags, const uint8_t *payload, uint16_t len)
+{
+    uint8_t buffer[DANP_HEADER_SIZE + DANP_MAX_PACKET_SIZE];
+    uint32_t header = danp_pack_header(0, TEST_NODE_ID, TEST_NODE_ID, dst_port, src_port, flags);
+
+    memcpy(buffer, &header, DANP_HEADER_SIZE);
+    if (len > 0)
+    {
+        memcpy(buffer + DANP_HEADER_SIZE, payload, len);
+    }
+    danp_input(&loopback_iface, buffer, DANP_HEADER_SIZE + len);
+}
+
+/**
+ * @brief Answer traffic for LEGACY_PEER_PORT the way a node without v2 support does
+ */
+static void legacy_peer_handle(const danp_packet_t *packet)
+{
+    uint16_t dst, src;
+    uint8_t dst_port, src_port, flags;
+    uint8_t ack;
+    danp_unpack_header(packet->header_raw, &dst, &src, &dst_port, &src_port, &flags);
+
+    legacy_peer_last_len = packet->length;
+
+    if (flags & DANP_FLAG_SYN)
+    {
+        ack = 0;
+        send_raw(src_port, dst_port, DANP_FLAG_SYN | DANP_FLAG_ACK, &ack, 1);
+    }
+    else if (flags == DANP_FLAG_NONE && packet->length > 0)
+    {
+        legacy_peer_segments++;
+        legacy_peer_last_seq = packet->payload[0];
+        ack = packet->payload[0];
+        send_raw(src_port, dst_port, DANP_FLAG_ACK, &ack, 1);
+    }
+}
+
 static int32_t loopback_tx(void *iface_common, danp_packet_t *packet)
 {
     danp_interface_t *iface = (danp_interface_t *)iface_common;
     uint8_t buffer[DANP_HEADER_SIZE + DANP_MAX_PACKET_SIZE];
+    uint16_t dst, src;
+    uint8_t dst_port, src_port, flags;
+
+    loopback_observe(packet);
+
+    danp_unpack_header(packet->header_raw, &dst, &src, &dst_port, &src_port, &flags);
+    if (flags == DANP_FLAG_SYN && loopback_drop_syns > 0)
+    {
+        loopback_drop_syns--;
+        return 0;
+    }
+    if (loopback_blackhole_port != 0 && dst_port == loopback_blackhole_port)
+    {
+        return 0;
+    }
+    if (flags == (DANP_FLAG_SYN | DANP_FLAG_ACK) && loopback_hold_synacks > 0 && loopback_held_count < 4)
+    {
+        loopback_hold_synacks--;
+        memcpy(loopback_held[loopback_held_count], &packet->header_raw, DANP_HEADER_SIZE);
+        memcpy(loopback_held[loopback_held_count] + DANP_HEADER_SIZE, packet->payload, packet->length);
+        loopback_held_len[loopback_held_count] = (uint16_t)(DANP_HEADER_SIZE + packet->length);
+        loopback_held_count++;
+        return 0;
+    }
+    if (dst_port == LEGACY_PEER_PORT)
+    {
+        legacy_peer_handle(packet);
+        return 0;
+    }
 
     memcpy(buffer, &packet->header_raw, DANP_HEADER_SIZE);
     if (packet->length > 0)
@@ -49,6 +200,18 @@ static int32_t loopback_tx(void *iface_common, danp_packet_t *packet)
     return 0;
 }
 
+/**
+ * @brief Deliver the SYN-ACKs held back by loopback_hold_synacks, late
+ */
+static void loopback_release_held(void)
+{
+    for (uint32_t i = 0; i < loopback_held_count; i++)
+    {
+        danp_input(&loopback_iface, loopback_held[i], loopback_held_len[i]);
+    }
+    loopback_held_count = 0;
+}
+
 static void setup_loopback_interface(void)
 {
     if (!loopback_registered)
@@ -68,6 +231,21 @@ static void setup_loopback_interface(void)
     TEST_ASSERT_TRUE(written > 0 && written < (int)sizeof(route_entry));
     TEST_ASSERT_EQUAL_INT32(0, danp_route_table_load(route_entry));
 }
+
+/**
+ * @brief Feed a raw v2 STREAM data segment (without ACK) into the stack as if it came from the wire
+ */
+static void inject_segment(uint8_t dst_port, uint8_t src_port, uint16_t seq, const char *data, uint16_t len)
+{
+    uint8_t payload[DANP_MAX_PACKET_SIZE];
+
+    memset(payload, 0, DANP_STREAM_HEADER_SIZE);
+    payload[0] = DANP_STREAM_V2 << 4;
+    payload[1] = (uint8_t)(seq >> 8);
+    payload[2] = (uint8_t)seq;
+    memcpy(payload + DANP_STREAM_HEADER_SIZE, data, len);
+    send_raw(dst_port, src_port, DANP_FLAG_NONE, payload, DANP_STREAM_HEADER_SIZE + len);
+}
 /* ============================================================================
  * Test Enable Flags (set to 1 to run, 0 to skip)
  * ============================================================================
@@ -76,6 +254,16 @@ static void setup_loopback_interface(void)
 #define ENABLE_TEST_STREAM_CLOSE_RST 1
 #define ENABLE_TEST_STREAM_SOCKET_STATES 1
 #define ENABLE_TEST_STREAM_BIDIRECTIONAL 1
+#define ENABLE_TEST_STREAM_DELAYED_ACK 1
+#define ENABLE_TEST_STREAM_FLOW_CONTROL 1
+#define ENABLE_TEST_STREAM_VERSIONING 1
+#define ENABLE_TEST_STREAM_SEGMENTATION 1
+#define ENABLE_TEST_STREAM_COALESCING 1
+#define ENABLE_TEST_STREAM_NONBLOCKING 1
+#define ENABLE_TEST_STREAM_BACKLOG 1
+#define ENABLE_TEST_STREAM_CONCURRENCY 1
+#define ENABLE_TEST_STREAM_TIMERS 1
+#define ENABLE_TEST_STREAM_SHUTDOWN 1
 
 /* ============================================================================
  * Test Setup and Teardown
@@ -170,11 +358,11 @@ void test_stream_handshake_and_data_transfer(void)
 }
 
 /**
- * @brief Test that closing a socket triggers RST and closes peer socket
+ * @brief Test that an abortive close triggers RST and closes peer socket
  *
  * This test verifies the connection reset (RST) mechanism:
  * 1. Establish a connection between client and server
- * 2. Close the client socket (sends RST)
+ * 2. Close the client socket with a linger time of 0 (sends RST)
  * 3. Verify the server socket is automatically closed
  *
  * Note: The RST packet is looped back immediately and processed
@@ -196,15 +384,24 @@ void test_stream_close_triggers_rst(void)
     TEST_ASSERT_NOT_NULL(accepted_socket);
     TEST_ASSERT_EQUAL(DANP_SOCK_ESTABLISHED, accepted_socket->state);
 
-    /* Step 2: Close client socket (triggers RST) */
+    /* Step 2: Close client socket without lingering (triggers RST) */
+    TEST_ASSERT_EQUAL(0, danp_setsockopt(client_socket, DANP_SO_LINGER, 0));
     danp_close(client_socket);
 
     /* Step 3: Verify server socket receives RST and transitions to CLOSED */
     /* The RST packet is looped back immediately through the mock driver,
      * so the accepted socket should be CLOSED synchronously */
     TEST_ASSERT_EQUAL(DANP_SOCK_CLOSED, accepted_socket->state);
+    TEST_ASSERT_EQUAL(DANP_SOCK_LISTENING, server_socket->state);
+
+    /* Step 4: The reset handle keeps its slot until the application closes it */
+    danp_socket_t *next_socket = danp_socket(DANP_TYPE_STREAM);
+    TEST_ASSERT_NOT_NULL(next_socket);
+    TEST_ASSERT_TRUE(next_socket != accepted_socket);
 
     /* Cleanup */
+    danp_close(next_socket);
+    danp_close(accepted_socket);
     danp_close(server_socket);
 }
 
@@ -312,35 +509,1346 @@ void test_stream_accept_timeout_returns_null(void)
     danp_close(server_socket);
 }
 
-/* ============================================================================
- * Test Runner
- * ============================================================================
+/**
+ * @brief Test that ACKs for consecutive segments are coalesced
+ *
+ * The first in-order segment only arms the delayed ACK; the second one
+ * reaches DANP_ACK_COALESCE_COUNT and releases a single ACK covering both.
  */
+void test_stream_delayed_ack_coalesces_segments(void)
+{
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 16);
+    danp_listen(server_socket, 5);
+
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 17);
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, 16));
+
+    danp_socket_t *accepted_socket = danp_accept(server_socket, DANP_WAIT_FOREVER);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+
+    loopback_reset_counters();
+
+    inject_segment(16, 17, 0, "one", 3);
+    TEST_ASSERT_EQUAL_UINT32(0, loopback_pure_ack_count);
+    TEST_ASSERT_TRUE(accepted_socket->ack_pending);
+
+    inject_segment(16, 17, 1, "two", 3);
+    TEST_ASSERT_EQUAL_UINT32(1, loopback_pure_ack_count);
+    TEST_ASSERT_EQUAL_UINT16(1, loopback_last_ack_seq);
+    TEST_ASSERT_FALSE(accepted_socket->ack_pending);
+
+    char buffer[8];
+    TEST_ASSERT_EQUAL(6, danp_recv(accepted_socket, buffer, sizeof(buffer), 0));
+    TEST_ASSERT_EQUAL_MEMORY("onetwo", buffer, 6);
+
+    danp_close(client_socket);
+    danp_close(server_socket);
+}
 
 /**
- * @brief Main test runner
+ * @brief Test that a lone segment is still acknowledged once the delay expires
+ */
+void test_stream_delayed_ack_sent_after_timeout(void)
+{
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 18);
+    danp_listen(server_socket, 5);
+
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 19);
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, 18));
+
+    danp_socket_t *accepted_socket = danp_accept(server_socket, DANP_WAIT_FOREVER);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+
+    loopback_reset_counters();
+
+    inject_segment(18, 19, 0, "solo", 4);
+    TEST_ASSERT_EQUAL_UINT32(0, loopback_pure_ack_count);
+
+    osalDelayMs(DANP_ACK_DELAY_MS * 5);
+
+    TEST_ASSERT_EQUAL_UINT32(1, loopback_pure_ack_count);
+    TEST_ASSERT_EQUAL_UINT8(18, loopback_last_ack_src_port);
+    TEST_ASSERT_EQUAL_UINT16(0, loopback_last_ack_seq);
+
+    danp_close(client_socket);
+    danp_close(server_socket);
+}
+
+/**
+ * @brief Test that a pending ACK rides on reverse-direction data
  *
- * Executes all STREAM socket tests in sequence
+ * The reply sent by the server carries the ACK for the request, so the
+ * server never emits a standalone ACK and the client still receives the
+ * reply payload intact.
  */
-int main(void)
+void test_stream_ack_piggybacks_on_reply(void)
 {
-    UNITY_BEGIN();
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 20);
+    danp_listen(server_socket, 5);
 
-    /* Run all STREAM socket tests */
-#if ENABLE_TEST_STREAM_HANDSHAKE
-    RUN_TEST(test_stream_handshake_and_data_transfer);
-#endif
-#if ENABLE_TEST_STREAM_CLOSE_RST
-    RUN_TEST(test_stream_close_triggers_rst);
-#endif
-#if ENABLE_TEST_STREAM_SOCKET_STATES
-    RUN_TEST(test_stream_socket_creation_and_states);
-#endif
-#if ENABLE_TEST_STREAM_BIDIRECTIONAL
-    RUN_TEST(test_stream_bidirectional_communication);
-#endif
-#if ENABLE_TEST_STREAM_BIDIRECTIONAL
-    RUN_TEST(test_stream_accept_timeout_returns_null);
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 21);
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, 20));
+
+    danp_socket_t *accepted_socket = danp_accept(server_socket, DANP_WAIT_FOREVER);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+
+    loopback_reset_counters();
+
+    inject_segment(20, 21, 0, "Request", 7);
+    TEST_ASSERT_TRUE(accepted_socket->ack_pending);
+
+    TEST_ASSERT_EQUAL(5, danp_send(accepted_socket, "Reply", 5));
+    TEST_ASSERT_EQUAL_UINT32(1, loopback_piggyback_count);
+    TEST_ASSERT_FALSE(accepted_socket->ack_pending);
+
+    char buffer[16];
+    int32_t received = danp_recv(client_socket, buffer, sizeof(buffer), DANP_WAIT_FOREVER);
+    TEST_ASSERT_EQUAL(5, received);
+    TEST_ASSERT_EQUAL_MEMORY("Reply", buffer, 5);
+
+    danp_close(client_socket);
+    danp_close(server_socket);
+}
+
+/* Largest segment payload and receive window of a v2 connection */
+#define STREAM_MSS (DANP_MAX_PACKET_SIZE - DANP_STREAM_HEADER_SIZE)
+#define STREAM_FULL_WINDOW (DANP_STREAM_RX_BUFFER_SIZE / STREAM_MSS)
+
+/**
+ * @brief Test that ACKs advertise the free receive window
+ */
+void test_stream_ack_advertises_receive_window(void)
+{
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 22);
+    danp_listen(server_socket, 5);
+
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 23);
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, 22));
+    TEST_ASSERT_EQUAL_UINT16(STREAM_FULL_WINDOW, client_socket->peer_wnd);
+
+    danp_socket_t *accepted_socket = danp_accept(server_socket, DANP_WAIT_FOREVER);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+
+    loopback_reset_counters();
+
+    inject_segment(22, 23, 0, "one", 3);
+    inject_segment(22, 23, 1, "two", 3);
+    TEST_ASSERT_EQUAL_UINT32(1, loopback_pure_ack_count);
+    TEST_ASSERT_EQUAL_UINT16((DANP_STREAM_RX_BUFFER_SIZE - 6) / STREAM_MSS, loopback_last_ack_wnd);
+
+    char buffer[8];
+    TEST_ASSERT_EQUAL(6, danp_recv(accepted_socket, buffer, sizeof(buffer), 0));
+    TEST_ASSERT_EQUAL_MEMORY("onetwo", buffer, 6);
+    TEST_ASSERT_EQUAL_UINT16(0, accepted_socket->rx_count);
+
+    danp_close(client_socket);
+    danp_close(server_socket);
+}
+
+#define FILL_SEGMENT_LEN 100
+#define FILL_SEGMENTS (DANP_STREAM_RX_BUFFER_SIZE / FILL_SEGMENT_LEN)
+
+/**
+ * @brief Test that a full receiver drops instead of ACKing and reopens its window
+ *
+ * Once the receive ring cannot take another segment, the next in-order
+ * segment is dropped and answered with a zero window. Reading one segment
+ * worth of data sends a window update right away.
+ */
+void test_stream_full_receiver_drops_and_reopens_window(void)
+{
+    char fill[FILL_SEGMENT_LEN];
+
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 24);
+    danp_listen(server_socket, 5);
+
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 25);
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, 24));
+
+    danp_socket_t *accepted_socket = danp_accept(server_socket, DANP_WAIT_FOREVER);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+
+    memset(fill, 'f', sizeof(fill));
+    for (uint16_t seq = 0; seq < FILL_SEGMENTS; seq++)
+    {
+        inject_segment(24, 25, seq, fill, sizeof(fill));
+    }
+    TEST_ASSERT_EQUAL_UINT16(FILL_SEGMENTS * FILL_SEGMENT_LEN, accepted_socket->rx_count);
+
+    loopback_reset_counters();
+
+    inject_segment(24, 25, FILL_SEGMENTS, fill, sizeof(fill));
+    TEST_ASSERT_EQUAL_UINT32(1, loopback_pure_ack_count);
+    TEST_ASSERT_EQUAL_UINT16(FILL_SEGMENTS - 1, loopback_last_ack_seq);
+    TEST_ASSERT_EQUAL_UINT16(0, loopback_last_ack_wnd);
+    TEST_ASSERT_EQUAL_UINT16(FILL_SEGMENTS, accepted_socket->rx_expected_seq);
+
+    char buffer[FILL_SEGMENT_LEN];
+    TEST_ASSERT_EQUAL(FILL_SEGMENT_LEN, danp_recv(accepted_socket, buffer, sizeof(buffer), 0));
+    TEST_ASSERT_EQUAL_UINT32(2, loopback_pure_ack_count);
+    TEST_ASSERT_EQUAL_UINT16(FILL_SEGMENTS - 1, loopback_last_ack_seq);
+    TEST_ASSERT_EQUAL_UINT16(
+        (DANP_STREAM_RX_BUFFER_SIZE - (FILL_SEGMENTS - 1) * FILL_SEGMENT_LEN) / STREAM_MSS,
+        loopback_last_ack_wnd);
+
+    danp_close(client_socket);
+    danp_close(server_socket);
+}
+
+/**
+ * @brief Test that reads span segment boundaries and keep what does not fit
+ *
+ * Segments are coalesced into the receive ring on arrival, so their pool
+ * packets are back in the pool before the application reads anything.
+ */
+void test_stream_recv_spans_segments_and_keeps_leftovers(void)
+{
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 34);
+    danp_listen(server_socket, 5);
+
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 35);
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, 34));
+
+    danp_socket_t *accepted_socket = danp_accept(server_socket, DANP_WAIT_FOREVER);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+
+    size_t free_before = danp_buffer_get_free_count();
+    inject_segment(34, 35, 0, "hello", 5);
+    inject_segment(34, 35, 1, "world", 5);
+    TEST_ASSERT_EQUAL(free_before, danp_buffer_get_free_count());
+
+    char buffer[16];
+    TEST_ASSERT_EQUAL(3, danp_recv(accepted_socket, buffer, 3, 0));
+    TEST_ASSERT_EQUAL_MEMORY("hel", buffer, 3);
+    TEST_ASSERT_EQUAL(7, danp_recv(accepted_socket, buffer, sizeof(buffer), 0));
+    TEST_ASSERT_EQUAL_MEMORY("loworld", buffer, 7);
+    TEST_ASSERT_EQUAL(0, danp_recv(accepted_socket, buffer, sizeof(buffer), 0));
+
+    danp_close(client_socket);
+    danp_close(server_socket);
+}
+
+#define BACKPRESSURE_SEGMENTS 24
+
+static danp_socket_t *backpressure_client;
+static volatile int32_t backpressure_sent = 0;
+
+static void backpressure_sender(void *arg)
+{
+    uint8_t chunk[FILL_SEGMENT_LEN];
+
+    (void)arg;
+
+    for (int i = 0; i < BACKPRESSURE_SEGMENTS; i++)
+    {
+        memset(chunk, i, sizeof(chunk));
+        if (danp_send(backpressure_client, chunk, sizeof(chunk)) != (int32_t)sizeof(chunk))
+        {
+            break;
+        }
+        backpressure_sent++;
+    }
+}
+
+/**
+ * @brief Test that a slow consumer stalls the sender instead of losing data
+ *
+ * The application does not read while the client keeps sending. The sender
+ * must stop at the advertised window and stay connected, and every segment
+ * must arrive in order once the application starts reading.
+ */
+void test_stream_slow_consumer_applies_backpressure(void)
+{
+    osalThreadAttr_t thread_attr = {
+        .name = "testSender",
+        .stackSize = 1024 * 8,
+        .stackMem = NULL,
+        .priority = OSAL_THREAD_PRIORITY_NORMAL,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 26);
+    danp_listen(server_socket, 5);
+
+    backpressure_client = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(backpressure_client, 27);
+    TEST_ASSERT_EQUAL(0, danp_connect(backpressure_client, TEST_NODE_ID, 26));
+
+    danp_socket_t *accepted_socket = danp_accept(server_socket, DANP_WAIT_FOREVER);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+
+    backpressure_sent = 0;
+    TEST_ASSERT_NOT_NULL(osalThreadCreate(backpressure_sender, NULL, &thread_attr));
+
+    osalDelayMs(DANP_ACK_TIMEOUT_MS);
+
+    TEST_ASSERT_EQUAL_UINT16(FILL_SEGMENTS * FILL_SEGMENT_LEN, accepted_socket->rx_count);
+    TEST_ASSERT_EQUAL_UINT16(0, backpressure_client->peer_wnd);
+    TEST_ASSERT_EQUAL(DANP_SOCK_ESTABLISHED, backpressure_client->state);
+    TEST_ASSERT_TRUE(backpressure_sent < BACKPRESSURE_SEGMENTS);
+
+    uint8_t buffer[FILL_SEGMENT_LEN];
+    for (int i = 0; i < BACKPRESSURE_SEGMENTS; i++)
+    {
+        TEST_ASSERT_EQUAL(FILL_SEGMENT_LEN, danp_recv(accepted_socket, buffer, sizeof(buffer), 2000));
+        TEST_ASSERT_EQUAL_UINT8(i, buffer[0]);
+        TEST_ASSERT_EQUAL_UINT8(i, buffer[FILL_SEGMENT_LEN - 1]);
+    }
+    for (int wait = 0; wait < 100 && backpressure_sent < BACKPRESSURE_SEGMENTS; wait++)
+    {
+        osalDelayMs(10);
+    }
+    TEST_ASSERT_EQUAL(BACKPRESSURE_SEGMENTS, backpressure_sent);
+    TEST_ASSERT_EQUAL(DANP_SOCK_ESTABLISHED, backpressure_client->state);
+
+    danp_close(backpressure_client);
+    danp_close(server_socket);
+}
+
+/**
+ * @brief Test that two v2 nodes negotiate the versioned header and run past 256 segments
+ */
+void test_stream_v2_sequence_numbers_exceed_one_byte(void)
+{
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 28);
+    danp_listen(server_socket, 5);
+
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 29);
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, 28));
+
+    danp_socket_t *accepted_socket = danp_accept(server_socket, DANP_WAIT_FOREVER);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+    TEST_ASSERT_EQUAL(DANP_STREAM_V2, client_socket->version);
+    TEST_ASSERT_EQUAL(DANP_STREAM_V2, accepted_socket->version);
+    TEST_ASSERT_EQUAL_UINT16(DANP_STREAM_HEADER_SIZE, loopback_last_synack_len);
+
+    uint8_t chunk[2];
+    uint8_t buffer[8];
+    for (uint16_t i = 0; i < 300; i++)
+    {
+        chunk[0] = (uint8_t)(i >> 8);
+        chunk[1] = (uint8_t)i;
+        TEST_ASSERT_EQUAL(2, danp_send(client_socket, chunk, sizeof(chunk)));
+        TEST_ASSERT_EQUAL(2, danp_recv(accepted_socket, buffer, sizeof(buffer), 1000));
+        TEST_ASSERT_EQUAL_MEMORY(chunk, buffer, 2);
+    }
+
+    TEST_ASSERT_EQUAL_UINT16(300, accepted_socket->rx_expected_seq);
+    TEST_ASSERT_EQUAL_UINT16(300, client_socket->tx_seq);
+
+    danp_close(client_socket);
+    danp_close(server_socket);
+}
+
+/**
+ * @brief Test that connecting to a legacy node falls back to the v1 format
+ *
+ * The peer answers the v2 SYN with a one-byte SYN-ACK. The connection then
+ * uses one-byte sequence numbers and a bare one-byte final ACK.
+ */
+void test_stream_v2_falls_back_to_legacy_listener(void)
+{
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 31);
+
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, LEGACY_PEER_PORT));
+    TEST_ASSERT_EQUAL(DANP_STREAM_V1, client_socket->version);
+    TEST_ASSERT_EQUAL_UINT16(1, legacy_peer_last_len);
+
+    legacy_peer_segments = 0;
+    TEST_ASSERT_EQUAL(3, danp_send(client_socket, "abc", 3));
+    TEST_ASSERT_EQUAL(3, danp_send(client_socket, "def", 3));
+    TEST_ASSERT_EQUAL_UINT32(2, legacy_peer_segments);
+    TEST_ASSERT_EQUAL_UINT16(4, legacy_peer_last_len);
+    TEST_ASSERT_EQUAL_UINT8(1, legacy_peer_last_seq);
+    TEST_ASSERT_EQUAL_UINT16(2, client_socket->snd_una);
+
+    danp_close(client_socket);
+}
+
+/**
+ * @brief Test that a legacy node opening a connection is served in the v1 format
+ */
+void test_stream_v2_serves_legacy_initiator(void)
+{
+    uint8_t legacy_ack = 0;
+    uint8_t legacy_data[3] = {0, 'h', 'i'};
+
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 32);
+    danp_listen(server_socket, 5);
+
+    loopback_reset_counters();
+
+    /* Legacy SYN carries no payload; the SYN-ACK must be the one-byte legacy form */
+    send_raw(32, 33, DANP_FLAG_SYN, NULL, 0);
+    danp_socket_t *accepted_socket = danp_accept(server_socket, 0);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+    TEST_ASSERT_EQUAL(DANP_STREAM_V1, accepted_socket->version);
+    TEST_ASSERT_EQUAL_UINT16(1, loopback_last_synack_len);
+
+    send_raw(32, 33, DANP_FLAG_ACK, &legacy_ack, 1);
+    TEST_ASSERT_EQUAL(DANP_SOCK_ESTABLISHED, accepted_socket->state);
+
+    send_raw(32, 33, DANP_FLAG_NONE, legacy_data, sizeof(legacy_data));
+    osalDelayMs(DANP_ACK_DELAY_MS * 5);
+    TEST_ASSERT_EQUAL_UINT32(1, loopback_pure_ack_count);
+    TEST_ASSERT_EQUAL_UINT16(0, loopback_last_ack_seq);
+
+    char buffer[8];
+    TEST_ASSERT_EQUAL(2, danp_recv(accepted_socket, buffer, sizeof(buffer), 0));
+    TEST_ASSERT_EQUAL_MEMORY("hi", buffer, 2);
+
+    danp_close(server_socket);
+    danp_close(accepted_socket);
+}
+
+#define BULK_SEND_LEN 4000
+
+static uint8_t bulk_data[BULK_SEND_LEN];
+static danp_socket_t *bulk_client;
+static volatile int32_t bulk_send_result = 0;
+static volatile bool bulk_send_done = false;
+
+static void bulk_sender(void *arg)
+{
+    (void)arg;
+
+    bulk_send_result = danp_send(bulk_client, bulk_data, sizeof(bulk_data));
+    bulk_send_done = true;
+}
+
+/**
+ * @brief Test that one danp_send() call takes a buffer far larger than a packet
+ *
+ * The buffer is cut into segments sized to the loopback MTU and arrives
+ * intact while the receiver drains it.
+ */
+void test_stream_send_segments_large_buffer(void)
+{
+    osalThreadAttr_t thread_attr = {
+        .name = "testBulk",
+        .stackSize = 1024 * 8,
+        .stackMem = NULL,
+        .priority = OSAL_THREAD_PRIORITY_NORMAL,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+    const uint16_t mss = 128 - DANP_HEADER_SIZE - DANP_STREAM_HEADER_SIZE;
+
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 36);
+    danp_listen(server_socket, 5);
+
+    bulk_client = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(bulk_client, 37);
+    TEST_ASSERT_EQUAL(0, danp_connect(bulk_client, TEST_NODE_ID, 36));
+
+    danp_socket_t *accepted_socket = danp_accept(server_socket, DANP_WAIT_FOREVER);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+
+    for (int i = 0; i < BULK_SEND_LEN; i++)
+    {
+        bulk_data[i] = (uint8_t)(i * 7);
+    }
+    bulk_send_done = false;
+    TEST_ASSERT_NOT_NULL(osalThreadCreate(bulk_sender, NULL, &thread_attr));
+
+    static uint8_t received[BULK_SEND_LEN];
+    uint32_t total = 0;
+    while (total < BULK_SEND_LEN)
+    {
+        int32_t len = danp_recv(accepted_socket, received + total, BULK_SEND_LEN - total, 2000);
+        TEST_ASSERT_TRUE(len > 0);
+        total += (uint32_t)len;
+    }
+
+    for (int wait = 0; wait < 100 && !bulk_send_done; wait++)
+    {
+        osalDelayMs(10);
+    }
+    TEST_ASSERT_TRUE(bulk_send_done);
+    TEST_ASSERT_EQUAL(BULK_SEND_LEN, bulk_send_result);
+    TEST_ASSERT_EQUAL_MEMORY(bulk_data, received, BULK_SEND_LEN);
+    TEST_ASSERT_EQUAL_UINT16((BULK_SEND_LEN + mss - 1) / mss, bulk_client->tx_seq);
+
+    danp_close(bulk_client);
+    danp_close(server_socket);
+}
+
+/**
+ * @brief Test that DANP_SO_SEND_WAIT_ACK makes danp_send() wait for the ACK
+ *
+ * A lone segment is ACKed only after DANP_ACK_DELAY_MS, so by default
+ * danp_send() returns with it still unacknowledged, while with the option set
+ * it returns once everything it sent is acknowledged.
+ */
+void test_stream_send_wait_ack_option(void)
+{
+    uint32_t value = 0;
+    uint8_t data[300];
+    uint8_t buffer[sizeof(data)];
+
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 38);
+    danp_listen(server_socket, 5);
+
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 39);
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, 38));
+
+    danp_socket_t *accepted_socket = danp_accept(server_socket, DANP_WAIT_FOREVER);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+
+    memset(data, 0x5A, sizeof(data));
+
+    TEST_ASSERT_EQUAL(0, danp_getsockopt(client_socket, DANP_SO_SEND_WAIT_ACK, &value));
+    TEST_ASSERT_EQUAL_UINT32(0, value);
+    TEST_ASSERT_EQUAL(10, danp_send(client_socket, data, 10));
+    TEST_ASSERT_NOT_EQUAL(client_socket->tx_seq, client_socket->snd_una);
+    TEST_ASSERT_EQUAL(10, danp_recv(accepted_socket, buffer, sizeof(buffer), 0));
+    osalDelayMs(DANP_ACK_DELAY_MS * 5);
+
+    TEST_ASSERT_EQUAL(0, danp_setsockopt(client_socket, DANP_SO_SEND_WAIT_ACK, 1));
+    TEST_ASSERT_EQUAL(0, danp_getsockopt(client_socket, DANP_SO_SEND_WAIT_ACK, &value));
+    TEST_ASSERT_EQUAL_UINT32(1, value);
+    TEST_ASSERT_EQUAL((int32_t)sizeof(data), danp_send(client_socket, data, sizeof(data)));
+    TEST_ASSERT_EQUAL(client_socket->tx_seq, client_socket->snd_una);
+    TEST_ASSERT_EQUAL((int32_t)sizeof(data), danp_recv(accepted_socket, buffer, sizeof(buffer), 0));
+    TEST_ASSERT_EQUAL_MEMORY(data, buffer, sizeof(data));
+
+    TEST_ASSERT_EQUAL(-1, danp_setsockopt(client_socket, (danp_socket_option_t)99, 1));
+
+    danp_close(client_socket);
+    danp_close(server_socket);
+}
+
+/**
+ * @brief Test that small writes merge into one segment while data is unacknowledged
+ *
+ * The first write goes out at once; its ACK is delayed, and the writes made
+ * meanwhile are sent together as a single segment when it arrives.
+ */
+void test_stream_nodelay_off_coalesces_small_writes(void)
+{
+    uint32_t value = 0;
+    char buffer[16] = {0};
+    int32_t total = 0;
+
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 40);
+    danp_listen(server_socket, 5);
+
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 41);
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, 40));
+
+    danp_socket_t *accepted_socket = danp_accept(server_socket, DANP_WAIT_FOREVER);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+
+    TEST_ASSERT_EQUAL(0, danp_getsockopt(client_socket, DANP_SO_NODELAY, &value));
+    TEST_ASSERT_EQUAL_UINT32(1, value);
+    TEST_ASSERT_EQUAL(0, danp_setsockopt(client_socket, DANP_SO_NODELAY, 0));
+
+    TEST_ASSERT_EQUAL(1, danp_send(client_socket, "a", 1));
+    TEST_ASSERT_EQUAL(1, danp_send(client_socket, "b", 1));
+    TEST_ASSERT_EQUAL(1, danp_send(client_socket, "c", 1));
+    TEST_ASSERT_EQUAL(1, danp_send(client_socket, "d", 1));
+
+    // "a" is in flight, "bcd" share one segment that has not been sent yet.
+    TEST_ASSERT_EQUAL_UINT16(2, client_socket->tx_seq);
+    TEST_ASSERT_EQUAL_UINT16(1, client_socket->snd_max);
+
+    while (total < 4)
+    {
+        int32_t len = danp_recv(accepted_socket, buffer + total, sizeof(buffer) - 1 - total, 1000);
+        TEST_ASSERT_TRUE(len > 0);
+        total += len;
+    }
+    TEST_ASSERT_EQUAL_STRING("abcd", buffer);
+    TEST_ASSERT_EQUAL_UINT16(2, client_socket->snd_max);
+
+    danp_close(client_socket);
+    danp_close(server_socket);
+}
+
+/**
+ * @brief Test that danp_flush() sends a coalesced segment without waiting for the ACK
+ */
+void test_stream_flush_sends_held_segment(void)
+{
+    char buffer[16] = {0};
+
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 42);
+    danp_listen(server_socket, 5);
+
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 43);
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, 42));
+
+    danp_socket_t *accepted_socket = danp_accept(server_socket, DANP_WAIT_FOREVER);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+
+    TEST_ASSERT_EQUAL(0, danp_setsockopt(client_socket, DANP_SO_NODELAY, 0));
+    TEST_ASSERT_EQUAL(1, danp_send(client_socket, "x", 1));
+    TEST_ASSERT_EQUAL(1, danp_send(client_socket, "y", 1));
+    TEST_ASSERT_EQUAL_UINT16(1, client_socket->snd_max);
+
+    TEST_ASSERT_EQUAL(0, danp_flush(client_socket));
+    TEST_ASSERT_EQUAL_UINT16(2, client_socket->snd_max);
+    TEST_ASSERT_EQUAL(2, danp_recv(accepted_socket, buffer, sizeof(buffer) - 1, 0));
+    TEST_ASSERT_EQUAL_STRING("xy", buffer);
+
+    // A flushed segment is closed: later writes start a new one.
+    TEST_ASSERT_EQUAL(1, danp_send(client_socket, "z", 1));
+    TEST_ASSERT_EQUAL_UINT16(3, client_socket->tx_seq);
+
+    danp_close(client_socket);
+    danp_close(server_socket);
+}
+
+typedef struct
+{
+    danp_socket_t *last_sock;
+    uint32_t count[DANP_EVENT_RESET + 1];
+} event_log_t;
+
+static void record_event(danp_socket_t *sock, danp_socket_event_t event, void *user_data)
+{
+    event_log_t *log = (event_log_t *)user_data;
+
+    log->last_sock = sock;
+    log->count[event]++;
+}
+
+/**
+ * @brief Test non-blocking accept, send and recv, and the events they report
+ *
+ * The sender keeps writing until the unread receiver closes its window and
+ * the send window fills; draining the receiver then reports it writable.
+ */
+void test_stream_nonblocking_io_and_events(void)
+{
+    event_log_t server_events = {0};
+    event_log_t client_events = {0};
+    uint8_t data[FILL_SEGMENT_LEN];
+    uint8_t buffer[DANP_STREAM_RX_BUFFER_SIZE];
+    int32_t queued = 0;
+    int32_t ret = 0;
+    int32_t received = 0;
+    uint32_t value = 0;
+
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 44);
+    danp_listen(server_socket, 5);
+    TEST_ASSERT_EQUAL(0, danp_setsockopt(server_socket, DANP_SO_NONBLOCK, 1));
+    TEST_ASSERT_EQUAL(0, danp_socket_set_callback(server_socket, record_event, &server_events));
+
+    TEST_ASSERT_NULL(danp_accept(server_socket, DANP_WAIT_FOREVER));
+
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 45);
+    TEST_ASSERT_EQUAL(0, danp_setsockopt(client_socket, DANP_SO_NONBLOCK, 1));
+    TEST_ASSERT_EQUAL(0, danp_getsockopt(client_socket, DANP_SO_NONBLOCK, &value));
+    TEST_ASSERT_EQUAL_UINT32(1, value);
+    TEST_ASSERT_EQUAL(0, danp_socket_set_callback(client_socket, record_event, &client_events));
+
+    // The loopback answers the SYN before danp_connect() returns.
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, 44));
+    TEST_ASSERT_EQUAL_UINT32(1, client_events.count[DANP_EVENT_CONNECTED]);
+    TEST_ASSERT_EQUAL_UINT32(1, server_events.count[DANP_EVENT_ACCEPT]);
+
+    danp_socket_t *accepted_socket = danp_accept(server_socket, DANP_WAIT_FOREVER);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+    TEST_ASSERT_EQUAL_UINT32(1, server_events.count[DANP_EVENT_CONNECTED]);
+    TEST_ASSERT_EQUAL_PTR(accepted_socket, server_events.last_sock);
+
+    // Accepted connections inherit the non-blocking mode of the listener.
+    TEST_ASSERT_EQUAL(DANP_ERR_WOULD_BLOCK, danp_recv(accepted_socket, buffer, sizeof(buffer), DANP_WAIT_FOREVER));
+
+    memset(data, 0x33, sizeof(data));
+    for (int i = 0; i < 2 * FILL_SEGMENTS + DANP_STREAM_TX_WINDOW; i++)
+    {
+        ret = danp_send(client_socket, data, sizeof(data));
+        if (ret < 0)
+        {
+            break;
+        }
+        queued += ret;
+    }
+    TEST_ASSERT_EQUAL(DANP_ERR_WOULD_BLOCK, ret);
+    TEST_ASSERT_TRUE(queued > 0);
+    TEST_ASSERT_TRUE(server_events.count[DANP_EVENT_DATA_READY] > 0);
+    TEST_ASSERT_EQUAL_UINT32(0, client_events.count[DANP_EVENT_WRITABLE]);
+
+    while (received < queued)
+    {
+        ret = danp_recv(accepted_socket, buffer, sizeof(buffer), 0);
+        if (ret == DANP_ERR_WOULD_BLOCK)
+        {
+            osalDelayMs(DANP_ACK_DELAY_MS);
+            continue;
+        }
+        TEST_ASSERT_TRUE(ret > 0);
+        received += ret;
+    }
+    TEST_ASSERT_EQUAL(queued, received);
+    TEST_ASSERT_TRUE(client_events.count[DANP_EVENT_WRITABLE] > 0);
+
+    danp_setsockopt(client_socket, DANP_SO_LINGER, 0);
+    danp_close(client_socket);
+    TEST_ASSERT_EQUAL_UINT32(1, server_events.count[DANP_EVENT_RESET]);
+    danp_close(server_socket);
+}
+
+/**
+ * @brief Test that a non-blocking connect to a silent port reports its failure
+ */
+void test_stream_nonblocking_connect_times_out(void)
+{
+    event_log_t client_events = {0};
+
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 46);
+    danp_setsockopt(client_socket, DANP_SO_NONBLOCK, 1);
+    danp_socket_set_callback(client_socket, record_event, &client_events);
+
+    TEST_ASSERT_EQUAL(DANP_ERR_IN_PROGRESS, danp_connect(client_socket, TEST_NODE_ID, 47));
+    TEST_ASSERT_EQUAL(DANP_SOCK_SYN_SENT, client_socket->state);
+
+    danp_pollfd_t fd = {.sock = client_socket, .events = DANP_POLLOUT};
+    TEST_ASSERT_EQUAL(1, danp_poll(&fd, 1, DANP_ACK_TIMEOUT_MS * 8));
+    TEST_ASSERT_EQUAL_UINT8(DANP_POLLERR, fd.revents);
+    TEST_ASSERT_EQUAL(DANP_SOCK_OPEN, client_socket->state);
+    TEST_ASSERT_EQUAL_UINT32(1, client_events.count[DANP_EVENT_RESET]);
+    TEST_ASSERT_EQUAL_UINT32(0, client_events.count[DANP_EVENT_CONNECTED]);
+
+    danp_close(client_socket);
+}
+
+/**
+ * @brief Test that the listen backlog bounds pending connections and counts overflows
+ *
+ * The SYN beyond the backlog is dropped without a reply, so that connect
+ * times out; once the backlog is drained a new connection gets through.
+ */
+void test_stream_listen_backlog_limits_pending_connections(void)
+{
+    danp_socket_t *clients[4];
+
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 48);
+    TEST_ASSERT_EQUAL(0, danp_listen(server_socket, 2));
+    TEST_ASSERT_EQUAL_UINT16(2, server_socket->backlog);
+
+    for (int i = 0; i < 4; i++)
+    {
+        clients[i] = danp_socket(DANP_TYPE_STREAM);
+        danp_bind(clients[i], (uint16_t)(49 + i));
+    }
+
+    TEST_ASSERT_EQUAL(0, danp_connect(clients[0], TEST_NODE_ID, 48));
+    TEST_ASSERT_EQUAL(0, danp_connect(clients[1], TEST_NODE_ID, 48));
+    TEST_ASSERT_EQUAL(-1, danp_connect(clients[2], TEST_NODE_ID, 48));
+    TEST_ASSERT_EQUAL_UINT16(2, server_socket->accept_pending);
+    /* Every SYN retry of the refused client is counted */
+    TEST_ASSERT_EQUAL_UINT32(DANP_RETRY_LIMIT, server_socket->syn_overflows);
+
+    danp_socket_t *first = danp_accept(server_socket, 0);
+    danp_socket_t *second = danp_accept(server_socket, 0);
+    TEST_ASSERT_NOT_NULL(first);
+    TEST_ASSERT_NOT_NULL(second);
+    TEST_ASSERT_EQUAL_UINT16(clients[0]->local_port, first->remote_port);
+    TEST_ASSERT_EQUAL_UINT16(clients[1]->local_port, second->remote_port);
+    TEST_ASSERT_NULL(danp_accept(server_socket, 0));
+
+    TEST_ASSERT_EQUAL(0, danp_connect(clients[3], TEST_NODE_ID, 48));
+    TEST_ASSERT_NOT_NULL(danp_accept(server_socket, 0));
+    TEST_ASSERT_EQUAL_UINT32(DANP_RETRY_LIMIT, server_socket->syn_overflows);
+
+    for (int i = 0; i < 4; i++)
+    {
+        danp_close(clients[i]);
+    }
+    danp_close(server_socket);
+}
+
+/**
+ * @brief Test that connections leave the backlog when reset or when the listener closes
+ */
+void test_stream_backlog_releases_reset_connections(void)
+{
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 53);
+    danp_listen(server_socket, 0);
+    TEST_ASSERT_EQUAL_UINT16(DANP_LISTEN_BACKLOG_DEFAULT, server_socket->backlog);
+
+    danp_socket_t *client_a = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_a, 54);
+    danp_socket_t *client_b = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_b, 55);
+
+    TEST_ASSERT_EQUAL(0, danp_connect(client_a, TEST_NODE_ID, 53));
+    TEST_ASSERT_EQUAL(0, danp_connect(client_b, TEST_NODE_ID, 53));
+    TEST_ASSERT_EQUAL_UINT16(2, server_socket->accept_pending);
+
+    // The peer gives up before the connection is accepted.
+    danp_setsockopt(client_a, DANP_SO_LINGER, 0);
+    danp_close(client_a);
+    TEST_ASSERT_EQUAL_UINT16(1, server_socket->accept_pending);
+
+    // Closing the listener resets what is still waiting.
+    danp_close(server_socket);
+    TEST_ASSERT_EQUAL(DANP_SOCK_CLOSED, client_b->state);
+
+    danp_close(client_b);
+}
+
+/**
+ * @brief Test that only connections hold a receive ring and that running out refuses new ones
+ *
+ * A half-open connection to a silent port keeps its ring, so the next client
+ * gets the last ring but its listener has none left for the accepting side.
+ * Once a ring is returned the retried SYN gets through.
+ */
+void test_stream_receive_rings_are_lent_to_connections(void)
+{
+    danp_socket_t *clients[3];
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 33);
+    TEST_ASSERT_EQUAL(0, danp_listen(server_socket, 8));
+    TEST_ASSERT_NULL(server_socket->rx_buf);
+
+    // Both ends of a local connection take a ring.
+    for (int i = 0; i < 3; i++)
+    {
+        clients[i] = danp_socket(DANP_TYPE_STREAM);
+        danp_bind(clients[i], (uint16_t)(49 + i));
+        TEST_ASSERT_NULL(clients[i]->rx_buf);
+        TEST_ASSERT_EQUAL(0, danp_connect(clients[i], TEST_NODE_ID, 33));
+        TEST_ASSERT_NOT_NULL(clients[i]->rx_buf);
+        TEST_ASSERT_EQUAL_UINT16(STREAM_FULL_WINDOW, clients[i]->rx_wnd_advertised);
+    }
+    // Written for the default ring count: two rings are left.
+    TEST_ASSERT_EQUAL(3 * 2, DANP_STREAM_RX_RING_COUNT - 2);
+
+    danp_socket_t *silent = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(silent, 52);
+    danp_setsockopt(silent, DANP_SO_NONBLOCK, 1);
+    TEST_ASSERT_EQUAL(DANP_ERR_IN_PROGRESS, danp_connect(silent, TEST_NODE_ID, 47));
+
+    danp_socket_t *late = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(late, 2);
+    danp_setsockopt(late, DANP_SO_NONBLOCK, 1);
+    TEST_ASSERT_EQUAL(DANP_ERR_IN_PROGRESS, danp_connect(late, TEST_NODE_ID, 33));
+    TEST_ASSERT_EQUAL_UINT32(1, server_socket->syn_overflows);
+    TEST_ASSERT_EQUAL(DANP_SOCK_SYN_SENT, late->state);
+
+    danp_socket_t *refused = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(refused, 3);
+    TEST_ASSERT_EQUAL(-1, danp_connect(refused, TEST_NODE_ID, 33));
+    TEST_ASSERT_NULL(refused->rx_buf);
+
+    danp_close(silent);
+    danp_pollfd_t fd = {.sock = late, .events = DANP_POLLOUT};
+    TEST_ASSERT_EQUAL(1, danp_poll(&fd, 1, DANP_ACK_TIMEOUT_MS * 2));
+    TEST_ASSERT_EQUAL_UINT8(DANP_POLLOUT, fd.revents);
+    TEST_ASSERT_EQUAL(DANP_SOCK_ESTABLISHED, late->state);
+
+    danp_close(refused);
+    danp_close(late);
+    for (int i = 0; i < 3; i++)
+    {
+        danp_close(clients[i]);
+    }
+    danp_close(server_socket);
+}
+
+#define DUPLEX_SEND_LEN 3000
+
+static uint8_t duplex_data[2][DUPLEX_SEND_LEN];
+static danp_socket_t *duplex_socks[2];
+static volatile int32_t duplex_send_result[2];
+static volatile bool duplex_send_done[2];
+
+static void duplex_sender(void *arg)
+{
+    int side = (int)(intptr_t)arg;
+
+    duplex_send_result[side] = danp_send(duplex_socks[side], duplex_data[side], DUPLEX_SEND_LEN);
+    duplex_send_done[side] = true;
+}
+
+/**
+ * @brief Test that both ends of a connection can send at once from their own threads
+ *
+ * Over the synchronous loopback every transmit re-enters the input path of
+ * the other socket, so this deadlocks if a socket lock is held while sending.
+ */
+void test_stream_concurrent_transfers_in_both_directions(void)
+{
+    osalThreadAttr_t thread_attr = {
+        .name = "testDuplex",
+        .stackSize = 1024 * 8,
+        .stackMem = NULL,
+        .priority = OSAL_THREAD_PRIORITY_NORMAL,
+        .cbMem = NULL,
+        .cbSize = 0,
+    };
+    static uint8_t received[2][DUPLEX_SEND_LEN];
+    uint32_t total[2] = { 0, 0 };
+
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 56);
+    danp_listen(server_socket, 1);
+
+    duplex_socks[0] = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(duplex_socks[0], 57);
+    TEST_ASSERT_EQUAL(0, danp_connect(duplex_socks[0], TEST_NODE_ID, 56));
+    duplex_socks[1] = danp_accept(server_socket, DANP_WAIT_FOREVER);
+    TEST_ASSERT_NOT_NULL(duplex_socks[1]);
+
+    for (int side = 0; side < 2; side++)
+    {
+        for (int i = 0; i < DUPLEX_SEND_LEN; i++)
+        {
+            duplex_data[side][i] = (uint8_t)(i * (side + 3));
+        }
+        duplex_send_done[side] = false;
+        TEST_ASSERT_NOT_NULL(osalThreadCreate(duplex_sender, (void *)(intptr_t)side, &thread_attr));
+    }
+
+    // Each side reads what the other one sends.
+    for (int rounds = 0; rounds < 1000 && (total[0] < DUPLEX_SEND_LEN || total[1] < DUPLEX_SEND_LEN); rounds++)
+    {
+        for (int side = 0; side < 2; side++)
+        {
+            int32_t len = danp_recv(
+                duplex_socks[side],
+                received[side] + total[side],
+                (uint16_t)(DUPLEX_SEND_LEN - total[side]),
+                10);
+            if (len > 0)
+            {
+                total[side] += (uint32_t)len;
+            }
+        }
+    }
+
+    for (int wait = 0; wait < 100 && !(duplex_send_done[0] && duplex_send_done[1]); wait++)
+    {
+        osalDelayMs(10);
+    }
+    TEST_ASSERT_TRUE(duplex_send_done[0] && duplex_send_done[1]);
+    TEST_ASSERT_EQUAL(DUPLEX_SEND_LEN, duplex_send_result[0]);
+    TEST_ASSERT_EQUAL(DUPLEX_SEND_LEN, duplex_send_result[1]);
+    TEST_ASSERT_EQUAL_MEMORY(duplex_data[1], received[0], DUPLEX_SEND_LEN);
+    TEST_ASSERT_EQUAL_MEMORY(duplex_data[0], received[1], DUPLEX_SEND_LEN);
+
+    danp_close(duplex_socks[0]);
+    danp_close(duplex_socks[1]);
+    danp_close(server_socket);
+}
+
+/**
+ * @brief Test that the timer service retransmits a lost SYN and reports its next deadline
+ */
+void test_stream_timer_retries_lost_syn(void)
+{
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 58);
+    danp_listen(server_socket, 1);
+
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 59);
+
+    loopback_drop_syns = 1;
+    uint32_t start_ms = osalGetTickMs();
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, 58));
+    TEST_ASSERT_TRUE(osalGetTickMs() - start_ms >= DANP_ACK_TIMEOUT_MS);
+    TEST_ASSERT_EQUAL_UINT32(0, loopback_drop_syns);
+
+    danp_socket_t *accepted_socket = danp_accept(server_socket, 0);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+
+    /* A single segment leaves a delayed ACK pending, the earliest running timer */
+    TEST_ASSERT_EQUAL(1, danp_send(client_socket, "x", 1));
+    TEST_ASSERT_TRUE(accepted_socket->ack_pending);
+    TEST_ASSERT_TRUE(danp_timer_tick() <= DANP_ACK_DELAY_MS);
+
+    danp_close(client_socket);
+    danp_close(accepted_socket);
+    danp_close(server_socket);
+}
+
+/**
+ * @brief Test that a SYN-ACK slower than the retry interval does not reset the connection
+ *
+ * The first two SYN-ACKs are held back, as on a path whose RTT exceeds the SYN
+ * timeout, so the retried SYNs reach a connection in SYN_RECEIVED. The late
+ * SYN-ACKs and a duplicated SYN then reach connections that are established.
+ */
+void test_stream_slow_synack_keeps_connection(void)
+{
+    char buffer[8] = {0};
+
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 62);
+    danp_listen(server_socket, 1);
+
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 63);
+
+    /* Retries back off: the third SYN goes out DANP_ACK_TIMEOUT_MS * 3 after the first */
+    loopback_hold_synacks = 2;
+    uint32_t start_ms = osalGetTickMs();
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, 62));
+    TEST_ASSERT_TRUE(osalGetTickMs() - start_ms >= DANP_ACK_TIMEOUT_MS * 3U);
+    TEST_ASSERT_EQUAL_UINT32(0, loopback_hold_synacks);
+
+    danp_socket_t *accepted_socket = danp_accept(server_socket, 0);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+
+    /* The path duplicates the client's SYN before any data has moved */
+    uint32_t acks = loopback_pure_ack_count;
+    send_raw(62, 63, DANP_FLAG_SYN, NULL, 0);
+    TEST_ASSERT_TRUE(loopback_pure_ack_count >= acks + 1U);
+    TEST_ASSERT_EQUAL(DANP_SOCK_ESTABLISHED, accepted_socket->state);
+
+    TEST_ASSERT_EQUAL(2, danp_send(client_socket, "ab", 2));
+    TEST_ASSERT_EQUAL(2, danp_recv(accepted_socket, buffer, sizeof(buffer), 100));
+
+    /* The held SYN-ACKs arrive late */
+    acks = loopback_pure_ack_count;
+    loopback_release_held();
+    TEST_ASSERT_TRUE(loopback_pure_ack_count >= acks + 2U);
+    TEST_ASSERT_EQUAL(DANP_SOCK_ESTABLISHED, client_socket->state);
+    TEST_ASSERT_EQUAL(DANP_SOCK_ESTABLISHED, accepted_socket->state);
+
+    /* Sequence state survived: the next bytes arrive in order, both ways */
+    TEST_ASSERT_EQUAL(2, danp_send(client_socket, "cd", 2));
+    TEST_ASSERT_EQUAL(2, danp_recv(accepted_socket, buffer, sizeof(buffer), 100));
+    TEST_ASSERT_EQUAL_MEMORY("cd", buffer, 2);
+    TEST_ASSERT_EQUAL(2, danp_send(accepted_socket, "ef", 2));
+    TEST_ASSERT_EQUAL(2, danp_recv(client_socket, buffer, sizeof(buffer), 100));
+    TEST_ASSERT_EQUAL_MEMORY("ef", buffer, 2);
+
+    danp_close(client_socket);
+    danp_close(accepted_socket);
+    danp_close(server_socket);
+}
+
+/**
+ * @brief Test that a peer restarting on the same port resynchronises the connection
+ *
+ * The client vanishes after data has moved both ways, and its reset never
+ * reaches the server. A new client on the same port then connects: its SYN
+ * resets the server's end, and data flows on the fresh sequence numbers.
+ */
+void test_stream_peer_restart_resyncs_connection(void)
+{
+    char buffer[8] = {0};
+
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 62);
+    danp_listen(server_socket, 1);
+
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 63);
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, 62));
+    danp_socket_t *accepted_socket = danp_accept(server_socket, 0);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+    TEST_ASSERT_EQUAL(2, danp_send(client_socket, "ab", 2));
+    TEST_ASSERT_EQUAL(2, danp_recv(accepted_socket, buffer, sizeof(buffer), 100));
+    TEST_ASSERT_EQUAL(2, danp_send(accepted_socket, "cd", 2));
+    TEST_ASSERT_EQUAL(2, danp_recv(client_socket, buffer, sizeof(buffer), 100));
+
+    /* The client goes away and its reset is lost */
+    TEST_ASSERT_EQUAL(0, danp_setsockopt(client_socket, DANP_SO_LINGER, 0));
+    loopback_blackhole_port = 62;
+    danp_close(client_socket);
+    loopback_blackhole_port = 0;
+    TEST_ASSERT_EQUAL(DANP_SOCK_ESTABLISHED, accepted_socket->state);
+
+    /* It comes back on the same port */
+    client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 63);
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, 62));
+    TEST_ASSERT_EQUAL(DANP_SOCK_ESTABLISHED, client_socket->state);
+    TEST_ASSERT_EQUAL(DANP_SOCK_ESTABLISHED, accepted_socket->state);
+
+    TEST_ASSERT_EQUAL(2, danp_send(client_socket, "ef", 2));
+    TEST_ASSERT_EQUAL(2, danp_recv(accepted_socket, buffer, sizeof(buffer), 100));
+    TEST_ASSERT_EQUAL_MEMORY("ef", buffer, 2);
+    TEST_ASSERT_EQUAL(2, danp_send(accepted_socket, "gh", 2));
+    TEST_ASSERT_EQUAL(2, danp_recv(client_socket, buffer, sizeof(buffer), 100));
+    TEST_ASSERT_EQUAL_MEMORY("gh", buffer, 2);
+
+    danp_close(client_socket);
+    danp_close(accepted_socket);
+    danp_close(server_socket);
+}
+
+/**
+ * @brief Test that keepalive probes keep an idle connection up and reset it once the peer is gone
+ */
+void test_stream_keepalive_resets_dead_peer(void)
+{
+    event_log_t client_events = {0};
+    uint32_t value = 0;
+
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 60);
+    danp_listen(server_socket, 1);
+
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 61);
+    TEST_ASSERT_EQUAL(0, danp_getsockopt(client_socket, DANP_SO_KEEPCNT, &value));
+    TEST_ASSERT_EQUAL_UINT32(DANP_KEEPALIVE_COUNT, value);
+    TEST_ASSERT_EQUAL(-1, danp_setsockopt(client_socket, DANP_SO_KEEPIDLE, 0));
+    TEST_ASSERT_EQUAL(0, danp_setsockopt(client_socket, DANP_SO_KEEPIDLE, 30));
+    TEST_ASSERT_EQUAL(0, danp_setsockopt(client_socket, DANP_SO_KEEPINTVL, 20));
+    TEST_ASSERT_EQUAL(0, danp_setsockopt(client_socket, DANP_SO_KEEPCNT, 2));
+    danp_socket_set_callback(client_socket, record_event, &client_events);
+
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, 60));
+    danp_socket_t *accepted_socket = danp_accept(server_socket, 0);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+    TEST_ASSERT_EQUAL(0, danp_setsockopt(client_socket, DANP_SO_KEEPALIVE, 1));
+
+    /* The peer answers every probe, so the idle connection stays up */
+    osalDelayMs(200);
+    TEST_ASSERT_EQUAL(DANP_SOCK_ESTABLISHED, client_socket->state);
+
+    /* The peer disappears without a word */
+    loopback_blackhole_port = 60;
+    for (int wait = 0; wait < 50 && client_socket->state == DANP_SOCK_ESTABLISHED; wait++)
+    {
+        osalDelayMs(10);
+    }
+    loopback_blackhole_port = 0;
+    TEST_ASSERT_EQUAL(DANP_SOCK_CLOSED, client_socket->state);
+    TEST_ASSERT_EQUAL_UINT32(1, client_events.count[DANP_EVENT_RESET]);
+
+    danp_close(client_socket);
+    danp_close(accepted_socket);
+    danp_close(server_socket);
+}
+
+/**
+ * @brief Test that closing delivers data still in flight, then the end of the stream
+ *
+ * The client closes while its segments are being lost. Retransmission
+ * delivers them and the FIN behind them, so the server reads everything and
+ * then 0. The client port then stays in TIME_WAIT.
+ */
+void test_stream_close_delivers_queued_data(void)
+{
+    event_log_t server_events = {0};
+    uint8_t data[3 * FILL_SEGMENT_LEN];
+    uint8_t buffer[sizeof(data)];
+    uint8_t fin[DANP_STREAM_HEADER_SIZE] = {0};
+    int32_t received = 0;
+    int32_t ret = 0;
+
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 62);
+    danp_listen(server_socket, 1);
+    danp_socket_set_callback(server_socket, record_event, &server_events);
+
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 63);
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, 62));
+    danp_socket_t *accepted_socket = danp_accept(server_socket, 0);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+
+    for (uint16_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)i;
+    }
+
+    loopback_blackhole_port = 62;
+    TEST_ASSERT_EQUAL(sizeof(data), danp_send(client_socket, data, sizeof(data)));
+    TEST_ASSERT_EQUAL(0, danp_close(client_socket));
+    loopback_blackhole_port = 0;
+
+    while ((ret = danp_recv(accepted_socket, buffer + received, (uint16_t)(sizeof(buffer) - received), 3000)) > 0)
+    {
+        received += ret;
+    }
+    TEST_ASSERT_EQUAL(0, ret);
+    TEST_ASSERT_EQUAL(sizeof(data), received);
+    TEST_ASSERT_EQUAL_MEMORY(data, buffer, sizeof(data));
+    TEST_ASSERT_EQUAL(DANP_SOCK_CLOSE_WAIT, accepted_socket->state);
+    TEST_ASSERT_EQUAL_UINT32(0, server_events.count[DANP_EVENT_RESET]);
+
+    /* The end of the stream is readable */
+    danp_pollfd_t fd = {.sock = accepted_socket, .events = DANP_POLLIN};
+    TEST_ASSERT_EQUAL(1, danp_poll(&fd, 1, 0));
+    TEST_ASSERT_EQUAL_UINT8(DANP_POLLIN, fd.revents);
+
+    /* Closing the server side completes the shutdown and frees both slots */
+    danp_close(accepted_socket);
+    TEST_ASSERT_EQUAL(DANP_SOCK_CLOSED, client_socket->state);
+    TEST_ASSERT_EQUAL_UINT16(0, client_socket->local_port);
+    TEST_ASSERT_EQUAL_UINT16(0, accepted_socket->local_port);
+
+    /* A retransmitted FIN reaching the port in TIME_WAIT is acknowledged again */
+    loopback_reset_counters();
+    fin[0] = (uint8_t)((DANP_STREAM_V2 << 4) | 0x01);
+    send_raw(63, 62, DANP_FLAG_ACK, fin, sizeof(fin));
+    TEST_ASSERT_EQUAL_UINT32(1, loopback_pure_ack_count);
+    TEST_ASSERT_EQUAL_UINT8(63, loopback_last_ack_src_port);
+
+    danp_close(server_socket);
+}
+
+/**
+ * @brief Test that a linger time makes close wait until the peer acknowledged everything
+ */
+void test_stream_linger_waits_for_acknowledgement(void)
+{
+    uint32_t value = 0;
+    char buffer[8];
+
+    danp_socket_t *server_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(server_socket, 62);
+    danp_listen(server_socket, 1);
+
+    danp_socket_t *client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 63);
+    TEST_ASSERT_EQUAL(0, danp_getsockopt(client_socket, DANP_SO_LINGER, &value));
+    TEST_ASSERT_EQUAL_UINT32(DANP_LINGER_OFF, value);
+    TEST_ASSERT_EQUAL(0, danp_setsockopt(client_socket, DANP_SO_LINGER, 1000));
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, 62));
+    danp_socket_t *accepted_socket = danp_accept(server_socket, 0);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+
+    /* Half-close: the client can still read after it shut down sending */
+    TEST_ASSERT_EQUAL(3, danp_send(client_socket, "abc", 3));
+    TEST_ASSERT_EQUAL(0, danp_shutdown(client_socket));
+    TEST_ASSERT_EQUAL(DANP_SOCK_FIN_WAIT, client_socket->state);
+    TEST_ASSERT_TRUE(danp_send(client_socket, "d", 1) < 0);
+    TEST_ASSERT_EQUAL(3, danp_recv(accepted_socket, buffer, sizeof(buffer), 0));
+    TEST_ASSERT_EQUAL(0, danp_recv(accepted_socket, buffer, sizeof(buffer), 0));
+    TEST_ASSERT_EQUAL(2, danp_send(accepted_socket, "ok", 2));
+    TEST_ASSERT_EQUAL(2, danp_recv(client_socket, buffer, sizeof(buffer), 1000));
+
+    TEST_ASSERT_EQUAL(0, danp_close(client_socket));
+    danp_close(accepted_socket);
+
+    /* A peer that stops answering makes the close give up and reset the connection */
+    client_socket = danp_socket(DANP_TYPE_STREAM);
+    danp_bind(client_socket, 63);
+    TEST_ASSERT_EQUAL(0, danp_setsockopt(client_socket, DANP_SO_LINGER, 100));
+    TEST_ASSERT_EQUAL(0, danp_connect(client_socket, TEST_NODE_ID, 62));
+    accepted_socket = danp_accept(server_socket, 0);
+    TEST_ASSERT_NOT_NULL(accepted_socket);
+
+    loopback_blackhole_port = 62;
+    TEST_ASSERT_EQUAL(1, danp_send(client_socket, "x", 1));
+    uint32_t start_ms = osalGetTickMs();
+    TEST_ASSERT_EQUAL(-1, danp_close(client_socket));
+    TEST_ASSERT_TRUE(osalGetTickMs() - start_ms >= 100);
+    loopback_blackhole_port = 0;
+
+    danp_setsockopt(accepted_socket, DANP_SO_LINGER, 0);
+    danp_close(accepted_socket);
+    danp_close(server_socket);
+}
+
+/* ============================================================================
+ * Test Runner
+ * ============================================================================
+ */
+
+/**
+ * @brief Main test runner
+ *
+ * Executes all STREAM socket tests in sequence
+ */
+int main(void)
+{
+    UNITY_BEGIN();
+
+    /* Run all STREAM socket tests */
+#if ENABLE_TEST_STREAM_HANDSHAKE
+    RUN_TEST(test_stream_handshake_and_data_transfer);
+#endif
+#if ENABLE_TEST_STREAM_CLOSE_RST
+    RUN_TEST(test_stream_close_triggers_rst);
+#endif
+#if ENABLE_TEST_STREAM_SOCKET_STATES
+    RUN_TEST(test_stream_socket_creation_and_states);
+#endif
+#if ENABLE_TEST_STREAM_BIDIRECTIONAL
+    RUN_TEST(test_stream_bidirectional_communication);
+#endif
+#if ENABLE_TEST_STREAM_BIDIRECTIONAL
+    RUN_TEST(test_stream_accept_timeout_returns_null);
+#endif
+#if ENABLE_TEST_STREAM_DELAYED_ACK
+    RUN_TEST(test_stream_delayed_ack_coalesces_segments);
+    RUN_TEST(test_stream_delayed_ack_sent_after_timeout);
+    RUN_TEST(test_stream_ack_piggybacks_on_reply);
+#endif
+#if ENABLE_TEST_STREAM_FLOW_CONTROL
+    RUN_TEST(test_stream_ack_advertises_receive_window);
+    RUN_TEST(test_stream_full_receiver_drops_and_reopens_window);
+    RUN_TEST(test_stream_recv_spans_segments_and_keeps_leftovers);
+    RUN_TEST(test_stream_slow_consumer_applies_backpressure);
+#endif
+#if ENABLE_TEST_STREAM_VERSIONING
+    RUN_TEST(test_stream_v2_sequence_numbers_exceed_one_byte);
+    RUN_TEST(test_stream_v2_falls_back_to_legacy_listener);
+    RUN_TEST(test_stream_v2_serves_legacy_initiator);
+#endif
+#if ENABLE_TEST_STREAM_SEGMENTATION
+    RUN_TEST(test_stream_send_segments_large_buffer);
+    RUN_TEST(test_stream_send_wait_ack_option);
+#endif
+#if ENABLE_TEST_STREAM_COALESCING
+    RUN_TEST(test_stream_nodelay_off_coalesces_small_writes);
+    RUN_TEST(test_stream_flush_sends_held_segment);
+#endif
+#if ENABLE_TEST_STREAM_NONBLOCKING
+    RUN_TEST(test_stream_nonblocking_io_and_events);
+    RUN_TEST(test_stream_nonblocking_connect_times_out);
+#endif
+#if ENABLE_TEST_STREAM_BACKLOG
+    RUN_TEST(test_stream_listen_backlog_limits_pending_connections);
+    RUN_TEST(test_stream_backlog_releases_reset_connections);
+    RUN_TEST(test_stream_receive_rings_are_lent_to_connections);
+#endif
+#if ENABLE_TEST_STREAM_CONCURRENCY
+    RUN_TEST(test_stream_concurrent_transfers_in_both_directions);
+#endif
+#if ENABLE_TEST_STREAM_TIMERS
+    RUN_TEST(test_stream_timer_retries_lost_syn);
+    RUN_TEST(test_stream_slow_synack_keeps_connection);
+    RUN_TEST(test_stream_peer_restart_resyncs_connection);
+    RUN_TEST(test_stream_keepalive_resets_dead_peer);
+#endif
+#if ENABLE_TEST_STREAM_SHUTDOWN
+    RUN_TEST(test_stream_close_delivers_queued_data);
+    RUN_TEST(test_stream_linger_waits_for_acknowledgement);
 #endif
 
     return UNITY_END();
@@ -0,0 +1,389 @@
+/**
+ * @file test_udp.c
+ * @brief UDP driver tests for DANP library
+ *
+ * Two UDP interfaces in one process talk to each other over 127.0.0.1:
+ * - udpA has address 1 and reaches node 2 through udpB's port
+ * - udpB has address 2 and reaches node 1 through udpA's port
+ * The driver threads cannot be stopped, so the interfaces are created once
+ * and shared by all tests.
+ */
+
+#include "danp/danp.h"
+#include "danp/drivers/danp_udp.h"
+#include "osal/osal.h"
+#include "unity.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/* ============================================================================
+ * Test Configuration
+ * ============================================================================
+ */
+
+#define NODE_A 1
+#define NODE_B 2
+#define NODE_C 3
+#define NODE_UNKNOWN 4
+#define NODE_REMOTE 5
+#define MCAST_NET "239.255.68.0"
+#define MCAST_PORT 47068
+
+static danp_udp_interface_t udp_a;
+static danp_udp_interface_t udp_b;
+static bool udp_ready = false;
+
+static void setup_udp_interfaces(void)
+{
+    if (!udp_ready)
+    {
+        danp_udp_config_t config_a = {
+            .name = "udpA",
+            .address = NODE_A,
+            .bind_host = "127.0.0.1",
+            .bind_port = 0,
+            .rx_threads = 1,
+        };
+        danp_udp_config_t config_b = {
+            .name = "udpB",
+            .address = NODE_B,
+            .bind_host = "127.0.0.1",
+            .bind_port = 0,
+            .rx_threads = 1,
+        };
+
+        TEST_ASSERT_EQUAL_INT32(0, danp_udp_init(&udp_a, &config_a));
+        TEST_ASSERT_EQUAL_INT32(0, danp_udp_init(&udp_b, &config_b));
+        TEST_ASSERT_EQUAL_INT32(0, danp_udp_add_peer(&udp_a, NODE_B, "127.0.0.1", udp_b.bound_port));
+        TEST_ASSERT_EQUAL_INT32(0, danp_udp_add_peer(&udp_b, NODE_A, "127.0.0.1", udp_a.bound_port));
+        danp_register_interface(&udp_a);
+        danp_register_interface(&udp_b);
+        udp_ready = true;
+    }
+
+    TEST_ASSERT_EQUAL_INT32(0, danp_route_table_load("2:udpA, 1:udpB"));
+}
+
+/* ============================================================================
+ * Test Setup and Teardown
+ * ============================================================================
+ */
+
+void setUp(void)
+{
+    danp_config_t config = {.local_node = NODE_A};
+    danp_init(&config);
+
+    setup_udp_interfaces();
+}
+
+void tearDown(void)
+{
+    /* Interfaces stay up for the next test */
+}
+
+/* ============================================================================
+ * UDP Driver Tests
+ * ============================================================================
+ */
+
+/**
+ * @brief A datagram and its reply cross the kernel loopback in both directions
+ */
+void test_udp_dgram_round_trip(void)
+{
+    danp_socket_t *sock_a = danp_socket(DANP_TYPE_DGRAM);
+    danp_socket_t *sock_b = danp_socket(DANP_TYPE_DGRAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sock_a, 30));
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sock_b, 31));
+
+    TEST_ASSERT_EQUAL_INT32(4, danp_send_to(sock_a, "ping", 4, NODE_B, 31));
+
+    char buffer[16] = {0};
+    uint16_t src_node = 0;
+    uint16_t src_port = 0;
+    TEST_ASSERT_EQUAL_INT32(4, danp_recv_from(sock_b, buffer, sizeof(buffer), &src_node, &src_port, 1000));
+    TEST_ASSERT_EQUAL_MEMORY("ping", buffer, 4);
+    TEST_ASSERT_EQUAL_UINT16(NODE_A, src_node);
+    TEST_ASSERT_EQUAL_UINT16(30, src_port);
+
+    TEST_ASSERT_EQUAL_INT32(4, danp_send_to(sock_b, "pong", 4, NODE_A, 30));
+    TEST_ASSERT_EQUAL_INT32(4, danp_recv(sock_a, buffer, sizeof(buffer), 1000));
+    TEST_ASSERT_EQUAL_MEMORY("pong", buffer, 4);
+
+    danp_close(sock_a);
+    danp_close(sock_b);
+}
+
+/**
+ * @brief A burst is delivered completely and sent in at most one syscall per datagram
+ */
+void test_udp_burst_is_delivered_in_batches(void)
+{
+    const uint32_t burst = DANP_RX_QUEUE_SIZE - 2; /* stays within the receiver queue */
+    danp_socket_t *sender = danp_socket(DANP_TYPE_DGRAM);
+    danp_socket_t *receiver = danp_socket(DANP_TYPE_DGRAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sender, 32));
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(receiver, 33));
+
+    uint32_t tx_packets = udp_a.stats.tx_packets;
+    uint32_t tx_batches = udp_a.stats.tx_batches;
+    uint32_t rx_packets = udp_b.stats.rx_packets;
+
+    for (uint32_t i = 0; i < burst; i++)
+    {
+        uint8_t value = (uint8_t)i;
+        TEST_ASSERT_EQUAL_INT32(1, danp_send_to(sender, &value, 1, NODE_B, 33));
+    }
+
+    for (uint32_t i = 0; i < burst; i++)
+    {
+        uint8_t value = 0xFF;
+        TEST_ASSERT_EQUAL_INT32(1, danp_recv(receiver, &value, 1, 1000));
+        TEST_ASSERT_EQUAL_UINT8((uint8_t)i, value);
+    }
+
+    /* The transmit thread counts after sendmmsg() returns, which may be after delivery */
+    for (uint32_t waited = 0; waited < 1000 && (udp_a.stats.tx_packets - tx_packets) < burst; waited++)
+    {
+        osalDelayMs(1);
+    }
+    TEST_ASSERT_EQUAL_UINT32(burst, udp_a.stats.tx_packets - tx_packets);
+    TEST_ASSERT_EQUAL_UINT32(burst, udp_b.stats.rx_packets - rx_packets);
+    TEST_ASSERT_TRUE((udp_a.stats.tx_batches - tx_batches) >= 1);
+    TEST_ASSERT_TRUE((udp_a.stats.tx_batches - tx_batches) <= burst);
+
+    danp_close(sender);
+    danp_close(receiver);
+}
+
+/**
+ * @brief Packets routed to a node without an endpoint are counted and dropped
+ */
+void test_udp_drops_packets_for_unknown_nodes(void)
+{
+    TEST_ASSERT_EQUAL_INT32(0, danp_route_table_load("2:udpA, 1:udpB, 4:udpA"));
+    danp_socket_t *sock = danp_socket(DANP_TYPE_DGRAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sock, 34));
+
+    uint32_t drops = udp_a.stats.tx_drops;
+    danp_send_to(sock, "lost", 4, NODE_UNKNOWN, 35);
+    TEST_ASSERT_EQUAL_UINT32(drops + 1, udp_a.stats.tx_drops);
+
+    danp_close(sock);
+}
+
+/**
+ * @brief Several receive threads bind their own sockets to one port
+ */
+void test_udp_reuseport_shares_port_between_rx_threads(void)
+{
+    static danp_udp_interface_t udp_c;
+    danp_udp_config_t config_c = {
+        .name = "udpC",
+        .address = NODE_C,
+        .bind_host = "127.0.0.1",
+        .bind_port = 0,
+        .rx_threads = 2,
+    };
+    TEST_ASSERT_EQUAL_INT32(0, danp_udp_init(&udp_c, &config_c));
+    danp_register_interface(&udp_c);
+
+    TEST_ASSERT_EQUAL_UINT32(2, udp_c.rx_threads);
+    TEST_ASSERT_TRUE(udp_c.fds[0] >= 0);
+    TEST_ASSERT_TRUE(udp_c.fds[1] >= 0);
+    TEST_ASSERT_NOT_EQUAL(udp_c.fds[0], udp_c.fds[1]);
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        struct sockaddr_in local;
+        socklen_t len = sizeof(local);
+        TEST_ASSERT_EQUAL_INT(0, getsockname(udp_c.fds[i], (struct sockaddr *)&local, &len));
+        TEST_ASSERT_EQUAL_UINT16(udp_c.bound_port, ntohs(local.sin_port));
+    }
+
+    TEST_ASSERT_EQUAL_INT32(0, danp_udp_add_peer(&udp_a, NODE_C, "127.0.0.1", udp_c.bound_port));
+    TEST_ASSERT_EQUAL_INT32(0, danp_route_table_load("2:udpA, 1:udpB, 3:udpA"));
+
+    danp_socket_t *sender = danp_socket(DANP_TYPE_DGRAM);
+    danp_socket_t *receiver = danp_socket(DANP_TYPE_DGRAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sender, 36));
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(receiver, 37));
+    TEST_ASSERT_EQUAL_INT32(5, danp_send_to(sender, "hello", 5, NODE_C, 37));
+
+    char buffer[8] = {0};
+    TEST_ASSERT_EQUAL_INT32(5, danp_recv(receiver, buffer, sizeof(buffer), 1000));
+    TEST_ASSERT_EQUAL_MEMORY("hello", buffer, 5);
+    TEST_ASSERT_EQUAL_UINT32(1, udp_c.stats.rx_packets);
+
+    danp_close(sender);
+    danp_close(receiver);
+}
+
+/**
+ * @brief Invalid settings and peer addresses are rejected
+ */
+void test_udp_rejects_invalid_configuration(void)
+{
+    danp_udp_interface_t scratch;
+    danp_udp_config_t config = {
+        .address = 9,
+        .bind_host = "not-an-address",
+        .bind_port = 0,
+        .rx_threads = 1,
+    };
+
+    TEST_ASSERT_EQUAL_INT32(-1, danp_udp_init(&scratch, &config));
+    config.bind_host = "127.0.0.1";
+    config.rx_threads = DANP_UDP_MAX_RX_THREADS + 1;
+    TEST_ASSERT_EQUAL_INT32(-1, danp_udp_init(&scratch, &config));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_udp_init(NULL, &config));
+
+    TEST_ASSERT_EQUAL_INT32(-1, danp_udp_add_peer(&udp_a, 7, "300.0.0.1", 1000));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_udp_add_peer(&udp_a, 7, NULL, 1000));
+}
+
+/**
+ * @brief A STREAM connection is established and carries data over UDP
+ *
+ * The stack has a single node, so udpA sends node 1's traffic to its own port.
+ */
+void test_udp_stream_transfer(void)
+{
+    uint8_t data[600];
+    uint8_t received[600];
+    uint32_t total = 0;
+
+    for (uint32_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)(i * 7U);
+    }
+
+    TEST_ASSERT_EQUAL_INT32(0, danp_udp_add_peer(&udp_a, NODE_A, "127.0.0.1", udp_a.bound_port));
+    TEST_ASSERT_EQUAL_INT32(0, danp_route_table_load("1:udpA"));
+
+    danp_socket_t *server = danp_socket(DANP_TYPE_STREAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(server, 41));
+    TEST_ASSERT_EQUAL_INT32(0, danp_listen(server, 1));
+
+    danp_socket_t *client = danp_socket(DANP_TYPE_STREAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(client, 40));
+    TEST_ASSERT_EQUAL_INT32(0, danp_connect(client, NODE_A, 41));
+
+    danp_socket_t *conn = danp_accept(server, 1000);
+    TEST_ASSERT_NOT_NULL(conn);
+
+    TEST_ASSERT_EQUAL_INT32((int32_t)sizeof(data), danp_send(client, data, sizeof(data)));
+    while (total < sizeof(received))
+    {
+        int32_t len = danp_recv(conn, received + total, (uint16_t)(sizeof(received) - total), 2000);
+        TEST_ASSERT_TRUE(len > 0);
+        total += (uint32_t)len;
+    }
+    TEST_ASSERT_EQUAL_MEMORY(data, received, sizeof(data));
+
+    danp_setsockopt(client, DANP_SO_LINGER, 0);
+    danp_close(client);
+    danp_close(conn);
+    danp_close(server);
+}
+
+/**
+ * @brief Broadcasts leave as IPv4 multicast, and joined groups arrive from other hosts
+ *
+ * A plain socket stands in for a remote node on the multicast block.
+ */
+void test_udp_multicast_groups(void)
+{
+    static danp_udp_interface_t udp_d;
+    danp_udp_config_t config_d = {
+        .name = "udpD",
+        .address = NODE_A,
+        .bind_host = "127.0.0.1",
+        .bind_port = 0,
+        .rx_threads = 1,
+        .multicast_net = MCAST_NET,
+        .multicast_port = MCAST_PORT,
+    };
+    TEST_ASSERT_EQUAL_INT32(0, danp_udp_init(&udp_d, &config_d));
+    TEST_ASSERT_TRUE(udp_d.mcast_fd >= 0);
+    danp_register_interface(&udp_d);
+    TEST_ASSERT_EQUAL_INT32(0, danp_route_table_load("255:udpD, 241:udpD"));
+
+    int remote = socket(AF_INET, SOCK_DGRAM, 0);
+    int one = 1;
+    struct timeval timeout = {.tv_sec = 1, .tv_usec = 0};
+    struct sockaddr_in any = {.sin_family = AF_INET, .sin_port = htons(MCAST_PORT)};
+    struct ip_mreq mreq;
+    mreq.imr_multiaddr.s_addr = inet_addr("239.255.68.255");
+    mreq.imr_interface.s_addr = inet_addr("127.0.0.1");
+    struct in_addr out_if = {.s_addr = inet_addr("127.0.0.1")};
+    TEST_ASSERT_EQUAL_INT(0, setsockopt(remote, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)));
+    TEST_ASSERT_EQUAL_INT(0, bind(remote, (struct sockaddr *)&any, sizeof(any)));
+    TEST_ASSERT_EQUAL_INT(0, setsockopt(remote, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)));
+    TEST_ASSERT_EQUAL_INT(0, setsockopt(remote, IPPROTO_IP, IP_MULTICAST_IF, &out_if, sizeof(out_if)));
+    TEST_ASSERT_EQUAL_INT(0, setsockopt(remote, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)));
+
+    danp_socket_t *sock = danp_socket(DANP_TYPE_DGRAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sock, 43));
+
+    // The broadcast reaches the remote node; the copy looped back to udpD is dropped.
+    uint8_t frame[DANP_HEADER_SIZE + 8];
+    uint32_t header = 0;
+    TEST_ASSERT_EQUAL_INT32(3, danp_send_to(sock, "all", 3, DANP_BROADCAST_NODE, 43));
+    TEST_ASSERT_EQUAL_INT(DANP_HEADER_SIZE + 3, recv(remote, frame, sizeof(frame), 0));
+    memcpy(&header, frame, DANP_HEADER_SIZE);
+    TEST_ASSERT_EQUAL_UINT32(DANP_BROADCAST_NODE, (header >> 22) & 0xFF);
+    char buffer[8] = {0};
+    uint16_t src_node = 0;
+    uint16_t src_port = 0;
+    TEST_ASSERT_EQUAL_INT32(-1, danp_recv_from(sock, buffer, sizeof(buffer), &src_node, &src_port, 100));
+
+    // A group packet from the remote node arrives once a local socket has joined.
+    struct sockaddr_in group = {.sin_family = AF_INET, .sin_port = htons(MCAST_PORT)};
+    group.sin_addr.s_addr = inet_addr("239.255.68.241");
+    header = danp_pack_header(DANP_PRIORITY_NORMAL, 0xF1, NODE_REMOTE, 43, 9, DANP_FLAG_NONE);
+    memcpy(frame, &header, DANP_HEADER_SIZE);
+    memcpy(frame + DANP_HEADER_SIZE, "grp", 3);
+    TEST_ASSERT_EQUAL_INT32(0, danp_setsockopt(sock, DANP_SO_JOIN_GROUP, 0xF1));
+    TEST_ASSERT_EQUAL_INT(
+        DANP_HEADER_SIZE + 3, sendto(remote, frame, DANP_HEADER_SIZE + 3, 0, (struct sockaddr *)&group, sizeof(group)));
+
+    TEST_ASSERT_EQUAL_INT32(3, danp_recv_from(sock, buffer, sizeof(buffer), &src_node, &src_port, 1000));
+    TEST_ASSERT_EQUAL_MEMORY("grp", buffer, 3);
+    TEST_ASSERT_EQUAL_UINT16(NODE_REMOTE, src_node);
+
+    // After leaving, the host no longer delivers the group to udpD.
+    TEST_ASSERT_EQUAL_INT32(0, danp_setsockopt(sock, DANP_SO_LEAVE_GROUP, 0xF1));
+    sendto(remote, frame, DANP_HEADER_SIZE + 3, 0, (struct sockaddr *)&group, sizeof(group));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_recv_from(sock, buffer, sizeof(buffer), &src_node, &src_port, 100));
+
+    close(remote);
+    danp_close(sock);
+}
+
+/* ============================================================================
+ * Test Runner
+ * ============================================================================
+ */
+
+/**
+ * @brief Main test runner
+ */
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_udp_dgram_round_trip);
+    RUN_TEST(test_udp_burst_is_delivered_in_batches);
+    RUN_TEST(test_udp_drops_packets_for_unknown_nodes);
+    RUN_TEST(test_udp_reuseport_shares_port_between_rx_threads);
+    RUN_TEST(test_udp_rejects_invalid_configuration);
+    RUN_TEST(test_udp_stream_transfer);
+    RUN_TEST(test_udp_multicast_groups);
+
+    return UNITY_END();
+}
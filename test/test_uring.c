@@ -0,0 +1,338 @@
+/**
+ * @file test_uring.c
+ * @brief io_uring loop tests for DANP library
+ *
+ * One loop services a UDP interface (address 1) whose peer table sends node 1's
+ * traffic to its own port, plus the stream sources the tests add. The loop keeps
+ * pool packets lent to the kernel, so the stack is initialised only once; the
+ * loop thread cannot be stopped and is shared by all tests.
+ */
+
+#include "danp/danp.h"
+#include "danp/danp_buffer.h"
+#include "danp/drivers/danp_udp.h"
+#include "danp/drivers/danp_uring.h"
+#include "osal/osal.h"
+#include "unity.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/* ============================================================================
+ * Test Configuration
+ * ============================================================================
+ */
+
+#define NODE_A 1
+
+static danp_uring_t loop;
+static danp_udp_interface_t udp_a;
+static bool uring_ready = false;
+static bool uring_unavailable = false;
+
+static uint8_t stream_bytes[64];
+static volatile uint32_t stream_length = 0;
+
+static void stream_on_read(void *arg, const uint8_t *data, uint32_t length)
+{
+    (void)arg;
+    if (stream_length + length <= sizeof(stream_bytes))
+    {
+        memcpy(stream_bytes + stream_length, data, length);
+        stream_length += length;
+    }
+}
+
+/**
+ * @brief Wait up to timeout_ms for a counter to move by at least delta
+ */
+static uint32_t wait_for_count(volatile uint32_t *counter, uint32_t start, uint32_t delta, uint32_t timeout_ms)
+{
+    for (uint32_t waited = 0; waited < timeout_ms && (*counter - start) < delta; waited++)
+    {
+        osalDelayMs(1);
+    }
+    return *counter - start;
+}
+
+/* ============================================================================
+ * Test Setup and Teardown
+ * ============================================================================
+ */
+
+void setUp(void)
+{
+    if (uring_unavailable)
+    {
+        TEST_IGNORE_MESSAGE("io_uring is not available");
+    }
+
+    if (!uring_ready)
+    {
+        danp_config_t config = {.local_node = NODE_A};
+        danp_udp_config_t udp_config = {
+            .name = "udpA",
+            .address = NODE_A,
+            .bind_host = "127.0.0.1",
+            .bind_port = 0,
+            .rx_threads = 1,
+            .uring = &loop,
+        };
+
+        danp_init(&config);
+        if (danp_uring_init(&loop) != 0)
+        {
+            uring_unavailable = true;
+            TEST_IGNORE_MESSAGE("io_uring is not available");
+        }
+        TEST_ASSERT_EQUAL_INT32(0, danp_udp_init(&udp_a, &udp_config));
+        TEST_ASSERT_EQUAL_INT32(0, danp_udp_add_peer(&udp_a, NODE_A, "127.0.0.1", udp_a.bound_port));
+        danp_register_interface(&udp_a);
+        uring_ready = true;
+    }
+
+    TEST_ASSERT_EQUAL_INT32(0, danp_route_table_load("1:udpA"));
+}
+
+void tearDown(void)
+{
+    /* The loop and its interface stay up for the next test */
+}
+
+/* ============================================================================
+ * io_uring Loop Tests
+ * ============================================================================
+ */
+
+/**
+ * @brief A datagram leaves through the loop and comes back in a lent pool packet
+ */
+void test_uring_udp_dgram_round_trip(void)
+{
+    danp_socket_t *sock_a = danp_socket(DANP_TYPE_DGRAM);
+    danp_socket_t *sock_b = danp_socket(DANP_TYPE_DGRAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sock_a, 30));
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sock_b, 31));
+    uint32_t rx_packets = loop.stats.rx_packets;
+
+    TEST_ASSERT_EQUAL_INT32(4, danp_send_to(sock_a, "ping", 4, NODE_A, 31));
+
+    char buffer[16] = {0};
+    uint16_t src_node = 0;
+    uint16_t src_port = 0;
+    TEST_ASSERT_EQUAL_INT32(4, danp_recv_from(sock_b, buffer, sizeof(buffer), &src_node, &src_port, 1000));
+    TEST_ASSERT_EQUAL_MEMORY("ping", buffer, 4);
+    TEST_ASSERT_EQUAL_UINT16(NODE_A, src_node);
+    TEST_ASSERT_EQUAL_UINT16(30, src_port);
+    TEST_ASSERT_EQUAL_UINT32(1, loop.stats.rx_packets - rx_packets);
+
+    danp_close(sock_a);
+    danp_close(sock_b);
+}
+
+/**
+ * @brief A burst arrives complete and in order, with fewer system calls than frames
+ */
+void test_uring_udp_burst_needs_few_system_calls(void)
+{
+    const uint32_t burst = DANP_RX_QUEUE_SIZE - 2; /* stays within the receiver queue */
+    danp_socket_t *sender = danp_socket(DANP_TYPE_DGRAM);
+    danp_socket_t *receiver = danp_socket(DANP_TYPE_DGRAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sender, 32));
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(receiver, 33));
+
+    uint32_t tx_packets = loop.stats.tx_packets;
+    uint32_t rx_packets = loop.stats.rx_packets;
+    uint32_t enters = loop.stats.enters;
+
+    for (uint32_t i = 0; i < burst; i++)
+    {
+        uint8_t value = (uint8_t)i;
+        TEST_ASSERT_EQUAL_INT32(1, danp_send_to(sender, &value, 1, NODE_A, 33));
+    }
+    for (uint32_t i = 0; i < burst; i++)
+    {
+        uint8_t value = 0xFF;
+        TEST_ASSERT_EQUAL_INT32(1, danp_recv(receiver, &value, 1, 1000));
+        TEST_ASSERT_EQUAL_UINT8((uint8_t)i, value);
+    }
+
+    /* The loop counts a send when its completion is reaped, which may be after delivery */
+    TEST_ASSERT_EQUAL_UINT32(burst, wait_for_count(&loop.stats.tx_packets, tx_packets, burst, 1000));
+    TEST_ASSERT_EQUAL_UINT32(burst, loop.stats.rx_packets - rx_packets);
+    /* Sending and receiving one at a time would take at least one call per frame each way */
+    TEST_ASSERT_TRUE((loop.stats.enters - enters) < 2 * burst);
+
+    danp_close(sender);
+    danp_close(receiver);
+}
+
+/**
+ * @brief The kernel holds exactly DANP_URING_RX_BUFFERS pool packets while idle
+ */
+void test_uring_lends_pool_packets_to_the_kernel(void)
+{
+    uint32_t expected = DANP_POOL_SIZE - DANP_URING_RX_BUFFERS;
+
+    /* Delivered packets are replaced on the loop's next pass */
+    for (uint32_t waited = 0; waited < 1000 && (uint32_t)danp_buffer_get_free_count() != expected; waited++)
+    {
+        osalDelayMs(1);
+    }
+    TEST_ASSERT_EQUAL_UINT32(expected, (uint32_t)danp_buffer_get_free_count());
+}
+
+/**
+ * @brief Datagrams too short or too long for a frame are dropped and their packet reused
+ */
+void test_uring_drops_malformed_datagrams(void)
+{
+    uint8_t oversized[DANP_HEADER_SIZE + DANP_MAX_PACKET_SIZE + 1];
+    struct sockaddr_in to;
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    TEST_ASSERT_TRUE(fd >= 0);
+    uint32_t rx_drops = loop.stats.rx_drops;
+
+    memset(oversized, 0, sizeof(oversized));
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_port = htons(udp_a.bound_port);
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    TEST_ASSERT_EQUAL_INT(2, sendto(fd, oversized, 2, 0, (struct sockaddr *)&to, sizeof(to)));
+    TEST_ASSERT_EQUAL_INT((int)sizeof(oversized), sendto(fd, oversized, sizeof(oversized), 0, (struct sockaddr *)&to, sizeof(to)));
+
+    TEST_ASSERT_EQUAL_UINT32(2, wait_for_count(&loop.stats.rx_drops, rx_drops, 2, 1000));
+    close(fd);
+}
+
+/**
+ * @brief A stream source hands read bytes to its callback and writes queued frames
+ */
+void test_uring_stream_source_reads_and_writes(void)
+{
+    int pair[2];
+    char buffer[8] = {0};
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, pair));
+
+    int32_t source = danp_uring_add_stream(&loop, pair[0], stream_on_read, NULL);
+    TEST_ASSERT_TRUE(source >= 0);
+
+    stream_length = 0;
+    TEST_ASSERT_EQUAL_INT(5, write(pair[1], "hello", 5));
+    for (uint32_t waited = 0; waited < 1000 && stream_length < 5; waited++)
+    {
+        osalDelayMs(1);
+    }
+    TEST_ASSERT_EQUAL_UINT32(5, stream_length);
+    TEST_ASSERT_EQUAL_MEMORY("hello", stream_bytes, 5);
+
+    TEST_ASSERT_EQUAL_INT32(0, danp_uring_send(&loop, source, "wor", 3, NULL, 0));
+    TEST_ASSERT_EQUAL_INT32(0, danp_uring_send(&loop, source, "ld", 2, NULL, 0));
+    uint32_t total = 0;
+    while (total < 5)
+    {
+        ssize_t len = read(pair[1], buffer + total, 5 - total);
+        TEST_ASSERT_TRUE(len > 0);
+        total += (uint32_t)len;
+    }
+    TEST_ASSERT_EQUAL_MEMORY("world", buffer, 5);
+
+    /* The peer going away stops the source instead of spinning on end of file */
+    close(pair[1]);
+    osalDelayMs(20);
+    uint32_t rx_reads = loop.stats.rx_reads;
+    osalDelayMs(20);
+    TEST_ASSERT_EQUAL_UINT32(rx_reads, loop.stats.rx_reads);
+}
+
+/**
+ * @brief Invalid arguments and settings are rejected
+ */
+void test_uring_rejects_invalid_arguments(void)
+{
+    uint8_t frame[DANP_URING_FRAME_SIZE + 1] = {0};
+    danp_udp_interface_t scratch;
+    danp_udp_config_t config = {
+        .address = 9,
+        .bind_host = "127.0.0.1",
+        .bind_port = 0,
+        .rx_threads = 2,
+        .uring = &loop,
+    };
+
+    TEST_ASSERT_EQUAL_INT32(-1, danp_uring_init(NULL));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_uring_send(&loop, udp_a.uring_source, frame, sizeof(frame), NULL, 0));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_uring_send(&loop, DANP_URING_MAX_SOURCES, frame, 1, NULL, 0));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_uring_send(&loop, -1, frame, 1, NULL, 0));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_uring_add_stream(&loop, 0, NULL, NULL));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_uring_add_datagram(&loop, NULL, 0));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_uring_add_datagram(&loop, &udp_a.common, -1));
+
+    /* A loop services one socket per interface */
+    TEST_ASSERT_EQUAL_INT32(-1, danp_udp_init(&scratch, &config));
+}
+
+/**
+ * @brief A STREAM connection runs over the loop, with replies sent from the loop thread
+ */
+void test_uring_udp_stream_transfer(void)
+{
+    uint8_t data[600];
+    uint8_t received[600];
+    uint32_t total = 0;
+
+    for (uint32_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)(i * 7U);
+    }
+
+    danp_socket_t *server = danp_socket(DANP_TYPE_STREAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(server, 41));
+    TEST_ASSERT_EQUAL_INT32(0, danp_listen(server, 1));
+
+    danp_socket_t *client = danp_socket(DANP_TYPE_STREAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(client, 40));
+    TEST_ASSERT_EQUAL_INT32(0, danp_connect(client, NODE_A, 41));
+
+    danp_socket_t *conn = danp_accept(server, 1000);
+    TEST_ASSERT_NOT_NULL(conn);
+
+    TEST_ASSERT_EQUAL_INT32((int32_t)sizeof(data), danp_send(client, data, sizeof(data)));
+    while (total < sizeof(received))
+    {
+        int32_t len = danp_recv(conn, received + total, (uint16_t)(sizeof(received) - total), 2000);
+        TEST_ASSERT_TRUE(len > 0);
+        total += (uint32_t)len;
+    }
+    TEST_ASSERT_EQUAL_MEMORY(data, received, sizeof(data));
+
+    danp_setsockopt(client, DANP_SO_LINGER, 0);
+    danp_close(client);
+    danp_close(conn);
+    danp_close(server);
+}
+
+/* ============================================================================
+ * Test Runner
+ * ============================================================================
+ */
+
+/**
+ * @brief Main test runner
+ */
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_uring_udp_dgram_round_trip);
+    RUN_TEST(test_uring_udp_burst_needs_few_system_calls);
+    RUN_TEST(test_uring_lends_pool_packets_to_the_kernel);
+    RUN_TEST(test_uring_drops_malformed_datagrams);
+    RUN_TEST(test_uring_stream_source_reads_and_writes);
+    RUN_TEST(test_uring_rejects_invalid_arguments);
+    RUN_TEST(test_uring_udp_stream_transfer);
+
+    return UNITY_END();
+}
@@ -0,0 +1,394 @@
+/**
+ * @file test_zmq.c
+ * @brief ZeroMQ driver tests for DANP library
+ *
+ * The interface "zmq" has address 1. Its PUB socket binds ZMQ_EP_DRIVER and its
+ * SUB socket listens on that endpoint and on ZMQ_EP_RAW, so traffic to node 1
+ * comes back to the stack. The tests own a second ZMQ context next to the
+ * driver's:
+ * - raw_sub subscribes to node 2 on ZMQ_EP_DRIVER and sees the frames the
+ *   driver publishes, byte for byte
+ * - raw_pub binds ZMQ_EP_RAW and feeds hand-built frames to the driver
+ * The receive thread only stops with danp_zmq_shutdown(), so the interface is
+ * created once and shared; the shutdown test runs last and opens it again.
+ */
+
+#include "danp/danp.h"
+#include "danp/drivers/danp_zmq.h"
+#include "osal/osal.h"
+#include "unity.h"
+#include <string.h>
+#include <zmq.h>
+
+/* ============================================================================
+ * Test Configuration
+ * ============================================================================
+ */
+
+#define NODE_A 1
+#define NODE_B 2
+#define ZMQ_EP_DRIVER "tcp://127.0.0.1:47110"
+#define ZMQ_EP_RAW "tcp://127.0.0.1:47111"
+#define ZMQ_EP_REINIT "tcp://127.0.0.1:47112"
+#define ZMQ_JOIN_MS 200
+#define ZMQ_RECV_TIMEOUT_MS 1000
+#define ZMQ_FRAME_MAX (DANP_ZMQ_AGG_MAX_BYTES)
+
+static danp_zmq_interface_t zmq_a;
+static bool zmq_ready = false;
+static void *raw_context = NULL;
+static void *raw_pub = NULL;
+static void *raw_sub = NULL;
+
+static void open_driver(const char *endpoint)
+{
+    const char *peers[] = {endpoint, ZMQ_EP_RAW};
+
+    danp_zmq_init(&zmq_a, endpoint, peers, 2, NODE_A);
+    TEST_ASSERT_NOT_NULL(zmq_a.context);
+    zmq_a.common.name = "zmq";
+}
+
+static void setup_zmq_interface(void)
+{
+    if (!zmq_ready)
+    {
+        int timeout_ms = ZMQ_RECV_TIMEOUT_MS;
+        uint8_t topic = NODE_B;
+
+        raw_context = zmq_ctx_new();
+        TEST_ASSERT_NOT_NULL(raw_context);
+        raw_pub = zmq_socket(raw_context, ZMQ_PUB);
+        TEST_ASSERT_EQUAL_INT(0, zmq_bind(raw_pub, ZMQ_EP_RAW));
+
+        open_driver(ZMQ_EP_DRIVER);
+        danp_register_interface(&zmq_a);
+
+        raw_sub = zmq_socket(raw_context, ZMQ_SUB);
+        TEST_ASSERT_EQUAL_INT(0, zmq_setsockopt(raw_sub, ZMQ_SUBSCRIBE, &topic, sizeof(topic)));
+        TEST_ASSERT_EQUAL_INT(0, zmq_setsockopt(raw_sub, ZMQ_RCVTIMEO, &timeout_ms, sizeof(timeout_ms)));
+        TEST_ASSERT_EQUAL_INT(0, zmq_connect(raw_sub, ZMQ_EP_DRIVER));
+
+        // Subscriptions travel to the publishers asynchronously.
+        osalDelayMs(ZMQ_JOIN_MS);
+        zmq_ready = true;
+    }
+
+    TEST_ASSERT_EQUAL_INT32(0, danp_route_table_load("1:zmq, 2:zmq"));
+}
+
+/**
+ * @brief Write the topic and header of a single-packet frame the way a peer would
+ * @return Offset of the payload.
+ */
+static uint32_t put_frame(uint8_t *frame, uint16_t dst, uint16_t src, uint8_t dst_port, uint8_t src_port)
+{
+    uint32_t header = danp_pack_header(0, dst, src, dst_port, src_port, DANP_FLAG_NONE);
+
+    frame[0] = (uint8_t)dst;
+    frame[1] = DANP_ZMQ_KIND_SINGLE;
+    memcpy(frame + DANP_ZMQ_TOPIC_SIZE, &header, DANP_HEADER_SIZE);
+    return DANP_ZMQ_TOPIC_SIZE + DANP_HEADER_SIZE;
+}
+
+/**
+ * @brief Append one length-prefixed entry to a bundle
+ * @return Offset after the entry.
+ */
+static uint32_t put_entry(uint8_t *bundle, uint32_t offset, uint16_t src, uint8_t dst_port, uint8_t src_port, const char *payload)
+{
+    uint16_t entry_len = (uint16_t)(DANP_HEADER_SIZE + strlen(payload));
+    uint32_t header = danp_pack_header(0, NODE_A, src, dst_port, src_port, DANP_FLAG_NONE);
+
+    bundle[offset] = (uint8_t)(entry_len >> 8);
+    bundle[offset + 1] = (uint8_t)entry_len;
+    memcpy(bundle + offset + 2, &header, DANP_HEADER_SIZE);
+    memcpy(bundle + offset + 2 + DANP_HEADER_SIZE, payload, strlen(payload));
+    return offset + 2U + entry_len;
+}
+
+static void check_header(const uint8_t *raw, uint16_t dst, uint16_t src, uint8_t dst_port, uint8_t src_port)
+{
+    uint32_t header;
+    uint16_t got_dst, got_src;
+    uint8_t got_dst_port, got_src_port, got_flags;
+
+    memcpy(&header, raw, DANP_HEADER_SIZE);
+    danp_unpack_header(header, &got_dst, &got_src, &got_dst_port, &got_src_port, &got_flags);
+    TEST_ASSERT_EQUAL_UINT16(dst, got_dst);
+    TEST_ASSERT_EQUAL_UINT16(src, got_src);
+    TEST_ASSERT_EQUAL_UINT8(dst_port, got_dst_port);
+    TEST_ASSERT_EQUAL_UINT8(src_port, got_src_port);
+}
+
+/**
+ * @brief Wait until a driver counter reaches a value
+ */
+static bool wait_for_count(const uint32_t *counter, uint32_t value, uint32_t timeout_ms)
+{
+    uint32_t start_ms = osalGetTickMs();
+
+    while (__atomic_load_n(counter, __ATOMIC_ACQUIRE) < value)
+    {
+        if (osalGetTickMs() - start_ms >= timeout_ms)
+        {
+            return false;
+        }
+        osalDelayMs(1);
+    }
+    return true;
+}
+
+/* ============================================================================
+ * Test Setup and Teardown
+ * ============================================================================
+ */
+
+void setUp(void)
+{
+    danp_config_t config = {.local_node = NODE_A};
+    danp_init(&config);
+
+    setup_zmq_interface();
+}
+
+void tearDown(void)
+{
+    uint8_t frame[ZMQ_FRAME_MAX];
+
+    danp_zmq_set_aggregation(&zmq_a, 0, 0);
+    while (zmq_recv(raw_sub, frame, sizeof(frame), ZMQ_DONTWAIT) >= 0)
+    {
+    }
+}
+
+/* ============================================================================
+ * ZMQ Driver Tests
+ * ============================================================================
+ */
+
+/**
+ * @brief A packet travels as one message: node, kind, header, payload
+ */
+void test_zmq_single_frame_format(void)
+{
+    uint8_t frame[ZMQ_FRAME_MAX];
+    char buffer[8] = {0};
+    uint16_t src_node = 0;
+    uint16_t src_port = 0;
+    uint32_t tx_frames = zmq_a.stats.tx_pool_frames + zmq_a.stats.tx_copied;
+    uint32_t rx_packets = zmq_a.stats.rx_packets;
+    uint32_t rx_drops = zmq_a.stats.rx_drops;
+
+    danp_socket_t *sock = danp_socket(DANP_TYPE_DGRAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sock, 30));
+
+    // Out: the frame as published.
+    TEST_ASSERT_EQUAL_INT32(3, danp_send_to(sock, "abc", 3, NODE_B, 31));
+    TEST_ASSERT_EQUAL_INT(DANP_ZMQ_TOPIC_SIZE + DANP_HEADER_SIZE + 3, zmq_recv(raw_sub, frame, sizeof(frame), 0));
+    TEST_ASSERT_EQUAL_UINT8(NODE_B, frame[0]);
+    TEST_ASSERT_EQUAL_UINT8(DANP_ZMQ_KIND_SINGLE, frame[1]);
+    check_header(frame + DANP_ZMQ_TOPIC_SIZE, NODE_B, NODE_A, 31, 30);
+    TEST_ASSERT_EQUAL_MEMORY("abc", frame + DANP_ZMQ_TOPIC_SIZE + DANP_HEADER_SIZE, 3);
+    TEST_ASSERT_EQUAL_UINT32(tx_frames + 1U, zmq_a.stats.tx_pool_frames + zmq_a.stats.tx_copied);
+
+    // In: a frame from a peer reaches the socket.
+    uint32_t len = put_frame(frame, NODE_A, NODE_B, 30, 31);
+    memcpy(frame + len, "xyz", 3);
+    TEST_ASSERT_EQUAL_INT((int)len + 3, zmq_send(raw_pub, frame, len + 3U, 0));
+    TEST_ASSERT_EQUAL_INT32(3, danp_recv_from(sock, buffer, sizeof(buffer), &src_node, &src_port, ZMQ_RECV_TIMEOUT_MS));
+    TEST_ASSERT_EQUAL_MEMORY("xyz", buffer, 3);
+    TEST_ASSERT_EQUAL_UINT16(NODE_B, src_node);
+    TEST_ASSERT_EQUAL_UINT16(31, src_port);
+    TEST_ASSERT_EQUAL_UINT32(rx_packets + 1U, zmq_a.stats.rx_packets);
+
+    // A message too short for a header is counted and dropped.
+    TEST_ASSERT_EQUAL_INT(DANP_ZMQ_TOPIC_SIZE + 1, zmq_send(raw_pub, frame, DANP_ZMQ_TOPIC_SIZE + 1U, 0));
+    TEST_ASSERT_TRUE(wait_for_count(&zmq_a.stats.rx_drops, rx_drops + 1U, ZMQ_RECV_TIMEOUT_MS));
+
+    danp_close(sock);
+}
+
+/**
+ * @brief A burst larger than the pool frames ZMQ may hold still reaches a subscriber that reads late
+ */
+void test_zmq_burst_reaches_slow_subscriber(void)
+{
+    uint8_t frame[ZMQ_FRAME_MAX];
+    uint8_t payload;
+    uint32_t burst = DANP_ZMQ_POOL_FRAMES * 4U;
+    uint32_t tx_drops = zmq_a.stats.tx_drops;
+
+    danp_socket_t *sock = danp_socket(DANP_TYPE_DGRAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sock, 30));
+
+    for (uint32_t i = 0; i < burst; i++)
+    {
+        payload = (uint8_t)i;
+        TEST_ASSERT_EQUAL_INT32(1, danp_send_to(sock, &payload, 1, NODE_B, 31));
+    }
+    TEST_ASSERT_EQUAL_UINT32(tx_drops, zmq_a.stats.tx_drops);
+
+    for (uint32_t i = 0; i < burst; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(DANP_ZMQ_TOPIC_SIZE + DANP_HEADER_SIZE + 1, zmq_recv(raw_sub, frame, sizeof(frame), 0));
+        TEST_ASSERT_EQUAL_UINT8((uint8_t)i, frame[DANP_ZMQ_TOPIC_SIZE + DANP_HEADER_SIZE]);
+    }
+
+    danp_close(sock);
+}
+
+/**
+ * @brief Packets to one node share a bundle of big-endian length-prefixed entries
+ */
+void test_zmq_bundle_pack_and_unpack(void)
+{
+    static const char *payloads[] = {"a", "bcd", ""};
+    uint8_t bundle[ZMQ_FRAME_MAX];
+    char buffer[8];
+    uint32_t tx_bundles = zmq_a.stats.tx_bundles;
+    uint32_t rx_bundles = zmq_a.stats.rx_bundles;
+    uint32_t rx_drops = zmq_a.stats.rx_drops;
+
+    TEST_ASSERT_EQUAL_INT32(-1, danp_zmq_set_aggregation(&zmq_a, DANP_ZMQ_AGG_MAX_BYTES + 1U, 0));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_zmq_set_aggregation(&zmq_a, DANP_MAX_PACKET_SIZE, 0));
+    TEST_ASSERT_EQUAL_INT32(0, danp_zmq_set_aggregation(&zmq_a, DANP_ZMQ_AGG_MAX_BYTES, 20000));
+
+    danp_socket_t *sock = danp_socket(DANP_TYPE_DGRAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sock, 32));
+
+    // Pack: three datagrams leave in one message.
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        uint16_t len = (uint16_t)strlen(payloads[i]);
+        TEST_ASSERT_EQUAL_INT32(len, danp_send_to(sock, (void *)payloads[i], len, NODE_B, (uint16_t)(40 + i)));
+    }
+    int total = zmq_recv(raw_sub, bundle, sizeof(bundle), 0);
+    TEST_ASSERT_GREATER_THAN_INT(DANP_ZMQ_TOPIC_SIZE, total);
+    TEST_ASSERT_EQUAL_UINT8(NODE_B, bundle[0]);
+    TEST_ASSERT_EQUAL_UINT8(DANP_ZMQ_KIND_BUNDLE, bundle[1]);
+    uint32_t offset = DANP_ZMQ_TOPIC_SIZE;
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        uint16_t len = (uint16_t)strlen(payloads[i]);
+        TEST_ASSERT_EQUAL_UINT16(DANP_HEADER_SIZE + len, (uint16_t)((bundle[offset] << 8) | bundle[offset + 1]));
+        check_header(bundle + offset + 2, NODE_B, NODE_A, (uint8_t)(40 + i), 32);
+        TEST_ASSERT_EQUAL_MEMORY(payloads[i], bundle + offset + 2 + DANP_HEADER_SIZE, len);
+        offset += 2U + DANP_HEADER_SIZE + len;
+    }
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)total, offset);
+    TEST_ASSERT_EQUAL_UINT32(tx_bundles + 1U, zmq_a.stats.tx_bundles);
+
+    // Unpack: whole entries are delivered in order, a truncated tail is dropped.
+    bundle[0] = NODE_A;
+    bundle[1] = DANP_ZMQ_KIND_BUNDLE;
+    offset = DANP_ZMQ_TOPIC_SIZE;
+    offset = put_entry(bundle, offset, NODE_B, 32, 50, "one");
+    offset = put_entry(bundle, offset, NODE_B, 32, 51, "two");
+    bundle[offset] = 0;
+    bundle[offset + 1] = DANP_HEADER_SIZE + 8;
+    memset(bundle + offset + 2, 0, DANP_HEADER_SIZE);
+    offset += 2U + DANP_HEADER_SIZE;
+    TEST_ASSERT_EQUAL_INT((int)offset, zmq_send(raw_pub, bundle, offset, 0));
+
+    TEST_ASSERT_EQUAL_INT32(3, danp_recv(sock, buffer, sizeof(buffer), ZMQ_RECV_TIMEOUT_MS));
+    TEST_ASSERT_EQUAL_MEMORY("one", buffer, 3);
+    TEST_ASSERT_EQUAL_INT32(3, danp_recv(sock, buffer, sizeof(buffer), ZMQ_RECV_TIMEOUT_MS));
+    TEST_ASSERT_EQUAL_MEMORY("two", buffer, 3);
+    TEST_ASSERT_EQUAL_UINT32(rx_bundles + 1U, zmq_a.stats.rx_bundles);
+    TEST_ASSERT_EQUAL_UINT32(rx_drops + 1U, zmq_a.stats.rx_drops);
+
+    danp_close(sock);
+}
+
+/**
+ * @brief A bundle that never fills leaves once its first packet has waited the delay
+ */
+void test_zmq_deadline_flush(void)
+{
+    const uint32_t delay_ms = 30;
+    uint8_t frame[ZMQ_FRAME_MAX];
+
+    TEST_ASSERT_EQUAL_INT32(0, danp_zmq_set_aggregation(&zmq_a, DANP_ZMQ_AGG_MAX_BYTES, delay_ms * 1000U));
+
+    danp_socket_t *sock = danp_socket(DANP_TYPE_DGRAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sock, 34));
+
+    uint32_t start_ms = osalGetTickMs();
+    TEST_ASSERT_EQUAL_INT32(1, danp_send_to(sock, "x", 1, NODE_B, 35));
+    osalDelayMs(delay_ms / 3U);
+    TEST_ASSERT_EQUAL_INT(-1, zmq_recv(raw_sub, frame, sizeof(frame), ZMQ_DONTWAIT));
+
+    TEST_ASSERT_EQUAL_INT(DANP_ZMQ_TOPIC_SIZE + 2 + DANP_HEADER_SIZE + 1, zmq_recv(raw_sub, frame, sizeof(frame), 0));
+    uint32_t elapsed_ms = osalGetTickMs() - start_ms;
+    TEST_ASSERT_EQUAL_UINT8(DANP_ZMQ_KIND_BUNDLE, frame[1]);
+    // The tick may have turned just before the send.
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(delay_ms - 1U, elapsed_ms);
+    TEST_ASSERT_LESS_THAN_UINT32(ZMQ_RECV_TIMEOUT_MS, elapsed_ms);
+
+    danp_close(sock);
+}
+
+/**
+ * @brief Shutdown sends what is pending and closes the interface; init opens it again
+ */
+void test_zmq_shutdown_and_reinit(void)
+{
+    uint8_t frame[ZMQ_FRAME_MAX];
+    char buffer[8];
+
+    danp_socket_t *sock = danp_socket(DANP_TYPE_DGRAM);
+    TEST_ASSERT_EQUAL_INT32(0, danp_bind(sock, 36));
+
+    // A bundle far from its deadline still goes out.
+    TEST_ASSERT_EQUAL_INT32(0, danp_zmq_set_aggregation(&zmq_a, DANP_ZMQ_AGG_MAX_BYTES, 10000000));
+    TEST_ASSERT_EQUAL_INT32(1, danp_send_to(sock, "p", 1, NODE_B, 37));
+    TEST_ASSERT_EQUAL_INT32(0, danp_zmq_shutdown());
+    TEST_ASSERT_EQUAL_INT(DANP_ZMQ_TOPIC_SIZE + 2 + DANP_HEADER_SIZE + 1, zmq_recv(raw_sub, frame, sizeof(frame), 0));
+    TEST_ASSERT_EQUAL_UINT8(DANP_ZMQ_KIND_BUNDLE, frame[1]);
+
+    // The closed interface refuses to send and to be configured.
+    uint32_t tx_frames = zmq_a.stats.tx_pool_frames + zmq_a.stats.tx_copied + zmq_a.stats.tx_bundled;
+    danp_send_to(sock, "q", 1, NODE_B, 37);
+    TEST_ASSERT_EQUAL_UINT32(tx_frames, zmq_a.stats.tx_pool_frames + zmq_a.stats.tx_copied + zmq_a.stats.tx_bundled);
+    TEST_ASSERT_EQUAL_INT32(-1, danp_zmq_set_aggregation(&zmq_a, 0, 0));
+    TEST_ASSERT_EQUAL_INT32(-1, danp_zmq_shutdown());
+
+    // The same interface opens again on a new endpoint and carries traffic both ways.
+    open_driver(ZMQ_EP_REINIT);
+    TEST_ASSERT_EQUAL_INT(0, zmq_connect(raw_sub, ZMQ_EP_REINIT));
+    osalDelayMs(ZMQ_JOIN_MS);
+
+    TEST_ASSERT_EQUAL_INT32(1, danp_send_to(sock, "r", 1, NODE_B, 37));
+    TEST_ASSERT_EQUAL_INT(DANP_ZMQ_TOPIC_SIZE + DANP_HEADER_SIZE + 1, zmq_recv(raw_sub, frame, sizeof(frame), 0));
+    TEST_ASSERT_EQUAL_UINT8(DANP_ZMQ_KIND_SINGLE, frame[1]);
+    TEST_ASSERT_EQUAL_MEMORY("r", frame + DANP_ZMQ_TOPIC_SIZE + DANP_HEADER_SIZE, 1);
+
+    TEST_ASSERT_EQUAL_INT32(1, danp_send_to(sock, "s", 1, NODE_A, 36));
+    TEST_ASSERT_EQUAL_INT32(1, danp_recv(sock, buffer, sizeof(buffer), ZMQ_RECV_TIMEOUT_MS));
+    TEST_ASSERT_EQUAL_UINT8('s', buffer[0]);
+
+    danp_close(sock);
+}
+
+/* ============================================================================
+ * Test Runner
+ * ============================================================================
+ */
+
+/**
+ * @brief Main test runner
+ */
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_zmq_single_frame_format);
+    RUN_TEST(test_zmq_burst_reaches_slow_subscriber);
+    RUN_TEST(test_zmq_bundle_pack_and_unpack);
+    RUN_TEST(test_zmq_deadline_flush);
+    // Leaves the interface open again for anything added after it.
+    RUN_TEST(test_zmq_shutdown_and_reinit);
+
+    return UNITY_END();
+}